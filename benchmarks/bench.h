@@ -0,0 +1,102 @@
+/*
+ * @Description: 微基准测试框架，结果以 JSON 输出到标准输出
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+/*
+ * 每个用例执行 repeat 轮，每轮调用一次 fn(ops)，由 fn 自行循环 ops 次，返回本轮处理的字节数(没有则返回 0)。
+ * 以各轮耗时的中位数计算每次操作的耗时，同时给出最快一轮，便于区分噪声与回退。
+ * 参数：
+ *   --repeat N   每个用例的轮数，默认 5
+ *   --filter S   只执行名称中包含 S 的用例
+ */
+class Bench {
+public:
+    Bench(int argc, char **argv, const char *suite)
+        : _suite(suite)
+        , _repeat(5)
+        , _filter(nullptr) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            if (strcmp(argv[i], "--repeat") == 0) {
+                _repeat = std::max(1, atoi(argv[i + 1]));
+            } else if (strcmp(argv[i], "--filter") == 0) {
+                _filter = argv[i + 1];
+            }
+        }
+    }
+
+    ~Bench() {
+        printf("{\n  \"suite\": \"%s\",\n  \"results\": [", _suite);
+        for (size_t i = 0; i < _results.size(); i++) {
+            const Result &r = _results[i];
+            printf("%s\n    {\"name\": \"%s\", \"ops\": %zu, \"repeat\": %d, \"ns_per_op\": %.3f, "
+                   "\"ns_per_op_min\": %.3f, \"ops_per_sec\": %.1f, \"bytes_per_sec\": %.1f}",
+                   i ? "," : "", r.name.c_str(), r.ops, _repeat, r.ns_per_op, r.ns_per_op_min,
+                   r.ns_per_op > 0 ? 1e9 / r.ns_per_op : 0.0, r.bytes_per_sec);
+        }
+        printf("\n  ]\n}\n");
+    }
+
+    template <class F>
+    void run(const std::string &name, size_t ops, F &&fn) {
+        if (_filter && name.find(_filter) == std::string::npos) {
+            return;
+        }
+        std::vector<double> rounds;
+        size_t bytes = 0;
+        for (int i = 0; i < _repeat; i++) {
+            auto start = std::chrono::steady_clock::now();
+            bytes      = fn(ops);
+            auto end   = std::chrono::steady_clock::now();
+            rounds.push_back(std::chrono::duration<double, std::nano>(end - start).count());
+        }
+        std::sort(rounds.begin(), rounds.end());
+        double median = rounds[rounds.size() / 2];
+
+        Result result;
+        result.name          = name;
+        result.ops           = ops;
+        result.ns_per_op     = median / ops;
+        result.ns_per_op_min = rounds.front() / ops;
+        result.bytes_per_sec = median > 0 ? bytes * 1e9 / median : 0;
+        _results.push_back(result);
+        fprintf(stderr, "%-40s %12.1f ns/op\n", name.c_str(), result.ns_per_op);
+    }
+
+private:
+    struct Result {
+        std::string name;
+        size_t ops;
+        double ns_per_op;
+        double ns_per_op_min;
+        double bytes_per_sec;
+    };
+
+    const char *_suite;
+    int _repeat;
+    const char *_filter;
+    std::vector<Result> _results;
+};
+
+/* 阻止编译器把只为计时而计算的结果优化掉 */
+template <class T>
+inline void doNotOptimize(T &value) {
+    asm volatile("" : "+m"(value) : : "memory");
+}
+
+#endif // BENCH_H
@@ -0,0 +1,61 @@
+/*
+ * @Description: BlockDeque 的入队与出队
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include <string>
+#include <thread>
+
+#include "bench.h"
+#include "blockqueue.hpp"
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "blockqueue");
+
+    /* 单线程交替入队出队，衡量加锁与拷贝的固定开销 */
+    bench.run("push_pop/uncontended", 1000000, [](size_t ops) {
+        BlockDeque<int> deque(1024);
+        int item = 0, sum = 0;
+        for (size_t i = 0; i < ops; i++) {
+            deque.push_back(i);
+            deque.pop(item);
+            sum += item;
+        }
+        doNotOptimize(sum);
+        return 0;
+    });
+
+    /* 多个生产者与一个消费者，与异步日志的用法一致 */
+    const std::string line(96, 'x');
+    for (size_t capacity : {64, 1024}) {
+        for (size_t producers : {1, 4, 8}) {
+            std::string name = "mpsc/capacity_" + std::to_string(capacity) + "/producers_" + std::to_string(producers);
+            bench.run(name, 200000, [&](size_t ops) {
+                BlockDeque<std::string> deque(capacity);
+                std::thread consumer([&deque, ops] {
+                    std::string item;
+                    for (size_t i = 0; i < ops && deque.pop(item); i++) {
+                    }
+                });
+                std::vector<std::thread> threads;
+                for (size_t p = 0; p < producers; p++) {
+                    size_t count = ops / producers + (p < ops % producers ? 1 : 0);
+                    threads.emplace_back([&deque, &line, count] {
+                        for (size_t i = 0; i < count; i++) {
+                            deque.push_back(line);
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+                consumer.join();
+                return ops * line.size();
+            });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+/*
+ * @Description: Buffer 的追加与读写文件描述符
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include <sys/socket.h>
+
+#include "bench.h"
+#include "buffer.h"
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "buffer");
+
+    for (size_t chunk : {16, 256, 4096}) {
+        std::string data(chunk, 'x');
+        bench.run("append/" + std::to_string(chunk), 100000, [&](size_t ops) {
+            Buffer buff;
+            for (size_t i = 0; i < ops; i++) {
+                buff.append(data);
+                /* 模拟写出后回收，避免缓冲区无限增长 */
+                if (buff.readableBytes() >= 64 * 1024) {
+                    buff.reset();
+                }
+            }
+            doNotOptimize(buff);
+            return ops * chunk;
+        });
+    }
+
+    /* 经本地 socket 对收发，计时包含对端的一次 write/read 系统调用 */
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    for (size_t chunk : {512, 4096, 32768}) {
+        std::string data(chunk, 'x');
+        std::vector<char> sink(chunk);
+        bench.run("readFd/" + std::to_string(chunk), 20000, [&](size_t ops) {
+            Buffer buff;
+            int err = 0;
+            for (size_t i = 0; i < ops; i++) {
+                if (write(fds[1], data.data(), chunk) != (ssize_t)chunk || buff.readFd(fds[0], &err) <= 0) {
+                    abort();
+                }
+                buff.reset();
+            }
+            return ops * chunk;
+        });
+        bench.run("writeFd/" + std::to_string(chunk), 20000, [&](size_t ops) {
+            Buffer buff;
+            int err = 0;
+            for (size_t i = 0; i < ops; i++) {
+                buff.append(data);
+                if (buff.writeFd(fds[0], &err) != (ssize_t)chunk || read(fds[1], sink.data(), chunk) != (ssize_t)chunk) {
+                    abort();
+                }
+                buff.reset();
+            }
+            return ops * chunk;
+        });
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return 0;
+}
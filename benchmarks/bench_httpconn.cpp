@@ -0,0 +1,125 @@
+/*
+ * @Description: 经 socketpair 驱动 HttpConn 处理长连接请求，并检查预热后不再向堆申请内存
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:20:14
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:20:14
+ */
+#include <atomic>
+#include <fcntl.h>
+#include <new>
+#include <sys/socket.h>
+
+#include "arena.h"
+#include "bench.h"
+#include "bufferpool.h"
+#include "httpconn.h"
+
+/* 统计全局 operator new 的调用次数，连同 arena 与内存池的堆申请计数一起检查 */
+static std::atomic<size_t> new_calls(0);
+
+void *operator new(size_t len) {
+    new_calls.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(len ? len : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+
+struct AllocCount {
+    size_t arena;
+    size_t pool;
+    size_t news;
+
+    static AllocCount now() {
+        return {Arena::totalHeapAllocs(), BufferPool::getInstance()->heapAllocs(),
+                new_calls.load(std::memory_order_relaxed)};
+    }
+};
+
+/* 与服务器的一次读写任务相同：读请求、构造应答、写完后在空闲时归还缓冲区 */
+static size_t serve(HttpConn &conn, int peer, const std::string &request, char *sink, size_t sink_len) {
+    if (write(peer, request.data(), request.size()) != (ssize_t)request.size()) {
+        fprintf(stderr, "write request error\n");
+        exit(1);
+    }
+    int err = 0;
+    conn.read(&err);
+    if (!conn.process()) {
+        fprintf(stderr, "request not complete\n");
+        exit(1);
+    }
+    size_t total = conn.toWriteBytes();
+    while (conn.toWriteBytes() > 0) {
+        if (conn.write(&err) < 0 && err != EAGAIN) {
+            fprintf(stderr, "write response error: %d\n", err);
+            exit(1);
+        }
+        while (read(peer, sink, sink_len) > 0) {
+        }
+    }
+    while (read(peer, sink, sink_len) > 0) {
+    }
+    /* 缓冲区已读空，连接变为空闲 */
+    conn.process();
+    return total;
+}
+
+int main(int argc, char **argv) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) < 0) {
+        perror("socketpair");
+        return 1;
+    }
+    HttpConn::is_et   = true;
+    HttpConn::src_dir = RESOURCES_DIR;
+
+    static char sink[64 * 1024];
+    std::string request = "GET /index.html HTTP/1.1\r\nHost: 127.0.0.1\r\nConnection: keep-alive\r\n\r\n";
+    HttpConn conn;
+    struct sockaddr_in addr = {};
+    conn.init(fds[0], addr);
+
+    /* 预热：线程的指标槽位、内存池中的块均在此期间就位 */
+    for (int i = 0; i < 1000; i++) {
+        serve(conn, fds[1], request, sink, sizeof(sink));
+    }
+
+    /* 计时框架自身会分配内存，只累计请求循环内的次数 */
+    AllocCount allocs = {0, 0, 0};
+    {
+        Bench bench(argc, argv, "httpconn");
+        bench.run("keepalive/get_index", 10000, [&](size_t ops) {
+            size_t bytes      = 0;
+            AllocCount before = AllocCount::now();
+            for (size_t i = 0; i < ops; i++) {
+                bytes += serve(conn, fds[1], request, sink, sizeof(sink));
+            }
+            AllocCount after = AllocCount::now();
+            allocs.arena += after.arena - before.arena;
+            allocs.pool += after.pool - before.pool;
+            allocs.news += after.news - before.news;
+            return bytes;
+        });
+    }
+    conn.disconn();
+    close(fds[1]);
+
+    fprintf(stderr, "heap allocations after warm-up: arena %zu, buffer pool %zu, operator new %zu\n", allocs.arena,
+            allocs.pool, allocs.news);
+    if (allocs.arena || allocs.pool || allocs.news) {
+        fprintf(stderr, "FAIL: keep-alive requests allocated from the heap after warm-up\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * @Description: HttpRequest::parse 解析常见请求
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include "arena.h"
+#include "bench.h"
+#include "httprequest.h"
+
+struct Sample {
+    const char *name;
+    std::string text;
+};
+
+static std::vector<Sample> corpus() {
+    std::vector<Sample> samples;
+    samples.push_back({"get_minimal", "GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n"});
+    samples.push_back({"get_browser",
+                       "GET /css/style.css?v=20261019 HTTP/1.1\r\n"
+                       "Host: 127.0.0.1:12345\r\n"
+                       "Connection: keep-alive\r\n"
+                       "sec-ch-ua: \"Chromium\";v=\"128\", \"Not;A=Brand\";v=\"24\"\r\n"
+                       "sec-ch-ua-mobile: ?0\r\n"
+                       "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+                       "Chrome/128.0.0.0 Safari/537.36\r\n"
+                       "sec-ch-ua-platform: \"Linux\"\r\n"
+                       "Accept: text/css,*/*;q=0.1\r\n"
+                       "Sec-Fetch-Site: same-origin\r\n"
+                       "Sec-Fetch-Mode: no-cors\r\n"
+                       "Sec-Fetch-Dest: style\r\n"
+                       "Referer: http://127.0.0.1:12345/index.html\r\n"
+                       "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+                       "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+                       "Cookie: sid=6b1f3c0e9d2a4f5b8c7e1d0a3b2c4d5e; theme=dark\r\n"
+                       "\r\n"});
+    samples.push_back({"get_query",
+                       "GET /search?q=epoll%20edge%20triggered&page=2&sort=desc&lang=zh-CN HTTP/1.1\r\n"
+                       "Host: 127.0.0.1\r\nAccept: */*\r\nConnection: keep-alive\r\n\r\n"});
+    samples.push_back({"post_form",
+                       "POST /login HTTP/1.1\r\n"
+                       "Host: 127.0.0.1:12345\r\n"
+                       "Connection: keep-alive\r\n"
+                       "Content-Type: application/x-www-form-urlencoded\r\n"
+                       "Content-Length: 37\r\n"
+                       "Origin: http://127.0.0.1:12345\r\n"
+                       "\r\n"
+                       "username=ab%2Fc&password=x+y%21%40%23"});
+    samples.push_back({"post_json",
+                       "POST /api/items HTTP/1.1\r\n"
+                       "Host: 127.0.0.1\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Content-Length: 77\r\n"
+                       "\r\n"
+                       "{\"name\":\"widget\",\"tags\":[\"a\",\"b\",\"c\"],\"price\":12.5,\"stock\":{\"n\":3,\"ok\":true}}"});
+    samples.push_back({"post_chunked",
+                       "POST /api/upload HTTP/1.1\r\n"
+                       "Host: 127.0.0.1\r\n"
+                       "Content-Type: text/plain\r\n"
+                       "Transfer-Encoding: chunked\r\n"
+                       "\r\n"
+                       "10\r\n0123456789abcdef\r\n"
+                       "10\r\n0123456789abcdef\r\n"
+                       "0\r\n\r\n"});
+    return samples;
+}
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "httprequest");
+    std::vector<Sample> samples = corpus();
+    for (const Sample &sample : samples) {
+        bench.run(std::string("parse/") + sample.name, 100000, [&](size_t ops) {
+            Arena arena;
+            HttpRequest request;
+            Buffer buff;
+            for (size_t i = 0; i < ops; i++) {
+                buff.append(sample.text);
+                request.init(&arena);
+                if (request.parse(buff) != HttpRequest::GET_REQUEST) {
+                    fprintf(stderr, "%s: unexpected parse result\n", sample.name);
+                    abort();
+                }
+                request.release();
+                arena.reset();
+                buff.reset();
+            }
+            return ops * sample.text.size();
+        });
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+/*
+ * @Description: 多线程并发写日志，异步与同步两种模式
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include <dirent.h>
+#include <thread>
+
+#include "bench.h"
+#include "logger.h"
+
+/* 删除基准测试写出的日志文件 */
+static void removeDir(const std::string &path) {
+    DIR *dir = opendir(path.c_str());
+    if (!dir) {
+        return;
+    }
+    while (struct dirent *entry = readdir(dir)) {
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, "..")) {
+            unlink((path + "/" + entry->d_name).c_str());
+        }
+    }
+    closedir(dir);
+    rmdir(path.c_str());
+}
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "logger");
+    char path[] = "/tmp/bench_logger_XXXXXX";
+    if (!mkdtemp(path)) {
+        perror("mkdtemp");
+        return 1;
+    }
+
+    /* 异步模式计时到全部线程写入队列为止，同步模式计时到写入 stdio 缓冲区为止 */
+    for (int queue_size : {1024, 0}) {
+        Logger::getInstance()->init(1, path, ".log", queue_size);
+        const char *mode = queue_size ? "async" : "sync";
+        for (size_t writers : {1, 4, 8}) {
+            std::string name = std::string("write/") + mode + "/threads_" + std::to_string(writers);
+            bench.run(name, 100000, [&](size_t ops) {
+                std::vector<std::thread> threads;
+                for (size_t t = 0; t < writers; t++) {
+                    size_t count = ops / writers + (t < ops % writers ? 1 : 0);
+                    threads.emplace_back([count, t] {
+                        for (size_t i = 0; i < count; i++) {
+                            LOG_INFO("Client[%zu](127.0.0.1:%zu) in, user_count:%zu", t, i, count);
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+                return 0;
+            });
+        }
+    }
+    Logger::getInstance()->flush();
+    removeDir(path);
+    return 0;
+}
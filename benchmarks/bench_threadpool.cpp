@@ -0,0 +1,45 @@
+/*
+ * @Description: ThreadPool 多个生产者并发提交时的任务吞吐
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include <atomic>
+#include <thread>
+
+#include "bench.h"
+#include "threadpool.h"
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "threadpool");
+
+    for (size_t workers : {1, 4, 8}) {
+        for (size_t producers : {1, 4, 8}) {
+            std::string name = "tasks/workers_" + std::to_string(workers) + "/producers_" + std::to_string(producers);
+            bench.run(name, 200000, [&](size_t ops) {
+                ThreadPool pool(workers);
+                std::atomic<size_t> done(0);
+                std::vector<std::thread> threads;
+                for (size_t p = 0; p < producers; p++) {
+                    size_t count = ops / producers + (p < ops % producers ? 1 : 0);
+                    threads.emplace_back([&pool, &done, count] {
+                        for (size_t i = 0; i < count; i++) {
+                            pool.addTask([&done] { done.fetch_add(1, std::memory_order_relaxed); });
+                        }
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+                /* 计时到全部任务执行完毕 */
+                while (done.load(std::memory_order_relaxed) < ops) {
+                    std::this_thread::yield();
+                }
+                return 0;
+            });
+        }
+    }
+    return 0;
+}
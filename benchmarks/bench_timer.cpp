@@ -0,0 +1,77 @@
+/*
+ * @Description: HeapTimer 在 1 万至 10 万个计时器下的添加、调整与到期处理
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:07:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:07:18
+ */
+#include <random>
+
+#include "bench.h"
+#include "timer.h"
+
+int main(int argc, char **argv) {
+    Bench bench(argc, argv, "timer");
+    std::mt19937 rng(42);
+
+    for (size_t n : {10000, 100000}) {
+        std::string suffix = "/" + std::to_string(n);
+        std::vector<int> timeouts(n);
+        for (auto &timeout : timeouts) {
+            timeout = 60000 + rng() % 60000;
+        }
+
+        /* 逐个添加 n 个超时各不相同的计时器 */
+        bench.run("add" + suffix, n, [&](size_t ops) {
+            HeapTimer timer;
+            for (size_t i = 0; i < ops; i++) {
+                timer.add(i, timeouts[i], [] {});
+            }
+            return 0;
+        });
+
+        /* 已有 n 个计时器时，随机连接活跃后延长超时，对应 _extentTime */
+        HeapTimer timer;
+        for (size_t i = 0; i < n; i++) {
+            timer.add(i, timeouts[i], [] {});
+        }
+        std::vector<int> ids(n);
+        for (auto &id : ids) {
+            id = rng() % n;
+        }
+        int round = 0;
+        bench.run("adjust" + suffix, n, [&](size_t ops) {
+            round++;
+            for (size_t i = 0; i < ops; i++) {
+                timer.adjust(ids[i], timeouts[i] + round * 1000);
+            }
+            return 0;
+        });
+
+        /* 到期处理：n 个已到期的计时器由一次 tick 全部弹出 */
+        bench.run("tick_expired" + suffix, n, [&](size_t ops) {
+            HeapTimer expired;
+            size_t fired = 0;
+            for (size_t i = 0; i < ops; i++) {
+                expired.add(i, -1 - (int)(rng() % 1000), [&fired] { fired++; });
+            }
+            expired.tick();
+            if (fired != ops) {
+                abort();
+            }
+            return 0;
+        });
+
+        /* 未到期时每轮事件循环的 getNextTick 开销 */
+        bench.run("next_tick" + suffix, 100000, [&](size_t ops) {
+            int next = 0;
+            for (size_t i = 0; i < ops; i++) {
+                next += timer.getNextTick();
+            }
+            doNotOptimize(next);
+            return 0;
+        });
+    }
+    return 0;
+}
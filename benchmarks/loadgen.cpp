@@ -0,0 +1,529 @@
+/*
+ * @Description: 基于 epoll 的多线程 HTTP 压测客户端
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:31:52
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 22:03:10
+ */
+#include <algorithm>
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <map>
+#include <memory>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <random>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "histogram.h"
+#include "responseparser.h"
+
+/*
+ * 两种模式：
+ *   - 闭环(默认)：每个连接保持 depth 个请求在途，收到应答立即发出下一个；
+ *   - 定速(-R)：每个连接按 rate / connections 的间隔排定发送时刻，连接忙时请求顺延，
+ *     延迟从排定时刻而非实际发出时刻算起，服务器卡顿期间本应发出的请求也计入延迟(coordinated omission 校正)。
+ * 每个线程一个 epoll 实例，连接平均分配到各线程；延迟记录在线程私有的直方图中，结束后合并。
+ * 结果以 JSON 输出到标准输出，摘要输出到标准错误。
+ */
+
+struct Options {
+    std::string host  = "127.0.0.1";
+    int port          = 12345;
+    int threads       = 2;
+    int connections   = 64;
+    double duration   = 10;
+    double warmup     = 0;
+    double rate       = 0; /* 每秒请求数，0 为闭环 */
+    int depth         = 1; /* 每个连接在途请求数，大于 1 时流水线发送 */
+    bool keep_alive   = true;
+    const char *urls  = nullptr;
+    const char *label = "";
+};
+
+struct Target {
+    std::string request;
+    double weight;
+};
+
+struct Pending {
+    uint64_t intended_ns; /* 定速模式下排定的发送时刻，闭环模式同 sent_ns */
+    uint64_t sent_ns;
+};
+
+struct Stats {
+    Histogram latency;     /* 校正后的延迟 */
+    Histogram service;     /* 实际发出到收到应答 */
+    uint64_t requests = 0; /* 完成的请求 */
+    uint64_t errors   = 0; /* 连接失败、应答前断开、无法解析的应答 */
+    uint64_t connects = 0;
+    uint64_t bytes    = 0;
+    std::map<int, uint64_t> status;
+};
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+class Worker {
+public:
+    Worker(const Options &options, const std::vector<Target> &targets, int conn_num, uint64_t seed)
+        : _options(options)
+        , _targets(targets)
+        , _conns(conn_num)
+        , _rng(seed) {
+        double total = 0;
+        for (auto &target : targets) {
+            total += target.weight;
+            _cumulative.push_back(total);
+        }
+    }
+
+    void run(uint64_t start_ns, uint64_t record_ns, uint64_t end_ns);
+
+    const Stats &stats() const { return _stats; }
+
+private:
+    struct Conn {
+        int fd = -1;
+        std::string out;
+        size_t out_pos = 0;
+        ResponseParser parser;
+        std::vector<Pending> pending;
+        size_t pending_pos = 0;
+        uint64_t next_send = 0;
+        uint64_t retry_at  = 0; /* 连接失败后的重试时刻 */
+        bool want_write    = false;
+        bool connecting    = false; /* 非阻塞 connect 尚未完成 */
+
+        size_t inflight() const { return pending.size() - pending_pos; }
+    };
+
+    bool _connect(Conn &conn);
+    bool _finishConnect(Conn &conn);
+    void _reset(Conn &conn, bool failed);
+    void _send(Conn &conn, uint64_t intended, uint64_t now);
+    bool _flush(Conn &conn);
+    bool _read(Conn &conn);
+    void _complete(Conn &conn, int code);
+
+    const Options &_options;
+    const std::vector<Target> &_targets;
+    std::vector<double> _cumulative;
+    std::vector<Conn> _conns;
+    std::mt19937_64 _rng;
+    int _epfd             = -1;
+    uint64_t _record_ns   = 0;
+    uint64_t _interval_ns = 0;
+    Stats _stats;
+};
+
+bool Worker::_connect(Conn &conn) {
+    /* 非阻塞 connect：服务器监听队列溢出时 SYN 重传可达数秒，不能阻塞同一线程的其他连接 */
+    conn.fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (conn.fd < 0) {
+        return false;
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_port           = htons(_options.port);
+    inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr);
+    if (connect(conn.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(conn.fd);
+        conn.fd = -1;
+        return false;
+    }
+    int one = 1;
+    setsockopt(conn.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    /* 连接建立后可写，期间生成的请求暂存在 out 中 */
+    struct epoll_event event = {};
+    event.events             = EPOLLIN | EPOLLOUT;
+    event.data.ptr           = &conn;
+    epoll_ctl(_epfd, EPOLL_CTL_ADD, conn.fd, &event);
+    conn.want_write = true;
+    conn.connecting = true;
+    return true;
+}
+/**
+ * @description: 非阻塞 connect 完成，失败时计一次错误并在稍后重试
+ * @param {Conn} &conn
+ * @return {*} 连接建立时返回 true
+ */
+bool Worker::_finishConnect(Conn &conn) {
+    int err       = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err) {
+        uint64_t now  = nowNs();
+        conn.retry_at = now + 100000000ull;
+        _stats.errors += now >= _record_ns;
+        _reset(conn, false);
+        return false;
+    }
+    conn.connecting = false;
+    _stats.connects++;
+    return true;
+}
+/**
+ * @description: 关闭连接，在途请求记为失败；定速模式的排定时刻保持不变，重连后顺延发出
+ * @param {Conn} &conn
+ * @param {bool} failed，在途请求是否计为错误
+ * @return {*}
+ */
+void Worker::_reset(Conn &conn, bool failed) {
+    if (conn.fd >= 0) {
+        close(conn.fd);
+        conn.fd = -1;
+    }
+    conn.connecting = false;
+    if (failed && _record_ns <= nowNs()) {
+        _stats.errors += conn.inflight();
+    }
+    conn.out.clear();
+    conn.out_pos = 0;
+    conn.parser.reset();
+    conn.pending.clear();
+    conn.pending_pos = 0;
+}
+
+void Worker::_send(Conn &conn, uint64_t intended, uint64_t now) {
+    size_t i = std::upper_bound(_cumulative.begin(), _cumulative.end(),
+                                std::uniform_real_distribution<double>(0, _cumulative.back())(_rng)) -
+               _cumulative.begin();
+    conn.out.append(_targets[std::min(i, _targets.size() - 1)].request);
+    conn.pending.push_back({intended, now});
+}
+/**
+ * @description: 写出待发送的请求，写满时监听可写事件
+ * @param {Conn} &conn
+ * @return {*} 连接出错时返回 false
+ */
+bool Worker::_flush(Conn &conn) {
+    if (conn.connecting) {
+        return true;
+    }
+    while (conn.out_pos < conn.out.size()) {
+        ssize_t n = send(conn.fd, conn.out.data() + conn.out_pos, conn.out.size() - conn.out_pos, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN) {
+                return false;
+            }
+            break;
+        }
+        conn.out_pos += n;
+    }
+    if (conn.out_pos == conn.out.size()) {
+        conn.out.clear();
+        conn.out_pos = 0;
+    }
+    bool want_write = !conn.out.empty();
+    if (want_write != conn.want_write) {
+        struct epoll_event event = {};
+        event.events             = EPOLLIN | (want_write ? EPOLLOUT : 0);
+        event.data.ptr           = &conn;
+        epoll_ctl(_epfd, EPOLL_CTL_MOD, conn.fd, &event);
+        conn.want_write = want_write;
+    }
+    return true;
+}
+/**
+ * @description: 读取并解析应答
+ * @param {Conn} &conn
+ * @return {*} 连接已关闭、出错或服务器要求关闭连接时返回 false
+ */
+bool Worker::_read(Conn &conn) {
+    char buff[65536];
+    auto on_response = [this, &conn](int code) { _complete(conn, code); };
+    while (true) {
+        ssize_t n = recv(conn.fd, buff, sizeof(buff), 0);
+        if (n > 0) {
+            _stats.bytes += n;
+            if (!conn.parser.feed(buff, n, on_response)) {
+                _stats.errors += _record_ns <= nowNs();
+                return false;
+            }
+            if (conn.parser.closed() || (!_options.keep_alive && conn.inflight() == 0)) {
+                return false;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return true;
+        }
+        conn.parser.eof(on_response);
+        return false;
+    }
+}
+
+void Worker::_complete(Conn &conn, int code) {
+    if (conn.inflight() == 0) {
+        /* 没有对应请求的应答 */
+        _stats.errors += _record_ns <= nowNs();
+        return;
+    }
+    const Pending &pending = conn.pending[conn.pending_pos++];
+    uint64_t now           = nowNs();
+    if (pending.sent_ns >= _record_ns) {
+        _stats.latency.record(now - pending.intended_ns);
+        _stats.service.record(now - pending.sent_ns);
+        _stats.requests++;
+        _stats.status[code]++;
+    }
+    if (conn.pending_pos == conn.pending.size()) {
+        conn.pending.clear();
+        conn.pending_pos = 0;
+    }
+}
+
+void Worker::run(uint64_t start_ns, uint64_t record_ns, uint64_t end_ns) {
+    _epfd      = epoll_create1(0);
+    _record_ns = record_ns;
+    if (_options.rate > 0) {
+        _interval_ns = static_cast<uint64_t>(1e9 * _options.connections / _options.rate);
+    }
+    /* 各连接的排定时刻错开，避免同一时刻集中发送 */
+    for (size_t i = 0; i < _conns.size(); i++) {
+        _conns[i].next_send = start_ns + (_interval_ns * i) / _conns.size();
+    }
+    const size_t depth = _options.keep_alive ? _options.depth : 1;
+
+    std::vector<struct epoll_event> events(_conns.size() + 1);
+    uint64_t now = nowNs();
+    while (now < end_ns) {
+        uint64_t next_wake = now + 100000000ull;
+        for (auto &conn : _conns) {
+            if (conn.fd < 0 && (now < conn.retry_at || !_connect(conn))) {
+                if (now >= conn.retry_at) {
+                    conn.retry_at = now + 100000000ull;
+                    _stats.errors += now >= _record_ns;
+                }
+                continue;
+            }
+            size_t before = conn.inflight();
+            if (_interval_ns) {
+                while (conn.next_send <= now && conn.inflight() < depth) {
+                    _send(conn, conn.next_send, now);
+                    conn.next_send += _interval_ns;
+                }
+                if (conn.inflight() < depth) {
+                    next_wake = std::min(next_wake, conn.next_send);
+                }
+            } else {
+                while (conn.inflight() < depth) {
+                    _send(conn, now, now);
+                }
+            }
+            if (conn.inflight() != before && !_flush(conn)) {
+                _reset(conn, true);
+            }
+        }
+
+        int timeout = next_wake > now ? static_cast<int>((next_wake - now + 999999) / 1000000) : 0;
+        int n       = epoll_wait(_epfd, events.data(), events.size(), timeout);
+        for (int i = 0; i < n; i++) {
+            Conn &conn = *static_cast<Conn *>(events[i].data.ptr);
+            if (conn.fd < 0) {
+                continue;
+            }
+            if (conn.connecting && !_finishConnect(conn)) {
+                continue;
+            }
+            bool ok = true;
+            if (events[i].events & EPOLLOUT) {
+                ok = _flush(conn);
+            }
+            if (ok && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                ok = _read(conn);
+            }
+            if (!ok) {
+                _reset(conn, conn.inflight() > 0);
+            }
+        }
+        now = nowNs();
+    }
+    for (auto &conn : _conns) {
+        if (conn.fd >= 0) {
+            close(conn.fd);
+        }
+    }
+    close(_epfd);
+}
+
+/**
+ * @description: 读取 URL 列表，每行 "路径 [权重]"，# 开头为注释
+ * @return {*}
+ */
+static bool loadTargets(const Options &options, std::vector<Target> &targets) {
+    std::vector<std::pair<std::string, double>> paths;
+    if (options.urls) {
+        FILE *fp = fopen(options.urls, "r");
+        if (!fp) {
+            perror(options.urls);
+            return false;
+        }
+        char line[4096], path[4096];
+        while (fgets(line, sizeof(line), fp)) {
+            double weight = 1;
+            if (line[0] == '#' || sscanf(line, "%4095s %lf", path, &weight) < 1 || weight <= 0) {
+                continue;
+            }
+            paths.emplace_back(path, weight);
+        }
+        fclose(fp);
+    }
+    if (paths.empty()) {
+        paths.emplace_back("/", 1);
+    }
+    for (auto &path : paths) {
+        std::string request = "GET " + path.first + " HTTP/1.1\r\nHost: " + options.host + ":" +
+                              std::to_string(options.port) + "\r\nUser-Agent: loadgen\r\nConnection: " +
+                              (options.keep_alive ? "keep-alive" : "close") + "\r\n\r\n";
+        targets.push_back({request, path.second});
+    }
+    return true;
+}
+
+static void appendLatency(std::string &out, const char *name, const Histogram &histogram) {
+    char line[512];
+    snprintf(line, sizeof(line),
+             "  \"%s\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, "
+             "\"p9999\": %.3f, \"max\": %.3f}",
+             name, histogram.count() ? histogram.sum() / 1e6 / histogram.count() : 0.0,
+             histogram.percentile(0.5) / 1e6, histogram.percentile(0.9) / 1e6, histogram.percentile(0.99) / 1e6,
+             histogram.percentile(0.999) / 1e6, histogram.percentile(0.9999) / 1e6, histogram.max() / 1e6);
+    out.append(line);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  -u HOST:PORT  server address, default 127.0.0.1:12345\n"
+            "  -t N          threads, default 2\n"
+            "  -c N          connections, default 64\n"
+            "  -d SECONDS    measured duration, default 10\n"
+            "  -w SECONDS    warmup before recording, default 0\n"
+            "  -R RPS        fixed total request rate, default 0 (closed loop)\n"
+            "  -p N          pipelined requests per connection, default 1\n"
+            "  -f FILE       URL mix, one \"path [weight]\" per line\n"
+            "  -n            no keep-alive, one request per connection\n"
+            "  -l LABEL      label copied into the JSON output\n",
+            name);
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "u:t:c:d:w:R:p:f:nl:h")) != -1) {
+        switch (opt) {
+        case 'u': {
+            std::string addr = optarg;
+            size_t colon     = addr.rfind(':');
+            options.host     = addr.substr(0, colon);
+            if (colon != std::string::npos) {
+                options.port = atoi(addr.c_str() + colon + 1);
+            }
+            break;
+        }
+        case 't': options.threads = atoi(optarg); break;
+        case 'c': options.connections = atoi(optarg); break;
+        case 'd': options.duration = atof(optarg); break;
+        case 'w': options.warmup = atof(optarg); break;
+        case 'R': options.rate = atof(optarg); break;
+        case 'p': options.depth = atoi(optarg); break;
+        case 'f': options.urls = optarg; break;
+        case 'n': options.keep_alive = false; break;
+        case 'l': options.label = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    options.threads = std::max(1, std::min(options.threads, options.connections));
+    if (options.connections < 1 || options.depth < 1 || options.duration <= 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::vector<Target> targets;
+    if (!loadTargets(options, targets)) {
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < options.threads; i++) {
+        int conn_num = options.connections / options.threads + (i < options.connections % options.threads ? 1 : 0);
+        workers.emplace_back(new Worker(options, targets, conn_num, 42 + i));
+    }
+    uint64_t start_ns  = nowNs();
+    uint64_t record_ns = start_ns + static_cast<uint64_t>(options.warmup * 1e9);
+    uint64_t end_ns    = record_ns + static_cast<uint64_t>(options.duration * 1e9);
+    std::vector<std::thread> threads;
+    for (auto &worker : workers) {
+        threads.emplace_back([&worker, start_ns, record_ns, end_ns] { worker->run(start_ns, record_ns, end_ns); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    Stats total;
+    for (auto &worker : workers) {
+        const Stats &stats = worker->stats();
+        total.latency.merge(stats.latency);
+        total.service.merge(stats.service);
+        total.requests += stats.requests;
+        total.errors += stats.errors;
+        total.connects += stats.connects;
+        total.bytes += stats.bytes;
+        for (auto &status : stats.status) {
+            total.status[status.first] += status.second;
+        }
+    }
+
+    std::string out;
+    char line[512];
+    snprintf(line, sizeof(line),
+             "{\n  \"label\": \"%s\",\n  \"mode\": \"%s\",\n  \"threads\": %d,\n  \"connections\": %d,\n"
+             "  \"depth\": %d,\n  \"keep_alive\": %s,\n  \"target_rate\": %.1f,\n  \"duration_s\": %.3f,\n"
+             "  \"requests\": %llu,\n  \"errors\": %llu,\n  \"connects\": %llu,\n  \"rps\": %.1f,\n"
+             "  \"received_bytes\": %llu,\n  \"status\": {",
+             options.label, options.rate > 0 ? "fixed_rate" : "closed_loop", options.threads, options.connections,
+             options.depth, options.keep_alive ? "true" : "false", options.rate, options.duration,
+             (unsigned long long)total.requests, (unsigned long long)total.errors,
+             (unsigned long long)total.connects, total.requests / options.duration, (unsigned long long)total.bytes);
+    out.append(line);
+    bool first = true;
+    for (auto &status : total.status) {
+        snprintf(line, sizeof(line), "%s\"%d\": %llu", first ? "" : ", ", status.first,
+                 (unsigned long long)status.second);
+        out.append(line);
+        first = false;
+    }
+    out.append("},\n");
+    /* 延迟单位毫秒；定速模式下 latency_ms 从排定时刻算起，service_ms 从实际发出算起 */
+    appendLatency(out, "latency_ms", total.latency);
+    out.append(",\n");
+    appendLatency(out, "service_ms", total.service);
+    out.append("\n}\n");
+    fputs(out.c_str(), stdout);
+
+    fprintf(stderr, "%llu requests, %llu errors, %.1f req/s, p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+            (unsigned long long)total.requests, (unsigned long long)total.errors, total.requests / options.duration,
+            total.latency.percentile(0.5) / 1e6, total.latency.percentile(0.99) / 1e6,
+            total.latency.percentile(0.999) / 1e6, total.latency.max() / 1e6);
+    return 0;
+}
@@ -0,0 +1,455 @@
+/*
+ * @Description: 回放 TrafficCapture 采集的请求流量
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:58:14
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:58:14
+ */
+#include <arpa/inet.h>
+#include <deque>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+#include "capture.h"
+#include "histogram.h"
+#include "responseparser.h"
+
+/*
+ * 每个采集到的连接对应一个回放连接，连接上的数据按原始顺序、原始时间间隔(除以 -s 倍速)发送。
+ * 采集中的 RESPONSE 记录标记一个请求的结束：回放连接须收到相应数量的应答后，才继续发送之后的数据，
+ * 与原客户端等待应答后再发出下一请求的行为一致；-s 0 时不等待时间间隔，只保留这一依赖。
+ * 延迟从请求的第一块数据发出算起，到应答完整收到为止。
+ */
+
+struct Options {
+    std::string host  = "127.0.0.1";
+    int port          = 12345;
+    double speed      = 1;
+    int timeout_ms    = 10000; /* 等待应答的上限 */
+    const char *label = "";
+    const char *path  = nullptr;
+};
+
+struct Event {
+    uint64_t time_ns;
+    uint16_t type;
+    uint32_t len;
+    const char *data;
+};
+
+struct Session {
+    std::vector<Event> events;
+    size_t next = 0;
+    int fd      = -1;
+    bool done   = false;
+
+    ResponseParser parser;
+    std::string out;
+    size_t out_pos  = 0;
+    bool want_write = false;
+
+    uint64_t answered = 0; /* 已经过的 RESPONSE 记录数 */
+    uint64_t received = 0; /* 已收到的应答数 */
+    uint64_t blocked  = 0; /* 开始等待应答的时刻，0 表示未在等待 */
+    bool new_request  = true;
+    std::deque<uint64_t> starts;
+};
+
+struct Stats {
+    Histogram latency;
+    uint64_t requests = 0;
+    uint64_t errors   = 0;
+    uint64_t sent     = 0;
+    uint64_t bytes    = 0;
+    std::map<int, uint64_t> status;
+};
+
+static uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+class Replayer {
+public:
+    Replayer(const Options &options)
+        : _options(options)
+        , _epfd(epoll_create1(0)) {}
+    ~Replayer() { close(_epfd); }
+
+    bool load(const char *path);
+    void run();
+    void report() const;
+
+private:
+    bool _connect(Session &session);
+    void _finish(Session &session, bool failed);
+    void _advance(Session &session, uint64_t now, uint64_t &next_wake);
+    bool _flush(Session &session);
+    bool _read(Session &session);
+    bool _completed(const Session &session) const;
+
+    const Options &_options;
+    int _epfd;
+    std::vector<char> _file;
+    std::vector<Session> _sessions;
+    uint64_t _start_ns   = 0;
+    uint64_t _elapsed_ns = 0;
+    uint64_t _capture_ns = 0;
+    Stats _stats;
+};
+
+/**
+ * @description: 读入采集文件，按连接分组
+ * @param {char} *path
+ * @return {*}
+ */
+bool Replayer::load(const char *path) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        perror(path);
+        return false;
+    }
+    char buff[65536];
+    size_t n;
+    while ((n = fread(buff, 1, sizeof(buff), fp)) > 0) {
+        _file.insert(_file.end(), buff, buff + n);
+    }
+    fclose(fp);
+    if (_file.size() < sizeof(CAPTURE_MAGIC) || memcmp(_file.data(), CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != 0) {
+        fprintf(stderr, "%s: not a capture file\n", path);
+        return false;
+    }
+
+    std::unordered_map<uint32_t, size_t> index;
+    size_t pos = sizeof(CAPTURE_MAGIC);
+    while (pos + sizeof(CaptureRecord) <= _file.size()) {
+        CaptureRecord record;
+        memcpy(&record, _file.data() + pos, sizeof(record));
+        pos += sizeof(record);
+        size_t payload = record.type == CaptureRecord::DATA ? record.len : 0;
+        if (pos + payload > _file.size()) {
+            break; /* 采集时被截断的最后一条记录 */
+        }
+        auto it = index.find(record.conn);
+        if (it == index.end()) {
+            /* 只回放完整采集的连接 */
+            if (record.type != CaptureRecord::OPEN) {
+                pos += payload;
+                continue;
+            }
+            it = index.emplace(record.conn, _sessions.size()).first;
+            _sessions.emplace_back();
+        }
+        _sessions[it->second].events.push_back({record.time_ns, record.type, record.len, _file.data() + pos});
+        _capture_ns = std::max(_capture_ns, record.time_ns);
+        pos += payload;
+    }
+    fprintf(stderr, "%s: %zu connections, %.3f s\n", path, _sessions.size(), _capture_ns / 1e9);
+    return !_sessions.empty();
+}
+
+bool Replayer::_connect(Session &session) {
+    session.fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (session.fd < 0) {
+        return false;
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family         = AF_INET;
+    addr.sin_port           = htons(_options.port);
+    inet_pton(AF_INET, _options.host.c_str(), &addr.sin_addr);
+    if (connect(session.fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(session.fd);
+        session.fd = -1;
+        return false;
+    }
+    int one = 1;
+    setsockopt(session.fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(session.fd, F_SETFL, fcntl(session.fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct epoll_event event = {};
+    event.events             = EPOLLIN;
+    event.data.ptr           = &session;
+    epoll_ctl(_epfd, EPOLL_CTL_ADD, session.fd, &event);
+    return true;
+}
+
+void Replayer::_finish(Session &session, bool failed) {
+    if (session.fd >= 0) {
+        close(session.fd);
+        session.fd = -1;
+    }
+    if (failed) {
+        _stats.errors++;
+    }
+    session.done = true;
+}
+/**
+ * @description: 发送已到时刻的数据，遇到尚未收到应答的 RESPONSE 记录时停下等待
+ * @param {Session} &session
+ * @param {uint64_t} now
+ * @param {uint64_t} &next_wake，下一条记录到时刻时更新
+ * @return {*}
+ */
+void Replayer::_advance(Session &session, uint64_t now, uint64_t &next_wake) {
+    size_t before = session.out.size();
+    bool waiting  = false;
+    while (!waiting && session.next < session.events.size()) {
+        const Event &event = session.events[session.next];
+        uint64_t due       = _options.speed > 0 ? _start_ns + static_cast<uint64_t>(event.time_ns / _options.speed)
+                                                : _start_ns;
+        if (due > now) {
+            next_wake = std::min(next_wake, due);
+            break;
+        }
+        switch (event.type) {
+        case CaptureRecord::OPEN:
+            if (!_connect(session)) {
+                _finish(session, true);
+                return;
+            }
+            break;
+        case CaptureRecord::DATA:
+        case CaptureRecord::GAP:
+            if (session.new_request) {
+                session.starts.push_back(now);
+                session.new_request = false;
+            }
+            if (event.type == CaptureRecord::DATA) {
+                session.out.append(event.data, event.len);
+            } else {
+                session.out.append(event.len, '\0');
+            }
+            break;
+        case CaptureRecord::RESPONSE:
+            if (session.received <= session.answered) {
+                if (!session.blocked) {
+                    session.blocked = now;
+                }
+                waiting = true;
+                continue;
+            }
+            session.answered++;
+            session.blocked     = 0;
+            session.new_request = true;
+            break;
+        case CaptureRecord::CLOSE:
+            _finish(session, false);
+            return;
+        }
+        session.next++;
+    }
+    /* 采集被截断，没有 CLOSE 记录的连接在数据发完、应答收齐后关闭 */
+    if (session.next == session.events.size() && session.received >= session.answered && session.out.empty()) {
+        _finish(session, false);
+        return;
+    }
+    if (session.out.size() != before && !_flush(session)) {
+        _finish(session, true);
+    }
+}
+
+bool Replayer::_flush(Session &session) {
+    while (session.out_pos < session.out.size()) {
+        ssize_t n = send(session.fd, session.out.data() + session.out_pos, session.out.size() - session.out_pos,
+                         MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN) {
+                return false;
+            }
+            break;
+        }
+        session.out_pos += n;
+        _stats.sent += n;
+    }
+    if (session.out_pos == session.out.size()) {
+        session.out.clear();
+        session.out_pos = 0;
+    }
+    bool want_write = !session.out.empty();
+    if (want_write != session.want_write) {
+        struct epoll_event event = {};
+        event.events             = EPOLLIN | (want_write ? EPOLLOUT : 0);
+        event.data.ptr           = &session;
+        epoll_ctl(_epfd, EPOLL_CTL_MOD, session.fd, &event);
+        session.want_write = want_write;
+    }
+    return true;
+}
+/**
+ * @description: 读取应答
+ * @param {Session} &session
+ * @return {*} 服务器关闭连接或出错时返回 false
+ */
+bool Replayer::_read(Session &session) {
+    char buff[65536];
+    auto on_response = [this, &session](int code) {
+        uint64_t now = nowNs();
+        session.received++;
+        _stats.requests++;
+        _stats.status[code]++;
+        if (!session.starts.empty()) {
+            _stats.latency.record(now - session.starts.front());
+            session.starts.pop_front();
+        }
+    };
+    while (true) {
+        ssize_t n = recv(session.fd, buff, sizeof(buff), 0);
+        if (n > 0) {
+            _stats.bytes += n;
+            if (!session.parser.feed(buff, n, on_response)) {
+                return false;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EAGAIN) {
+            return true;
+        }
+        session.parser.eof(on_response);
+        return false;
+    }
+}
+
+/**
+ * @description: 服务器关闭连接时判断回放是否已完整：余下的数据都已发出，应答都已收到
+ * @param {Session} &session
+ * @return {*}
+ */
+bool Replayer::_completed(const Session &session) const {
+    uint64_t expected = session.answered;
+    for (size_t i = session.next; i < session.events.size(); i++) {
+        uint16_t type = session.events[i].type;
+        if (type == CaptureRecord::CLOSE) {
+            break;
+        }
+        if (type == CaptureRecord::DATA || type == CaptureRecord::GAP) {
+            return false;
+        }
+        expected += type == CaptureRecord::RESPONSE;
+    }
+    return session.received >= expected;
+}
+
+void Replayer::run() {
+    std::vector<struct epoll_event> events(1024);
+    _start_ns    = nowNs();
+    size_t alive = _sessions.size();
+    while (alive > 0) {
+        uint64_t now       = nowNs();
+        uint64_t next_wake = now + 100000000ull;
+        alive              = 0;
+        for (auto &session : _sessions) {
+            if (session.done) {
+                continue;
+            }
+            _advance(session, now, next_wake);
+            if (session.blocked && now - session.blocked > _options.timeout_ms * 1000000ull) {
+                _finish(session, true);
+            }
+            alive += !session.done;
+        }
+        int timeout = next_wake > now ? static_cast<int>((next_wake - now + 999999) / 1000000) : 0;
+        int n       = epoll_wait(_epfd, events.data(), events.size(), timeout);
+        for (int i = 0; i < n; i++) {
+            Session &session = *static_cast<Session *>(events[i].data.ptr);
+            if (session.done) {
+                continue;
+            }
+            bool ok = true;
+            if (events[i].events & EPOLLOUT) {
+                ok = _flush(session);
+            }
+            if (ok && (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) {
+                ok = _read(session);
+            }
+            if (!ok) {
+                _finish(session, !_completed(session));
+            }
+        }
+    }
+    _elapsed_ns = nowNs() - _start_ns;
+}
+
+void Replayer::report() const {
+    const Histogram &latency = _stats.latency;
+    double seconds           = _elapsed_ns / 1e9;
+    printf("{\n  \"label\": \"%s\",\n  \"capture\": \"%s\",\n  \"speed\": %.3f,\n  \"connections\": %zu,\n"
+           "  \"capture_duration_s\": %.3f,\n  \"duration_s\": %.3f,\n  \"requests\": %llu,\n  \"errors\": %llu,\n"
+           "  \"rps\": %.1f,\n  \"sent_bytes\": %llu,\n  \"received_bytes\": %llu,\n  \"status\": {",
+           _options.label, _options.path, _options.speed, _sessions.size(), _capture_ns / 1e9, seconds,
+           (unsigned long long)_stats.requests, (unsigned long long)_stats.errors,
+           seconds > 0 ? _stats.requests / seconds : 0.0, (unsigned long long)_stats.sent,
+           (unsigned long long)_stats.bytes);
+    bool first = true;
+    for (auto &status : _stats.status) {
+        printf("%s\"%d\": %llu", first ? "" : ", ", status.first, (unsigned long long)status.second);
+        first = false;
+    }
+    printf("},\n  \"latency_ms\": {\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"p999\": %.3f, "
+           "\"max\": %.3f}\n}\n",
+           latency.count() ? latency.sum() / 1e6 / latency.count() : 0.0, latency.percentile(0.5) / 1e6,
+           latency.percentile(0.9) / 1e6, latency.percentile(0.99) / 1e6, latency.percentile(0.999) / 1e6,
+           latency.max() / 1e6);
+    fprintf(stderr, "%llu requests, %llu errors in %.3f s, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            (unsigned long long)_stats.requests, (unsigned long long)_stats.errors, seconds,
+            latency.percentile(0.5) / 1e6, latency.percentile(0.99) / 1e6, latency.max() / 1e6);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options] CAPTURE\n"
+            "  -u HOST:PORT  server address, default 127.0.0.1:12345\n"
+            "  -s SPEED      time scale, 1 original, 2 twice as fast, 0 no delays, default 1\n"
+            "  -T MS         give up on a connection waiting this long for a response, default 10000\n"
+            "  -l LABEL      label copied into the JSON output\n",
+            name);
+}
+
+int main(int argc, char **argv) {
+    Options options;
+    int opt;
+    while ((opt = getopt(argc, argv, "u:s:T:l:h")) != -1) {
+        switch (opt) {
+        case 'u': {
+            std::string addr = optarg;
+            size_t colon     = addr.rfind(':');
+            options.host     = addr.substr(0, colon);
+            if (colon != std::string::npos) {
+                options.port = atoi(addr.c_str() + colon + 1);
+            }
+            break;
+        }
+        case 's': options.speed = atof(optarg); break;
+        case 'T': options.timeout_ms = atoi(optarg); break;
+        case 'l': options.label = optarg; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (optind != argc - 1 || options.speed < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    options.path = argv[optind];
+    signal(SIGPIPE, SIG_IGN);
+
+    Replayer replayer(options);
+    if (!replayer.load(options.path)) {
+        return 1;
+    }
+    replayer.run();
+    replayer.report();
+    return 0;
+}
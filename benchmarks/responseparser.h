@@ -0,0 +1,173 @@
+/*
+ * @Description: 压测客户端使用的 HTTP 应答边界解析
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:58:14
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:58:14
+ */
+#ifndef RESPONSE_PARSER_H
+#define RESPONSE_PARSER_H
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <strings.h>
+
+/*
+ * 只关心状态码与 body 的边界：支持 Content-Length、chunked 与以关闭连接结束的 body。
+ * 每解析出一个完整应答调用一次 on_response(code)；应答带 Connection: close 时停止解析，closed() 返回 true。
+ */
+class ResponseParser {
+public:
+    ResponseParser() { reset(); }
+
+    void reset() {
+        _in.clear();
+        _pos         = 0;
+        _state       = HEAD;
+        _remain      = 0;
+        _code        = 0;
+        _close_after = false;
+        _closed      = false;
+    }
+
+    bool closed() const { return _closed; }
+
+    /**
+     * @description: 追加读到的数据并解析
+     * @return {*} 应答格式错误时返回 false
+     */
+    template <class F>
+    bool feed(const char *data, size_t len, F &&on_response) {
+        _in.append(data, len);
+        bool ok = _parse(on_response);
+        /* 已解析的部分只在积累较多时前移，避免逐个应答搬移数据 */
+        if (_pos == _in.size()) {
+            _in.clear();
+            _pos = 0;
+        } else if (_pos > 64 * 1024) {
+            _in.erase(0, _pos);
+            _pos = 0;
+        }
+        return ok;
+    }
+
+    /**
+     * @description: 对端关闭连接，结束以关闭连接为界的 body
+     */
+    template <class F>
+    void eof(F &&on_response) {
+        if (_state == UNTIL_CLOSE) {
+            _state = HEAD;
+            on_response(_code);
+        }
+    }
+
+private:
+    enum PARSE_STATE {
+        HEAD,
+        BODY,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_TRAILER,
+        UNTIL_CLOSE,
+    };
+
+    template <class F>
+    bool _parse(F &on_response) {
+        while (!_closed) {
+            const char *data = _in.data() + _pos;
+            size_t len       = _in.size() - _pos;
+            if (_state == HEAD) {
+                const char *end = (const char *)memmem(data, len, "\r\n\r\n", 4);
+                if (!end) {
+                    return true;
+                }
+                if (len < 12 || strncmp(data, "HTTP/1.", 7) != 0) {
+                    return false;
+                }
+                _code            = atoi(data + 9);
+                _remain          = 0;
+                bool chunked     = false;
+                bool has_length  = false;
+                bool close_after = false;
+                for (const char *line = (const char *)memchr(data, '\n', end + 2 - data) + 1; line < end;) {
+                    const char *eol = (const char *)memchr(line, '\r', end + 2 - line);
+                    if (!eol) {
+                        break;
+                    }
+                    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                        _remain    = strtoull(line + 15, nullptr, 10);
+                        has_length = true;
+                    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+                        chunked = memmem(line, eol - line, "chunked", 7) != nullptr;
+                    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+                        close_after = memmem(line, eol - line, "close", 5) != nullptr;
+                    }
+                    line = eol + 2;
+                }
+                _pos += end + 4 - data;
+                _close_after = close_after;
+                if (chunked) {
+                    _state = CHUNK_SIZE;
+                } else if (has_length || _code == 204 || _code == 304) {
+                    _state = BODY;
+                } else {
+                    _state = UNTIL_CLOSE;
+                }
+            } else if (_state == BODY || _state == CHUNK_DATA) {
+                size_t skip = std::min(_remain, len);
+                _pos += skip;
+                _remain -= skip;
+                if (_remain) {
+                    return true;
+                }
+                if (_state == BODY) {
+                    _finish(on_response);
+                } else {
+                    _state = CHUNK_SIZE;
+                }
+            } else if (_state == CHUNK_SIZE || _state == CHUNK_TRAILER) {
+                const char *eol = (const char *)memmem(data, len, "\r\n", 2);
+                if (!eol) {
+                    return true;
+                }
+                _pos += eol + 2 - data;
+                if (_state == CHUNK_TRAILER) {
+                    /* 空行结束 trailer */
+                    if (eol == data) {
+                        _finish(on_response);
+                    }
+                    continue;
+                }
+                size_t size = strtoull(data, nullptr, 16);
+                _state      = size ? CHUNK_DATA : CHUNK_TRAILER;
+                _remain     = size + 2;
+            } else {
+                /* UNTIL_CLOSE：body 持续到连接关闭 */
+                _pos = _in.size();
+                return true;
+            }
+        }
+        return true;
+    }
+
+    template <class F>
+    void _finish(F &on_response) {
+        _state  = HEAD;
+        _closed = _close_after;
+        on_response(_code);
+    }
+
+    std::string _in;
+    size_t _pos;
+    PARSE_STATE _state;
+    size_t _remain;
+    int _code;
+    bool _close_after;
+    bool _closed;
+};
+
+#endif // RESPONSE_PARSER_H
@@ -0,0 +1,76 @@
+#!/bin/bash
+# 在每种 ET 模式与线程池数量下启动 simple_server，用 loadgen 压测并记录结果
+#
+# 用法: benchmarks/run_loadgen.sh [loadgen 参数...]
+#   环境变量:
+#     BUILD_DIR  构建目录，默认 build
+#     MODES      ET 模式列表，默认 "0 1 2 3"
+#     THREADS    线程池数量列表，默认 "2 6"
+#     PORT       服务器端口，默认 12345
+#     OUT_DIR    结果目录，默认 loadgen_results/<时间>
+#   例: MODES="3" THREADS="4 8" benchmarks/run_loadgen.sh -c 256 -t 4 -d 20 -w 2 -R 20000 -f urls.txt
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-build}
+MODES=${MODES:-"0 1 2 3"}
+THREADS=${THREADS:-"2 6"}
+PORT=${PORT:-12345}
+OUT_DIR=${OUT_DIR:-loadgen_results/$(date +%Y%m%d_%H%M%S)}
+
+cd "$ROOT"
+LOADGEN="$BUILD_DIR/benchmarks/loadgen"
+if [ ! -x ./simple_server ] || [ ! -x "$LOADGEN" ]; then
+    echo "build simple_server and loadgen first: cmake --build $BUILD_DIR --target simple_server loadgen" >&2
+    exit 1
+fi
+mkdir -p "$OUT_DIR"
+
+SERVER_PID=
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+}
+trap cleanup EXIT
+
+# 等待端口可连接
+wait_port() {
+    for _ in $(seq 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+printf "mode\tthreads\trps\terrors\tp50_ms\tp99_ms\tp999_ms\tmax_ms\n" > "$OUT_DIR/summary.tsv"
+for mode in $MODES; do
+    for threads in $THREADS; do
+        name="mode${mode}_threads${threads}"
+        # 日志等级 3 只记录错误，避免日志写入成为瓶颈
+        ./simple_server -p "$PORT" -m "$mode" -t "$threads" -l 3 > "$OUT_DIR/$name.server.log" 2>&1 &
+        SERVER_PID=$!
+        if ! wait_port; then
+            echo "$name: server did not start" >&2
+            cleanup
+            SERVER_PID=
+            continue
+        fi
+        echo "== $name" >&2
+        "$LOADGEN" -u "127.0.0.1:$PORT" -l "$name" "$@" > "$OUT_DIR/$name.json"
+        cleanup
+        SERVER_PID=
+        python3 - "$OUT_DIR/$name.json" "$mode" "$threads" >> "$OUT_DIR/summary.tsv" <<'PY'
+import json, sys
+r = json.load(open(sys.argv[1]))
+l = r["latency_ms"]
+print("\t".join([sys.argv[2], sys.argv[3], "%.1f" % r["rps"], str(r["errors"]),
+                 "%.3f" % l["p50"], "%.3f" % l["p99"], "%.3f" % l["p999"], "%.3f" % l["max"]]))
+PY
+    done
+done
+cat "$OUT_DIR/summary.tsv" >&2
+echo "results in $OUT_DIR" >&2
@@ -0,0 +1,80 @@
+#!/bin/bash
+# 两阶段 PGO 构建：插桩构建 simple_server，用 loadgen(或 replay 回放采集的流量)训练，再以 profile 重新构建
+#
+# 用法: benchmarks/run_pgo.sh [cmake 参数...]
+#   环境变量:
+#     BUILD_DIR  构建目录，两阶段共用，默认 build-pgo
+#     PORT       训练时服务器端口，默认 12345
+#     URLS       loadgen 请求组合，默认 benchmarks/pgo_urls.txt
+#     DURATION   loadgen 训练时长(秒)，默认 20
+#     CAPTURE    流量采集文件，设置时改用 replay 训练
+#   例: benchmarks/run_pgo.sh -DMARCH=native -DENABLE_LTO=ON
+#   完成后 ./simple_server 即为使用 profile 构建的版本
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+BUILD_DIR=${BUILD_DIR:-build-pgo}
+PORT=${PORT:-12345}
+URLS=${URLS:-benchmarks/pgo_urls.txt}
+DURATION=${DURATION:-20}
+PROFILE_DIR="$ROOT/$BUILD_DIR/pgo-profiles"
+
+cd "$ROOT"
+
+SERVER_PID=
+cleanup() {
+    if [ -n "$SERVER_PID" ]; then
+        kill "$SERVER_PID" 2>/dev/null || true
+        wait "$SERVER_PID" 2>/dev/null || true
+    fi
+}
+trap cleanup EXIT
+
+# 等待端口可连接
+wait_port() {
+    for _ in $(seq 50); do
+        if (exec 3<>"/dev/tcp/127.0.0.1/$PORT") 2>/dev/null; then
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+echo "== instrumented build" >&2
+cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release -DPGO=generate -DPGO_DIR="$PROFILE_DIR" "$@" > /dev/null
+cmake --build "$BUILD_DIR" --target simple_server loadgen replay -j"$(nproc)" > /dev/null
+rm -rf "$PROFILE_DIR"
+
+echo "== training" >&2
+# 日志等级 3 只记录错误，训练集中在请求处理路径上
+./simple_server -p "$PORT" -l 3 > "$BUILD_DIR/pgo-train.log" 2>&1 &
+SERVER_PID=$!
+if ! wait_port; then
+    echo "server did not start, see $BUILD_DIR/pgo-train.log" >&2
+    exit 1
+fi
+if [ -n "$CAPTURE" ]; then
+    "$BUILD_DIR/benchmarks/replay" -u "127.0.0.1:$PORT" -s 0 "$CAPTURE" > /dev/null
+else
+    "$BUILD_DIR/benchmarks/loadgen" -u "127.0.0.1:$PORT" -c 32 -d "$DURATION" -f "$URLS" > /dev/null
+    "$BUILD_DIR/benchmarks/loadgen" -u "127.0.0.1:$PORT" -c 8 -d 2 -n -f "$URLS" > /dev/null
+fi
+# SIGTERM 使服务器从 main 返回，插桩代码在退出时写出 profile
+kill -TERM "$SERVER_PID"
+wait "$SERVER_PID" || true
+SERVER_PID=
+
+if [ -z "$(ls -A "$PROFILE_DIR" 2>/dev/null)" ]; then
+    echo "no profile written to $PROFILE_DIR" >&2
+    exit 1
+fi
+if ls "$PROFILE_DIR"/*.profraw > /dev/null 2>&1; then
+    llvm-profdata merge -o "$PROFILE_DIR/default.profdata" "$PROFILE_DIR"/*.profraw
+fi
+
+echo "== optimized build" >&2
+cmake -S . -B "$BUILD_DIR" -DPGO=use > /dev/null
+cmake --build "$BUILD_DIR" --target clean
+cmake --build "$BUILD_DIR" -j"$(nproc)" > /dev/null
+echo "profiles in $PROFILE_DIR, ./simple_server rebuilt with them" >&2
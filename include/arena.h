@@ -0,0 +1,104 @@
+/*
+ * @Description: 单请求生命周期的线性(bump)内存分配器
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 10:40:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 10:40:18
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <assert.h>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "bufferpool.h"
+
+class Arena {
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena &)            = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    void *allocate(size_t len, size_t align = alignof(std::max_align_t));
+
+    char *copy(const char *str, size_t len);
+
+    std::string_view concat(std::string_view lhs, std::string_view rhs);
+
+    void reset();
+
+    void release();
+
+    size_t capacity() const { return _capacity; }
+
+    size_t heapAllocs() const { return _heap_allocs; }
+
+    static size_t totalHeapAllocs() { return total_heap_allocs; }
+
+private:
+    void _newBlock(size_t len);
+
+    size_t _capacity;
+    size_t _cur_block;
+    size_t _offset;
+    size_t _heap_allocs;
+    std::vector<std::vector<char>> _blocks;
+
+    static std::atomic<size_t> total_heap_allocs;
+};
+
+/* 供标准容器使用的 arena 分配器，arena 为空时退化为堆分配 */
+template <class T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator(Arena *arena = nullptr) noexcept
+        : _arena(arena) {}
+
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U> &other) noexcept
+        : _arena(other.arena()) {}
+
+    T *allocate(size_t n) {
+        if (_arena) {
+            return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *p, size_t) noexcept {
+        /* arena 内存随 reset 统一回收 */
+        if (!_arena) {
+            ::operator delete(p);
+        }
+    }
+
+    Arena *arena() const { return _arena; }
+
+private:
+    Arena *_arena;
+};
+
+template <class T, class U>
+bool operator==(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs) {
+    return lhs.arena() == rhs.arena();
+}
+
+template <class T, class U>
+bool operator!=(const ArenaAllocator<T> &lhs, const ArenaAllocator<U> &rhs) {
+    return lhs.arena() != rhs.arena();
+}
+
+#endif // ARENA_H
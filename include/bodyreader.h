@@ -0,0 +1,98 @@
+/*
+ * @Description: 请求 body 的增量读取，支持 Content-Length 与 chunked 编码，跨多次 readFd 以切片形式交付
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 14:20:11
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 14:20:11
+ */
+#ifndef BODY_READER_H
+#define BODY_READER_H
+
+#include <string_view>
+
+#include "arena.h"
+#include "buffer.h"
+
+/* body 数据的接收者，切片只在回调期间有效 */
+class BodySink {
+public:
+    virtual ~BodySink() = default;
+
+    /* 返回 false 时终止读取，请求以 errorCode() 应答 */
+    virtual bool onBodyData(std::string_view slice) = 0;
+
+    virtual bool onBodyEnd() { return true; }
+
+    virtual int errorCode() const { return 400; }
+};
+
+/* 默认接收者：将 body 收集到 arena 中，超过上限时拒绝 */
+class BodyCollector : public BodySink {
+public:
+    BodyCollector() { init(nullptr, 0, 0); }
+
+    void init(Arena *arena, size_t hint, size_t limit);
+
+    bool onBodyData(std::string_view slice) override;
+
+    int errorCode() const override { return 413; }
+
+    char *data() { return _data; }
+
+    size_t size() const { return _size; }
+
+private:
+    Arena *_arena;
+    char *_data;
+    size_t _size;
+    size_t _capacity;
+    size_t _hint;
+    size_t _limit;
+};
+
+class BodyReader {
+public:
+    enum READ_STATE {
+        NONE = 0,
+        LENGTH,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_CRLF,
+        TRAILER,
+        DONE,
+        ERROR,
+    };
+
+    BodyReader() { init(); }
+
+    void init();
+
+    void initLength(size_t len);
+
+    void initChunked();
+
+    READ_STATE feed(Buffer &buff, BodySink *sink);
+
+    READ_STATE state() const { return _state; }
+
+    size_t received() const { return _received; }
+
+    int errorCode() const { return _error_code; }
+
+    static size_t max_body_size;  /* body 总长度上限 */
+    static size_t max_chunk_line; /* chunk-size 行与 trailer 行的长度上限 */
+
+private:
+    READ_STATE _deliver(Buffer &buff, BodySink *sink, READ_STATE next);
+    READ_STATE _parseChunkSize(std::string_view line);
+    READ_STATE _fail(int code);
+
+    READ_STATE _state;
+    size_t _remaining;
+    size_t _received;
+    size_t _trailer_bytes;
+    int _error_code;
+};
+
+#endif // BODY_READER_H
@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-20 18:00:45
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:45:24
+ * @LastEditTime: 2026-10-19 12:16:02
  */
 #ifndef BUFFER_H
 #define BUFFER_H
@@ -13,10 +13,14 @@
 #include <atomic>
 #include <cstring>
 #include <iostream>
+#include <string>
+#include <string_view>
 #include <sys/uio.h>
 #include <unistd.h>
 #include <vector>
 
+#include "bufferpool.h"
+
 class Buffer {
 public:
     Buffer(int init_buffsize = 1024);
@@ -44,7 +48,7 @@ public:
 
     char *beginWrite();
 
-    void append(const std::string &str);
+    void append(std::string_view str);
 
     void append(const char *str, size_t len);
 
@@ -54,9 +58,15 @@ public:
 
     ssize_t writeFd(int fd, int *save_errno);
 
+    void shrink();
+
+    size_t capacity() const;
+
 private:
     char *_beginPtr();
 
+    void _restore(size_t len);
+
     void _expandBuffer(size_t len);
 
     std::vector<char> _buffer;
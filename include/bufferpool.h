@@ -0,0 +1,65 @@
+/*
+ * @Description: 缓冲区内存池，回收空闲连接的缓冲区供活跃连接复用，每个线程先在本线程的缓存中取还
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 09:12:40
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+class BufferPool {
+public:
+    static BufferPool *getInstance();
+
+    void init(size_t block_size, size_t max_blocks);
+
+    std::vector<char> acquire(size_t len);
+
+    void release(std::vector<char> &block);
+
+    size_t blockSize() const { return _block_size; }
+
+    /* 只统计全局池，不含各线程缓存中的块 */
+    size_t pooledBlocks();
+
+    size_t pooledBytes();
+
+    size_t heapAllocs() const { return _heap_allocs; }
+
+private:
+    BufferPool();
+    ~BufferPool() = default;
+
+    static const size_t DEFAULT_BLOCK_SIZE = 1024;
+    static const size_t DEFAULT_MAX_BLOCKS = 4096;
+    static constexpr size_t LOCAL_MAX_BLOCKS = 64; /* 线程缓存上限，超出时成批归还全局池 */
+    static constexpr size_t LOCAL_BATCH      = 32; /* 线程缓存与全局池之间一次移动的块数 */
+
+    typedef std::vector<std::vector<char>> BlockList;
+
+    /* 线程退出时缓存的块归还全局池 */
+    struct LocalCache {
+        BlockList blocks;
+        ~LocalCache();
+    };
+
+    void _refill(BlockList &local);
+    void _flush(BlockList &local, size_t count);
+
+    size_t _block_size;
+    size_t _max_blocks;
+    std::atomic<size_t> _heap_allocs; /* 池中无可用块时向堆申请的次数 */
+
+    std::mutex _mtx;
+    BlockList _free_blocks;
+
+    static thread_local LocalCache _local;
+};
+
+#endif // BUFFER_POOL_H
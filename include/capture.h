@@ -0,0 +1,72 @@
+/*
+ * @Description: 请求流量采集，按连接抽样记录原始请求字节与时间，供 replay 回放
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:58:14
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:58:14
+ */
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+
+/*
+ * 文件格式：8 字节魔数 CAPTURE_MAGIC，之后是连续的记录，每条记录为 CaptureRecord 加 len 字节数据。
+ * 只有 DATA 记录带数据；GAP 的 len 为未采集的字节数(splice 落盘的上传 body)，
+ * RESPONSE 的 len 为应答状态码，标记一个请求的结束，回放时据此等待应答后再发送下一请求。
+ * 整个连接要么全部记录要么全部跳过，回放能够复现连接复用的方式。
+ * 记录经 writev 直接写入文件，进程异常退出时已写出的记录不丢失；超出容量上限后停止采集。
+ */
+static const char CAPTURE_MAGIC[8] = {'W', 'S', 'C', 'A', 'P', '0', '0', '1'};
+
+struct CaptureRecord {
+    enum TYPE : uint16_t {
+        OPEN = 0,
+        DATA,
+        GAP,
+        RESPONSE,
+        CLOSE,
+    };
+
+    uint64_t time_ns; /* 距开始采集的时间 */
+    uint32_t conn;    /* 连接编号，从 1 开始 */
+    uint16_t type;
+    uint16_t reserved;
+    uint32_t len;
+};
+
+class TrafficCapture {
+public:
+    TrafficCapture(double sample_rate, size_t max_bytes);
+    ~TrafficCapture();
+
+    TrafficCapture(const TrafficCapture &)            = delete;
+    TrafficCapture &operator=(const TrafficCapture &) = delete;
+
+    bool open(const char *path);
+
+    uint32_t sample();
+    void record(uint32_t conn, CaptureRecord::TYPE type, const char *data = nullptr, uint32_t len = 0);
+
+    size_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+
+private:
+    uint64_t _now() const;
+
+    int _fd;
+    std::string _path;
+    double _sample_rate;
+    size_t _max_bytes;
+    uint64_t _start_ns;
+
+    std::mutex _mtx;
+    std::atomic<uint32_t> _seq;
+    std::atomic<size_t> _bytes;
+    std::atomic<bool> _full;
+};
+
+#endif // CAPTURE_H
@@ -0,0 +1,111 @@
+/*
+ * @Description: 本地用户凭据存储，追加写的记录日志 + mmap 的开放寻址哈希索引，启动时加载，查询无需访问数据库
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:12:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:58
+ */
+#ifndef CREDENTIAL_STORE_H
+#define CREDENTIAL_STORE_H
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+
+#include "sha256.h"
+
+/*
+ * 磁盘格式：
+ *   users.log  记录依次追加，每条为 Record 定长头 + 用户名，同名用户以最后一条为准
+ *   users.idx  IndexHeader + capacity 个 Slot，线性探测；Slot.tag 为用户名哈希(最低位恒为 1，0 表示空槽)，
+ *              Slot.offset 为记录在日志中的偏移。索引可由日志完全重建，header.log_size 记录已建索引的日志长度
+ * 共享模式(多进程)下各进程共享日志，不使用索引文件，索引建在各自的匿名内存中：
+ *   追加时持有日志的 flock 排他锁，先补齐其他进程追加的记录再检查重名；查不到用户时先补齐再查一次
+ */
+class CredentialStore {
+public:
+    enum RESULT {
+        OK = 0,
+        NOT_FOUND,
+        WRONG_PASSWORD,
+        EXISTS,
+        INVALID,
+        IO_ERROR,
+    };
+
+    CredentialStore();
+    ~CredentialStore();
+
+    bool open(const char *dir, bool shared = false);
+    void close();
+    bool isOpen() const { return _log_fd >= 0; }
+
+    RESULT verify(std::string_view name, std::string_view password);
+    RESULT add(std::string_view name, std::string_view password);
+
+    size_t size() const;
+
+    static std::string encodePassword(std::string_view password);
+    static bool checkPassword(std::string_view encoded, std::string_view password);
+
+    static uint32_t iterations;            /* 新建用户的 PBKDF2 迭代次数，记录中保存各自的次数 */
+    static const size_t MAX_NAME_LEN = 64; /* 用户名上限 */
+
+private:
+    static const uint32_t LOG_MAGIC    = 0x44455243; /* "CRED" */
+    static const uint32_t INDEX_MAGIC  = 0x58444943; /* "CIDX" */
+    static const size_t SALT_SIZE      = 16;
+    static const uint64_t MIN_CAPACITY = 1024; /* 槽位数，保持 2 的幂 */
+
+    struct Record {
+        uint32_t magic;
+        uint32_t iterations;
+        uint8_t name_len;
+        uint8_t reserved[7];
+        uint8_t salt[SALT_SIZE];
+        uint8_t hash[Sha256::DIGEST_SIZE];
+    };
+
+    struct IndexHeader {
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t seed; /* 哈希种子，创建索引时随机生成 */
+        uint64_t capacity;
+        uint64_t count;
+        uint64_t log_size;
+    };
+
+    struct Slot {
+        uint64_t tag;
+        uint64_t offset;
+    };
+
+    bool _loadIndex();
+    bool _rebuildIndex(uint64_t capacity);
+    bool _replay(bool truncate);
+    bool _catchUp();
+    RESULT _append(uint64_t tag, std::string_view name, const char *buff, size_t len);
+    bool _insert(uint64_t tag, uint64_t offset, std::string_view name);
+    Slot *_find(uint64_t tag, std::string_view name, Record *record) const;
+    bool _readRecord(uint64_t offset, Record *record, std::string_view name) const;
+    void _unmapIndex();
+    uint64_t _tag(std::string_view name) const;
+
+    static bool _validName(std::string_view name);
+    static bool _equal(const uint8_t *lhs, const uint8_t *rhs, size_t len);
+    static bool _fromHex(std::string_view hex, uint8_t *out);
+
+    std::string _log_path;
+    std::string _index_path;
+    int _log_fd;
+    int _index_fd;
+    IndexHeader *_header; /* 映射的索引文件 */
+    Slot *_slots;
+    size_t _map_size;
+    bool _shared;
+    mutable std::shared_mutex _mtx; /* 查询共享，追加、补齐与扩容独占 */
+};
+
+#endif // CREDENTIAL_STORE_H
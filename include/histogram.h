@@ -0,0 +1,67 @@
+/*
+ * @Description: HDR 风格的对数-线性分桶直方图，用于延迟分位数
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 19:21:07
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:31:52
+ */
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+ * 小于 SUB_COUNT 的值各占一个桶；之后每个 2 的幂区间均分为 SUB_COUNT / 2 个桶，
+ * 相对误差不超过 1/32，桶数只随量程对数增长。以纳秒为单位时量程约 36 分钟，超出的值计入最后一个桶。
+ * 记录只需一次前导零计数与移位，由调用方在各线程独占的计数数组上完成(见 Metrics)，这里负责合并后的统计。
+ */
+class Histogram {
+public:
+    static const int SUB_BITS  = 6;
+    static const int SUB_COUNT = 1 << SUB_BITS;
+    static const int HALF      = SUB_COUNT / 2;
+    static const int MAX_SHIFT = 35;
+    static const int BUCKETS   = SUB_COUNT + MAX_SHIFT * HALF;
+
+    static int index(uint64_t value) {
+        if (value < (uint64_t)SUB_COUNT) {
+            return static_cast<int>(value);
+        }
+        int shift = 63 - __builtin_clzll(value) - (SUB_BITS - 1);
+        if (shift > MAX_SHIFT) {
+            return BUCKETS - 1;
+        }
+        return SUB_COUNT + (shift - 1) * HALF + static_cast<int>(value >> shift) - HALF;
+    }
+    static uint64_t highest(int index);
+
+    Histogram();
+
+    void add(int index, uint64_t count) {
+        _counts[index] += count;
+        _total += count;
+    }
+    void addSum(uint64_t sum) { _sum += sum; }
+    void addMax(uint64_t max) { _max = max > _max ? max : _max; }
+    void record(uint64_t value) {
+        add(index(value), 1);
+        addSum(value);
+        addMax(value);
+    }
+    void merge(const Histogram &other);
+
+    uint64_t percentile(double quantile) const;
+    uint64_t count() const { return _total; }
+    uint64_t sum() const { return _sum; }
+    uint64_t max() const { return _max; }
+
+private:
+    std::vector<uint64_t> _counts;
+    uint64_t _total;
+    uint64_t _sum;
+    uint64_t _max;
+};
+
+#endif // HISTOGRAM_H
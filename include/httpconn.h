@@ -4,21 +4,44 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:03:39
+ * @LastEditTime: 2026-10-19 23:59:47
  */
 #ifndef HTTP_CONN_H
 #define HTTP_CONN_H
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <functional>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 
+#include "arena.h"
 #include "logger.h"
 #include "buffer.h"
+#include "capture.h"
+#include "metrics.h"
+#include "probes.h"
 #include "httprequest.h"
 #include "httpresponse.h"
+#include "router.h"
+#include "tracer.h"
+#include "uploadfile.h"
+
+/* 单个连接的内存占用明细，单位字节 */
+struct ConnMemInfo {
+    size_t conn;       /* HttpConn 对象本身 */
+    size_t read_buff;  /* 读缓冲区 */
+    size_t write_buff; /* 写缓冲区 */
+    size_t arena;      /* 请求/响应状态所在的 arena */
+
+    size_t total() const {
+        return conn + read_buff + write_buff + arena;
+    }
+};
+
+/* 落盘上传完成后的处理函数，fd 为 body 所在的临时文件，返回的状态码(100-599)原样写入响应行 */
+typedef std::function<int(const HttpRequest &request, int fd, size_t len)> UploadHandler;
 
 class HttpConn {
 public:
@@ -49,18 +72,82 @@ public:
     }
 
     bool isKeepAlive() const {
-        return _request.isKeepAlive();
+        return _request.isKeepAlive() && _response.isKeepAlive();
+    }
+
+    /* 由工作线程写入，事件循环在优雅退出时读取 */
+    bool isIdle() const {
+        return _is_idle;
+    }
+
+    bool isClosed() const {
+        return _is_close;
+    }
+
+    size_t readableBytes() const {
+        return _read_buff.readableBytes();
+    }
+
+    uint32_t traceId() const {
+        return _trace_id;
+    }
+
+    bool isDeferred() const {
+        return _response.isDeferred();
     }
 
+    void runDeferred();
+
+    /* 只在事件循环中调用，见 HttpResponse::cancel */
+    HttpResponse::CANCEL_RESULT cancelDeferred() {
+        return _response.cancel();
+    }
+
+    /* 只由事件循环访问：已派发给工作线程，尚未因重新注册收到事件，期间连接由工作线程或延后应答的完成方持有 */
+    bool isDispatched() const {
+        return _dispatched;
+    }
+
+    void setDispatched(bool dispatched) {
+        _dispatched = dispatched;
+    }
+
+    ConnMemInfo memInfo() const;
+
     static bool is_et;
     static const char *src_dir;
     static std::atomic<int> user_count;
+    static const char *upload_dir;
+    static UploadHandler upload_handler;
+    static const Router *router; /* 启动前注册完毕，运行期只读 */
+    static std::function<void(HttpConn *)> resume_handler; /* 延后的应答构造完毕，重新注册写事件 */
+    static TrafficCapture *capture; /* 为空时不采集 */
+    static std::atomic<bool> draining; /* 优雅退出中，此后的应答均带 Connection: close */
 
 private:
+    static const size_t READ_HIGH_WATER = 64 * 1024;
+
+    void _shed();
+    bool _onUploadStart();
+    bool _onUploadComplete();
+    void _dispatch();
+    void _onResume();
+    void _prepareWrite();
+
     int _fd;
     struct sockaddr_in _addr;
 
-    bool _is_close;
+    std::atomic<bool> _is_close;
+    std::atomic<bool> _is_idle;
+    bool _dispatched;
+
+    /* 阶段耗时的起点，为 0 表示未在计时 */
+    uint64_t _accepted_ns; // 建立连接，读到第一个字节时结束
+    uint64_t _ready_ns;    // 应答就绪，最后一个字节写出时结束
+    uint64_t _idle_ns;     // 应答写完，下一请求到达时结束
+
+    uint32_t _capture_id; // 流量采集中的连接编号，0 表示未被抽中
+    uint32_t _trace_id;   // 追踪中的连接编号，0 表示未被抽中
 
     int _iov_cnt;
     struct iovec _iov[2];
@@ -68,8 +155,10 @@ private:
     Buffer _read_buff;  // 读缓冲区
     Buffer _write_buff; // 写缓冲区
 
+    Arena _arena; // 单请求内存，请求间 O(1) 重置
     HttpRequest _request;
     HttpResponse _response;
+    UploadFile _upload; // 大文件上传的临时文件，body 不经过读缓冲区
 };
 
 #endif // HTTP_CONN_H
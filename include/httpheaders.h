@@ -0,0 +1,62 @@
+/*
+ * @Description: http 首部表，常用首部解析时直接落入固定槽位，其余首部存入 arena 中的线性表
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 13:02:15
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:31:52
+ */
+#ifndef HTTP_HEADERS_H
+#define HTTP_HEADERS_H
+
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+
+typedef std::pair<std::string_view, std::string_view> HttpField;
+typedef std::vector<HttpField, ArenaAllocator<HttpField>> HttpFieldList;
+
+class HttpHeaders {
+public:
+    enum KNOWN_HEADER {
+        CONNECTION = 0,
+        CONTENT_LENGTH,
+        CONTENT_TYPE,
+        HOST,
+        ACCEPT_ENCODING,
+        IF_NONE_MATCH,
+        RANGE,
+        TRANSFER_ENCODING,
+        COOKIE,
+        KNOWN_COUNT,
+    };
+
+    HttpHeaders() { init(nullptr); }
+
+    void init(Arena *arena);
+
+    bool add(std::string_view name, std::string_view value);
+
+    std::string_view get(KNOWN_HEADER key) const { return _known[key]; }
+
+    bool has(KNOWN_HEADER key) const { return _known[key].data() != nullptr; }
+
+    std::string_view get(std::string_view name) const;
+
+    const HttpFieldList &others() const { return _others; }
+
+    static int lookup(std::string_view name);
+
+    static std::string_view name(KNOWN_HEADER key);
+
+    static bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs);
+
+private:
+    Arena *_arena;
+    std::string_view _known[KNOWN_COUNT];
+    HttpFieldList _others;
+};
+
+#endif // HTTP_HEADERS_H
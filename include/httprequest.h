@@ -4,19 +4,26 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:03:47
+ * @LastEditTime: 2026-10-19 21:46:03
  */
 #ifndef HTTP_REQUEST_H
 #define HTTP_REQUEST_H
 
+#include <algorithm>
 #include <errno.h>
-#include <regex>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "arena.h"
+#include "bodyreader.h"
 #include "buffer.h"
+#include "httpheaders.h"
+#include "json.h"
 #include "logger.h"
+#include "multipart.h"
+#include "router.h"
 
 class HttpRequest {
 public:
@@ -24,6 +31,7 @@ public:
         REQUEST_LINE,
         HEADERS,
         BODY,
+        UPLOAD,
         FINISH,
     };
 
@@ -36,48 +44,87 @@ public:
         FILE_REQUEST,
         INTERNAL_ERROR,
         CLOSED_CONNECTION,
+        UPLOAD_REQUEST,
     };
 
-    HttpRequest() { init(); }
+    HttpRequest() { init(nullptr); }
     ~HttpRequest() = default;
 
-    void init();
-    bool parse(Buffer &buff);
+    void init(Arena *arena);
+    HTTP_CODE parse(Buffer &buff);
 
-    std::string path() const;
-    std::string &path();
-    std::string method() const;
-    std::string version() const;
-    std::string getPost(const std::string &key) const;
-    std::string getPost(const char *key) const;
+    std::string_view path() const;
+    std::string_view target() const { return _target; }
+    std::string_view method() const;
+    std::string_view version() const;
+    std::string_view getHeader(std::string_view key) const;
+    std::string_view getHeader(HttpHeaders::KNOWN_HEADER key) const;
+    const HttpHeaders &headers() const { return _header; }
+    std::string_view getPost(std::string_view key) const;
+    std::string_view getQuery(std::string_view key) const;
+    std::string_view getCookie(std::string_view name) const;
+    const HttpFieldList &queries() const { return _query; }
+    std::string_view getParam(std::string_view key) const;
+    const HttpFieldList &params() const { return _params; }
+    const MultipartPartList &parts() const { return _parts.parts(); }
+    JsonValue json() const { return _json.root(); }
+    std::string_view body() const { return _body; }
+    size_t bodyLength() const { return _body_reader.received(); }
+    size_t contentLength() const { return _content_length; }
+    void setBodySink(BodySink *sink) { _sink = sink; }
+    void endUpload(int error_code);
+    int route(const Router &router, const RouteHandler **handler);
 
+    PARSE_STATE state() const { return _state; }
+    int errorCode() const { return _error_code; }
     bool isKeepAlive() const;
 
-    /*
-    todo
-    void HttpConn::ParseFormData() {}
-    void HttpConn::ParseJson() {}
-    */
+    void release();
+
+    static size_t max_header_size;   /* 请求行与首部的总长度上限 */
+    static size_t max_buffered_body; /* 未指定 BodySink 时，收集到内存中的 body 上限 */
+    static size_t upload_threshold;  /* Content-Length 不小于该值的 POST/PUT 转为落盘上传，0 为关闭 */
+    static size_t max_upload_size;   /* 落盘上传的 body 上限 */
+    static std::function<bool(std::string_view path)> raw_body_filter; /* 返回 true 的路径 body 原样保留，不做表单解析，也不转为落盘上传 */
 
 private:
-    bool _parseRequestLine(const std::string &line);
-    void _parseHeader(const std::string &line);
-    void _parseBody(const std::string &line);
+    bool _parseRequestLine(std::string_view line);
+    bool _parseHeader(std::string_view line);
+    bool _onHeadersComplete();
+    bool _isUpload() const;
+    bool _isMultipart() const;
+    void _onBodyComplete();
+    HTTP_CODE _fail(int code);
+    HTTP_CODE _parseBuffer(Buffer &buff);
+
+    void _parsePost(char *body, size_t len);
+    void _parseQuery(std::string_view query);
+    void _parseFormData();
+    bool _parseJson(char *body, size_t len);
 
-    void _parsePath();
-    void _parsePost();
-    void _parseFromUrlencoded();
+    std::string_view _save(std::string_view str);
 
-    static bool _userVerify(const std::string &name, const std::string &pwd, bool isLogin);
-    static int _converHex(char ch);
+    static std::string_view _find(const HttpFieldList &fields, std::string_view key);
 
+    Arena *_arena;
     PARSE_STATE _state;
-    std::string _method, _path, _version, _body;
-    std::unordered_map<std::string, std::string> _header;
-    std::unordered_map<std::string, std::string> _post;
+    int _error_code;
+    size_t _header_bytes;
+    size_t _content_length;
+    std::string_view _method, _path, _version, _body;
+    std::string_view _target; /* 原始请求目标，含查询串，_path 为其前缀 */
+    bool _raw_body;
+    HttpHeaders _header;
+    HttpFieldList _post;
+    HttpFieldList _query;
+    HttpFieldList _params; /* 路由参数，值指向 _path */
 
-    static const std::unordered_set<std::string> DEFAULT_HTML;
-    static const std::unordered_map<std::string, int> DEFAULT_HTML_TAG;
+    BodyReader _body_reader;
+    BodyCollector _collector;
+    BodySink *_sink;
+    MultipartParser _multipart;
+    MultipartCollector _parts;
+    JsonDocument _json;
 };
 
 #endif // HTTP_REQUEST_H
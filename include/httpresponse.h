@@ -4,17 +4,22 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:50:29
+ * @LastEditTime: 2026-10-19 23:44:10
  */
 #ifndef HTTP_RESPONSE_H
 #define HTTP_RESPONSE_H
 
+#include <atomic>
 #include <fcntl.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
-#include <unordered_map>
 
+#include "arena.h"
 #include "buffer.h"
 #include "logger.h"
 
@@ -23,34 +28,103 @@ public:
     HttpResponse();
     ~HttpResponse();
 
-    void init(const std::string &src_dir, std::string &path, bool is_keep_alive = false, int code = -1);
+    void init(Arena *arena, std::string_view src_dir, std::string_view path,
+              bool is_keep_alive = false, int code = -1);
     void makeResponse(Buffer &buff);
+    void makeStatusResponse(Buffer &buff);
     void unmapFile();
     char *file();
     size_t fileLen() const;
     int code() const { return _code; }
+    void setCode(int code) { _code = code; }
+    void setPath(std::string_view path);
+    void setContent(std::string_view content, std::string_view type);
+    void setContent(std::shared_ptr<const std::string> content, std::string_view type);
+    void addHeader(std::string_view name, std::string_view value);
+    void addHeaderLines(std::string_view lines);
+    void release();
+
+    /* 处理函数无法立即给出结果时调用：task 在请求线程交还连接前执行，结果就绪后由任意线程调用 resume() 发出应答 */
+    void defer(std::function<void()> task);
+    bool isDeferred() const { return static_cast<bool>(_deferred); }
+    std::function<void()> takeDeferred();
+    void runDeferred();
+    void resume();
+
+    /* 连接可能在延后期间被事件循环关闭：其他线程的完成方须先以 defer 时取得的 token 调用 claim，失败表示已被 cancel 撤销，
+       此后不得再访问应答；cancel 只能由事件循环调用，完成方已 claim 或请求线程尚未交出时返回 BUSY */
+    enum CANCEL_RESULT { NOT_DEFERRED, CANCELLED, BUSY };
+    uint32_t deferToken() const { return _defer_state.load(std::memory_order_relaxed) & ~DEFER_STATE_MASK; }
+    bool claim(uint32_t token);
+    CANCEL_RESULT cancel();
+    void setResumeHandler(std::function<void()> handler) { _resume_handler = std::move(handler); }
+
+    /* 结果就绪时(同步返回由调用方触发，延后时在 resume 中)先于发出应答调用一次，用于共享结果给其他请求 */
+    void setCompleteHandler(std::function<void(HttpResponse &)> handler) { _complete_handler = std::move(handler); }
+    void complete();
+    void abandon(int code);
+
+    /* 缓冲模式下处理函数须以 setContent 给出完整应答，不得直接写 socket；不可共享的结果以 setCacheable 标记，Set-Cookie 自动标记 */
+    void setBuffered(bool buffered) { _buffered = buffered; }
+    bool isBuffered() const { return _buffered; }
+    void setCacheable(bool cacheable) { _cacheable = cacheable; }
+    bool isCacheable() const { return _cacheable; }
+    std::string_view path() const { return _path; }
+    std::string_view content() const { return _content; }
+    std::string_view contentType() const { return _content_type; }
+    std::string_view headerLines() const { return _extra_headers; }
+    bool hasContent() const { return _content.data() != nullptr; }
+
+    /* 延后期间处理函数可直接向客户端 socket 写出应答(如反向代理流式转发)，完成后以 setSent 标记再 resume */
+    int socket() const { return _socket; }
+    void setSocket(int fd) { _socket = fd; }
+    void setSent(bool keep_alive);
+    bool isKeepAlive() const { return _is_keep_alive; }
+
+    static std::string_view mimeType(std::string_view suffix);
+    static std::string_view statusText(int code);
 
 private:
     void _addStateLine(Buffer &buff);
-    void _addHeader(Buffer &buff);
+    void _addHeader(Buffer &buff, std::string_view type);
     void _addContent(Buffer &buff);
-    void _errorContent(Buffer &buff, std::string message);
+    void _statusContent(Buffer &buff, const char *message);
 
     void _errorHtml();
-    std::string _getFileType();
+    void _makeFilePath();
+    std::string_view _getFileType();
+
+    /* _defer_state 低两位为状态，其余为每次 defer 递增的代数 */
+    static const uint32_t DEFER_STATE_MASK = 3;
+    static const uint32_t DEFER_NONE       = 0;
+    static const uint32_t DEFER_RUNNING    = 1; /* 请求线程仍在执行延后的任务 */
+    static const uint32_t DEFER_WAITING    = 2; /* 已交给完成方，可被撤销 */
+    static const uint32_t DEFER_CLAIMED    = 3; /* 完成方正在写入结果 */
 
     int _code;
     bool _is_keep_alive;
+    bool _sent; /* 应答已由处理函数写出，makeResponse 不再生成内容 */
+    bool _buffered;
+    bool _cacheable;
+    int _socket;
+
+    Arena *_arena;
+    std::string_view _path;
+    std::string_view _src_dir;
+    const char *_file_path;
 
-    std::string _path;
-    std::string _src_dir;
+    std::string_view _content; /* 处理函数生成的 body，位于 arena 中 */
+    std::string_view _content_type;
+    std::string_view _extra_headers; /* 处理函数追加的头部行，位于 arena 中 */
+    std::shared_ptr<const std::string> _shared_content; /* 共享的 body(如缓存结果)，写出期间持有，经 file() 零拷贝发送 */
+
+    std::function<void()> _deferred;
+    std::atomic<uint32_t> _defer_state;
+    std::function<void()> _resume_handler; /* 由所属连接设置 */
+    std::function<void(HttpResponse &)> _complete_handler;
 
     char *_mm_file;
     struct stat _mm_file_stat;
-
-    static const std::unordered_map<std::string, std::string> SUFFIX_TYPE;
-    static const std::unordered_map<int, std::string> CODE_STATUS;
-    static const std::unordered_map<int, std::string> CODE_PATH;
 };
 
 #endif // HTTP_RESPONSE_H
@@ -0,0 +1,126 @@
+/*
+ * @Description: 原地(in-situ) JSON 解析，字符串在 body 缓冲区内原地反转义，
+ *               解析结果为 arena 中的扁平节点带(tape)，节点只保存指向 body 的 string_view
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:02:33
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 16:02:33
+ */
+#ifndef JSON_H
+#define JSON_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+
+enum JSON_TYPE {
+    JSON_NULL = 0,
+    JSON_FALSE,
+    JSON_TRUE,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT,
+};
+
+/*
+ * 节点按先序排列：对象的子节点为 "键(字符串)、值" 交替，数组的子节点为各元素；
+ * next 为跳过整棵子树后的下一节点下标，用于 O(1) 跳过兄弟节点
+ */
+struct JsonNode {
+    JSON_TYPE type;
+    uint32_t next;
+    uint32_t count;        /* 数组元素数或对象成员数 */
+    std::string_view text; /* 字符串内容(已反转义)或数字原文 */
+};
+
+typedef std::vector<JsonNode, ArenaAllocator<JsonNode>> JsonTape;
+
+class JsonDocument;
+
+/* 节点的只读视图，访问不存在的成员或类型不符时返回默认值 */
+class JsonValue {
+public:
+    JsonValue()
+        : _doc(nullptr)
+        , _index(0) {}
+
+    JsonValue(const JsonDocument *doc, uint32_t index)
+        : _doc(doc)
+        , _index(index) {}
+
+    bool valid() const { return _doc != nullptr; }
+
+    JSON_TYPE type() const;
+
+    bool isNull() const { return valid() && type() == JSON_NULL; }
+    bool isBool() const { return valid() && (type() == JSON_TRUE || type() == JSON_FALSE); }
+    bool isNumber() const { return valid() && type() == JSON_NUMBER; }
+    bool isString() const { return valid() && type() == JSON_STRING; }
+    bool isArray() const { return valid() && type() == JSON_ARRAY; }
+    bool isObject() const { return valid() && type() == JSON_OBJECT; }
+
+    size_t size() const;
+
+    JsonValue get(std::string_view key) const;
+
+    JsonValue at(size_t index) const;
+
+    std::string_view keyAt(size_t index) const;
+
+    std::string_view asString(std::string_view def = std::string_view()) const;
+
+    int64_t asInt(int64_t def = 0) const;
+
+    double asDouble(double def = 0) const;
+
+    bool asBool(bool def = false) const;
+
+private:
+    const JsonNode &_node() const;
+    uint32_t _child(size_t index) const;
+
+    const JsonDocument *_doc;
+    uint32_t _index;
+};
+
+class JsonDocument {
+public:
+    JsonDocument() { init(nullptr); }
+
+    void init(Arena *arena);
+
+    bool parse(char *data, size_t len);
+
+    JsonValue root() const { return _tape.empty() ? JsonValue() : JsonValue(this, 0); }
+
+    const JsonTape &tape() const { return _tape; }
+
+    const char *error() const { return _error; }
+
+    size_t errorOffset() const { return _error_offset; }
+
+    static size_t max_depth; /* 容器嵌套深度上限 */
+
+private:
+    bool _parseValue(size_t depth);
+    bool _parseContainer(JSON_TYPE type, size_t depth);
+    bool _parseString(std::string_view *out);
+    bool _parseNumber();
+    bool _parseLiteral(std::string_view literal, JSON_TYPE type);
+    bool _fail(const char *error);
+    void _skipSpace();
+
+    Arena *_arena;
+    JsonTape _tape;
+    char *_begin;
+    char *_cur;
+    char *_end;
+    const char *_error;
+    size_t _error_offset;
+};
+
+#endif // JSON_H
@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 16:14:26
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:48:30
+ * @LastEditTime: 2026-10-19 18:58:42
  */
 #ifndef LOGGER_H
 #define LOGGER_H
@@ -36,6 +36,7 @@ public:
     int getLevel();
     void setLevel(int level);
     bool isOpen() { return _is_open; }
+    size_t queueSize();
 
 private:
     Logger();
@@ -0,0 +1,68 @@
+/*
+ * @Description: 多进程模式的 master，打开监听 socket，fork 并看护 worker 进程
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 22:58:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 22:58:37
+ */
+#ifndef MASTER_H
+#define MASTER_H
+
+#include <functional>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <vector>
+
+/*
+ * 每个 worker 运行完整的 WebServer 事件循环，共享 master 打开的监听 socket，由内核在各进程间分配连接。
+ * worker 崩溃只影响其上的连接，master 回收后重新 fork；启动后很快退出的 worker 延迟重启，避免反复崩溃占满 CPU。
+ * master 不处理请求，只以 sigtimedwait 同步等待信号：
+ *   SIGCHLD 回收 worker，SIGTERM/SIGINT 转发给全部 worker 并等待其优雅退出，SIGUSR1 输出全部 worker 汇总的阶段耗时。
+ * 运行指标经 Metrics::share 放在共享内存中，任一 worker 抓取 /metrics 得到的计数器均为全部 worker 之和。
+ */
+class Master {
+public:
+    /* 在 worker 进程中执行，参数为 worker 编号，返回值作为进程退出码 */
+    typedef std::function<int(int index)> WorkerMain;
+
+    Master(int port, bool opt_linger, int worker_num, bool pin_cpu);
+    ~Master();
+
+    int run(const WorkerMain &worker_main);
+
+private:
+    struct Worker {
+        pid_t pid;           /* 0 表示未运行 */
+        uint64_t start_ms;
+        uint64_t respawn_ms; /* 未运行时重新 fork 的时刻 */
+    };
+
+    bool _spawn(int index);
+    void _reap();
+    void _respawn();
+    void _dealSignal(int signo);
+    void _signalWorkers(int signo);
+    int _running() const;
+
+    static uint64_t _nowMs();
+
+    static const int SLOTS_PER_WORKER = 64;   /* 每个 worker 可占用的共享指标槽位，即线程数上限 */
+    static const int RESPAWN_DELAY_MS = 1000; /* 启动不足此时长即退出的 worker 延迟重启 */
+    static const int POLL_MS          = 1000;
+
+    int _port;
+    bool _open_linger;
+    bool _pin_cpu;
+    int _listen_fd;
+    bool _stopping;
+    pid_t _pid;
+    sigset_t _signals;  /* master 同步等待的信号 */
+    sigset_t _old_mask; /* worker 中恢复 */
+    std::vector<Worker> _workers;
+    std::vector<int> _cpus; /* 允许运行的 CPU，worker i 绑定 _cpus[i % size] */
+    WorkerMain _worker_main;
+};
+
+#endif // MASTER_H
@@ -0,0 +1,140 @@
+/*
+ * @Description: 运行指标，每个线程独占一组按缓存行对齐的计数器，抓取时汇总
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:58:42
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 22:41:26
+ */
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <sys/types.h>
+#include <time.h>
+#include <vector>
+
+#include "histogram.h"
+
+/*
+ * 计数只写本线程的槽位：单一写者，relaxed 的读加写即可，不需要原子读改写，也不与其他线程共享缓存行。
+ * 槽位在线程首次计数时登记，线程退出后保留，已计入的值不丢失。
+ * 抓取时遍历全部槽位求和，以 Prometheus 文本格式输出，读到的是各线程近似同一时刻的值。
+ * 请求各阶段的耗时同样记录在本线程的直方图中，读取时合并后计算分位数。
+ * 多进程模式下槽位分配在 fork 前创建的共享内存中，任一进程抓取时汇总全部进程；
+ * 槽位记录所属进程，进程退出后由 master 释放，新线程接着已有的值累加，计数不因 worker 重启而回退。
+ */
+class Metrics {
+public:
+    enum COUNTER {
+        CONN_ACCEPTED = 0,
+        CONN_CLOSED,
+        CONN_REJECTED, /* 连接数已满，拒绝的连接 */
+        BYTES_IN,
+        BYTES_OUT,
+        LOG_QUEUE_FULL, /* 异步日志队列已满，改为同步写出的行数 */
+        MICRO_CACHE_HITS, /* 以下由 MicroCache 计数并输出 */
+        MICRO_CACHE_STALE_HITS,
+        MICRO_CACHE_MISSES,
+        MICRO_CACHE_COALESCED,
+        COUNTER_COUNT,
+    };
+
+    /* 请求生命周期中的阶段 */
+    enum STAGE {
+        STAGE_FIRST_BYTE = 0, /* 建立连接到读到第一个字节 */
+        STAGE_QUEUE,          /* 任务在线程池队列中等待 */
+        STAGE_PARSE,          /* HttpRequest::parse */
+        STAGE_RESPONSE,       /* HttpResponse::makeResponse */
+        STAGE_WRITE,          /* 应答就绪到最后一个字节写出 */
+        STAGE_IDLE,           /* 长连接上一个应答写完到下一请求到达 */
+        STAGE_COUNT,
+    };
+
+    /* 瞬时值，由单一线程 set(如只在事件循环中访问的计时器)，或由各线程以增量 addGauge；抓取时各槽位求和 */
+    enum GAUGE {
+        TIMER_HEAP = 0,
+        CONNECTIONS, /* 建立与关闭连接时增减 */
+        GAUGE_COUNT,
+    };
+
+    static void add(COUNTER counter, uint64_t n = 1) {
+        std::atomic<uint64_t> &value = _local()->counters[counter];
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    static void addStatus(int code);
+    static void set(GAUGE gauge, int64_t value) { _local()->gauges[gauge].store(value, std::memory_order_relaxed); }
+    static void addGauge(GAUGE gauge, int64_t delta) {
+        std::atomic<int64_t> &value = _local()->gauges[gauge];
+        value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    static uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    }
+    static void record(STAGE stage, uint64_t ns) {
+        Latency &latency              = _local()->latency[stage];
+        std::atomic<uint64_t> &bucket = latency.buckets[Histogram::index(ns)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        latency.sum.store(latency.sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+        if (ns > latency.max.load(std::memory_order_relaxed)) {
+            latency.max.store(ns, std::memory_order_relaxed);
+        }
+    }
+    static void since(STAGE stage, uint64_t start_ns) { record(stage, now() - start_ns); }
+
+    static uint64_t total(COUNTER counter);
+    static void latency(STAGE stage, Histogram &histogram);
+    static void dumpLatency(std::string &out);
+    static void scrape(std::string &out);
+    static void appendCounter(std::string &out, const char *name, const char *help, uint64_t value);
+    static void appendGauge(std::string &out, const char *name, const char *help, double value);
+
+    static bool share(size_t max_slots);
+    static void release(pid_t pid);
+    static void afterFork();
+
+    static const int MAX_STATUS = 600;
+
+private:
+    struct Latency {
+        std::atomic<uint64_t> buckets[Histogram::BUCKETS];
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+
+    /* 共享内存中的槽位不经构造，全零即为有效的初始状态 */
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> counters[COUNTER_COUNT];
+        std::atomic<int64_t> gauges[GAUGE_COUNT];
+        std::atomic<uint64_t> status[MAX_STATUS];
+        Latency latency[STAGE_COUNT];
+        std::atomic<pid_t> owner; /* 共享槽位所属的进程，0 表示空闲 */
+
+        Slot();
+    };
+
+    static Slot *_local() {
+        if (!_slot) {
+            _slot = _register();
+        }
+        return _slot;
+    }
+    static Slot *_register();
+    static std::mutex &_registryMutex();
+    static std::vector<std::unique_ptr<Slot>> &_registry();
+    template <class F>
+    static void _forEach(F &&f);
+
+    static thread_local Slot *_slot;
+    static Slot *_shared; /* 为空时只使用本进程的槽位 */
+    static size_t _shared_count;
+};
+
+#endif // METRICS_H
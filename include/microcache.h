@@ -0,0 +1,138 @@
+/*
+ * @Description: 动态应答的请求合并(single-flight)与短时缓存
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:36:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#ifndef MICRO_CACHE_H
+#define MICRO_CACHE_H
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "metrics.h"
+#include "router.h"
+#include "threadpool.h"
+
+/*
+ * 包装路由处理函数，只作用于不带 Cookie、Authorization 的 GET，以 Host 与请求目标(路径与查询串)为键：
+ *   - 同一键同时只有一个请求执行处理函数(leader)，其余请求延后挂起，结果就绪后共享同一份结果；
+ *     结果不可共享时(如带 Set-Cookie)各自重新执行处理函数；
+ *   - 状态码 200、带 body 且可缓存的结果保存 ttl_ms，期间直接应答，body 零拷贝写出；
+ *   - 过期后 stale_ms 内仍以旧结果立即应答，首个命中的请求复制一份请求交给线程池，
+ *     在独立的任务中重新执行处理函数刷新(stale-while-revalidate)。
+ * 条目按键的哈希分布到各分片，分片内 LRU，内存超出预算时从尾部淘汰。
+ * leader 以缓冲模式执行处理函数：结果须以 setContent 给出，反向代理在该模式下收集完整 body。
+ */
+class MicroCache {
+public:
+    MicroCache(size_t max_bytes, int stale_ms, ThreadPool *pool, const Router *router, size_t shard_num = 16);
+    ~MicroCache();
+
+    MicroCache(const MicroCache &)            = delete;
+    MicroCache &operator=(const MicroCache &) = delete;
+
+    RouteHandler wrap(RouteHandler handler, int ttl_ms);
+
+    size_t size() const { return _count.load(std::memory_order_relaxed); }
+    size_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+    /* 命中计数记录在 Metrics 中，多进程模式下为全部 worker 之和 */
+    size_t hits() const { return Metrics::total(Metrics::MICRO_CACHE_HITS); }
+    size_t staleHits() const { return Metrics::total(Metrics::MICRO_CACHE_STALE_HITS); }
+    size_t misses() const { return Metrics::total(Metrics::MICRO_CACHE_MISSES); }
+    size_t coalesced() const { return Metrics::total(Metrics::MICRO_CACHE_COALESCED); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Result {
+        int code;
+        std::string content;
+        std::string type;
+        std::string headers; /* 处理函数追加的头部行 */
+    };
+    typedef std::shared_ptr<const Result> ResultPtr;
+
+    /* 挂起的请求，连接关闭后应答已被撤销，以 token 认领失败的不再访问 */
+    struct Waiter {
+        const HttpRequest *request;
+        HttpResponse *response;
+        uint32_t token;
+    };
+
+    /* 进行中的计算，done 之后加入的请求直接取 result，result 为空表示不可共享 */
+    struct Flight {
+        const RouteHandler *handler;
+        bool done = false;
+        ResultPtr result;
+        std::vector<Waiter> waiters;
+    };
+    typedef std::shared_ptr<Flight> FlightPtr;
+
+    struct Entry {
+        std::string key;
+        ResultPtr result;
+        Clock::time_point fresh_until;
+        Clock::time_point stale_until;
+        size_t bytes;
+    };
+    typedef std::list<Entry> EntryList;
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        EntryList lru; /* 头部最近访问 */
+        std::unordered_map<std::string_view, EntryList::iterator> index; /* 键指向链表节点中的 key */
+        std::unordered_map<std::string, FlightPtr> flights;
+        size_t bytes = 0;
+    };
+
+    /* 后台刷新使用的请求副本与独立应答，不对应任何连接 */
+    struct Revalidation {
+        Arena arena;
+        Buffer raw;
+        HttpRequest request;
+        HttpResponse response;
+    };
+
+    void _handle(const RouteHandler &handler, int ttl_ms, const HttpRequest &request, HttpResponse &response);
+    void _revalidate(const RouteHandler &handler, int ttl_ms, const std::string &key, const FlightPtr &flight,
+                     std::string_view raw);
+    void _land(const std::string &key, const FlightPtr &flight, int ttl_ms, HttpResponse &response);
+    void _store(Shard &shard, const std::string &key, ResultPtr result, int ttl_ms);
+    void _erase(Shard &shard, EntryList::iterator it);
+    void _reap();
+    Shard &_shard(std::string_view key);
+
+    static std::string _copyRequest(const HttpRequest &request);
+    static void _apply(const ResultPtr &result, HttpResponse &response);
+    static void _rerun(const RouteHandler &handler, const HttpRequest &request, HttpResponse &response);
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t _mask;
+    size_t _shard_budget;
+    int _stale_ms;
+    ThreadPool *_pool;      /* 执行后台刷新 */
+    const Router *_router;  /* 为请求副本重新匹配路由参数 */
+
+    std::mutex _reap_mtx;
+    std::vector<Revalidation *> _running; /* 进行中的后台刷新 */
+    std::vector<Revalidation *> _finished;
+
+    std::atomic<size_t> _count;
+    std::atomic<size_t> _bytes;
+};
+
+#endif // MICRO_CACHE_H
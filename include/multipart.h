@@ -0,0 +1,130 @@
+/*
+ * @Description: multipart/form-data 流式解析，Boyer-Moore-Horspool 搜索分隔符，
+ *               各部分的首部与数据切片随到随交付，不在内存中拼出完整 body
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 15:41:07
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 15:41:07
+ */
+#ifndef MULTIPART_H
+#define MULTIPART_H
+
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "bodyreader.h"
+
+struct MultipartPart {
+    std::string_view name;
+    std::string_view filename;     /* 非空表示文件部分 */
+    std::string_view content_type;
+    std::string_view data;         /* 内存中的内容，溢出到文件后为空 */
+    int fd;                        /* 溢出到临时文件时的文件描述符，否则为 -1 */
+    size_t size;
+};
+
+typedef std::vector<MultipartPart, ArenaAllocator<MultipartPart>> MultipartPartList;
+
+/* 各部分的接收者，切片只在回调期间有效 */
+class MultipartListener {
+public:
+    virtual ~MultipartListener() = default;
+
+    /* 部分首部解析完毕，数据尚未到达 */
+    virtual bool onPartBegin(const MultipartPart &part) = 0;
+
+    virtual bool onPartData(std::string_view slice) = 0;
+
+    virtual bool onPartEnd() = 0;
+
+    virtual int errorCode() const { return 400; }
+};
+
+/* 默认接收者：普通字段收集到 arena 中，文件部分超过阈值后溢出到临时文件 */
+class MultipartCollector : public MultipartListener {
+public:
+    MultipartCollector() { init(nullptr, 0); }
+
+    ~MultipartCollector() { clear(); }
+
+    void init(Arena *arena, size_t limit);
+
+    void clear();
+
+    bool onPartBegin(const MultipartPart &part) override;
+
+    bool onPartData(std::string_view slice) override;
+
+    bool onPartEnd() override;
+
+    int errorCode() const override { return _error_code; }
+
+    const MultipartPartList &parts() const { return _parts; }
+
+    static size_t spill_threshold; /* 文件部分在内存中的上限，超过后写入临时文件 */
+    static const char *spill_dir;  /* 临时文件目录 */
+
+private:
+    bool _spill(MultipartPart &part);
+    bool _write(int fd, std::string_view slice);
+
+    Arena *_arena;
+    MultipartPartList _parts;
+    char *_data;      /* 当前部分在 arena 中的内容 */
+    size_t _capacity; /* 当前部分在 arena 中的容量 */
+    size_t _used;     /* 所有部分累计分配的 arena 字节 */
+    size_t _limit;
+    int _error_code;
+};
+
+class MultipartParser : public BodySink {
+public:
+    enum PARSE_STATE {
+        PREAMBLE = 0,
+        DELIMITER,
+        HEADERS,
+        DATA,
+        EPILOGUE,
+        ERROR,
+    };
+
+    MultipartParser() { init(nullptr, std::string_view(), nullptr); }
+
+    bool init(Arena *arena, std::string_view content_type, MultipartListener *listener);
+
+    bool onBodyData(std::string_view slice) override;
+
+    bool onBodyEnd() override;
+
+    int errorCode() const override;
+
+    static std::string_view boundary(std::string_view content_type);
+
+    static size_t search(std::string_view haystack, std::string_view needle, const unsigned char *skip);
+
+    static const size_t MAX_BOUNDARY = 70;   /* RFC 2046 */
+    static const size_t CARRY_SIZE   = 4096; /* 跨切片保留的未决数据上限，即单个部分首部行的上限 */
+
+private:
+    size_t _process(std::string_view view);
+    bool _parsePartHeader(std::string_view line);
+    bool _emit(std::string_view data);
+    size_t _fail(int code);
+
+    Arena *_arena;
+    MultipartListener *_listener;
+    PARSE_STATE _state;
+    int _error_code;
+
+    std::string_view _delimiter; /* "\r\n--" + boundary */
+    unsigned char _skip[256];    /* BMH 坏字符跳转表 */
+    MultipartPart _part;
+    size_t _header_bytes;
+
+    char *_carry; /* 上一切片末尾未能判定的字节 */
+    size_t _carry_len;
+};
+
+#endif // MULTIPART_H
@@ -0,0 +1,142 @@
+/*
+ * @Description: 编译期完美哈希表，用于首部名、MIME 类型、状态码等固定集合的查找
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 13:02:15
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 13:02:15
+ */
+#ifndef PERFECT_HASH_H
+#define PERFECT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace perfecthash {
+
+constexpr char toLower(char ch) {
+    return (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+}
+
+/* 大小写敏感的字符串键 */
+struct CaseSensitive {
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char ch : key) {
+            h ^= static_cast<unsigned char>(ch);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 16);
+    }
+    static constexpr bool equal(std::string_view lhs, std::string_view rhs) {
+        return lhs == rhs;
+    }
+};
+
+/* 大小写不敏感的字符串键(HTTP 首部名)，哈希时统一置位 0x20，比较时逐字符转小写 */
+struct CaseInsensitive {
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char ch : key) {
+            h ^= static_cast<unsigned char>(ch | 0x20);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 16);
+    }
+    static constexpr bool equal(std::string_view lhs, std::string_view rhs) {
+        if (lhs.size() != rhs.size()) {
+            return false;
+        }
+        for (size_t i = 0; i < lhs.size(); i++) {
+            if (toLower(lhs[i]) != toLower(rhs[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+/* 整数键 */
+struct Integer {
+    static constexpr uint32_t hash(int key, uint32_t seed) {
+        uint32_t h = static_cast<uint32_t>(key) * 2654435761u ^ seed;
+        h ^= h >> 13;
+        h *= 0x5bd1e995u;
+        return h ^ (h >> 15);
+    }
+    static constexpr bool equal(int lhs, int rhs) {
+        return lhs == rhs;
+    }
+};
+
+template <class Key, class Value>
+struct Entry {
+    Key key;
+    Value value;
+};
+
+/*
+ * 编译期构造：搜索一个使所有键落入不同槽位的种子，查找时只需一次哈希与一次比较。
+ * M 为槽位数，必须是 2 的幂；找不到种子时编译报错，需要调大 M。
+ */
+template <class Hash, class Key, class Value, size_t M>
+class Map {
+    static_assert(M > 0 && (M & (M - 1)) == 0, "table size must be a power of two");
+
+public:
+    typedef Entry<Key, Value> EntryType;
+
+    template <size_t N>
+    constexpr Map(const EntryType (&entries)[N])
+        : _seed(_findSeed(entries))
+        , _size(N)
+        , _slots{}
+        , _used{} {
+        static_assert(N <= M, "too many entries for table size");
+        for (size_t i = 0; i < N; i++) {
+            size_t slot  = Hash::hash(entries[i].key, _seed) & (M - 1);
+            _slots[slot] = entries[i];
+            _used[slot]  = true;
+        }
+    }
+
+    constexpr const Value *find(const Key &key) const {
+        size_t slot = Hash::hash(key, _seed) & (M - 1);
+        return _used[slot] && Hash::equal(_slots[slot].key, key) ? &_slots[slot].value : nullptr;
+    }
+
+    constexpr Value get(const Key &key, Value def) const {
+        const Value *value = find(key);
+        return value ? *value : def;
+    }
+
+    constexpr size_t size() const { return _size; }
+
+private:
+    template <size_t N>
+    static constexpr uint32_t _findSeed(const EntryType (&entries)[N]) {
+        for (uint32_t seed = 0; seed < 65536; seed++) {
+            bool used[M] = {};
+            bool ok      = true;
+            for (size_t i = 0; i < N && ok; i++) {
+                size_t slot = Hash::hash(entries[i].key, seed) & (M - 1);
+                ok          = !used[slot];
+                used[slot]  = true;
+            }
+            if (ok) {
+                return seed;
+            }
+        }
+        throw "perfecthash: no collision-free seed, enlarge the table";
+    }
+
+    uint32_t _seed;
+    size_t _size;
+    EntryType _slots[M];
+    bool _used[M];
+};
+
+} // namespace perfecthash
+
+#endif // PERFECT_HASH_H
@@ -0,0 +1,44 @@
+/*
+ * @Description: USDT 静态探针，供 bpftrace/perf 在不重新编译的情况下观测热点路径
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 21:46:03
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 21:46:03
+ */
+#ifndef PROBES_H
+#define PROBES_H
+
+/*
+ * 以 cmake -DENABLE_USDT=ON 编译时，每个探针是一条 nop 指令并在 .note.stapsdt 段登记参数位置，
+ * 未挂载探针时没有其他开销；关闭时探针不产生任何代码，参数也不求值。
+ * provider 为 webserver，探针与参数：
+ *   conn_accept(fd, user_count)          HttpConn::init
+ *   conn_close(fd)                       HttpConn::disconn
+ *   task_enqueue(queue_size)             ThreadPool::addTask，入队后的队列长度
+ *   task_dequeue(enqueued_ns, queue_size) 工作线程取出任务，enqueued_ns 为 CLOCK_MONOTONIC 入队时刻，未计时的线程池为 0
+ *   parse_start(request, readable)       HttpRequest::parse，request 为对象地址，用于匹配 parse_end
+ *   parse_end(request, result)           result 为 HTTP_CODE
+ *   response_ready(fd, code, bytes)      应答构造完毕，bytes 为待写出的字节数
+ *   writev(fd, result, errno)            HttpConn::write 中每次 writev 的返回值
+ * 例：bpftrace -e 'usdt:./simple_server:webserver:writev { @bytes = hist(arg1); }'
+ */
+#ifdef ENABLE_USDT
+#include <sys/sdt.h>
+
+#define PROBE1(name, a1) DTRACE_PROBE1(webserver, name, a1)
+#define PROBE2(name, a1, a2) DTRACE_PROBE2(webserver, name, a1, a2)
+#define PROBE3(name, a1, a2, a3) DTRACE_PROBE3(webserver, name, a1, a2, a3)
+#else
+#define PROBE1(name, a1) \
+    do {                 \
+    } while (0)
+#define PROBE2(name, a1, a2) \
+    do {                     \
+    } while (0)
+#define PROBE3(name, a1, a2, a3) \
+    do {                         \
+    } while (0)
+#endif
+
+#endif // PROBES_H
@@ -0,0 +1,194 @@
+/*
+ * @Description: 反向代理，按路径前缀把请求转发到上游 HTTP/1.1 服务器，上游连接保持长连接复用
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:14:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:58:06
+ */
+#ifndef PROXY_H
+#define PROXY_H
+
+#include <arpa/inet.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer.h"
+#include "epoller.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+
+/*
+ * 工作线程中的路由处理函数调用 forward()：请求序列化后随延后任务交给事件循环，
+ * 之后的连接、发送、接收全部在事件循环线程中完成，不阻塞工作线程。
+ * 每个上游维护一组非阻塞长连接，空闲连接后进先出复用，连接数达到上限时请求排队。
+ * 应答头改写逐跳首部后写给客户端，body 按 Content-Length / chunked / 关闭连接三种方式界定：
+ * 定长与关闭界定的 body 经管道 splice 在内核中搬运，chunked 经用户态缓冲原样透传。
+ * 客户端 socket 写满时暂停读取上游，等客户端 EPOLLOUT 后继续，内存占用以管道容量为界。
+ * 应答处于缓冲模式(如由微缓存发起)时不写客户端，body 解码后完整收集，连同端到端首部交给应答。
+ */
+class ReverseProxy {
+public:
+    enum BALANCE {
+        ROUND_ROBIN = 0,
+        LEAST_OUTSTANDING, /* 选择进行中请求最少的上游 */
+    };
+
+    ReverseProxy();
+    ~ReverseProxy();
+
+    bool init(Epoller *epoller, uint32_t client_event, int timeout_ms = 30000);
+    void close();
+
+    int addGroup(const std::vector<std::string> &upstreams, BALANCE balance, size_t max_conns);
+    void forward(int group, const HttpRequest &request, HttpResponse &response);
+
+    bool handleEvent(int fd, uint32_t events);
+    void abort(int client_fd);
+
+    void setActivityHandler(std::function<void(int)> handler) { _activity_handler = std::move(handler); }
+
+    static bool parseAddress(std::string_view address, struct sockaddr_in *addr);
+
+private:
+    enum STATE {
+        WAIT_CONN = 0, /* 排队等待上游连接 */
+        SENDING,       /* 发送请求 */
+        RECV_HEADER,   /* 等待应答头 */
+        RECV_BODY,     /* 转发 body */
+    };
+
+    enum FRAMING {
+        BODY_NONE = 0,
+        BODY_LENGTH,
+        BODY_CHUNKED,
+        BODY_CLOSE, /* 以上游关闭连接结束，客户端连接随后关闭 */
+    };
+
+    enum CHUNK_STATE {
+        CHUNK_SIZE = 0,
+        CHUNK_EXT,
+        CHUNK_SIZE_LF,
+        CHUNK_DATA,
+        CHUNK_DATA_CR,
+        CHUNK_DATA_LF,
+        CHUNK_TRAILER, /* 尾部首部的行首 */
+        CHUNK_TRAILER_LINE,
+        CHUNK_TRAILER_LF,
+        CHUNK_DONE,
+        CHUNK_ERROR,
+    };
+
+    struct Upstream;
+    struct Group;
+    struct Exchange;
+
+    struct Conn {
+        int fd             = -1;
+        int pipe_fd[2]     = {-1, -1}; /* upstream -> pipe -> client 的 splice 管道，随连接复用 */
+        bool connecting    = false;
+        bool reused        = false; /* 取自空闲连接，失败时可重试 */
+        uint32_t events    = 0;     /* 当前注册的事件 */
+        Upstream *upstream = nullptr;
+        Exchange *exchange = nullptr;
+        Buffer in;
+
+        Conn()
+            : in(0) {}
+    };
+
+    struct Upstream {
+        struct sockaddr_in addr;
+        std::string name;
+        Group *group       = nullptr;
+        size_t conns       = 0; /* 已建立或正在建立的连接数 */
+        size_t outstanding = 0; /* 已分配到该上游、尚未完成的请求数 */
+        std::vector<Conn *> idle;
+        std::deque<Exchange *> waiting;
+    };
+
+    struct Group {
+        std::vector<std::unique_ptr<Upstream>> upstreams;
+        BALANCE balance;
+        size_t max_conns;
+        size_t next = 0;
+    };
+
+    struct Exchange {
+        HttpResponse *response;
+        int client_fd;
+        int key; /* _exchanges 中的键：客户端 fd，没有客户端连接时为负的序号 */
+        bool head;
+        bool idempotent;
+        bool client_keep_alive;
+        Group *group;
+        Upstream *upstream       = nullptr;
+        Conn *conn               = nullptr;
+        STATE state              = WAIT_CONN;
+        Buffer request;                   /* 序列化后的上游请求，重试时从头重发 */
+        size_t sent              = 0;     /* request 中已发送的字节数 */
+        Buffer out;                       /* 待写给客户端的应答头与 body */
+        size_t piped             = 0;     /* 管道中尚未写给客户端的字节数 */
+        FRAMING framing          = BODY_NONE;
+        size_t remaining         = 0;     /* BODY_LENGTH 剩余字节数；chunked 当前块剩余字节数 */
+        CHUNK_STATE chunk        = CHUNK_SIZE;
+        bool eof                 = false; /* 上游已关闭，BODY_CLOSE 的 body 结束 */
+        bool upstream_keep_alive = false;
+        bool client_blocked      = false; /* 等待客户端 EPOLLOUT，期间暂停读取上游 */
+        bool retried             = false;
+        int idle_ticks           = 0; /* 没有进展的检查周期数 */
+        bool buffered            = false; /* 应答收集在 out 中，完成后交给 response */
+        bool cacheable           = true;
+        int code                 = 0;
+        std::string content_type;
+        std::string headers; /* 缓冲模式下转发的端到端首部行 */
+
+        Exchange()
+            : request(0)
+            , out(0) {}
+    };
+
+    void _start(Exchange *exchange);
+    void _dispatchWaiting(Upstream *upstream);
+    void _assign(Exchange *exchange, Conn *conn);
+    Conn *_connect(Upstream *upstream);
+    void _closeConn(Conn *conn);
+    void _release(Conn *conn);
+    void _watch(Conn *conn, uint32_t events);
+
+    void _onConnEvent(Conn *conn, uint32_t events);
+    void _send(Exchange *exchange);
+    void _pump(Exchange *exchange);
+    int _parseHeader(Exchange *exchange);
+    size_t _scanChunked(Exchange *exchange, const char *data, size_t len, Buffer *decoded);
+    int _flushClient(Exchange *exchange);
+
+    bool _retry(Exchange *exchange);
+    void _finish(Exchange *exchange);
+    void _fail(Exchange *exchange, int code, const char *reason);
+    void _complete(Exchange *exchange);
+    void _drop(Exchange *exchange);
+    void _onTimer();
+
+    Epoller *_epoller;
+    uint32_t _client_event;
+    int _timeout_ms;
+    int _wake_fd;  /* eventfd，工作线程提交请求后唤醒事件循环 */
+    int _timer_fd; /* timerfd，检查上游超时 */
+    std::vector<std::unique_ptr<Group>> _groups;
+
+    std::mutex _mtx; /* 保护 _pending 与 _exchanges 的增删 */
+    std::vector<Exchange *> _pending;
+    std::unordered_map<int, Exchange *> _exchanges; /* Exchange::key -> 进行中的请求 */
+    int _detached_seq;
+    std::unordered_map<int, Conn *> _conns;         /* 上游 fd -> 连接，仅事件循环访问 */
+    std::function<void(int)> _activity_handler;
+};
+
+#endif // PROXY_H
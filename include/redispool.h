@@ -0,0 +1,88 @@
+/*
+ * @Description: 非阻塞的 RESP 连接池，连接注册在服务器的事件循环中，命令按连接流水线发送
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#ifndef REDIS_POOL_H
+#define REDIS_POOL_H
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "buffer.h"
+#include "epoller.h"
+#include "resp.h"
+
+/* 应答回调在事件循环线程中执行，应尽快返回，耗时的工作转交线程池 */
+typedef std::function<void(const RespReply &reply)> RedisCallback;
+
+/*
+ * 任意线程调用 command() 将命令编码进所选连接的发送缓冲区并通过 eventfd 唤醒事件循环，
+ * 唤醒前累积的命令合并为一次 write 发出，并发请求的查询共用一次往返。
+ * 同一连接上应答按发送顺序返回，与回调队列一一对应。
+ * 定时器按 health_ms 周期检查：断开的连接重连，空闲连接发送 PING，有未应答命令且两个周期内没有任何应答则断开重连。
+ */
+class RedisPool {
+public:
+    RedisPool();
+    ~RedisPool();
+
+    bool init(Epoller *epoller, const char *host, int port, size_t conn_num, int health_ms = 1000);
+    void close();
+
+    void command(std::initializer_list<std::string_view> args, RedisCallback callback);
+
+    bool handleEvent(int fd, uint32_t events);
+
+    size_t connected() const;
+
+private:
+    enum STATE {
+        DISCONNECTED = 0,
+        CONNECTING,
+        CONNECTED,
+    };
+
+    struct Conn {
+        int fd         = -1;
+        STATE state    = DISCONNECTED;
+        bool flushing  = false; /* 已唤醒事件循环发送 out */
+        bool writable  = true;  /* 上次发送未被内核缓冲区阻塞 */
+        int idle_ticks = 0;     /* 有未应答命令时，连续没有收到应答的检查周期数 */
+        Buffer out;
+        Buffer in;
+        std::deque<RedisCallback> callbacks; /* 空回调对应健康检查的 PING */
+        std::mutex mtx;                      /* 保护 state、out、callbacks */
+
+        Conn()
+            : out(0)
+            , in(0) {}
+    };
+
+    void _connect(Conn &conn);
+    void _reset(Conn &conn, const char *reason);
+    void _flush(Conn &conn);
+    void _onReadable(Conn &conn);
+    void _onWritable(Conn &conn);
+    void _onTimer();
+    void _wake();
+
+    Epoller *_epoller;
+    struct sockaddr_in _addr;
+    std::vector<std::unique_ptr<Conn>> _conns;
+    int _wake_fd;  /* eventfd，通知事件循环有待发送的命令 */
+    int _timer_fd; /* timerfd，健康检查周期 */
+    std::atomic<size_t> _next;
+};
+
+#endif // REDIS_POOL_H
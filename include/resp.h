@@ -0,0 +1,60 @@
+/*
+ * @Description: RESP(REdis Serialization Protocol) 编码与增量解析
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#ifndef RESP_H
+#define RESP_H
+
+#include <initializer_list>
+#include <string_view>
+#include <sys/types.h>
+#include <vector>
+
+#include "buffer.h"
+
+enum RESP_TYPE {
+    RESP_NIL = 0,
+    RESP_STATUS,  /* +OK */
+    RESP_ERROR,   /* -ERR ... */
+    RESP_INTEGER, /* :1 */
+    RESP_STRING,  /* $3 foo */
+    RESP_ARRAY,   /* *2 ... */
+};
+
+/* 应答中的字符串指向解析所用的缓冲区，仅在回调期间有效 */
+struct RespReply {
+    RESP_TYPE type = RESP_NIL;
+    std::string_view str;
+    long long integer = 0;
+    std::vector<RespReply> elements;
+
+    bool isError() const { return type == RESP_ERROR; }
+};
+
+class Resp {
+public:
+    static void encode(Buffer &buff, std::initializer_list<std::string_view> args);
+    static void encode(Buffer &buff, const std::string_view *args, size_t count);
+
+    static void status(Buffer &buff, std::string_view str);
+    static void error(Buffer &buff, std::string_view str);
+    static void integer(Buffer &buff, long long value);
+    static void bulk(Buffer &buff, std::string_view str);
+    static void nil(Buffer &buff);
+
+    static ssize_t parse(const char *data, size_t len, RespReply *reply);
+
+    static const size_t MAX_DEPTH       = 8;         /* 嵌套数组层数上限 */
+    static const long long MAX_ELEMENTS = 1 << 20;   /* 数组元素数上限 */
+    static const long long MAX_BULK     = 512 << 20; /* bulk string 长度上限 */
+
+private:
+    static ssize_t _parse(const char *data, size_t len, RespReply *reply, size_t depth);
+    static void _header(Buffer &buff, char type, long long value);
+};
+
+#endif // RESP_H
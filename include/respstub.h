@@ -0,0 +1,62 @@
+/*
+ * @Description: 进程内的 RESP 服务端桩，在独立线程中监听本地端口，实现连接池与会话所需的少量命令，
+ *               便于在没有 redis-server 的环境中联调
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#ifndef RESP_STUB_H
+#define RESP_STUB_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "buffer.h"
+#include "epoller.h"
+#include "resp.h"
+
+/* 支持的命令：PING ECHO GET SET(EX/PX/NX/XX) DEL EXISTS EXPIRE TTL INCR FLUSHALL */
+class RespStub {
+public:
+    RespStub();
+    ~RespStub();
+
+    bool start(int port = 0);
+    void stop();
+
+    int port() const { return _port; }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Entry {
+        std::string value;
+        Clock::time_point expires; /* 默认值表示不过期 */
+    };
+
+    struct Client {
+        Buffer in;
+        Buffer out;
+    };
+
+    void _loop();
+    bool _onReadable(int fd, Client &client);
+    void _execute(const RespReply &request, Buffer &out);
+    Entry *_lookup(const std::string &key);
+
+    int _listen_fd;
+    int _stop_fd;
+    int _port;
+    std::unique_ptr<Epoller> _epoller;
+    std::thread _thread;
+    std::unordered_map<int, Client> _clients;
+    std::unordered_map<std::string, Entry> _data; /* 仅由服务线程访问 */
+};
+
+#endif // RESP_STUB_H
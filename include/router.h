@@ -0,0 +1,70 @@
+/*
+ * @Description: 路由表，注册的路径模式编译为基数树(radix trie)，按方法分派到处理函数
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:41:12
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "httpheaders.h"
+
+class HttpRequest;
+class HttpResponse;
+
+/* 处理函数在工作线程中执行，通过 response 设置状态码、静态文件或 body */
+typedef std::function<void(const HttpRequest &request, HttpResponse &response)> RouteHandler;
+
+// 路径模式：
+//   /api/users          静态路径
+//   /api/users/:id      参数，匹配一个路径段
+//   /static/*path       前缀，匹配其后的全部内容，只能出现在末尾
+// 匹配优先级为 静态 > 参数 > 前缀；高优先级的分支没有注册请求方法时回退到低优先级的分支。
+class Router {
+public:
+    Router();
+    ~Router();
+
+    bool add(std::string_view method, std::string_view pattern, RouteHandler handler);
+
+    int match(std::string_view method, std::string_view path, HttpFieldList &params, const RouteHandler **handler) const;
+
+    size_t size() const { return _size; }
+
+private:
+    enum NODE_TYPE {
+        STATIC = 0,
+        PARAM,
+        WILDCARD,
+    };
+
+    struct Node {
+        NODE_TYPE type;
+        std::string label;   /* STATIC: 压缩后的边；PARAM/WILDCARD: 参数名 */
+        std::string indices; /* 静态子节点边的首字符，与 children 一一对应 */
+        std::vector<std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> param;
+        std::unique_ptr<Node> wildcard;
+        std::vector<std::pair<std::string, RouteHandler>> handlers; /* 方法 -> 处理函数 */
+    };
+
+    Node *_insertStatic(Node *node, std::string_view label);
+    const RouteHandler *_match(const Node *node, std::string_view method, std::string_view path,
+                               HttpFieldList &params, bool &path_found) const;
+
+    static const RouteHandler *_handler(const Node *node, std::string_view method, bool &path_found);
+
+    std::unique_ptr<Node> _root;
+    size_t _size;
+};
+
+#endif // ROUTER_H
@@ -0,0 +1,82 @@
+/*
+ * @Description: 分片的内存会话存储，会话 id 随机生成，通过 cookie 携带
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:52:16
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:52:16
+ */
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include <assert.h>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+/*
+ * 会话按 id 的哈希分布到 2 的幂个分片，每个分片独立加锁，不同分片上的查询互不竞争。
+ * 分片内为哈希表 + LRU 链表：查询 O(1)，命中时续期并移到链表头。
+ * 过期时间随访问滑动，链表尾即最早过期者，清理只需从尾部摘除已过期的会话；
+ * 分片内存超出预算时同样从尾部淘汰最久未访问的会话。
+ */
+class SessionStore {
+public:
+    SessionStore(size_t shard_num, int ttl_ms, size_t max_bytes);
+    ~SessionStore() = default;
+
+    SessionStore(const SessionStore &)            = delete;
+    SessionStore &operator=(const SessionStore &) = delete;
+
+    std::string create(std::string_view user);
+    bool lookup(std::string_view id, std::string *user);
+    bool remove(std::string_view id);
+    size_t expire();
+
+    size_t size() const { return _count.load(std::memory_order_relaxed); }
+    size_t bytes() const { return _bytes.load(std::memory_order_relaxed); }
+    size_t evicted() const { return _evicted.load(std::memory_order_relaxed); }
+    int ttl() const { return _ttl_ms; }
+
+    static const size_t ID_LEN = 32; /* 128 位随机数的十六进制表示 */
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Session {
+        std::string id;
+        std::string user;
+        Clock::time_point expires;
+        size_t bytes;
+    };
+    typedef std::list<Session> SessionList;
+
+    /* 按缓存行对齐，相邻分片的锁不共享缓存行 */
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        SessionList lru; /* 头部最近访问 */
+        std::unordered_map<std::string_view, SessionList::iterator> index; /* 键指向链表节点中的 id */
+        size_t bytes = 0;
+    };
+
+    Shard &_shard(std::string_view id);
+    void _erase(Shard &shard, SessionList::iterator it);
+
+    static bool _randomId(std::string *id);
+
+    std::unique_ptr<Shard[]> _shards;
+    size_t _mask;
+    int _ttl_ms;
+    size_t _shard_budget;
+
+    std::atomic<size_t> _count;
+    std::atomic<size_t> _bytes;
+    std::atomic<size_t> _evicted;
+};
+
+#endif // SESSION_STORE_H
@@ -0,0 +1,39 @@
+/*
+ * @Description: SHA-256 摘要与 PBKDF2-HMAC-SHA256 口令派生
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:12:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:12:05
+ */
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+class Sha256 {
+public:
+    static constexpr size_t DIGEST_SIZE = 32;
+    static constexpr size_t BLOCK_SIZE  = 64;
+
+    Sha256() { init(); }
+
+    void init();
+    void update(const void *data, size_t len);
+    void final(uint8_t digest[DIGEST_SIZE]);
+
+    static void pbkdf2(std::string_view password, const uint8_t *salt, size_t salt_len,
+                       uint32_t iterations, uint8_t *out, size_t out_len);
+
+private:
+    void _transform(const uint8_t block[BLOCK_SIZE]);
+
+    uint32_t _state[8];
+    uint64_t _bits;
+    uint8_t _block[BLOCK_SIZE];
+    size_t _used;
+};
+
+#endif // SHA256_H
@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-20 17:53:51
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:50:21
+ * @LastEditTime: 2026-10-19 22:12:45
  */
 #ifndef THREADPOOL_H
 #define THREADPOOL_H
@@ -15,34 +15,49 @@
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
+
+#include "metrics.h"
+#include "probes.h"
 
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t thread_count = 8);
+    /* timed 为 true 时记录任务的排队耗时(Metrics::STAGE_QUEUE) */
+    explicit ThreadPool(size_t thread_count = 8, bool timed = false);
 
     ThreadPool() = default;
 
     ThreadPool(ThreadPool &&) = default;
 
+    /* 等待已入队的任务执行完毕并回收工作线程 */
     ~ThreadPool();
 
     template <class F>
     void addTask(F &&task) {
         {
             std::lock_guard<std::mutex> locker(_pool->mtx);
-            _pool->tasks.emplace(std::forward<F>(task));
+            _pool->tasks.push({std::forward<F>(task), _pool->timed ? Metrics::now() : 0});
+            PROBE1(task_enqueue, _pool->tasks.size());
         }
         _pool->cond.notify_one();
     }
 
+    size_t queueSize() const;
+
 private:
+    struct Task {
+        std::function<void()> fn;
+        uint64_t enqueued_ns;
+    };
     struct Pool {
         std::mutex mtx;
         std::condition_variable cond;
         bool is_closed;
-        std::queue<std::function<void()>> tasks;
+        bool timed;
+        std::queue<Task> tasks;
     };
     std::shared_ptr<Pool> _pool;
+    std::vector<std::thread> _threads;
 };
 
 #endif // THREADPOOL_H
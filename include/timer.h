@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 14:26:42
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:49:33
+ * @LastEditTime: 2026-10-19 18:58:42
  */
 #ifndef HEAPTIMER_H
 #define HEAPTIMER_H
@@ -52,6 +52,8 @@ public:
 
     int getNextTick();
 
+    size_t size() const { return _heap.size(); }
+
 private:
     void _del(size_t i);
 
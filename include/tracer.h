@@ -0,0 +1,80 @@
+/*
+ * @Description: 请求处理过程的跨度(span)追踪，导出为 Chrome trace-event JSON
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 21:24:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 21:24:37
+ */
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "metrics.h"
+
+/*
+ * 按连接抽样：连接建立时决定是否追踪，被抽中的连接上的各处理阶段记录为 span，以连接编号关联。
+ * 每个线程写自己的环形缓冲区，写满后覆盖最旧的记录；导出时遍历全部线程，跳过导出过程中被覆盖的记录。
+ * 导出的 JSON 可直接在 chrome://tracing 或 Perfetto 中打开，按线程显示时间线。
+ */
+class Tracer {
+public:
+    static void enable(double sample_rate, size_t spans_per_thread);
+    static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+    static uint32_t sample();
+    static void span(const char *name, uint32_t id, uint64_t start_ns, uint64_t end_ns, const char *arg_name = nullptr,
+                     int64_t arg = 0);
+    static void instant(const char *name, uint32_t id, const char *arg_name = nullptr, int64_t arg = 0);
+    static void nameThread(const char *name);
+
+    static void exportJson(std::string &out);
+
+private:
+    enum KIND : uint8_t {
+        COMPLETE = 0,
+        INSTANT,
+    };
+
+    /* 字段以 relaxed 原子访问，导出线程可能读到正在被覆盖的记录，由序号检查丢弃 */
+    struct Span {
+        std::atomic<const char *> name;
+        std::atomic<const char *> arg_name;
+        std::atomic<uint64_t> start_ns;
+        std::atomic<uint64_t> dur_ns;
+        std::atomic<int64_t> arg;
+        std::atomic<uint32_t> id;
+        std::atomic<uint8_t> kind;
+    };
+
+    struct Ring {
+        int tid;
+        char name[32];
+        std::unique_ptr<Span[]> spans;
+        size_t mask;
+        std::atomic<uint64_t> head; /* 已写入的记录数 */
+    };
+
+    static void _record(KIND kind, const char *name, uint32_t id, uint64_t start_ns, uint64_t dur_ns,
+                        const char *arg_name, int64_t arg);
+    static Ring *_local() {
+        thread_local Ring *ring = _register();
+        return ring;
+    }
+    static Ring *_register();
+    static std::mutex &_registryMutex();
+    static std::vector<std::unique_ptr<Ring>> &_registry();
+
+    static std::atomic<bool> _enabled;
+    static double _sample_rate;
+    static size_t _capacity;
+    static std::atomic<uint32_t> _seq;
+};
+
+#endif // TRACER_H
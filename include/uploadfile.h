@@ -0,0 +1,61 @@
+/*
+ * @Description: 大文件上传落盘，body 经 pipe 由内核从 socket 直接 splice 到临时文件，不经过用户态缓冲区
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 15:22:40
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 15:41:07
+ */
+#ifndef UPLOAD_FILE_H
+#define UPLOAD_FILE_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "buffer.h"
+#include "logger.h"
+
+class UploadFile {
+public:
+    UploadFile();
+
+    ~UploadFile();
+
+    bool open(const char *dir, size_t length);
+
+    bool absorb(Buffer &buff);
+
+    ssize_t splice(int sock_fd, int *save_errno);
+
+    void close();
+
+    bool active() const { return _fd >= 0; }
+
+    bool done() const { return _fd >= 0 && _remaining == 0 && _in_pipe == 0; }
+
+    int fd() const { return _fd; }
+
+    size_t length() const { return _length; }
+
+    size_t received() const { return _length - _remaining; }
+
+    static bool linkTo(int fd, const char *path);
+
+    static int createTemp(const char *dir);
+
+    static size_t pipe_size; /* 每个上传使用的 pipe 容量，即单次 splice 的最大字节数 */
+
+private:
+    bool _drain();
+
+    int _fd;
+    int _pipe[2];
+    size_t _length;
+    size_t _remaining; /* socket 中尚未读取的字节 */
+    size_t _in_pipe;   /* 已进入 pipe、尚未写入文件的字节 */
+    size_t _capacity;  /* pipe 实际容量 */
+};
+
+#endif // UPLOAD_FILE_H
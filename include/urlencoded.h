@@ -0,0 +1,25 @@
+/*
+ * @Description: application/x-www-form-urlencoded 与 URL 查询串解析，在原缓冲区内解码，键值对为指向原缓冲区的 string_view
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:20:45
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 16:20:45
+ */
+#ifndef URL_ENCODED_H
+#define URL_ENCODED_H
+
+#include <cstddef>
+
+#include "httpheaders.h"
+
+class UrlEncoded {
+public:
+    static void parse(char *data, size_t len, HttpFieldList &fields);
+
+private:
+    static size_t _plainRun(const char *data, size_t len);
+    static int _hexValue(char ch);
+};
+
+#endif // URL_ENCODED_H
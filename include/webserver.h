@@ -4,25 +4,38 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 17:10:56
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:03:55
+ * @LastEditTime: 2026-10-19 23:59:58
  */
 #ifndef WEBSERVER_H
 #define WEBSERVER_H
 
 #include <arpa/inet.h>
 #include <assert.h>
+#include <climits>
 #include <errno.h>
 #include <fcntl.h>
 #include <netinet/in.h>
+#include <signal.h>
 #include <sys/socket.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #include <unordered_map>
 
+#include "capture.h"
+#include "credentialstore.h"
 #include "epoller.h"
 #include "logger.h"
+#include "metrics.h"
+#include "microcache.h"
+#include "proxy.h"
+#include "redispool.h"
+#include "respstub.h"
+#include "sessionstore.h"
 #include "threadpool.h"
 #include "timer.h"
+#include "tracer.h"
 #include "httpconn.h"
+#include "router.h"
 
 class WebServer {
 public:
@@ -33,6 +46,30 @@ public:
     ~WebServer();
     void start();
 
+    void setRequestLimits(size_t max_header_size, size_t max_body_size, size_t max_buffered_body);
+
+    void setUploadHandler(const char *dir, size_t threshold, size_t max_size, UploadHandler handler);
+
+    bool addRoute(std::string_view method, std::string_view pattern, RouteHandler handler, int cache_ttl_ms = 0);
+
+    bool setCredentialStore(const char *dir, int hash_threads, bool shared = false);
+
+    bool setRedis(const char *host, int port, size_t conn_num, int hash_threads);
+
+    void setSessionStore(size_t shard_num, int ttl_ms, size_t max_bytes);
+
+    bool addProxy(std::string_view prefix, const std::vector<std::string> &upstreams,
+                  ReverseProxy::BALANCE balance = ReverseProxy::ROUND_ROBIN, size_t max_conns = 32,
+                  int cache_ttl_ms = 0);
+
+    void setMicroCache(size_t max_bytes, int stale_ms);
+    bool setCapture(const char *path, double sample_rate, size_t max_bytes);
+    void setTracing(double sample_rate, size_t spans_per_thread);
+    void setGracefulShutdown(int drain_timeout_ms, char **argv = nullptr);
+
+    static int createListenSocket(int port, bool opt_linger);
+    static int inherited_listen_fd; /* 非负时使用 master 打开的监听 socket，不再绑定端口 */
+
     enum TRIGER_MODE {
         NO_ET = 0,
         CONNECT_ET,
@@ -42,23 +79,55 @@ public:
 
 private:
     bool _initSocket();
+    bool _initSignal();
+    bool _inheritListenFd(int handoff_fd);
+    bool _useListenFd(int fd, bool exclusive);
     void _initEventMode(int trigMode);
+    void _initRoutes();
+    void _userVerify(const HttpRequest &request, HttpResponse &response, bool is_login);
+    void _redisVerify(const std::string &name, const std::string &pwd, bool is_login, HttpResponse *resp,
+                      uint32_t token);
+    void _finishLogin(HttpResponse *resp, uint32_t token, const std::string &name, bool ok);
+    void _sweepSessions();
+    void _scrapeMetrics(std::string &out) const;
+    bool _isProxied(std::string_view path) const;
     void _addClient(int fd, sockaddr_in addr);
 
     void _dealListen();
     void _dealWrite(HttpConn *client);
     void _dealRead(HttpConn *client);
+    void _dealSignal();
+    void _dealUpgrade();
+
+    void _beginDrain();
+    void _closeIdle();
+    void _forceClose();
+    void _upgrade();
 
     void _sendError(int fd, const char *info);
     void _extentTime(HttpConn *client);
     void _closeConn(HttpConn *client);
+    void _requestClose(HttpConn *client);
 
     void _onRead(HttpConn *client);
     void _onWrite(HttpConn *client);
+    void _onTracedRead(HttpConn *client, uint64_t queued_ns);
+    void _onTracedWrite(HttpConn *client, uint64_t queued_ns);
     void _onProcess(HttpConn *client);
 
     static const int MAX_FD = 65536;
 
+    static constexpr const char *SESSION_COOKIE = "sid";
+    static constexpr int SESSION_TIMER          = INT_MAX; /* 会话清理在计时器中的 id，不与连接 fd 冲突 */
+    static constexpr int SESSION_SWEEP_MS       = 1000;
+    static constexpr int DRAIN_TIMER            = INT_MAX - 1; /* 优雅退出的截止时间 */
+    static constexpr int DRAIN_IDLE_TIMER       = INT_MAX - 2; /* 关闭空闲长连接的时刻 */
+    static constexpr int DRAIN_TIMEOUT_MS       = 30000;
+    static constexpr int DRAIN_IDLE_MS          = 1000;
+    static constexpr int DRAIN_POLL_MS          = 100; /* 优雅退出期间检查剩余连接数的间隔 */
+    static constexpr const char *HANDOFF_ENV    = "WEBSERVER_HANDOFF_FD"; /* 新进程由此得知交接用的 socket */
+    static constexpr int HANDOFF_FD             = 3;
+
     static int _setFdNonblock(int fd);
 
     int _port;
@@ -66,14 +135,32 @@ private:
     int _timeout_ms; /* 毫秒MS */
     bool _is_close;
     int _listen_fd;
+    int _signal_fds[2]; /* 信号处理函数写入 [1]，事件循环读取 [0] */
+    bool _draining;     /* 已停止接受连接，等待现有连接结束 */
+    std::atomic<bool> _closing_idle; /* 优雅退出中，空闲的长连接不再等待下一请求 */
+    int _drain_timeout_ms;
+    char **_argv;       /* 非空时 SIGUSR2 以此重新执行 */
+    int _upgrade_fd;    /* 旧进程一端：向新进程发送监听 socket，等待其开始服务 */
+    pid_t _upgrade_pid;
+    int _handoff_fd;    /* 新进程一端：开始服务后通知旧进程 */
     char *_src_dir;
 
     uint32_t _listen_event;
     uint32_t _conn_event;
 
     std::unique_ptr<HeapTimer> _timer;
+    std::unique_ptr<MicroCache> _cache; /* 早于 _threadpool 声明，工作线程结束后才析构 */
+    std::unique_ptr<TrafficCapture> _capture; /* 同上 */
     std::unique_ptr<ThreadPool> _threadpool;
     std::unique_ptr<Epoller> _epoller;
+    std::unique_ptr<Router> _router;
+    std::unique_ptr<RespStub> _redis_stub;
+    std::unique_ptr<RedisPool> _redis; /* 注册在 _epoller 中，先于其析构 */
+    std::unique_ptr<ReverseProxy> _proxy; /* 同上 */
+    std::vector<std::string> _proxy_prefixes; /* 启动前配置完毕，运行期只读 */
+    std::unique_ptr<CredentialStore> _credentials;
+    std::unique_ptr<SessionStore> _sessions;
+    std::unique_ptr<ThreadPool> _hash_pool; /* 晚于 _credentials 声明，先于其析构 */
     std::unordered_map<int, HttpConn> _users;
 };
 
@@ -0,0 +1,569 @@
+/*
+ * @Description: 用户凭据存储实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:12:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:58
+ */
+#include "credentialstore.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <errno.h>
+#include <fcntl.h>
+#include <mutex>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/random.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+uint32_t CredentialStore::iterations = 10000;
+
+CredentialStore::CredentialStore()
+    : _log_fd(-1)
+    , _index_fd(-1)
+    , _header(nullptr)
+    , _slots(nullptr)
+    , _map_size(0)
+    , _shared(false) {}
+
+CredentialStore::~CredentialStore() {
+    close();
+}
+/**
+ * @description: 打开 dir 下的日志与索引，目录不存在时创建。索引缺失、损坏或落后于日志时，从日志重放补齐
+ * @param {char} *dir
+ * @param {bool} shared，多个进程同时打开同一目录时为 true，须在 fork 之后各自打开
+ * @return {*}
+ */
+bool CredentialStore::open(const char *dir, bool shared) {
+    assert(dir && !isOpen());
+    _shared = shared;
+    if (mkdir(dir, 0700) < 0 && errno != EEXIST) {
+        LOG_ERROR("Credential dir %s error: %d", dir, errno);
+        return false;
+    }
+    _log_path   = std::string(dir) + "/users.log";
+    _index_path = std::string(dir) + "/users.idx";
+    _log_fd     = ::open(_log_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (_log_fd < 0) {
+        LOG_ERROR("Open %s error: %d", _log_path.c_str(), errno);
+        return false;
+    }
+    /* 共享模式下其他进程可能正在追加，重放期间持有排他锁，末尾不完整的记录才可确定是崩溃残留 */
+    if (_shared && flock(_log_fd, LOCK_EX) < 0) {
+        LOG_ERROR("Lock %s error: %d", _log_path.c_str(), errno);
+        close();
+        return false;
+    }
+    bool loaded      = (!_shared && _loadIndex()) || _rebuildIndex(MIN_CAPACITY);
+    uint64_t indexed = loaded ? _header->log_size : 0;
+    bool replayed    = loaded && _replay(true);
+    if (_shared) {
+        flock(_log_fd, LOCK_UN);
+    }
+    if (!replayed) {
+        close();
+        return false;
+    }
+    LOG_INFO("Credentials: %llu users, %llu log bytes replayed", (unsigned long long)_header->count,
+             (unsigned long long)(_header->log_size - indexed));
+    return true;
+}
+
+void CredentialStore::close() {
+    _unmapIndex();
+    if (_log_fd >= 0) {
+        ::close(_log_fd);
+        _log_fd = -1;
+    }
+}
+/**
+ * @description: 校验口令，PBKDF2 计算在调用线程中进行，不持有锁
+ * @param {string_view} name
+ * @param {string_view} password
+ * @return {*}
+ */
+CredentialStore::RESULT CredentialStore::verify(std::string_view name, std::string_view password) {
+    if (!_validName(name) || password.empty()) {
+        return INVALID;
+    }
+    Record record;
+    bool found;
+    {
+        std::shared_lock<std::shared_mutex> locker(_mtx);
+        if (!isOpen()) {
+            return IO_ERROR;
+        }
+        found = _find(_tag(name), name, &record) != nullptr;
+    }
+    if (!found && _shared) {
+        /* 可能由其他进程注册 */
+        std::unique_lock<std::shared_mutex> locker(_mtx);
+        found = isOpen() && _catchUp() && _find(_tag(name), name, &record) != nullptr;
+    }
+    uint8_t hash[Sha256::DIGEST_SIZE];
+    if (!found) {
+        /* 不存在的用户同样计算一次，应答耗时不暴露用户名是否存在 */
+        memset(&record, 0, sizeof(record));
+        record.iterations = iterations;
+    }
+    Sha256::pbkdf2(password, record.salt, SALT_SIZE, record.iterations, hash, sizeof(hash));
+    if (!found) {
+        return NOT_FOUND;
+    }
+    return _equal(hash, record.hash, sizeof(hash)) ? OK : WRONG_PASSWORD;
+}
+/**
+ * @description: 注册用户。口令派生在锁外进行，追加日志与更新索引时独占
+ * @param {string_view} name
+ * @param {string_view} password
+ * @return {*}
+ */
+CredentialStore::RESULT CredentialStore::add(std::string_view name, std::string_view password) {
+    if (!_validName(name) || password.empty()) {
+        return INVALID;
+    }
+    uint64_t tag;
+    {
+        std::shared_lock<std::shared_mutex> locker(_mtx);
+        if (!isOpen()) {
+            return IO_ERROR;
+        }
+        tag = _tag(name);
+        Record record;
+        if (_find(tag, name, &record)) {
+            return EXISTS;
+        }
+    }
+
+    char buff[sizeof(Record) + MAX_NAME_LEN];
+    Record *record = reinterpret_cast<Record *>(buff);
+    memset(record, 0, sizeof(Record));
+    record->magic      = LOG_MAGIC;
+    record->iterations = iterations;
+    record->name_len   = static_cast<uint8_t>(name.size());
+    if (getrandom(record->salt, SALT_SIZE, 0) != (ssize_t)SALT_SIZE) {
+        LOG_ERROR("Credential salt error: %d", errno);
+        return IO_ERROR;
+    }
+    Sha256::pbkdf2(password, record->salt, SALT_SIZE, record->iterations, record->hash, sizeof(record->hash));
+    memcpy(buff + sizeof(Record), name.data(), name.size());
+    size_t len = sizeof(Record) + name.size();
+
+    std::unique_lock<std::shared_mutex> locker(_mtx);
+    if (!_shared) {
+        return _append(tag, name, buff, len);
+    }
+    if (flock(_log_fd, LOCK_EX) < 0) {
+        LOG_ERROR("Lock %s error: %d", _log_path.c_str(), errno);
+        return IO_ERROR;
+    }
+    RESULT ret = _replay(true) ? _append(tag, name, buff, len) : IO_ERROR;
+    flock(_log_fd, LOCK_UN);
+    return ret;
+}
+/**
+ * @description: 重名检查后在已建索引的日志末尾追加记录并更新索引。调用方独占 _mtx，共享模式下还持有文件排他锁
+ * @param {uint64_t} tag
+ * @param {string_view} name
+ * @param {char} *buff，完整的记录
+ * @param {size_t} len
+ * @return {*}
+ */
+CredentialStore::RESULT CredentialStore::_append(uint64_t tag, std::string_view name, const char *buff, size_t len) {
+    Record existing;
+    if (_find(tag, name, &existing)) {
+        return EXISTS;
+    }
+    uint64_t offset = _header->log_size;
+    if (pwrite(_log_fd, buff, len, offset) != (ssize_t)len || fdatasync(_log_fd) < 0) {
+        LOG_ERROR("Credential log write error: %d", errno);
+        if (ftruncate(_log_fd, offset) < 0) {
+            LOG_ERROR("Credential log truncate error: %d", errno);
+        }
+        return IO_ERROR;
+    }
+    _header->log_size = offset + len;
+    if (!_insert(tag, offset, name)) {
+        return IO_ERROR;
+    }
+    return OK;
+}
+
+size_t CredentialStore::size() const {
+    std::shared_lock<std::shared_mutex> locker(_mtx);
+    return _header ? _header->count : 0;
+}
+/**
+ * @description: 以随机盐派生口令，编码为 "pbkdf2-sha256$迭代次数$盐(hex)$摘要(hex)"，用于存放在外部存储中的凭据
+ * @param {string_view} password
+ * @return {*} 获取随机数失败时返回空串
+ */
+std::string CredentialStore::encodePassword(std::string_view password) {
+    uint8_t salt[SALT_SIZE], hash[Sha256::DIGEST_SIZE];
+    if (getrandom(salt, SALT_SIZE, 0) != (ssize_t)SALT_SIZE) {
+        LOG_ERROR("Credential salt error: %d", errno);
+        return std::string();
+    }
+    Sha256::pbkdf2(password, salt, SALT_SIZE, iterations, hash, sizeof(hash));
+    char buff[64];
+    std::string encoded(buff, snprintf(buff, sizeof(buff), "pbkdf2-sha256$%u$", iterations));
+    static const char HEX[] = "0123456789abcdef";
+    for (uint8_t byte : salt) {
+        encoded.push_back(HEX[byte >> 4]);
+        encoded.push_back(HEX[byte & 0xf]);
+    }
+    encoded.push_back('$');
+    for (uint8_t byte : hash) {
+        encoded.push_back(HEX[byte >> 4]);
+        encoded.push_back(HEX[byte & 0xf]);
+    }
+    return encoded;
+}
+/**
+ * @description: 校验 encodePassword 生成的凭据。格式不符时仍按默认迭代次数计算一次，耗时与用户是否存在无关
+ * @param {string_view} encoded，可以为空
+ * @param {string_view} password
+ * @return {*}
+ */
+bool CredentialStore::checkPassword(std::string_view encoded, std::string_view password) {
+    static const std::string_view PREFIX = "pbkdf2-sha256$";
+    uint8_t salt[SALT_SIZE] = {0}, expected[Sha256::DIGEST_SIZE] = {0}, hash[Sha256::DIGEST_SIZE];
+    uint32_t rounds         = iterations;
+    bool valid              = false;
+    if (encoded.substr(0, PREFIX.size()) == PREFIX) {
+        encoded.remove_prefix(PREFIX.size());
+        size_t sep          = encoded.find('$');
+        std::string num     = std::string(encoded.substr(0, sep));
+        char *end           = nullptr;
+        unsigned long value = strtoul(num.c_str(), &end, 10);
+        if (sep != std::string_view::npos && !num.empty() && *end == '\0' && value > 0 && value <= (1u << 24) &&
+            encoded.size() == sep + 1 + SALT_SIZE * 2 + 1 + Sha256::DIGEST_SIZE * 2 &&
+            encoded[sep + 1 + SALT_SIZE * 2] == '$') {
+            valid  = _fromHex(encoded.substr(sep + 1, SALT_SIZE * 2), salt) &&
+                     _fromHex(encoded.substr(sep + 2 + SALT_SIZE * 2), expected);
+            rounds = valid ? static_cast<uint32_t>(value) : rounds;
+        }
+    }
+    Sha256::pbkdf2(password, salt, SALT_SIZE, rounds, hash, sizeof(hash));
+    return valid && _equal(hash, expected, sizeof(hash));
+}
+/**
+ * @description: 映射已有的索引文件，格式不符或已建索引的日志长度超过日志文件时视为无效
+ * @return {*}
+ */
+bool CredentialStore::_loadIndex() {
+    _index_fd = ::open(_index_path.c_str(), O_RDWR | O_CLOEXEC);
+    if (_index_fd < 0) {
+        return false;
+    }
+    struct stat index_stat, log_stat;
+    if (fstat(_index_fd, &index_stat) < 0 || fstat(_log_fd, &log_stat) < 0 ||
+        (size_t)index_stat.st_size < sizeof(IndexHeader)) {
+        _unmapIndex();
+        return false;
+    }
+    _map_size = index_stat.st_size;
+    void *map = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED, _index_fd, 0);
+    if (map == MAP_FAILED) {
+        _map_size = 0;
+        _unmapIndex();
+        return false;
+    }
+    _header = static_cast<IndexHeader *>(map);
+    _slots  = reinterpret_cast<Slot *>(_header + 1);
+    if (_header->magic != INDEX_MAGIC || _header->capacity < MIN_CAPACITY ||
+        (_header->capacity & (_header->capacity - 1)) != 0 ||
+        _map_size != sizeof(IndexHeader) + _header->capacity * sizeof(Slot) ||
+        _header->count >= _header->capacity || _header->log_size > (uint64_t)log_stat.st_size) {
+        LOG_WARN("Credential index %s invalid, rebuilding", _index_path.c_str());
+        _unmapIndex();
+        return false;
+    }
+    return true;
+}
+/**
+ * @description: 以 capacity 个槽位新建索引文件，已映射的索引逐项重新散列进去；
+ *               新文件写完后 rename 替换旧文件，中途失败不影响旧索引
+ * @param {uint64_t} capacity
+ * @return {*}
+ */
+bool CredentialStore::_rebuildIndex(uint64_t capacity) {
+    std::string tmp_path = _index_path + ".tmp";
+    size_t map_size      = sizeof(IndexHeader) + capacity * sizeof(Slot);
+    int fd               = -1;
+    void *map;
+    if (_shared) {
+        /* 共享模式下索引只在本进程内存中 */
+        map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    } else {
+        fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+        if (fd < 0 || ftruncate(fd, map_size) < 0) {
+            LOG_ERROR("Credential index %s error: %d", tmp_path.c_str(), errno);
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            return false;
+        }
+        map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (map == MAP_FAILED) {
+        LOG_ERROR("Credential index mmap error: %d", errno);
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        return false;
+    }
+    IndexHeader *header = static_cast<IndexHeader *>(map);
+    Slot *slots         = reinterpret_cast<Slot *>(header + 1);
+    if (_header) {
+        *header = *_header;
+        for (uint64_t i = 0; i < _header->capacity; i++) {
+            if (_slots[i].tag) {
+                uint64_t pos = _slots[i].tag & (capacity - 1);
+                while (slots[pos].tag) {
+                    pos = (pos + 1) & (capacity - 1);
+                }
+                slots[pos] = _slots[i];
+            }
+        }
+    } else {
+        header->magic = INDEX_MAGIC;
+        if (getrandom(&header->seed, sizeof(header->seed), 0) != sizeof(header->seed)) {
+            header->seed = static_cast<uint64_t>(getpid()) << 32 ^ static_cast<uint64_t>(time(nullptr));
+        }
+    }
+    header->capacity = capacity;
+    if (!_shared && rename(tmp_path.c_str(), _index_path.c_str()) < 0) {
+        LOG_ERROR("Credential index rename error: %d", errno);
+        munmap(map, map_size);
+        ::close(fd);
+        return false;
+    }
+    _unmapIndex();
+    _index_fd = fd;
+    _header   = header;
+    _slots    = slots;
+    _map_size = map_size;
+    return true;
+}
+/**
+ * @description: 从 header.log_size 起顺序读取日志并补齐索引；末尾不完整或损坏的记录视为崩溃时的残留，截断丢弃
+ * @param {bool} truncate，为 false 时只停在残留处，用于共享模式下未持有排他锁的补齐
+ * @return {*}
+ */
+bool CredentialStore::_replay(bool truncate) {
+    struct stat log_stat;
+    if (fstat(_log_fd, &log_stat) < 0) {
+        return false;
+    }
+    uint64_t offset = _header->log_size;
+    uint64_t end    = log_stat.st_size;
+    char buff[64 << 10];
+    while (offset < end) {
+        ssize_t len = pread(_log_fd, buff, std::min<uint64_t>(sizeof(buff), end - offset), offset);
+        if (len <= 0) {
+            LOG_ERROR("Credential log read error: %d", errno);
+            return false;
+        }
+        size_t pos = 0;
+        while (pos + sizeof(Record) <= (size_t)len) {
+            const Record *record = reinterpret_cast<const Record *>(buff + pos);
+            if (record->magic != LOG_MAGIC || record->name_len == 0 || record->name_len > MAX_NAME_LEN) {
+                break;
+            }
+            size_t record_len = sizeof(Record) + record->name_len;
+            if (pos + record_len > (size_t)len) {
+                break;
+            }
+            std::string_view name(buff + pos + sizeof(Record), record->name_len);
+            if (!_insert(_tag(name), offset + pos, name)) {
+                return false;
+            }
+            pos += record_len;
+        }
+        if (pos == 0) {
+            /* 缓冲区开头即无法解析出完整记录 */
+            if (!truncate) {
+                break;
+            }
+            LOG_WARN("Credential log truncated at %llu, %llu bytes dropped", (unsigned long long)offset,
+                     (unsigned long long)(end - offset));
+            if (ftruncate(_log_fd, offset) < 0) {
+                return false;
+            }
+            break;
+        }
+        offset += pos;
+        _header->log_size = offset;
+    }
+    return true;
+}
+/**
+ * @description: 共享模式下补齐其他进程追加的记录，日志没有增长时只需一次 fstat。调用方独占 _mtx
+ * @return {*}
+ */
+bool CredentialStore::_catchUp() {
+    struct stat log_stat;
+    if (fstat(_log_fd, &log_stat) < 0) {
+        return false;
+    }
+    if ((uint64_t)log_stat.st_size <= _header->log_size) {
+        return true;
+    }
+    /* 追加方在写完并同步之前持有排他锁，共享锁下读到的记录都是完整的 */
+    if (flock(_log_fd, LOCK_SH) < 0) {
+        return false;
+    }
+    bool ret = _replay(false);
+    flock(_log_fd, LOCK_UN);
+    return ret;
+}
+/**
+ * @description: 插入或覆盖索引项，负载超过 1/2 时先扩容一倍
+ * @param {uint64_t} tag
+ * @param {uint64_t} offset
+ * @param {string_view} name
+ * @return {*}
+ */
+bool CredentialStore::_insert(uint64_t tag, uint64_t offset, std::string_view name) {
+    Record record;
+    if (Slot *slot = _find(tag, name, &record)) {
+        slot->offset = offset;
+        return true;
+    }
+    if ((_header->count + 1) * 2 > _header->capacity && !_rebuildIndex(_header->capacity * 2) &&
+        _header->count + 1 >= _header->capacity) {
+        return false;
+    }
+    uint64_t mask = _header->capacity - 1;
+    uint64_t pos  = tag & mask;
+    while (_slots[pos].tag) {
+        pos = (pos + 1) & mask;
+    }
+    _slots[pos].offset = offset;
+    _slots[pos].tag    = tag;
+    _header->count++;
+    return true;
+}
+/**
+ * @description: 线性探测查找用户，tag 相同时读取日志中的记录比对用户名
+ * @param {uint64_t} tag
+ * @param {string_view} name
+ * @param {Record} *record，找到时填入记录
+ * @return {*} 找到时返回槽位，否则返回 nullptr
+ */
+CredentialStore::Slot *CredentialStore::_find(uint64_t tag, std::string_view name, Record *record) const {
+    uint64_t mask = _header->capacity - 1;
+    for (uint64_t pos = tag & mask; _slots[pos].tag; pos = (pos + 1) & mask) {
+        if (_slots[pos].tag == tag && _readRecord(_slots[pos].offset, record, name)) {
+            return &_slots[pos];
+        }
+    }
+    return nullptr;
+}
+/**
+ * @description: 读取 offset 处的记录，用户名与 name 一致时返回 true
+ * @param {uint64_t} offset
+ * @param {Record} *record
+ * @param {string_view} name
+ * @return {*}
+ */
+bool CredentialStore::_readRecord(uint64_t offset, Record *record, std::string_view name) const {
+    char buff[sizeof(Record) + MAX_NAME_LEN];
+    size_t len = sizeof(Record) + name.size();
+    if (pread(_log_fd, buff, len, offset) != (ssize_t)len) {
+        return false;
+    }
+    memcpy(record, buff, sizeof(Record));
+    return record->magic == LOG_MAGIC && record->name_len == name.size() &&
+           memcmp(buff + sizeof(Record), name.data(), name.size()) == 0;
+}
+
+void CredentialStore::_unmapIndex() {
+    if (_header) {
+        munmap(_header, _map_size);
+        _header   = nullptr;
+        _slots    = nullptr;
+        _map_size = 0;
+    }
+    if (_index_fd >= 0) {
+        ::close(_index_fd);
+        _index_fd = -1;
+    }
+}
+/**
+ * @description: 带种子的 FNV-1a，最低位置 1 以区分空槽
+ * @param {string_view} name
+ * @return {*}
+ */
+uint64_t CredentialStore::_tag(std::string_view name) const {
+    uint64_t hash = 0xcbf29ce484222325ULL ^ _header->seed;
+    for (unsigned char ch : name) {
+        hash ^= ch;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash | 1;
+}
+/**
+ * @description: 用户名非空、不超过上限且不含控制字符
+ * @param {string_view} name
+ * @return {*}
+ */
+bool CredentialStore::_validName(std::string_view name) {
+    if (name.empty() || name.size() > MAX_NAME_LEN) {
+        return false;
+    }
+    for (unsigned char ch : name) {
+        if (ch < 0x20 || ch == 0x7f) {
+            return false;
+        }
+    }
+    return true;
+}
+/**
+ * @description: 十六进制串解码到 out，长度为 hex 的一半
+ * @param {string_view} hex
+ * @param {uint8_t} *out
+ * @return {*}
+ */
+bool CredentialStore::_fromHex(std::string_view hex, uint8_t *out) {
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        int value = 0;
+        for (size_t j = i; j < i + 2; j++) {
+            char ch = hex[j];
+            if (ch >= '0' && ch <= '9') {
+                value = value << 4 | (ch - '0');
+            } else if (ch >= 'a' && ch <= 'f') {
+                value = value << 4 | (ch - 'a' + 10);
+            } else {
+                return false;
+            }
+        }
+        out[i / 2] = static_cast<uint8_t>(value);
+    }
+    return true;
+}
+/**
+ * @description: 定长比较，耗时与首个不同字节的位置无关
+ * @param {uint8_t} *lhs
+ * @param {uint8_t} *rhs
+ * @param {size_t} len
+ * @return {*}
+ */
+bool CredentialStore::_equal(const uint8_t *lhs, const uint8_t *rhs, size_t len) {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= lhs[i] ^ rhs[i];
+    }
+    return diff == 0;
+}
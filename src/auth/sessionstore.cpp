@@ -0,0 +1,157 @@
+/*
+ * @Description: 分片的内存会话存储实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:52:16
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:52:16
+ */
+#include "sessionstore.h"
+
+#include <sys/random.h>
+
+/* 链表节点的前后指针，以及哈希表节点(键、迭代器、next 指针、缓存的哈希值)与桶指针 */
+static const size_t NODE_OVERHEAD = 2 * sizeof(void *) + sizeof(std::string_view) + 4 * sizeof(void *);
+
+/**
+ * @description:
+ * @param {size_t} shard_num，向上取整为 2 的幂
+ * @param {int} ttl_ms，会话空闲超过该时长失效
+ * @param {size_t} max_bytes，全部会话的内存预算，平均分配到各分片
+ * @return {*}
+ */
+SessionStore::SessionStore(size_t shard_num, int ttl_ms, size_t max_bytes)
+    : _ttl_ms(ttl_ms)
+    , _count(0)
+    , _bytes(0)
+    , _evicted(0) {
+    assert(shard_num > 0 && ttl_ms > 0 && max_bytes > 0);
+    size_t n = 1;
+    while (n < shard_num) {
+        n <<= 1;
+    }
+    _shards.reset(new Shard[n]);
+    _mask         = n - 1;
+    _shard_budget = max_bytes / n;
+}
+/**
+ * @description: 为用户创建会话
+ * @param {string_view} user
+ * @return {*} 会话 id，随机数不可用时返回空串
+ */
+std::string SessionStore::create(std::string_view user) {
+    Session session;
+    if (!_randomId(&session.id)) {
+        return std::string();
+    }
+    session.user    = user;
+    session.expires = Clock::now() + std::chrono::milliseconds(_ttl_ms);
+    session.bytes   = sizeof(Session) + session.id.capacity() + session.user.capacity() + NODE_OVERHEAD;
+    std::string id  = session.id;
+    size_t bytes    = session.bytes;
+
+    Shard &shard = _shard(id);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    shard.lru.push_front(std::move(session));
+    shard.index.emplace(shard.lru.front().id, shard.lru.begin());
+    shard.bytes += bytes;
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _bytes.fetch_add(bytes, std::memory_order_relaxed);
+    /* 超出预算时从尾部淘汰，刚创建的会话保留 */
+    while (shard.bytes > _shard_budget && shard.lru.size() > 1) {
+        _erase(shard, std::prev(shard.lru.end()));
+        _evicted.fetch_add(1, std::memory_order_relaxed);
+    }
+    return id;
+}
+/**
+ * @description: 查找未过期的会话，命中时续期
+ * @param {string_view} id
+ * @param {string} *user，可为 nullptr
+ * @return {*}
+ */
+bool SessionStore::lookup(std::string_view id, std::string *user) {
+    if (id.size() != ID_LEN) {
+        return false;
+    }
+    Shard &shard = _shard(id);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(id);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    SessionList::iterator session = it->second;
+    Clock::time_point now         = Clock::now();
+    if (session->expires <= now) {
+        _erase(shard, session);
+        return false;
+    }
+    session->expires = now + std::chrono::milliseconds(_ttl_ms);
+    shard.lru.splice(shard.lru.begin(), shard.lru, session);
+    if (user) {
+        *user = session->user;
+    }
+    return true;
+}
+
+bool SessionStore::remove(std::string_view id) {
+    if (id.size() != ID_LEN) {
+        return false;
+    }
+    Shard &shard = _shard(id);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(id);
+    if (it == shard.index.end()) {
+        return false;
+    }
+    _erase(shard, it->second);
+    return true;
+}
+/**
+ * @description: 清理已过期的会话，由服务器计时器周期调用。每个分片只检查尾部，代价与过期数量成正比
+ * @return {*} 清理的会话数
+ */
+size_t SessionStore::expire() {
+    size_t removed        = 0;
+    Clock::time_point now = Clock::now();
+    for (size_t i = 0; i <= _mask; i++) {
+        Shard &shard = _shards[i];
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        while (!shard.lru.empty() && shard.lru.back().expires <= now) {
+            _erase(shard, std::prev(shard.lru.end()));
+            removed++;
+        }
+    }
+    return removed;
+}
+
+SessionStore::Shard &SessionStore::_shard(std::string_view id) {
+    return _shards[std::hash<std::string_view>()(id) & _mask];
+}
+/**
+ * @description: 删除会话，调用方持有分片锁
+ * @param {Shard} &shard
+ * @param {iterator} it
+ * @return {*}
+ */
+void SessionStore::_erase(Shard &shard, SessionList::iterator it) {
+    shard.bytes -= it->bytes;
+    _count.fetch_sub(1, std::memory_order_relaxed);
+    _bytes.fetch_sub(it->bytes, std::memory_order_relaxed);
+    shard.index.erase(std::string_view(it->id));
+    shard.lru.erase(it);
+}
+
+bool SessionStore::_randomId(std::string *id) {
+    static const char HEX[] = "0123456789abcdef";
+    unsigned char raw[ID_LEN / 2];
+    if (getrandom(raw, sizeof(raw), 0) != (ssize_t)sizeof(raw)) {
+        return false;
+    }
+    id->resize(ID_LEN);
+    for (size_t i = 0; i < sizeof(raw); i++) {
+        (*id)[2 * i]     = HEX[raw[i] >> 4];
+        (*id)[2 * i + 1] = HEX[raw[i] & 0xf];
+    }
+    return true;
+}
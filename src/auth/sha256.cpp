@@ -0,0 +1,184 @@
+/*
+ * @Description: SHA-256 与 PBKDF2 实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:12:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:12:05
+ */
+#include "sha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+void Sha256::init() {
+    static const uint32_t IV[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(_state, IV, sizeof(_state));
+    _bits = 0;
+    _used = 0;
+}
+/**
+ * @description: 追加数据，凑满 64 字节的块立即压缩
+ * @param {void} *data
+ * @param {size_t} len
+ * @return {*}
+ */
+void Sha256::update(const void *data, size_t len) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    _bits += static_cast<uint64_t>(len) << 3;
+    if (_used > 0) {
+        size_t take = std::min(len, BLOCK_SIZE - _used);
+        memcpy(_block + _used, bytes, take);
+        _used += take;
+        bytes += take;
+        len -= take;
+        if (_used < BLOCK_SIZE) {
+            return;
+        }
+        _transform(_block);
+        _used = 0;
+    }
+    for (; len >= BLOCK_SIZE; bytes += BLOCK_SIZE, len -= BLOCK_SIZE) {
+        _transform(bytes);
+    }
+    memcpy(_block, bytes, len);
+    _used = len;
+}
+/**
+ * @description: 填充并输出大端序摘要，之后需 init() 才能复用
+ * @param {uint8_t} digest
+ * @return {*}
+ */
+void Sha256::final(uint8_t digest[DIGEST_SIZE]) {
+    uint64_t bits = _bits;
+    _block[_used++] = 0x80;
+    if (_used > BLOCK_SIZE - 8) {
+        memset(_block + _used, 0, BLOCK_SIZE - _used);
+        _transform(_block);
+        _used = 0;
+    }
+    memset(_block + _used, 0, BLOCK_SIZE - 8 - _used);
+    for (int i = 0; i < 8; i++) {
+        _block[BLOCK_SIZE - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+    _transform(_block);
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4]     = static_cast<uint8_t>(_state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(_state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(_state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(_state[i]);
+    }
+}
+
+void Sha256::_transform(const uint8_t block[BLOCK_SIZE]) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = static_cast<uint32_t>(block[i * 4]) << 24 | static_cast<uint32_t>(block[i * 4 + 1]) << 16 |
+               static_cast<uint32_t>(block[i * 4 + 2]) << 8 | static_cast<uint32_t>(block[i * 4 + 3]);
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i]        = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    uint32_t a = _state[0], b = _state[1], c = _state[2], d = _state[3];
+    uint32_t e = _state[4], f = _state[5], g = _state[6], h = _state[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h           = g;
+        g           = f;
+        f           = e;
+        e           = d + t1;
+        d           = c;
+        c           = b;
+        b           = a;
+        a           = t1 + t2;
+    }
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+    _state[4] += e;
+    _state[5] += f;
+    _state[6] += g;
+    _state[7] += h;
+}
+/**
+ * @description: PBKDF2-HMAC-SHA256 (RFC 8018)。HMAC 的内外两层以密钥填充后的状态预先计算一次，
+ *               每轮迭代只需两次压缩
+ * @param {string_view} password
+ * @param {uint8_t} *salt
+ * @param {size_t} salt_len
+ * @param {uint32_t} iterations
+ * @param {uint8_t} *out
+ * @param {size_t} out_len
+ * @return {*}
+ */
+void Sha256::pbkdf2(std::string_view password, const uint8_t *salt, size_t salt_len,
+                    uint32_t iterations, uint8_t *out, size_t out_len) {
+    uint8_t key[BLOCK_SIZE] = {0};
+    if (password.size() > BLOCK_SIZE) {
+        Sha256 hash;
+        hash.update(password.data(), password.size());
+        hash.final(key);
+    } else {
+        memcpy(key, password.data(), password.size());
+    }
+    uint8_t pad[BLOCK_SIZE];
+    Sha256 inner, outer;
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        pad[i] = key[i] ^ 0x36;
+    }
+    inner.update(pad, BLOCK_SIZE);
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        pad[i] = key[i] ^ 0x5c;
+    }
+    outer.update(pad, BLOCK_SIZE);
+
+    for (uint32_t index = 1; out_len > 0; index++) {
+        uint8_t u[DIGEST_SIZE], t[DIGEST_SIZE];
+        uint8_t counter[4] = {static_cast<uint8_t>(index >> 24), static_cast<uint8_t>(index >> 16),
+                              static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index)};
+        Sha256 ctx = inner;
+        ctx.update(salt, salt_len);
+        ctx.update(counter, sizeof(counter));
+        ctx.final(u);
+        ctx = outer;
+        ctx.update(u, DIGEST_SIZE);
+        ctx.final(u);
+        memcpy(t, u, DIGEST_SIZE);
+        for (uint32_t round = 1; round < iterations; round++) {
+            ctx = inner;
+            ctx.update(u, DIGEST_SIZE);
+            ctx.final(u);
+            ctx = outer;
+            ctx.update(u, DIGEST_SIZE);
+            ctx.final(u);
+            for (size_t i = 0; i < DIGEST_SIZE; i++) {
+                t[i] ^= u[i];
+            }
+        }
+        size_t take = std::min(out_len, DIGEST_SIZE);
+        memcpy(out, t, take);
+        out += take;
+        out_len -= take;
+    }
+}
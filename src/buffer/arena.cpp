@@ -0,0 +1,109 @@
+/*
+ * @Description: 线性(bump)内存分配器实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 10:40:18
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 10:40:18
+ */
+#include "arena.h"
+
+#include <cstring>
+
+std::atomic<size_t> Arena::total_heap_allocs(0);
+
+Arena::Arena()
+    : _capacity(0)
+    , _cur_block(0)
+    , _offset(0)
+    , _heap_allocs(0) {}
+
+Arena::~Arena() {
+    release();
+}
+/**
+ * @description: 从当前块中按对齐要求切出 len 字节，空间不足时顺延到下一个块，
+ *               所有块都不够时才从内存池申请新块
+ * @param {size_t} len
+ * @param {size_t} align，必须为 2 的幂
+ * @return {*}
+ */
+void *Arena::allocate(size_t len, size_t align) {
+    assert(align > 0 && (align & (align - 1)) == 0);
+    while (true) {
+        while (_cur_block < _blocks.size()) {
+            std::vector<char> &block = _blocks[_cur_block];
+            size_t begin             = (_offset + align - 1) & ~(align - 1);
+            if (begin + len <= block.size()) {
+                _offset = begin + len;
+                return block.data() + begin;
+            }
+            _cur_block++;
+            _offset = 0;
+        }
+        _newBlock(len + align);
+    }
+}
+/**
+ * @description: 拷贝一段字符串到 arena，并以 '\0' 结尾
+ * @param {char} *str
+ * @param {size_t} len
+ * @return {*}
+ */
+char *Arena::copy(const char *str, size_t len) {
+    char *dst = static_cast<char *>(allocate(len + 1, 1));
+    if (len) {
+        memcpy(dst, str, len);
+    }
+    dst[len] = '\0';
+    return dst;
+}
+/**
+ * @description: 拼接两段字符串到 arena，结果以 '\0' 结尾
+ * @param {string_view} lhs
+ * @param {string_view} rhs
+ * @return {*}
+ */
+std::string_view Arena::concat(std::string_view lhs, std::string_view rhs) {
+    size_t len = lhs.size() + rhs.size();
+    char *dst  = static_cast<char *>(allocate(len + 1, 1));
+    memcpy(dst, lhs.data(), lhs.size());
+    memcpy(dst + lhs.size(), rhs.data(), rhs.size());
+    dst[len] = '\0';
+    return std::string_view(dst, len);
+}
+/**
+ * @description: O(1) 回收全部分配，保留已申请的块供下一请求复用
+ * @return {*}
+ */
+void Arena::reset() {
+    _cur_block = 0;
+    _offset    = 0;
+}
+/**
+ * @description: 所有块归还内存池，用于空闲连接归还内存
+ * @return {*}
+ */
+void Arena::release() {
+    for (auto &block : _blocks) {
+        BufferPool::getInstance()->release(block);
+    }
+    _blocks.clear();
+    _capacity  = 0;
+    _cur_block = 0;
+    _offset    = 0;
+}
+/**
+ * @description: 从内存池申请新块并追加到块链表尾部，超出标准块大小时才会直接向堆申请
+ * @param {size_t} len
+ * @return {*}
+ */
+void Arena::_newBlock(size_t len) {
+    BufferPool *pool = BufferPool::getInstance();
+    if (len > pool->blockSize()) {
+        _heap_allocs++;
+        total_heap_allocs++;
+    }
+    _blocks.push_back(pool->acquire(len));
+    _capacity += _blocks.back().size();
+}
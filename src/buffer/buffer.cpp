@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-20 18:00:45
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:51:15
+ * @LastEditTime: 2026-10-19 12:16:02
  */
 #include "buffer.h"
 
@@ -63,7 +63,9 @@ void Buffer::hasReadUntil(const char *end) {
  * @return {*}
  */
 void Buffer::reset() {
-    bzero(&_buffer[0], _buffer.size());
+    if (!_buffer.empty()) {
+        bzero(&_buffer[0], _buffer.size());
+    }
     _read_pos  = 0;
     _write_pos = 0;
 }
@@ -93,10 +95,10 @@ void Buffer::hasWritten(size_t len) {
 }
 /**
  * @description: 将字符串，加入缓冲区
- * @param {string} &str
+ * @param {string_view} str
  * @return {*}
  */
-void Buffer::append(const std::string &str) {
+void Buffer::append(std::string_view str) {
     append(str.data(), str.length());
 }
 /**
@@ -125,6 +127,9 @@ void Buffer::append(Buffer &buff) {
  * @return {*}
  */
 void Buffer::ensureWriteable(size_t len) {
+    if (_buffer.empty()) {
+        _restore(len);
+    }
     if (writableBytes() < len) {
         _expandBuffer(len);
     }
@@ -137,6 +142,9 @@ void Buffer::ensureWriteable(size_t len) {
  * @return {*}
  */
 ssize_t Buffer::readFd(int fd, int *save_errno) {
+    if (_buffer.empty()) {
+        _restore(0);
+    }
     char buff[65535];
     struct iovec iov[2];
     const size_t data_size = writableBytes();
@@ -180,7 +188,37 @@ ssize_t Buffer::writeFd(int fd, int *save_errno) {
  * @return {*}
  */
 char *Buffer::_beginPtr() {
-    return &*_buffer.begin();
+    return _buffer.data();
+}
+/**
+ * @description: 缓冲区无未读数据时，将底层内存归还内存池，下次写入时再取回
+ * @return {*}
+ */
+void Buffer::shrink() {
+    if (_buffer.empty() || readableBytes() > 0) {
+        return;
+    }
+    BufferPool::getInstance()->release(_buffer);
+    _read_pos  = 0;
+    _write_pos = 0;
+}
+/**
+ * @description: 返回缓冲区当前占用的内存大小
+ * @return {*}
+ */
+size_t Buffer::capacity() const {
+    return _buffer.capacity();
+}
+/**
+ * @description: 从内存池取回底层内存
+ * @param {size_t} len
+ * @return {*}
+ */
+void Buffer::_restore(size_t len) {
+    assert(_buffer.empty());
+    _buffer    = BufferPool::getInstance()->acquire(len);
+    _read_pos  = 0;
+    _write_pos = 0;
 }
 /**
  * @description: 回收/扩展缓冲区容量
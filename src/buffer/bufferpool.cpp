@@ -0,0 +1,125 @@
+/*
+ * @Description: 缓冲区内存池实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 09:12:40
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include "bufferpool.h"
+
+#include <algorithm>
+
+thread_local BufferPool::LocalCache BufferPool::_local;
+
+BufferPool::LocalCache::~LocalCache() {
+    BufferPool::getInstance()->_flush(blocks, blocks.size());
+}
+
+BufferPool::BufferPool()
+    : _block_size(DEFAULT_BLOCK_SIZE)
+    , _max_blocks(DEFAULT_MAX_BLOCKS)
+    , _heap_allocs(0) {}
+
+BufferPool *BufferPool::getInstance() {
+    static BufferPool inst;
+    return &inst;
+}
+/**
+ * @description: 配置内存块大小与池中最多缓存的块数量
+ * @param {size_t} block_size
+ * @param {size_t} max_blocks
+ * @return {*}
+ */
+void BufferPool::init(size_t block_size, size_t max_blocks) {
+    std::lock_guard<std::mutex> locker(_mtx);
+    _block_size = block_size;
+    _max_blocks = max_blocks;
+    _free_blocks.clear();
+}
+/**
+ * @description: 获取一个至少 len 字节的内存块，标准大小的块优先从本线程缓存取，缓存为空时从全局池成批补充
+ * @param {size_t} len
+ * @return {*}
+ */
+std::vector<char> BufferPool::acquire(size_t len) {
+    std::vector<char> block;
+    if (len <= _block_size) {
+        BlockList &local = _local.blocks;
+        if (local.empty()) {
+            _refill(local);
+        }
+        if (!local.empty()) {
+            block.swap(local.back());
+            local.pop_back();
+        }
+    }
+    if (block.size() < len || block.empty()) {
+        block.resize(len > _block_size ? len : _block_size);
+        _heap_allocs++;
+    }
+    return block;
+}
+/**
+ * @description: 归还内存块到本线程缓存，缓存满时成批归还全局池；扩容过的块直接释放，避免池中驻留大块内存
+ * @param {vector<char>} &block，调用后为空
+ * @return {*}
+ */
+void BufferPool::release(std::vector<char> &block) {
+    if (block.size() != _block_size) {
+        std::vector<char>().swap(block);
+        return;
+    }
+    BlockList &local = _local.blocks;
+    local.emplace_back();
+    local.back().swap(block);
+    if (local.size() > LOCAL_MAX_BLOCKS) {
+        _flush(local, LOCAL_BATCH);
+    }
+}
+/**
+ * @description: 从全局池取至多 LOCAL_BATCH 个块放入线程缓存
+ * @param {BlockList} &local
+ * @return {*}
+ */
+void BufferPool::_refill(BlockList &local) {
+    std::lock_guard<std::mutex> locker(_mtx);
+    size_t count = std::min(LOCAL_BATCH, _free_blocks.size());
+    for (size_t i = 0; i < count; i++) {
+        local.emplace_back();
+        local.back().swap(_free_blocks.back());
+        _free_blocks.pop_back();
+    }
+}
+/**
+ * @description: 线程缓存末尾的 count 个块归还全局池，全局池已满的部分直接释放
+ * @param {BlockList} &local
+ * @param {size_t} count
+ * @return {*}
+ */
+void BufferPool::_flush(BlockList &local, size_t count) {
+    std::lock_guard<std::mutex> locker(_mtx);
+    for (size_t i = 0; i < count; i++) {
+        if (local.back().size() == _block_size && _free_blocks.size() < _max_blocks) {
+            _free_blocks.emplace_back();
+            _free_blocks.back().swap(local.back());
+        }
+        local.pop_back();
+    }
+}
+/**
+ * @description: 返回池中空闲块数量
+ * @return {*}
+ */
+size_t BufferPool::pooledBlocks() {
+    std::lock_guard<std::mutex> locker(_mtx);
+    return _free_blocks.size();
+}
+/**
+ * @description: 返回池中空闲块占用的字节数
+ * @return {*}
+ */
+size_t BufferPool::pooledBytes() {
+    std::lock_guard<std::mutex> locker(_mtx);
+    return _free_blocks.size() * _block_size;
+}
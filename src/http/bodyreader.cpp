@@ -0,0 +1,210 @@
+/*
+ * @Description: 请求 body 增量读取实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 14:20:11
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include "bodyreader.h"
+
+#include <algorithm>
+#include <cstring>
+
+size_t BodyReader::max_body_size  = 1 << 20;
+size_t BodyReader::max_chunk_line = 1024;
+/**
+ * @description: 收集器初始化
+ * @param {Arena} *arena
+ * @param {size_t} hint，已知的 body 长度，用于一次性分配
+ * @param {size_t} limit，最多收集的字节数
+ * @return {*}
+ */
+void BodyCollector::init(Arena *arena, size_t hint, size_t limit) {
+    _arena    = arena;
+    _data     = nullptr;
+    _size     = 0;
+    _capacity = 0;
+    _hint     = hint;
+    _limit    = limit;
+}
+/**
+ * @description: 追加 body 切片，arena 中容量不足时按倍数重新分配
+ * @param {string_view} slice
+ * @return {*}
+ */
+bool BodyCollector::onBodyData(std::string_view slice) {
+    if (_size + slice.size() > _limit) {
+        return false;
+    }
+    if (_size + slice.size() > _capacity) {
+        assert(_arena);
+        size_t capacity = std::max({_capacity * 2, _size + slice.size(), _hint});
+        capacity        = std::min(capacity, _limit);
+        char *data      = static_cast<char *>(_arena->allocate(capacity, 1));
+        if (_size) {
+            memcpy(data, _data, _size);
+        }
+        _data     = data;
+        _capacity = capacity;
+    }
+    memcpy(_data + _size, slice.data(), slice.size());
+    _size += slice.size();
+    return true;
+}
+/**
+ * @description: 读取状态初始化
+ * @return {*}
+ */
+void BodyReader::init() {
+    _state         = NONE;
+    _remaining     = 0;
+    _received      = 0;
+    _trailer_bytes = 0;
+    _error_code    = 0;
+}
+/**
+ * @description: 按 Content-Length 读取
+ * @param {size_t} len
+ * @return {*}
+ */
+void BodyReader::initLength(size_t len) {
+    init();
+    if (len > max_body_size) {
+        _fail(413);
+        return;
+    }
+    _remaining = len;
+    _state     = len ? LENGTH : DONE;
+}
+/**
+ * @description: 按 chunked 编码读取
+ * @return {*}
+ */
+void BodyReader::initChunked() {
+    init();
+    _state = CHUNK_SIZE;
+}
+/**
+ * @description: 消费缓冲区中已到达的 body 字节并交付给接收者，数据不足时保留状态等待下一次读取
+ * @param {Buffer} &buff
+ * @param {BodySink} *sink，为空时丢弃数据
+ * @return {*}
+ */
+BodyReader::READ_STATE BodyReader::feed(Buffer &buff, BodySink *sink) {
+    const char CRLF[] = "\r\n";
+    while (true) {
+        switch (_state) {
+        case LENGTH:
+        case CHUNK_DATA:
+            if (buff.readableBytes() == 0) {
+                return _state;
+            }
+            if (_deliver(buff, sink, _state == LENGTH ? DONE : CHUNK_CRLF) == ERROR) {
+                return ERROR;
+            }
+            break;
+        case CHUNK_CRLF:
+            if (buff.readableBytes() < 2) {
+                return _state;
+            }
+            if (memcmp(buff.beginRead(), CRLF, 2) != 0) {
+                return _fail(400);
+            }
+            buff.hasRead(2);
+            _state = CHUNK_SIZE;
+            break;
+        case CHUNK_SIZE:
+        case TRAILER: {
+            const char *lineEnd = std::search(buff.beginRead(), buff.beginWrite(), CRLF, CRLF + 2);
+            if (lineEnd == buff.beginWrite()) {
+                return buff.readableBytes() > max_chunk_line ? _fail(400) : _state;
+            }
+            std::string_view line(buff.beginRead(), lineEnd - buff.beginRead());
+            if (line.size() > max_chunk_line) {
+                /* 整行一次到达时同样受长度限制，与分多次到达的结果一致 */
+                return _fail(400);
+            }
+            buff.hasReadUntil(lineEnd + 2);
+            if (_state == CHUNK_SIZE) {
+                if (_parseChunkSize(line) == ERROR) {
+                    return ERROR;
+                }
+            } else if (line.empty()) {
+                _state = DONE;
+            } else if ((_trailer_bytes += line.size() + 2) > max_chunk_line) {
+                /* trailer 字段不使用，只限制长度 */
+                return _fail(400);
+            }
+            break;
+        }
+        default:
+            return _state;
+        }
+    }
+}
+/**
+ * @description: 交付当前块剩余的数据，交付完毕后进入 next 状态
+ * @param {Buffer} &buff
+ * @param {BodySink} *sink
+ * @param {READ_STATE} next
+ * @return {*}
+ */
+BodyReader::READ_STATE BodyReader::_deliver(Buffer &buff, BodySink *sink, READ_STATE next) {
+    size_t len = std::min(_remaining, buff.readableBytes());
+    if (sink && !sink->onBodyData(std::string_view(buff.beginRead(), len))) {
+        return _fail(sink->errorCode());
+    }
+    buff.hasRead(len);
+    _remaining -= len;
+    _received += len;
+    if (_remaining == 0) {
+        _state = next;
+    }
+    return _state;
+}
+/**
+ * @description: 解析 chunk-size 行，格式为 "十六进制长度[;扩展]"
+ * @param {string_view} line
+ * @return {*}
+ */
+BodyReader::READ_STATE BodyReader::_parseChunkSize(std::string_view line) {
+    size_t size = 0;
+    size_t i    = 0;
+    for (; i < line.size(); i++) {
+        char ch = line[i];
+        int digit;
+        if (ch >= '0' && ch <= '9') {
+            digit = ch - '0';
+        } else if (ch >= 'a' && ch <= 'f') {
+            digit = ch - 'a' + 10;
+        } else if (ch >= 'A' && ch <= 'F') {
+            digit = ch - 'A' + 10;
+        } else {
+            break;
+        }
+        if (size > (max_body_size >> 4)) {
+            return _fail(413);
+        }
+        size = (size << 4) | digit;
+    }
+    if (i == 0 || (i < line.size() && line[i] != ';' && line[i] != ' ' && line[i] != '\t')) {
+        return _fail(400);
+    }
+    if (_received + size > max_body_size) {
+        return _fail(413);
+    }
+    _remaining = size;
+    _state     = size ? CHUNK_DATA : TRAILER;
+    return _state;
+}
+/**
+ * @description: 进入错误状态
+ * @param {int} code，应答的 HTTP 状态码
+ * @return {*}
+ */
+BodyReader::READ_STATE BodyReader::_fail(int code) {
+    _error_code = code;
+    _state      = ERROR;
+    return ERROR;
+}
@@ -0,0 +1,113 @@
+/*
+ * @Description: 请求流量采集实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 20:58:14
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:58:14
+ */
+#include "capture.h"
+
+#include <fcntl.h>
+#include <math.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+TrafficCapture::TrafficCapture(double sample_rate, size_t max_bytes)
+    : _fd(-1)
+    , _sample_rate(sample_rate)
+    , _max_bytes(max_bytes)
+    , _start_ns(0)
+    , _seq(0)
+    , _bytes(0)
+    , _full(false) {}
+
+TrafficCapture::~TrafficCapture() {
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+/**
+ * @description: 创建采集文件并写入魔数，已存在的文件被覆盖
+ * @param {char} *path
+ * @return {*}
+ */
+bool TrafficCapture::open(const char *path) {
+    _fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (_fd < 0) {
+        LOG_ERROR("Open capture file %s error: %s", path, strerror(errno));
+        return false;
+    }
+    if (write(_fd, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) != sizeof(CAPTURE_MAGIC)) {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    _path     = path;
+    _start_ns = _now();
+    _bytes    = sizeof(CAPTURE_MAGIC);
+    return true;
+}
+/**
+ * @description: 新连接建立时决定是否采集，按比例均匀抽样
+ * @return {*} 采集时返回连接编号并写入 OPEN 记录，否则返回 0
+ */
+uint32_t TrafficCapture::sample() {
+    if (_fd < 0 || _full.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    uint32_t seq = ++_seq;
+    if (floor(seq * _sample_rate) == floor((seq - 1) * _sample_rate)) {
+        return 0;
+    }
+    record(seq, CaptureRecord::OPEN);
+    return seq;
+}
+/**
+ * @description: 写入一条记录，超出容量上限后不再写入
+ * @param {uint32_t} conn
+ * @param {TYPE} type
+ * @param {char} *data，只有 DATA 记录带数据
+ * @param {uint32_t} len
+ * @return {*}
+ */
+void TrafficCapture::record(uint32_t conn, CaptureRecord::TYPE type, const char *data, uint32_t len) {
+    CaptureRecord record = {};
+    record.conn          = conn;
+    record.type          = type;
+    record.len           = len;
+
+    struct iovec iov[2];
+    iov[0].iov_base = &record;
+    iov[0].iov_len  = sizeof(record);
+    iov[1].iov_base = const_cast<char *>(data);
+    iov[1].iov_len  = type == CaptureRecord::DATA ? len : 0;
+
+    std::lock_guard<std::mutex> locker(_mtx);
+    if (_full) {
+        return;
+    }
+    if (_bytes + iov[0].iov_len + iov[1].iov_len > _max_bytes) {
+        _full = true;
+        LOG_WARN("Capture %s reached %zu bytes, stopped", _path.c_str(), _max_bytes);
+        return;
+    }
+    /* 在锁内取时间，文件中的记录按时间有序 */
+    record.time_ns = _now() - _start_ns;
+    ssize_t ret    = writev(_fd, iov, iov[1].iov_len ? 2 : 1);
+    if (ret < 0) {
+        _full = true;
+        LOG_ERROR("Write capture %s error: %s", _path.c_str(), strerror(errno));
+        return;
+    }
+    _bytes += ret;
+}
+
+uint64_t TrafficCapture::_now() const {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
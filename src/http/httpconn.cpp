@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:51:39
+ * @LastEditTime: 2026-10-19 23:59:47
  */
 #include "httpconn.h"
 
@@ -13,11 +13,29 @@ using namespace std;
 const char *HttpConn::src_dir;
 std::atomic<int> HttpConn::user_count;
 bool HttpConn::is_et;
+const char *HttpConn::upload_dir;
+UploadHandler HttpConn::upload_handler;
+const Router *HttpConn::router;
+std::function<void(HttpConn *)> HttpConn::resume_handler;
+TrafficCapture *HttpConn::capture;
+std::atomic<bool> HttpConn::draining;
 
 HttpConn::HttpConn()
     : _fd(-1)
     , _addr({0})
-    , _is_close(false) {};
+    , _is_close(false)
+    , _is_idle(true)
+    , _dispatched(false)
+    , _accepted_ns(0)
+    , _ready_ns(0)
+    , _idle_ns(0)
+    , _capture_id(0)
+    , _trace_id(0)
+    , _read_buff(0)
+    , _write_buff(0) {
+    /* 只捕获 this，存放在 std::function 的内联存储中 */
+    _response.setResumeHandler([this] { _onResume(); });
+};
 
 HttpConn::~HttpConn() {
     disconn();
@@ -33,9 +51,23 @@ void HttpConn::init(int fd, const sockaddr_in &addr) {
     user_count++;
     _addr = addr;
     _fd   = fd;
+    _response.setSocket(fd);
     _write_buff.reset();
     _read_buff.reset();
-    _is_close = false;
+    _is_close    = false;
+    _is_idle     = true;
+    _dispatched  = false;
+    _accepted_ns = Metrics::now();
+    _ready_ns    = 0;
+    _idle_ns     = 0;
+    _capture_id  = capture ? capture->sample() : 0;
+    _trace_id    = Tracer::sample();
+    if (_trace_id) {
+        Tracer::instant("accept", _trace_id, "fd", fd);
+    }
+    Metrics::add(Metrics::CONN_ACCEPTED);
+    Metrics::addGauge(Metrics::CONNECTIONS, 1);
+    PROBE2(conn_accept, fd, (int)user_count);
     LOG_INFO("Client[%d](%s:%d) in, user_count:%d", _fd, getIP(), getPort(), (int)user_count);
 }
 /**
@@ -44,10 +76,23 @@ void HttpConn::init(int fd, const sockaddr_in &addr) {
  */
 void HttpConn::disconn() {
     _response.unmapFile();
+    _upload.close();
+    _shed();
     if (_is_close == false) {
         _is_close = true;
         user_count--;
         close(_fd);
+        PROBE1(conn_close, _fd);
+        if (_capture_id) {
+            capture->record(_capture_id, CaptureRecord::CLOSE);
+            _capture_id = 0;
+        }
+        if (_trace_id) {
+            Tracer::instant("close", _trace_id, "fd", _fd);
+            _trace_id = 0;
+        }
+        Metrics::add(Metrics::CONN_CLOSED);
+        Metrics::addGauge(Metrics::CONNECTIONS, -1);
         LOG_INFO("Client[%d](%s:%d) quit, user_count:%d", _fd, getIP(), getPort(), (int)user_count);
     }
 }
@@ -86,12 +131,41 @@ int HttpConn::getPort() const {
  */
 ssize_t HttpConn::read(int *save_errno) {
     ssize_t len = -1;
+    _is_idle    = false;
+    if (_upload.active()) {
+        /* 上传 body 由内核直接搬运到临时文件 */
+        do {
+            len = _upload.splice(_fd, save_errno);
+            if (len > 0) {
+                Metrics::add(Metrics::BYTES_IN, len);
+                if (_capture_id) {
+                    /* body 不经过用户态，只记录长度 */
+                    capture->record(_capture_id, CaptureRecord::GAP, nullptr, len);
+                }
+            }
+        } while (is_et && len > 0 && !_upload.done());
+        return len;
+    }
     do {
         len = _read_buff.readFd(_fd, save_errno);
         if (len <= 0) {
             break;
         }
-    } while (is_et);
+        Metrics::add(Metrics::BYTES_IN, len);
+        if (_capture_id) {
+            /* 新读入的数据位于可读区域末尾 */
+            capture->record(_capture_id, CaptureRecord::DATA, _read_buff.beginRead() + _read_buff.readableBytes() - len,
+                            len);
+        }
+        if (_accepted_ns) {
+            Metrics::since(Metrics::STAGE_FIRST_BYTE, _accepted_ns);
+            _accepted_ns = 0;
+        } else if (_idle_ns) {
+            Metrics::since(Metrics::STAGE_IDLE, _idle_ns);
+            _idle_ns = 0;
+        }
+        /* 超过高水位先交给解析消费，剩余数据在重新注册 EPOLLIN 后继续读取 */
+    } while (is_et && _read_buff.readableBytes() < READ_HIGH_WATER);
     return len;
 }
 /**
@@ -102,11 +176,17 @@ ssize_t HttpConn::read(int *save_errno) {
 ssize_t HttpConn::write(int *save_errno) {
     ssize_t len = -1;
     do {
-        len = writev(_fd, _iov, _iov_cnt);
+        uint64_t start = _trace_id ? Metrics::now() : 0;
+        len            = writev(_fd, _iov, _iov_cnt);
+        PROBE3(writev, _fd, len, len < 0 ? errno : 0);
+        if (_trace_id) {
+            Tracer::span("writev", _trace_id, start, Metrics::now(), "bytes", len);
+        }
         if (len <= 0) {
             *save_errno = errno;
             break;
         }
+        Metrics::add(Metrics::BYTES_OUT, len);
         if (_iov[0].iov_len + _iov[1].iov_len == 0) {
             break;
         } /* 传输结束 */
@@ -123,6 +203,11 @@ ssize_t HttpConn::write(int *save_errno) {
             _write_buff.hasRead(len);
         }
     } while (is_et || toWriteBytes() > 10240);
+    if (toWriteBytes() == 0 && _ready_ns) {
+        _idle_ns = Metrics::now();
+        Metrics::record(Metrics::STAGE_WRITE, _idle_ns - _ready_ns);
+        _ready_ns = 0;
+    }
     return len;
 }
 /**
@@ -130,17 +215,104 @@ ssize_t HttpConn::write(int *save_errno) {
  * @return {*}
  */
 bool HttpConn::process() {
-    _request.init();
+    if (_upload.active()) {
+        return _upload.done() ? _onUploadComplete() : false;
+    }
+    /* 上一请求已完成，或尚未读到完整的请求行时，开始解析新请求 */
+    if (_request.state() == HttpRequest::FINISH || _request.state() == HttpRequest::REQUEST_LINE) {
+        /* 先释放请求持有的临时文件等资源，再重置其所在的 arena */
+        _request.release();
+        _arena.reset();
+        _request.init(&_arena);
+    }
     if (_read_buff.readableBytes() <= 0) {
+        if (_request.state() == HttpRequest::REQUEST_LINE) {
+            _shed();
+        }
+        return false;
+    }
+    uint64_t start             = Metrics::now();
+    HttpRequest::HTTP_CODE ret = _request.parse(_read_buff);
+    uint64_t end               = Metrics::now();
+    Metrics::record(Metrics::STAGE_PARSE, end - start);
+    if (_trace_id) {
+        Tracer::span("parse", _trace_id, start, end, "result", ret);
+    }
+    if (ret == HttpRequest::NO_REQUEST) {
+        /* 请求不完整，等待更多数据 */
         return false;
-    } else if (_request.parse(_read_buff)) {
-        LOG_DEBUG("%s", _request.path().c_str());
-        _response.init(src_dir, _request.path(), _request.isKeepAlive(), 200);
+    } else if (ret == HttpRequest::UPLOAD_REQUEST) {
+        return _onUploadStart();
+    } else if (ret == HttpRequest::GET_REQUEST) {
+        LOG_DEBUG("%.*s", (int)_request.path().size(), _request.path().data());
+        _response.init(&_arena, src_dir, _request.path(), _request.isKeepAlive() && !draining, 200);
+        _dispatch();
+        if (_response.isDeferred()) {
+            return false;
+        }
     } else {
-        _response.init(src_dir, _request.path(), false, 400);
+        _response.init(&_arena, src_dir, _request.path(), false, _request.errorCode());
     }
 
+    start = Metrics::now();
     _response.makeResponse(_write_buff);
+    end = Metrics::now();
+    Metrics::record(Metrics::STAGE_RESPONSE, end - start);
+    if (_trace_id) {
+        Tracer::span("response", _trace_id, start, end, "code", _response.code());
+    }
+    _prepareWrite();
+    return true;
+}
+/**
+ * @description: 请求交给路由表中的处理函数；没有匹配的路由时按静态文件处理，
+ *               路径已注册但方法未注册时，除 GET 外均应答 405
+ * @return {*}
+ */
+void HttpConn::_dispatch() {
+    if (!router) {
+        return;
+    }
+    const RouteHandler *handler = nullptr;
+    int code                    = _request.route(*router, &handler);
+    if (code == 200) {
+        (*handler)(_request, _response);
+    } else if (code == 405 && _request.method() != "GET") {
+        _response.setCode(405);
+    }
+}
+/**
+ * @description: 执行处理函数延后的任务，应在本线程最后一次访问连接时调用，此后连接归任务所有，直到 resume
+ * @return {*}
+ */
+void HttpConn::runDeferred() {
+    _response.runDeferred();
+}
+/**
+ * @description: 延后的处理结果就绪，构造应答并交还事件循环
+ * @return {*}
+ */
+void HttpConn::_onResume() {
+    uint64_t start = Metrics::now();
+    _response.makeResponse(_write_buff);
+    uint64_t end = Metrics::now();
+    Metrics::record(Metrics::STAGE_RESPONSE, end - start);
+    if (_trace_id) {
+        Tracer::span("response", _trace_id, start, end, "code", _response.code());
+    }
+    _prepareWrite();
+    resume_handler(this);
+}
+/**
+ * @description: 响应构造完毕，设置集中写的 iovec：响应头 + 映射的文件
+ * @return {*}
+ */
+void HttpConn::_prepareWrite() {
+    Metrics::addStatus(_response.code());
+    _ready_ns = Metrics::now();
+    if (_capture_id) {
+        capture->record(_capture_id, CaptureRecord::RESPONSE, nullptr, _response.code());
+    }
     /* 响应头 */
     _iov[0].iov_base = const_cast<char *>(_write_buff.beginRead());
     _iov[0].iov_len  = _write_buff.readableBytes();
@@ -152,6 +324,70 @@ bool HttpConn::process() {
         _iov[1].iov_len  = _response.fileLen();
         _iov_cnt         = 2;
     }
+    PROBE3(response_ready, _fd, _response.code(), toWriteBytes());
     LOG_DEBUG("filesize:%d, %d  to %d", _response.fileLen(), _iov_cnt, toWriteBytes());
+}
+/**
+ * @description: 首部解析完毕，开始落盘上传：已读入缓冲区的 body 前缀先写入文件，
+ *               其余部分在后续读事件中 splice，超时由连接计时器负责
+ * @return {*}
+ */
+bool HttpConn::_onUploadStart() {
+    if (!upload_dir || !_upload.open(upload_dir, _request.contentLength()) || !_upload.absorb(_read_buff)) {
+        _upload.close();
+        _request.endUpload(500);
+        _response.init(&_arena, src_dir, _request.path(), false, _request.errorCode());
+        _response.makeStatusResponse(_write_buff);
+        _prepareWrite();
+        return true;
+    }
+    LOG_INFO("Client[%d] upload %zu bytes", _fd, _upload.length());
+    return _upload.done() ? _onUploadComplete() : false;
+}
+/**
+ * @description: body 已全部写入临时文件，交给上传处理函数，处理函数返回后临时文件即被关闭
+ * @return {*}
+ */
+bool HttpConn::_onUploadComplete() {
+    _request.endUpload(0);
+    int code = upload_handler ? upload_handler(_request, _upload.fd(), _upload.length()) : 501;
+    _upload.close();
+    if (code < 100 || code > 599) {
+        /* 处理函数返回的不是合法状态码，属于服务器一侧的错误 */
+        LOG_ERROR("Client[%d] upload handler returned status %d", _fd, code);
+        code = 500;
+    }
+    _response.init(&_arena, src_dir, _request.path(), _request.isKeepAlive() && !draining, code);
+    _response.makeStatusResponse(_write_buff);
+    _prepareWrite();
     return true;
 }
+/**
+ * @description: 连接进入空闲(keep-alive 等待下一请求)时，归还缓冲区与请求状态内存，
+ *               仅保留 fd、地址与计时器状态，下次 EPOLLIN 读取时再从内存池取回
+ * @return {*}
+ */
+void HttpConn::_shed() {
+    if (_is_idle && _read_buff.capacity() == 0 && _write_buff.capacity() == 0 && _arena.capacity() == 0) {
+        return;
+    }
+    _read_buff.shrink();
+    _write_buff.shrink();
+    _request.release();
+    _response.release();
+    _arena.release();
+    _is_idle = true;
+    LOG_DEBUG("Client[%d] idle, %zu bytes in use", _fd, memInfo().total());
+}
+/**
+ * @description: 返回连接当前的内存占用明细
+ * @return {*}
+ */
+ConnMemInfo HttpConn::memInfo() const {
+    ConnMemInfo info;
+    info.conn       = sizeof(HttpConn);
+    info.read_buff  = _read_buff.capacity();
+    info.write_buff = _write_buff.capacity();
+    info.arena      = _arena.capacity();
+    return info;
+}
@@ -0,0 +1,117 @@
+/*
+ * @Description: http 首部表实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 13:02:15
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:31:52
+ */
+#include "httpheaders.h"
+
+#include "perfecthash.h"
+
+typedef perfecthash::Map<perfecthash::CaseInsensitive, std::string_view, int, 32> KnownHeaderMap;
+
+static constexpr KnownHeaderMap::EntryType KNOWN_HEADER_ENTRIES[] = {
+    {"Connection", HttpHeaders::CONNECTION},
+    {"Content-Length", HttpHeaders::CONTENT_LENGTH},
+    {"Content-Type", HttpHeaders::CONTENT_TYPE},
+    {"Host", HttpHeaders::HOST},
+    {"Accept-Encoding", HttpHeaders::ACCEPT_ENCODING},
+    {"If-None-Match", HttpHeaders::IF_NONE_MATCH},
+    {"Range", HttpHeaders::RANGE},
+    {"Transfer-Encoding", HttpHeaders::TRANSFER_ENCODING},
+    {"Cookie", HttpHeaders::COOKIE},
+};
+
+static constexpr KnownHeaderMap KNOWN_HEADERS(KNOWN_HEADER_ENTRIES);
+
+static_assert(KNOWN_HEADERS.size() == HttpHeaders::KNOWN_COUNT, "known header table out of sync");
+static_assert(KNOWN_HEADERS.get("content-length", -1) == HttpHeaders::CONTENT_LENGTH, "case-insensitive lookup");
+/**
+ * @description: 首部表初始化，其余首部的线性表分配在 arena 中
+ * @param {Arena} *arena
+ * @return {*}
+ */
+void HttpHeaders::init(Arena *arena) {
+    _arena = arena;
+    for (auto &value : _known) {
+        value = std::string_view();
+    }
+    _others = HttpFieldList(ArenaAllocator<HttpField>(arena));
+    if (arena) {
+        _others.reserve(8);
+    }
+}
+/**
+ * @description: 加入一个首部，常用首部直接写入对应槽位；重复的 Cookie 以 "; " 拼接，其余后者覆盖前者。
+ *               决定报文边界或目标的首部不能有歧义(RFC 9112 §3.2、§6.3)：重复的 Host、Transfer-Encoding
+ *               与取值不同的 Content-Length 返回 false，由调用方以 400 拒绝，避免与上游对 body 边界的理解不一致
+ * @param {string_view} name
+ * @param {string_view} value
+ * @return {*}
+ */
+bool HttpHeaders::add(std::string_view name, std::string_view value) {
+    int key = lookup(name);
+    if (key < 0) {
+        _others.emplace_back(name, value);
+        return true;
+    }
+    if (has(static_cast<KNOWN_HEADER>(key))) {
+        if (key == HOST || key == TRANSFER_ENCODING || (key == CONTENT_LENGTH && _known[key] != value)) {
+            return false;
+        }
+        if (key == COOKIE && _arena) {
+            value = _arena->concat(_arena->concat(_known[COOKIE], "; "), value);
+        }
+    }
+    _known[key] = value;
+    return true;
+}
+/**
+ * @description: 按名称查找首部，大小写不敏感
+ * @param {string_view} name
+ * @return {*}
+ */
+std::string_view HttpHeaders::get(std::string_view name) const {
+    int key = lookup(name);
+    if (key >= 0) {
+        return _known[key];
+    }
+    for (auto &field : _others) {
+        if (equalsIgnoreCase(field.first, name)) {
+            return field.second;
+        }
+    }
+    return std::string_view();
+}
+/**
+ * @description: 返回常用首部的槽位下标，非常用首部返回 -1
+ * @param {string_view} name
+ * @return {*}
+ */
+int HttpHeaders::lookup(std::string_view name) {
+    return KNOWN_HEADERS.get(name, -1);
+}
+/**
+ * @description: 返回常用首部的规范名称，用于转发时重新序列化首部
+ * @param {KNOWN_HEADER} key
+ * @return {*}
+ */
+std::string_view HttpHeaders::name(KNOWN_HEADER key) {
+    for (auto &entry : KNOWN_HEADER_ENTRIES) {
+        if (entry.value == key) {
+            return entry.key;
+        }
+    }
+    return std::string_view();
+}
+/**
+ * @description: 大小写不敏感的字符串比较
+ * @param {string_view} lhs
+ * @param {string_view} rhs
+ * @return {*}
+ */
+bool HttpHeaders::equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return perfecthash::CaseInsensitive::equal(lhs, rhs);
+}
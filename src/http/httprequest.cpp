@@ -4,275 +4,490 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:01:33
+ * @LastEditTime: 2026-10-19 23:59:59
  */
 #include "httprequest.h"
+#include "probes.h"
+
+#include "urlencoded.h"
+
 using namespace std;
 
-const unordered_set<string> HttpRequest::DEFAULT_HTML{
-    "/index",
-    "/register",
-    "/login",
-    "/welcome",
-    "/video",
-    "/picture",
-};
+size_t HttpRequest::max_header_size   = 16 << 10;
+size_t HttpRequest::max_buffered_body = 64 << 10;
+size_t HttpRequest::upload_threshold  = 0;
+size_t HttpRequest::max_upload_size   = 1 << 30;
 
-const unordered_map<string, int> HttpRequest::DEFAULT_HTML_TAG{
-    {"/register.html", 0},
-    {"/login.html", 1},
-};
+std::function<bool(std::string_view path)> HttpRequest::raw_body_filter;
 /**
- * @description: 请求初始化
+ * @description: 请求初始化，解析结果均分配在 arena 中，随 arena reset 一并回收
+ * @param {Arena} *arena
  * @return {*}
  */
-void HttpRequest::init() {
-    _method = _path = _version = _body = "";
-    _state                             = REQUEST_LINE;
-    _header.clear();
-    _post.clear();
+void HttpRequest::init(Arena *arena) {
+    _arena  = arena;
+    _method = _path = _version = _body = _target = std::string_view();
+    _raw_body                                    = false;
+    _state                                       = REQUEST_LINE;
+    _error_code                                  = 0;
+    _header_bytes                                = 0;
+    _content_length                              = 0;
+    _header.init(arena);
+    _post   = HttpFieldList(ArenaAllocator<HttpField>(arena));
+    _query  = HttpFieldList(ArenaAllocator<HttpField>(arena));
+    _params = HttpFieldList(ArenaAllocator<HttpField>(arena));
+    _body_reader.init();
+    _collector.init(arena, 0, 0);
+    _sink = nullptr;
+    _multipart.init(nullptr, std::string_view(), nullptr);
+    _parts.init(arena, 0);
+    _json.init(arena);
 }
 /**
- * @description: 返回请求头是否正确配置keep-alive
+ * @description: 空闲连接释放请求状态，arena 内存由连接统一释放
+ * @return {*}
+ */
+void HttpRequest::release() {
+    init(nullptr);
+}
+/**
+ * @description: 返回请求头是否正确配置keep-alive，解析出错的请求总是关闭连接
  * @return {*}
  */
 bool HttpRequest::isKeepAlive() const {
-    if (_header.count("Connection") == 1) {
-        return _header.find("Connection")->second == "keep-alive" && _version == "1.1";
-    }
-    return false;
+    return _error_code == 0 &&
+           HttpHeaders::equalsIgnoreCase(_header.get(HttpHeaders::CONNECTION), "keep-alive") && _version == "1.1";
 }
 /**
- * @description: 从缓冲区中，解析请求数据
+ * @description: 从缓冲区中增量解析请求，只消费完整的行与已到达的 body 字节，
+ *               数据不足时保留解析状态，等待下一次读取后继续
  * @param {Buffer&} buff
- * @return {*}
+ * @return {*} NO_REQUEST: 请求不完整；GET_REQUEST: 解析完成；BAD_REQUEST: 出错，状态码见 errorCode()；
+ *               UPLOAD_REQUEST: 首部解析完成，body 需由连接落盘
  */
-bool HttpRequest::parse(Buffer &buff) {
+HttpRequest::HTTP_CODE HttpRequest::parse(Buffer &buff) {
+    PROBE2(parse_start, this, buff.readableBytes());
+    HTTP_CODE ret = _parseBuffer(buff);
+    PROBE2(parse_end, this, ret);
+    return ret;
+}
+
+HttpRequest::HTTP_CODE HttpRequest::_parseBuffer(Buffer &buff) {
     const char CRLF[] = "\r\n";
-    if (buff.readableBytes() <= 0) {
-        return false;
-    }
     /* 分段解析：请求行+首部字段+body */
-    while (buff.readableBytes() && _state != FINISH) {
+    assert(_arena);
+    while (_state != FINISH) {
+        if (_state == BODY) {
+            BodyReader::READ_STATE ret = _body_reader.feed(buff, _sink);
+            if (ret == BodyReader::ERROR) {
+                return _fail(_body_reader.errorCode());
+            }
+            if (ret != BodyReader::DONE) {
+                return NO_REQUEST;
+            }
+            _onBodyComplete();
+            if (_error_code) {
+                return BAD_REQUEST;
+            }
+            break;
+        }
         const char *lineEnd = search(buff.beginRead(), buff.beginWrite(), CRLF, CRLF + 2);
-        std::string line((const char *)buff.beginRead(), lineEnd);
+        if (lineEnd == buff.beginWrite()) {
+            return _header_bytes + buff.readableBytes() > max_header_size ? _fail(431) : NO_REQUEST;
+        }
+        std::string_view line(buff.beginRead(), lineEnd - buff.beginRead());
+        _header_bytes += line.size() + 2;
+        if (_header_bytes > max_header_size) {
+            return _fail(431);
+        }
+        buff.hasReadUntil(lineEnd + 2);
         switch (_state) {
         case REQUEST_LINE:
+            /* 忽略请求行之前的空行 */
+            if (line.empty()) {
+                break;
+            }
             if (!_parseRequestLine(line)) {
-                return false;
+                return _fail(400);
             }
-            _parsePath();
             break;
         case HEADERS:
-            _parseHeader(line);
-            if (buff.readableBytes() <= 2) {
-                _state = FINISH;
+            if (!line.empty()) {
+                if (!_parseHeader(line)) {
+                    return _fail(400);
+                }
+            } else if (!_onHeadersComplete()) {
+                return BAD_REQUEST;
+            } else if (_state == UPLOAD) {
+                /* body 不经过缓冲区，交由连接 splice 落盘 */
+                return UPLOAD_REQUEST;
             }
             break;
-        case BODY:
-            _parseBody(line);
-            break;
         default:
             break;
         }
-        if (lineEnd == buff.beginWrite()) {
-            break;
-        }
-        buff.hasReadUntil(lineEnd + 2);
     }
-    LOG_DEBUG("[%s], [%s], [%s]", _method.c_str(), _path.c_str(), _version.c_str());
-    return true;
+    LOG_DEBUG("[%.*s], [%.*s], [%.*s]", (int)_method.size(), _method.data(),
+              (int)_path.size(), _path.data(), (int)_version.size(), _version.data());
+    return GET_REQUEST;
 }
 /**
- * @description: 解析url中的资源路径
+ * @description: 首部解析完毕，根据 Transfer-Encoding/Content-Length 确定 body 的读取方式
  * @return {*}
  */
-void HttpRequest::_parsePath() {
-    if (_path == "/") {
-        _path = "/index.html";
-    } else {
-        for (auto &item : DEFAULT_HTML) {
-            if (item == _path) {
-                _path += ".html";
-                break;
+bool HttpRequest::_onHeadersComplete() {
+    std::string_view encoding = _header.get(HttpHeaders::TRANSFER_ENCODING);
+    std::string_view length   = _header.get(HttpHeaders::CONTENT_LENGTH);
+    size_t content_length     = 0;
+    _raw_body                 = raw_body_filter && raw_body_filter(_path);
+    if (_header.has(HttpHeaders::TRANSFER_ENCODING)) {
+        /* 同时带 Content-Length，或 chunked 不是最后一个编码时，body 边界无法可靠确定(RFC 9112 §6.3)，
+           转发给上游会造成请求走私，以 400 拒绝并关闭连接 */
+        if (_header.has(HttpHeaders::CONTENT_LENGTH) || encoding.size() < 7 ||
+            !HttpHeaders::equalsIgnoreCase(encoding.substr(encoding.size() - 7), "chunked")) {
+            _fail(400);
+            return false;
+        }
+        _body_reader.initChunked();
+    } else if (_header.has(HttpHeaders::CONTENT_LENGTH)) {
+        /* 空的 Content-Length 不能当作没有 body，否则其后的 body 会被当成下一个请求 */
+        if (length.empty()) {
+            _fail(400);
+            return false;
+        }
+        size_t limit = std::max(BodyReader::max_body_size, max_upload_size);
+        for (char ch : length) {
+            if (ch < '0' || ch > '9' || content_length > (limit + 9) / 10) {
+                _fail(ch < '0' || ch > '9' ? 400 : 413);
+                return false;
             }
+            content_length = content_length * 10 + (ch - '0');
         }
+        _content_length = content_length;
+        if (_isUpload()) {
+            if (content_length > max_upload_size) {
+                _fail(413);
+                return false;
+            }
+            _state = UPLOAD;
+            return true;
+        }
+        _body_reader.initLength(content_length);
+        if (_body_reader.state() == BodyReader::ERROR) {
+            _fail(_body_reader.errorCode());
+            return false;
+        }
+        if (content_length == 0) {
+            _state = FINISH;
+            return true;
+        }
+    } else {
+        _state = FINISH;
+        return true;
+    }
+    if (!_raw_body && !_sink && _isMultipart()) {
+        /* multipart 表单流式解析，文件部分超过阈值后落盘，内存中只保留普通字段 */
+        if (!_multipart.init(_arena, _header.get(HttpHeaders::CONTENT_TYPE), &_parts)) {
+            _fail(400);
+            return false;
+        }
+        _parts.init(_arena, max_buffered_body);
+        _sink = &_multipart;
+    } else if (!_sink) {
+        /* 未指定接收者时收集到 arena 中，供表单解析使用 */
+        if (content_length > max_buffered_body) {
+            _fail(413);
+            return false;
+        }
+        _collector.init(_arena, content_length, max_buffered_body);
+        _sink = &_collector;
     }
+    _state = BODY;
+    return true;
 }
 /**
- * @description: 解析请求行
- * @param {string&} line
+ * @description: 是否转为落盘上传：已开启上传、未指定 BodySink 的大体积 POST/PUT，multipart 表单除外
  * @return {*}
  */
-bool HttpRequest::_parseRequestLine(const string &line) {
-    regex patten("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    smatch subMatch;
-    if (regex_match(line, subMatch, patten)) {
-        _method  = subMatch[1];
-        _path    = subMatch[2];
-        _version = subMatch[3];
-        _state   = HEADERS;
-        return true;
-    }
-    LOG_ERROR("RequestLine Error");
-    return false;
+bool HttpRequest::_isUpload() const {
+    return upload_threshold > 0 && _content_length >= upload_threshold && !_sink && !_raw_body && !_isMultipart() &&
+           (_method == "POST" || _method == "PUT");
 }
 /**
- * @description: 解析首部键值对
- * @param {string&} line
+ * @description: body 是否为 multipart/form-data
  * @return {*}
  */
-void HttpRequest::_parseHeader(const string &line) {
-    regex patten("^([^:]*): ?(.*)$");
-    smatch subMatch;
-    if (regex_match(line, subMatch, patten)) {
-        _header[subMatch[1]] = subMatch[2];
-    } else {
-        _state = BODY;
+bool HttpRequest::_isMultipart() const {
+    std::string_view type = _header.get(HttpHeaders::CONTENT_TYPE);
+    return HttpHeaders::equalsIgnoreCase(type.substr(0, 19), "multipart/form-data");
+}
+/**
+ * @description: 落盘上传结束，由连接在 body 全部写入文件或出错后调用
+ * @param {int} error_code，0 表示成功
+ * @return {*}
+ */
+void HttpRequest::endUpload(int error_code) {
+    assert(_state == UPLOAD);
+    _state = FINISH;
+    if (error_code) {
+        _fail(error_code);
+        return;
     }
+    LOG_DEBUG("Upload len:%zu", _content_length);
 }
 /**
- * @description: 解析body
- * @param {string&} line
+ * @description: body 读取完毕，收集到内存中的 body 或 multipart 字段交给表单解析
  * @return {*}
  */
-void HttpRequest::_parseBody(const string &line) {
-    _body = line;
-    _parsePost();
+void HttpRequest::_onBodyComplete() {
     _state = FINISH;
-    LOG_DEBUG("Body:%s, len:%d", line.c_str(), line.size());
+    if (!_sink->onBodyEnd()) {
+        _fail(_sink->errorCode());
+        return;
+    }
+    if (_sink == &_collector) {
+        _body = std::string_view(_collector.data(), _collector.size());
+        if (!_raw_body) {
+            _parsePost(_collector.data(), _collector.size());
+        }
+    } else if (_sink == &_multipart) {
+        _parsePost(nullptr, 0);
+    }
+    LOG_DEBUG("Body len:%zu", _body_reader.received());
 }
 /**
- * @description: 十六进制数转十进制数
- * @param {char} ch
+ * @description: 记录错误状态码，结束解析
+ * @param {int} code
  * @return {*}
  */
-int HttpRequest::_converHex(char ch) {
-    if (ch >= 'A' && ch <= 'F')
-        return ch - 'A' + 10;
-    if (ch >= 'a' && ch <= 'f')
-        return ch - 'a' + 10;
-    return ch;
+HttpRequest::HTTP_CODE HttpRequest::_fail(int code) {
+    _error_code = code;
+    _state      = FINISH;
+    LOG_WARN("Request error: %d", code);
+    return BAD_REQUEST;
 }
 /**
- * @description: 解析post请求携带的数据
+ * @description: 解析请求行，格式为 "方法 路径 HTTP/版本"
+ * @param {string_view} line
  * @return {*}
  */
-void HttpRequest::_parsePost() {
-    if (_method == "POST" && _header["Content-Type"] == "application/x-www-form-urlencoded") {
-        _parseFromUrlencoded();
-        if (DEFAULT_HTML_TAG.count(_path)) {
-            int tag = DEFAULT_HTML_TAG.find(_path)->second;
-            LOG_DEBUG("Tag:%d", tag);
-            if (tag == 0 || tag == 1) {
-                bool isLogin = (tag == 1);
-                if (_userVerify(_post["username"], _post["password"], isLogin)) {
-                    _path = "/welcome.html";
-                } else {
-                    _path = "/error.html";
-                }
+bool HttpRequest::_parseRequestLine(std::string_view line) {
+    size_t method_end = line.find(' ');
+    size_t path_end   = method_end == std::string_view::npos ? method_end : line.find(' ', method_end + 1);
+    if (path_end != std::string_view::npos) {
+        std::string_view version = line.substr(path_end + 1);
+        if (version.substr(0, 5) == "HTTP/" && version.find(' ') == std::string_view::npos) {
+            std::string_view target = line.substr(method_end + 1, path_end - method_end - 1);
+            size_t question         = target.find('?');
+            _method                 = _save(line.substr(0, method_end));
+            _target                 = _save(target);
+            _path                   = _target.substr(0, question);
+            _version                = _save(version.substr(5));
+            _state                  = HEADERS;
+            if (question != std::string_view::npos) {
+                _parseQuery(target.substr(question + 1));
             }
+            return true;
         }
     }
+    LOG_ERROR("RequestLine Error");
+    return false;
 }
 /**
- * @description: 根据post编码格式，解析数据键值对
+ * @description: 解析首部键值对，格式为 "键: 值"，值两端的空白被去除
+ * @param {string_view} line
+ * @return {*} 格式错误或首部重复而有歧义时返回 false
+ */
+bool HttpRequest::_parseHeader(std::string_view line) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        return false;
+    }
+    std::string_view value = line.substr(colon + 1);
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+        value.remove_suffix(1);
+    }
+    return _header.add(_save(line.substr(0, colon)), _save(value));
+}
+/**
+ * @description: 解析post请求携带的数据
+ * @param {char} *body
+ * @param {size_t} len
  * @return {*}
  */
-void HttpRequest::_parseFromUrlencoded() {
-    if (_body.size() == 0) {
+void HttpRequest::_parsePost(char *body, size_t len) {
+    std::string_view type = _header.get(HttpHeaders::CONTENT_TYPE);
+    if (_method != "POST") {
         return;
     }
-
-    string key, value;
-    int num = 0;
-    int n   = _body.size();
-    int i = 0, j = 0;
-
-    for (; i < n; i++) {
-        char ch = _body[i];
-        switch (ch) {
-        case '=':
-            key = _body.substr(j, i - j);
-            j   = i + 1;
-            break;
-        case '+':
-            _body[i] = ' ';
-            break;
-        case '%':
-            num          = _converHex(_body[i + 1]) * 16 + _converHex(_body[i + 2]);
-            _body[i + 2] = num % 10 + '0';
-            _body[i + 1] = num / 10 + '0';
-            i += 2;
-            break;
-        case '&':
-            value      = _body.substr(j, i - j);
-            j          = i + 1;
-            _post[key] = value;
-            LOG_DEBUG("%s = %s", key.c_str(), value.c_str());
-            break;
-        default:
-            break;
-        }
+    if (HttpHeaders::equalsIgnoreCase(type.substr(0, 33), "application/x-www-form-urlencoded")) {
+        _post.reserve(8);
+        UrlEncoded::parse(body, len, _post);
+    } else if (_isMultipart()) {
+        _parseFormData();
+    } else if (HttpHeaders::equalsIgnoreCase(type.substr(0, 16), "application/json")) {
+        _parseJson(body, len);
     }
-    assert(j <= i);
-    if (_post.count(key) == 0 && j < i) {
-        value      = _body.substr(j, i - j);
-        _post[key] = value;
+}
+/**
+ * @description: 解析 URL 查询串，拷贝到 arena 后原地解码，请求行所在的读缓冲区不被修改
+ * @param {string_view} query
+ * @return {*}
+ */
+void HttpRequest::_parseQuery(std::string_view query) {
+    if (query.empty()) {
+        return;
     }
+    _query.reserve(4);
+    UrlEncoded::parse(_arena->copy(query.data(), query.size()), query.size(), _query);
 }
 /**
- * @description: 验证用户，TODO
- * @param {string} &name
- * @param {string} &pwd
- * @param {bool} isLogin
+ * @description: multipart 表单中的普通字段加入 post 键值对，文件部分通过 parts() 获取
  * @return {*}
  */
-bool HttpRequest::_userVerify(const string &name, const string &pwd, bool isLogin) {
+void HttpRequest::_parseFormData() {
+    for (auto &part : _parts.parts()) {
+        if (part.filename.empty() && part.fd < 0) {
+            _post.emplace_back(part.name, part.data);
+            LOG_DEBUG("%.*s = %.*s", (int)part.name.size(), part.name.data(), (int)part.data.size(), part.data.data());
+        }
+    }
+}
+/**
+ * @description: 原地解析 JSON body，顶层对象的字符串成员同时加入 post 键值对，其余通过 json() 访问
+ * @param {char} *body
+ * @param {size_t} len
+ * @return {*} 语法错误时以 400 结束请求
+ */
+bool HttpRequest::_parseJson(char *body, size_t len) {
+    if (!_json.parse(body, len)) {
+        LOG_WARN("Json error: %s at %zu", _json.error(), _json.errorOffset());
+        _fail(400);
+        return false;
+    }
+    /* 顶层对象的成员在节点带中为 "键、值" 交替，按 next 跳过嵌套的值 */
+    const JsonTape &tape = _json.tape();
+    if (tape[0].type == JSON_OBJECT) {
+        for (uint32_t key = 1; key < tape.size(); key = tape[key + 1].next) {
+            if (tape[key + 1].type == JSON_STRING) {
+                _post.emplace_back(tape[key].text, tape[key + 1].text);
+            }
+        }
+    }
     return true;
 }
 /**
- * @description: 返回请求资源路径
+ * @description: 拷贝字符串到 arena，避免缓冲区整理后视图失效
+ * @param {string_view} str
  * @return {*}
  */
-std::string HttpRequest::path() const {
-    return _path;
+std::string_view HttpRequest::_save(std::string_view str) {
+    return std::string_view(_arena->copy(str.data(), str.size()), str.size());
 }
-
-std::string &HttpRequest::path() {
+/**
+ * @description: 在键值对列表中查找 key，未找到时返回空视图
+ * @param {HttpFieldList} &fields
+ * @param {string_view} key
+ * @return {*}
+ */
+std::string_view HttpRequest::_find(const HttpFieldList &fields, std::string_view key) {
+    for (auto &field : fields) {
+        if (field.first == key) {
+            return field.second;
+        }
+    }
+    return std::string_view();
+}
+/**
+ * @description: 返回请求资源路径
+ * @return {*}
+ */
+std::string_view HttpRequest::path() const {
     return _path;
 }
 /**
  * @description: 返回请求方法
  * @return {*}
  */
-std::string HttpRequest::method() const {
+std::string_view HttpRequest::method() const {
     return _method;
 }
 /**
  * @description: 返回请求版本号
  * @return {*}
  */
-std::string HttpRequest::version() const {
+std::string_view HttpRequest::version() const {
     return _version;
 }
 /**
- * @description: 返回post请求数据中，key对应的value
- * @param {string&} key
+ * @description: 返回首部字段 key 对应的 value，大小写不敏感
+ * @param {string_view} key
  * @return {*}
  */
-std::string HttpRequest::getPost(const std::string &key) const {
-    assert(key != "");
-    if (_post.count(key) == 1) {
-        return _post.find(key)->second;
-    }
-    return "";
+std::string_view HttpRequest::getHeader(std::string_view key) const {
+    return _header.get(key);
 }
 
-std::string HttpRequest::getPost(const char *key) const {
-    assert(key != nullptr);
-    if (_post.count(key) == 1) {
-        return _post.find(key)->second;
+std::string_view HttpRequest::getHeader(HttpHeaders::KNOWN_HEADER key) const {
+    return _header.get(key);
+}
+/**
+ * @description: 返回URL查询串中，key对应的value(已解码)
+ * @param {string_view} key
+ * @return {*}
+ */
+std::string_view HttpRequest::getQuery(std::string_view key) const {
+    assert(!key.empty());
+    return _find(_query, key);
+}
+/**
+ * @description: 返回 Cookie 头中 name 对应的值，按 "a=1; b=2" 的格式逐项扫描，不做解码
+ * @param {string_view} name
+ * @return {*}
+ */
+std::string_view HttpRequest::getCookie(std::string_view name) const {
+    assert(!name.empty());
+    std::string_view cookies = _header.get(HttpHeaders::COOKIE);
+    while (!cookies.empty()) {
+        size_t end            = cookies.find(';');
+        std::string_view pair = cookies.substr(0, end);
+        cookies               = end == std::string_view::npos ? std::string_view() : cookies.substr(end + 1);
+        size_t begin          = pair.find_first_not_of(' ');
+        pair                  = begin == std::string_view::npos ? std::string_view() : pair.substr(begin);
+        if (pair.size() > name.size() && pair[name.size()] == '=' && pair.compare(0, name.size(), name) == 0) {
+            return pair.substr(name.size() + 1);
+        }
     }
-    return "";
+    return std::string_view();
+}
+/**
+ * @description: 返回路由参数中，key对应的value，如模式 "/users/:id" 中的 id
+ * @param {string_view} key
+ * @return {*}
+ */
+std::string_view HttpRequest::getParam(std::string_view key) const {
+    assert(!key.empty());
+    return _find(_params, key);
+}
+/**
+ * @description: 在路由表中查找请求路径，匹配到的参数保存在请求中
+ * @param {Router} &router
+ * @param {RouteHandler} **handler，匹配成功时的处理函数
+ * @return {*} 200: 匹配成功；404: 没有匹配的路径；405: 路径匹配但方法未注册
+ */
+int HttpRequest::route(const Router &router, const RouteHandler **handler) {
+    _params.clear();
+    return router.match(_method, _path, _params, handler);
+}
+/**
+ * @description: 返回post请求数据中，key对应的value
+ * @param {string_view} key
+ * @return {*}
+ */
+std::string_view HttpRequest::getPost(std::string_view key) const {
+    assert(!key.empty());
+    return _find(_post, key);
 }
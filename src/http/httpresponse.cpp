@@ -4,52 +4,127 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 22:58:19
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:52:24
+ * @LastEditTime: 2026-10-19 23:59:59
  */
 #include "httpresponse.h"
 
+#include <algorithm>
+
+#include "httpheaders.h"
+#include "perfecthash.h"
+
 using namespace std;
 
-const unordered_map<string, string> HttpResponse::SUFFIX_TYPE = {
+typedef perfecthash::Map<perfecthash::CaseInsensitive, std::string_view, std::string_view, 128> SuffixTypeMap;
+typedef perfecthash::Map<perfecthash::Integer, int, std::string_view, 128> CodeStatusMap;
+typedef perfecthash::Map<perfecthash::Integer, int, std::string_view, 8> CodePathMap;
+
+static constexpr SuffixTypeMap::EntryType SUFFIX_TYPE_ENTRIES[] = {
     {".html", "text/html"},
+    {".htm", "text/html"},
     {".xml", "text/xml"},
     {".xhtml", "application/xhtml+xml"},
     {".txt", "text/plain"},
     {".rtf", "application/rtf"},
     {".pdf", "application/pdf"},
-    {".word", "application/nsword"},
+    {".word", "application/msword"},
+    {".json", "application/json"},
     {".png", "image/png"},
     {".gif", "image/gif"},
     {".jpg", "image/jpeg"},
     {".jpeg", "image/jpeg"},
+    {".webp", "image/webp"},
+    {".svg", "image/svg+xml"},
+    {".ico", "image/x-icon"},
     {".au", "audio/basic"},
+    {".mp3", "audio/mpeg"},
     {".mpeg", "video/mpeg"},
     {".mpg", "video/mpeg"},
+    {".mp4", "video/mp4"},
+    {".webm", "video/webm"},
     {".avi", "video/x-msvideo"},
     {".gz", "application/x-gzip"},
     {".tar", "application/x-tar"},
-    {".css", "text/css "},
-    {".js", "text/javascript "},
+    {".css", "text/css"},
+    {".js", "text/javascript"},
+    {".woff", "font/woff"},
+    {".woff2", "font/woff2"},
+    {".ttf", "font/ttf"},
+    {".otf", "font/otf"},
+    {".eot", "application/vnd.ms-fontobject"},
 };
 
-const unordered_map<int, string> HttpResponse::CODE_STATUS = {
+static constexpr CodeStatusMap::EntryType CODE_STATUS_ENTRIES[] = {
     {200, "OK"},
+    {201, "Created"},
+    {202, "Accepted"},
+    {204, "No Content"},
+    {206, "Partial Content"},
+    {301, "Moved Permanently"},
+    {302, "Found"},
+    {303, "See Other"},
+    {304, "Not Modified"},
+    {307, "Temporary Redirect"},
+    {308, "Permanent Redirect"},
     {400, "Bad Request"},
+    {401, "Unauthorized"},
     {403, "Forbidden"},
     {404, "Not Found"},
+    {405, "Method Not Allowed"},
+    {406, "Not Acceptable"},
+    {408, "Request Timeout"},
+    {409, "Conflict"},
+    {410, "Gone"},
+    {411, "Length Required"},
+    {412, "Precondition Failed"},
+    {413, "Payload Too Large"},
+    {414, "URI Too Long"},
+    {415, "Unsupported Media Type"},
+    {416, "Range Not Satisfiable"},
+    {422, "Unprocessable Content"},
+    {429, "Too Many Requests"},
+    {431, "Request Header Fields Too Large"},
+    {500, "Internal Server Error"},
+    {501, "Not Implemented"},
+    {502, "Bad Gateway"},
+    {503, "Service Unavailable"},
+    {504, "Gateway Timeout"},
+    {505, "HTTP Version Not Supported"},
 };
 
-const unordered_map<int, string> HttpResponse::CODE_PATH = {
+/* 表中没有的状态码按类别给出通用描述，状态码本身原样写出 */
+static constexpr std::string_view CLASS_STATUS[] = {
+    "Informational", "Success", "Redirection", "Client Error", "Server Error",
+};
+
+static constexpr CodePathMap::EntryType CODE_PATH_ENTRIES[] = {
     {400, "/400.html"},
     {403, "/403.html"},
     {404, "/404.html"},
+    {405, "/405.html"},
 };
 
+static constexpr SuffixTypeMap SUFFIX_TYPE(SUFFIX_TYPE_ENTRIES);
+static constexpr CodeStatusMap CODE_STATUS(CODE_STATUS_ENTRIES);
+static constexpr CodePathMap CODE_PATH(CODE_PATH_ENTRIES);
+
+static_assert(SUFFIX_TYPE.get(".WOFF2", "") == "font/woff2", "suffix lookup is case-insensitive");
+static_assert(CODE_STATUS.get(404, "") == "Not Found", "status lookup");
+static_assert(CODE_STATUS.get(429, "") == "Too Many Requests", "status lookup");
+static_assert(CODE_PATH.find(200) == nullptr, "no error page for 200");
+
 HttpResponse::HttpResponse()
     : _code(-1)
     , _is_keep_alive(false)
+    , _sent(false)
+    , _buffered(false)
+    , _cacheable(true)
+    , _socket(-1)
+    , _arena(nullptr)
     , _path("")
     , _src_dir("")
+    , _file_path(nullptr)
+    , _defer_state(DEFER_NONE)
     , _mm_file(nullptr)
     , _mm_file_stat({0}) {};
 
@@ -57,24 +132,204 @@ HttpResponse::~HttpResponse() {
     unmapFile();
 }
 /**
- * @description: HTTP 应答头初始化
- * @param {string} &src_dir
- * @param {string} &path
+ * @description: HTTP 应答头初始化，路径拼接等临时字符串分配在 arena 中
+ * @param {Arena} *arena
+ * @param {string_view} src_dir
+ * @param {string_view} path
  * @param {bool} is_keep_alive
  * @param {int} code
  * @return {*}
  */
-void HttpResponse::init(const string &src_dir, string &path, bool is_keep_alive, int code) {
-    assert(src_dir != "");
+void HttpResponse::init(Arena *arena, std::string_view src_dir, std::string_view path, bool is_keep_alive, int code) {
+    assert(arena && !src_dir.empty());
     if (_mm_file) {
         unmapFile();
     }
     _code          = code;
     _is_keep_alive = is_keep_alive;
-    _path          = path;
-    _src_dir       = src_dir;
-    _mm_file       = nullptr;
-    _mm_file_stat  = {0};
+    _sent             = false;
+    _buffered         = false;
+    _cacheable        = true;
+    _arena            = arena;
+    _path             = path;
+    _src_dir          = src_dir;
+    _content          = std::string_view();
+    _content_type     = std::string_view();
+    _extra_headers    = std::string_view();
+    _shared_content   = nullptr;
+    _deferred         = nullptr;
+    _complete_handler = nullptr;
+    _mm_file          = nullptr;
+    _mm_file_stat     = {0};
+    _makeFilePath();
+}
+/**
+ * @description: 以 src_dir 下的另一静态文件作为响应，路径拷贝到 arena 中
+ * @param {string_view} path
+ * @return {*}
+ */
+void HttpResponse::setPath(std::string_view path) {
+    _path = std::string_view(_arena->copy(path.data(), path.size()), path.size());
+    _makeFilePath();
+}
+/**
+ * @description: 以处理函数生成的内容作为响应 body，内容与类型拷贝到 arena 中
+ * @param {string_view} content
+ * @param {string_view} type，Content-type
+ * @return {*}
+ */
+void HttpResponse::setContent(std::string_view content, std::string_view type) {
+    _content        = std::string_view(_arena->copy(content.data(), content.size()), content.size());
+    _content_type   = std::string_view(_arena->copy(type.data(), type.size()), type.size());
+    _shared_content = nullptr;
+}
+/**
+ * @description: 以共享的内容作为响应 body，不拷贝，写出时直接引用。type 须与 content 同生命周期或为常量
+ * @param {shared_ptr<const std::string>} content
+ * @param {string_view} type，Content-type
+ * @return {*}
+ */
+void HttpResponse::setContent(std::shared_ptr<const std::string> content, std::string_view type) {
+    _content        = *content;
+    _content_type   = type;
+    _shared_content = std::move(content);
+}
+/**
+ * @description: 追加一行响应头，如 Set-Cookie，头部行拷贝到 arena 中
+ * @param {string_view} name
+ * @param {string_view} value
+ * @return {*}
+ */
+void HttpResponse::addHeader(std::string_view name, std::string_view value) {
+    size_t len = _extra_headers.size() + name.size() + value.size() + 4;
+    char *line = static_cast<char *>(_arena->allocate(len, 1));
+    char *p    = std::copy(_extra_headers.begin(), _extra_headers.end(), line);
+    p          = std::copy(name.begin(), name.end(), p);
+    *p++       = ':';
+    *p++       = ' ';
+    p          = std::copy(value.begin(), value.end(), p);
+    *p++       = '\r';
+    *p         = '\n';
+    _extra_headers = std::string_view(line, len);
+    if (HttpHeaders::equalsIgnoreCase(name, "Set-Cookie")) {
+        _cacheable = false;
+    }
+}
+/**
+ * @description: 追加若干完整的头部行，每行以 "\r\n" 结尾，如反向代理转发的上游首部
+ * @param {string_view} lines
+ * @return {*}
+ */
+void HttpResponse::addHeaderLines(std::string_view lines) {
+    if (lines.empty()) {
+        return;
+    }
+    size_t len = _extra_headers.size() + lines.size();
+    char *buff = static_cast<char *>(_arena->allocate(len, 1));
+    char *p    = std::copy(_extra_headers.begin(), _extra_headers.end(), buff);
+    std::copy(lines.begin(), lines.end(), p);
+    _extra_headers = std::string_view(buff, len);
+}
+/**
+ * @description: 标记应答已由处理函数直接写出，连接随后按 keep_alive 继续处理下一请求或关闭
+ * @param {bool} keep_alive
+ * @return {*}
+ */
+void HttpResponse::setSent(bool keep_alive) {
+    _sent          = true;
+    _is_keep_alive = _is_keep_alive && keep_alive;
+}
+/**
+ * @description: 延后的结果就绪，先执行完成回调再由所属连接发出应答
+ * @return {*}
+ */
+void HttpResponse::resume() {
+    uint32_t state = _defer_state.load(std::memory_order_acquire);
+    while ((state & DEFER_STATE_MASK) != DEFER_NONE &&
+           !_defer_state.compare_exchange_weak(state, state & ~DEFER_STATE_MASK, std::memory_order_acq_rel)) {
+    }
+    complete();
+    _resume_handler();
+}
+/**
+ * @description: 执行一次完成回调，回调可读取并共享本次结果
+ * @return {*}
+ */
+void HttpResponse::complete() {
+    if (_complete_handler) {
+        std::function<void(HttpResponse &)> handler = std::move(_complete_handler);
+        _complete_handler                           = nullptr;
+        handler(*this);
+    }
+}
+/**
+ * @description: 连接已关闭，延后的请求不再发出应答，仅以状态码通知完成回调
+ * @param {int} code
+ * @return {*}
+ */
+void HttpResponse::abandon(int code) {
+    _code    = code;
+    _content = std::string_view();
+    complete();
+}
+/**
+ * @description: 延后处理：task 在请求线程交还连接前执行，每次调用开始新的一代，旧 token 的 claim 随之失效
+ * @param {function<void()>} task
+ * @return {*}
+ */
+void HttpResponse::defer(std::function<void()> task) {
+    _deferred      = std::move(task);
+    uint32_t token = deferToken() + DEFER_STATE_MASK + 1;
+    _defer_state.store(token | DEFER_RUNNING, std::memory_order_release);
+}
+/**
+ * @description: 在请求线程中执行延后的任务，之后应答交给完成方，可由事件循环撤销
+ * @return {*}
+ */
+void HttpResponse::runDeferred() {
+    uint32_t token             = deferToken();
+    std::function<void()> task = takeDeferred();
+    task();
+    /* 任务中已完成、已被认领或已开始下一代时保持不变 */
+    uint32_t expected = token | DEFER_RUNNING;
+    _defer_state.compare_exchange_strong(expected, token | DEFER_WAITING, std::memory_order_acq_rel);
+}
+/**
+ * @description: 完成方取得应答的所有权，之后事件循环不再撤销，直到 resume
+ * @param {uint32_t} token，defer 之后由 deferToken 取得
+ * @return {bool} false 表示已被撤销或已开始下一代，不得再访问应答
+ */
+bool HttpResponse::claim(uint32_t token) {
+    uint32_t state = _defer_state.load(std::memory_order_acquire);
+    while ((state & ~DEFER_STATE_MASK) == token &&
+           ((state & DEFER_STATE_MASK) == DEFER_RUNNING || (state & DEFER_STATE_MASK) == DEFER_WAITING)) {
+        if (_defer_state.compare_exchange_weak(state, token | DEFER_CLAIMED, std::memory_order_acq_rel)) {
+            return true;
+        }
+    }
+    return false;
+}
+/**
+ * @description: 事件循环关闭连接前撤销延后中的应答，撤销后完成方的 claim 失败
+ * @return {CANCEL_RESULT}
+ */
+HttpResponse::CANCEL_RESULT HttpResponse::cancel() {
+    uint32_t state = _defer_state.load(std::memory_order_acquire);
+    while ((state & DEFER_STATE_MASK) == DEFER_WAITING) {
+        if (_defer_state.compare_exchange_weak(state, state & ~DEFER_STATE_MASK, std::memory_order_acq_rel)) {
+            return CANCELLED;
+        }
+    }
+    return (state & DEFER_STATE_MASK) == DEFER_NONE ? NOT_DEFERRED : BUSY;
+}
+/**
+ * @description: 取出延后执行的任务，之后响应不再处于延后状态
+ * @return {*}
+ */
+std::function<void()> HttpResponse::takeDeferred() {
+    std::function<void()> task = std::move(_deferred);
+    _deferred                  = nullptr;
+    return task;
 }
 /**
  * @description: 根据缓冲区数据，构造响应头
@@ -82,8 +337,24 @@ void HttpResponse::init(const string &src_dir, string &path, bool is_keep_alive,
  * @return {*}
  */
 void HttpResponse::makeResponse(Buffer &buff) {
-    /* 判断请求的资源文件 */
-    if (stat((_src_dir + _path).data(), &_mm_file_stat) < 0 || S_ISDIR(_mm_file_stat.st_mode)) {
+    if (_sent) {
+        return;
+    }
+    if (_content.data()) {
+        /* 处理函数生成的 body 直接写入缓冲区 */
+        char header[64];
+        int len = snprintf(header, sizeof(header), "Content-length: %zu\r\n\r\n", _content.size());
+        _addStateLine(buff);
+        _addHeader(buff, _content_type);
+        buff.append(header, len);
+        if (!_shared_content) {
+            buff.append(_content);
+        }
+        return;
+    }
+    /* 判断请求的资源文件，请求本身出错时不再访问资源 */
+    if (_code >= 400) {
+    } else if (stat(_file_path, &_mm_file_stat) < 0 || S_ISDIR(_mm_file_stat.st_mode)) {
         _code = 404;
     } else if (!(_mm_file_stat.st_mode & S_IROTH)) {
         _code = 403;
@@ -91,49 +362,79 @@ void HttpResponse::makeResponse(Buffer &buff) {
         _code = 200;
     }
     _errorHtml();
+    if (_code >= 400 && CODE_PATH.find(_code) == nullptr) {
+        /* 没有对应错误页面的状态码，直接构造 body */
+        makeStatusResponse(buff);
+        return;
+    }
     _addStateLine(buff);
-    _addHeader(buff);
+    _addHeader(buff, _getFileType());
     _addContent(buff);
 }
+/**
+ * @description: 构造不对应资源文件的响应，body 为状态码描述，用于错误与上传等结果
+ * @param {Buffer} &buff
+ * @return {*}
+ */
+void HttpResponse::makeStatusResponse(Buffer &buff) {
+    _mm_file_stat = {0};
+    _addStateLine(buff);
+    _addHeader(buff, "text/html");
+    _statusContent(buff, statusText(_code).data());
+}
 
+/**
+ * @description: 随应答头之后写出的 body：映射的文件，或共享的内容
+ * @return {*}
+ */
 char *HttpResponse::file() {
-    return _mm_file;
+    return _shared_content ? const_cast<char *>(_shared_content->data()) : _mm_file;
 }
 
 size_t HttpResponse::fileLen() const {
-    return _mm_file_stat.st_size;
+    return _shared_content ? _shared_content->size() : _mm_file_stat.st_size;
 }
 /**
  * @description: 检查是否error，并读取对应html资源信息
  * @return {*}
  */
 void HttpResponse::_errorHtml() {
-    if (CODE_PATH.count(_code) == 1) {
-        _path = CODE_PATH.find(_code)->second;
-        stat((_src_dir + _path).data(), &_mm_file_stat);
+    if (const std::string_view *path = CODE_PATH.find(_code)) {
+        _path = *path;
+        _makeFilePath();
+        stat(_file_path, &_mm_file_stat);
     }
 }
+/**
+ * @description: 拼接资源文件的完整路径
+ * @return {*}
+ */
+void HttpResponse::_makeFilePath() {
+    _file_path = _arena->concat(_src_dir, _path).data();
+}
 /**
  * @description: 构造响应头的响应行
  * @param {Buffer} &buff
  * @return {*}
  */
 void HttpResponse::_addStateLine(Buffer &buff) {
-    string status;
-    if (CODE_STATUS.count(_code) == 1) {
-        status = CODE_STATUS.find(_code)->second;
-    } else {
+    std::string_view status = statusText(_code);
+    if (status.empty()) {
+        /* 不在 100-599 范围内的状态码无法写进响应行 */
         _code  = 400;
-        status = CODE_STATUS.find(400)->second;
+        status = statusText(400);
     }
-    buff.append("HTTP/1.1 " + to_string(_code) + " " + status + "\r\n");
+    char line[64];
+    int len = snprintf(line, sizeof(line), "HTTP/1.1 %d %.*s\r\n", _code, (int)status.size(), status.data());
+    buff.append(line, len);
 }
 /**
  * @description: 构造响应头的header键值对
  * @param {Buffer} &buff
+ * @param {string_view} type
  * @return {*}
  */
-void HttpResponse::_addHeader(Buffer &buff) {
+void HttpResponse::_addHeader(Buffer &buff, std::string_view type) {
     buff.append("Connection: ");
     if (_is_keep_alive) {
         buff.append("keep-alive\r\n");
@@ -141,7 +442,12 @@ void HttpResponse::_addHeader(Buffer &buff) {
     } else {
         buff.append("close\r\n");
     }
-    buff.append("Content-type: " + _getFileType() + "\r\n");
+    buff.append("Content-type: ");
+    buff.append(type);
+    buff.append("\r\n");
+    if (!_extra_headers.empty()) {
+        buff.append(_extra_headers);
+    }
 }
 /**
  * @description: 构造响应头的body
@@ -149,23 +455,44 @@ void HttpResponse::_addHeader(Buffer &buff) {
  * @return {*}
  */
 void HttpResponse::_addContent(Buffer &buff) {
-    int src_fd = open((_src_dir + _path).data(), O_RDONLY);
+    int src_fd = open(_file_path, O_RDONLY);
     if (src_fd < 0) {
-        _errorContent(buff, "File NotFound!");
+        _statusContent(buff, "File NotFound!");
         return;
     }
 
     /* 将文件映射到内存提高文件的访问速度
         MAP_PRIVATE 建立一个写入时拷贝的私有映射*/
-    LOG_DEBUG("file path %s", (_src_dir + _path).data());
-    int *mmRet = (int *)mmap(0, _mm_file_stat.st_size, PROT_READ, MAP_PRIVATE, src_fd, 0);
-    if (*mmRet == -1) {
-        _errorContent(buff, "File NotFound!");
-        return;
+    LOG_DEBUG("file path %s", _file_path);
+    if (_mm_file_stat.st_size > 0) {
+        void *mmRet = mmap(0, _mm_file_stat.st_size, PROT_READ, MAP_PRIVATE, src_fd, 0);
+        if (mmRet == MAP_FAILED) {
+            close(src_fd);
+            _statusContent(buff, "File NotFound!");
+            return;
+        }
+        _mm_file = (char *)mmRet;
     }
-    _mm_file = (char *)mmRet;
     close(src_fd);
-    buff.append("Content-length: " + to_string(_mm_file_stat.st_size) + "\r\n\r\n");
+    char header[64];
+    int len = snprintf(header, sizeof(header), "Content-length: %lld\r\n\r\n", (long long)_mm_file_stat.st_size);
+    buff.append(header, len);
+}
+/**
+ * @description: 释放响应对象持有的文件映射，arena 内存由连接统一释放
+ * @return {*}
+ */
+void HttpResponse::release() {
+    unmapFile();
+    _arena         = nullptr;
+    _path          = std::string_view();
+    _src_dir       = std::string_view();
+    _file_path     = nullptr;
+    _content          = std::string_view();
+    _extra_headers    = std::string_view();
+    _shared_content   = nullptr;
+    _deferred         = nullptr;
+    _complete_handler = nullptr;
 }
 /**
  * @description: 解除构造body时，进行的mmap映射
@@ -181,38 +508,57 @@ void HttpResponse::unmapFile() {
  * @description: 判断文件类型，如果文件路径包含‘.’，或者为指定后缀资源，则认为是明文
  * @return {*}
  */
-string HttpResponse::_getFileType() {
+std::string_view HttpResponse::_getFileType() {
     /* 判断文件类型 */
-    string::size_type idx = _path.find_last_of('.');
-    if (idx == string::npos) {
+    std::string_view::size_type idx = _path.find_last_of('.');
+    if (idx == std::string_view::npos) {
         return "text/plain";
     }
-    string suffix = _path.substr(idx);
-    if (SUFFIX_TYPE.count(suffix) == 1) {
-        return SUFFIX_TYPE.find(suffix)->second;
+    return mimeType(_path.substr(idx));
+}
+/**
+ * @description: 根据文件后缀返回 MIME 类型，未知后缀视为明文
+ * @param {string_view} suffix，包含 '.'
+ * @return {*}
+ */
+std::string_view HttpResponse::mimeType(std::string_view suffix) {
+    return SUFFIX_TYPE.get(suffix, "text/plain");
+}
+/**
+ * @description: 返回状态码对应的描述，表中没有的状态码返回所属类别的通用描述，不合法的状态码返回空
+ * @param {int} code
+ * @return {*}
+ */
+std::string_view HttpResponse::statusText(int code) {
+    if (code < 100 || code > 599) {
+        return std::string_view();
     }
-    return "text/plain";
+    return CODE_STATUS.get(code, CLASS_STATUS[code / 100 - 1]);
 }
 /**
- * @description: 直接构造a'aerror响应头的body
+ * @description: 直接构造状态码描述页面作为响应的body
  * @param {Buffer} &buff
- * @param {string} message
+ * @param {char} *message
  * @return {*}
  */
-void HttpResponse::_errorContent(Buffer &buff, string message) {
-    string body;
-    string status;
-    body += "<html><title>Error</title>";
-    body += "<body bgcolor=\"ffffff\">";
-    if (CODE_STATUS.count(_code) == 1) {
-        status = CODE_STATUS.find(_code)->second;
-    } else {
+void HttpResponse::_statusContent(Buffer &buff, const char *message) {
+    std::string_view status = statusText(_code);
+    if (status.empty()) {
         status = "Bad Request";
     }
-    body += to_string(_code) + " : " + status + "\n";
-    body += "<p>" + message + "</p>";
-    body += "<hr><em>TinyWebServer</em></body></html>";
-
-    buff.append("Content-length: " + to_string(body.size()) + "\r\n\r\n");
-    buff.append(body);
+    char body[512];
+    int body_len = snprintf(body, sizeof(body),
+                            "<html><title>%d</title>"
+                            "<body bgcolor=\"ffffff\">"
+                            "%d : %.*s\n"
+                            "<p>%s</p>"
+                            "<hr><em>TinyWebServer</em></body></html>",
+                            _code, _code, (int)status.size(), status.data(), message);
+    if (body_len >= (int)sizeof(body)) {
+        body_len = sizeof(body) - 1;
+    }
+    char header[64];
+    int len = snprintf(header, sizeof(header), "Content-length: %d\r\n\r\n", body_len);
+    buff.append(header, len);
+    buff.append(body, body_len);
 }
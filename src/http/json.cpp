@@ -0,0 +1,470 @@
+/*
+ * @Description: 原地 JSON 解析实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:02:33
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 16:02:33
+ */
+#include "json.h"
+
+#include <charconv>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+size_t JsonDocument::max_depth = 64;
+/**
+ * @description: 在字符串内容中查找第一个需要特殊处理的字节：引号、反斜杠或控制字符。
+ *               字符串占 JSON 的绝大部分字节，SSE2 下每次比较 16 字节，其余平台逐字节比较
+ * @param {char} *p
+ * @param {char} *end
+ * @return {*} 找到的位置，未找到返回 end
+ */
+static char *scanString(char *p, char *end) {
+#if defined(__SSE2__)
+    const __m128i quote     = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control   = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hit   = _mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash));
+        /* 无符号 x <= 0x1F 等价于 max(x, 0x1F) == 0x1F */
+        hit      = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; p < end; p++) {
+        unsigned char ch = *p;
+        if (ch == '"' || ch == '\\' || ch < 0x20) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static int hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
+
+static int parseHex4(const char *p) {
+    int value = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = hexValue(p[i]);
+        if (digit < 0) {
+            return -1;
+        }
+        value = (value << 4) | digit;
+    }
+    return value;
+}
+/**
+ * @description: 码点编码为 UTF-8，返回写入的字节数
+ * @param {uint32_t} code
+ * @param {char} *out
+ * @return {*}
+ */
+static size_t encodeUtf8(uint32_t code, char *out) {
+    if (code < 0x80) {
+        out[0] = static_cast<char>(code);
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (code >> 6));
+        out[1] = static_cast<char>(0x80 | (code & 0x3F));
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (code >> 12));
+        out[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (code & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (code >> 18));
+    out[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (code & 0x3F));
+    return 4;
+}
+/**
+ * @description: 文档初始化，节点带分配在 arena 中
+ * @param {Arena} *arena
+ * @return {*}
+ */
+void JsonDocument::init(Arena *arena) {
+    _arena = arena;
+    _tape  = JsonTape(ArenaAllocator<JsonNode>(arena));
+    _begin = _cur = _end = nullptr;
+    _error               = nullptr;
+    _error_offset        = 0;
+}
+/**
+ * @description: 解析 data 中的 JSON 文本，字符串转义在 data 内原地展开，data 须在文档使用期间有效
+ * @param {char} *data
+ * @param {size_t} len
+ * @return {*} 语法错误时返回 false，错误信息见 error()/errorOffset()
+ */
+bool JsonDocument::parse(char *data, size_t len) {
+    _tape.clear();
+    _error        = nullptr;
+    _error_offset = 0;
+    _begin = _cur = data;
+    _end          = data + len;
+    if (len >= UINT32_MAX) {
+        return _fail("document too large");
+    }
+    _tape.reserve(16);
+    _skipSpace();
+    if (!_parseValue(0)) {
+        return false;
+    }
+    _skipSpace();
+    if (_cur != _end) {
+        return _fail("trailing characters");
+    }
+    return true;
+}
+
+bool JsonDocument::_parseValue(size_t depth) {
+    if (_cur == _end) {
+        return _fail("unexpected end");
+    }
+    switch (*_cur) {
+    case '{':
+        return _parseContainer(JSON_OBJECT, depth);
+    case '[':
+        return _parseContainer(JSON_ARRAY, depth);
+    case '"': {
+        std::string_view text;
+        if (!_parseString(&text)) {
+            return false;
+        }
+        _tape.push_back({JSON_STRING, (uint32_t)_tape.size() + 1, 0, text});
+        return true;
+    }
+    case 't':
+        return _parseLiteral("true", JSON_TRUE);
+    case 'f':
+        return _parseLiteral("false", JSON_FALSE);
+    case 'n':
+        return _parseLiteral("null", JSON_NULL);
+    default:
+        return _parseNumber();
+    }
+}
+/**
+ * @description: 解析对象或数组，容器节点先占位，子节点解析完后回填 next 与 count
+ * @param {JSON_TYPE} type
+ * @param {size_t} depth
+ * @return {*}
+ */
+bool JsonDocument::_parseContainer(JSON_TYPE type, size_t depth) {
+    if (depth >= max_depth) {
+        return _fail("nesting too deep");
+    }
+    const char close = type == JSON_OBJECT ? '}' : ']';
+    size_t index     = _tape.size();
+    uint32_t count   = 0;
+    _tape.push_back({type, 0, 0, std::string_view()});
+    _cur++;
+    _skipSpace();
+    if (_cur < _end && *_cur == close) {
+        _cur++;
+    } else {
+        while (true) {
+            if (type == JSON_OBJECT) {
+                std::string_view key;
+                if (_cur == _end || *_cur != '"' || !_parseString(&key)) {
+                    return _error ? false : _fail("expected member name");
+                }
+                _tape.push_back({JSON_STRING, (uint32_t)_tape.size() + 1, 0, key});
+                _skipSpace();
+                if (_cur == _end || *_cur != ':') {
+                    return _fail("expected ':'");
+                }
+                _cur++;
+                _skipSpace();
+            }
+            if (!_parseValue(depth + 1)) {
+                return false;
+            }
+            count++;
+            _skipSpace();
+            if (_cur < _end && *_cur == ',') {
+                _cur++;
+                _skipSpace();
+                continue;
+            }
+            if (_cur < _end && *_cur == close) {
+                _cur++;
+                break;
+            }
+            return _fail(type == JSON_OBJECT ? "expected ',' or '}'" : "expected ',' or ']'");
+        }
+    }
+    _tape[index].next  = _tape.size();
+    _tape[index].count = count;
+    return true;
+}
+/**
+ * @description: 解析字符串，无转义时直接引用原文；有转义时在原缓冲区内向前压缩写入，结果不会长于原文
+ * @param {string_view} *out
+ * @return {*}
+ */
+bool JsonDocument::_parseString(std::string_view *out) {
+    char *begin = ++_cur;
+    char *write = nullptr;
+    while (true) {
+        char *hit = scanString(_cur, _end);
+        if (write && hit > _cur) {
+            memmove(write, _cur, hit - _cur);
+            write += hit - _cur;
+        }
+        _cur = hit;
+        if (_cur == _end) {
+            return _fail("unterminated string");
+        }
+        if (*_cur == '"') {
+            *out = std::string_view(begin, (write ? write : _cur) - begin);
+            _cur++;
+            return true;
+        }
+        if (*_cur != '\\') {
+            return _fail("control character in string");
+        }
+        if (!write) {
+            write = _cur;
+        }
+        if (_end - _cur < 2) {
+            return _fail("unterminated string");
+        }
+        char esc = _cur[1];
+        _cur += 2;
+        switch (esc) {
+        case '"':
+        case '\\':
+        case '/':
+            *write++ = esc;
+            break;
+        case 'b':
+            *write++ = '\b';
+            break;
+        case 'f':
+            *write++ = '\f';
+            break;
+        case 'n':
+            *write++ = '\n';
+            break;
+        case 'r':
+            *write++ = '\r';
+            break;
+        case 't':
+            *write++ = '\t';
+            break;
+        case 'u': {
+            int code = _end - _cur >= 4 ? parseHex4(_cur) : -1;
+            if (code < 0) {
+                return _fail("invalid unicode escape");
+            }
+            _cur += 4;
+            uint32_t point = code;
+            if (code >= 0xD800 && code <= 0xDBFF) {
+                /* UTF-16 代理对 */
+                int low = _end - _cur >= 6 && _cur[0] == '\\' && _cur[1] == 'u' ? parseHex4(_cur + 2) : -1;
+                if (low < 0xDC00 || low > 0xDFFF) {
+                    return _fail("invalid surrogate pair");
+                }
+                _cur += 6;
+                point = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                return _fail("invalid surrogate pair");
+            }
+            write += encodeUtf8(point, write);
+            break;
+        }
+        default:
+            return _fail("invalid escape");
+        }
+    }
+}
+/**
+ * @description: 按 JSON 语法校验数字，节点保存原文，转换推迟到访问时
+ * @return {*}
+ */
+bool JsonDocument::_parseNumber() {
+    char *begin = _cur;
+    auto digits = [this] {
+        char *start = _cur;
+        while (_cur < _end && *_cur >= '0' && *_cur <= '9') {
+            _cur++;
+        }
+        return _cur - start;
+    };
+    if (_cur < _end && *_cur == '-') {
+        _cur++;
+    }
+    if (_cur < _end && *_cur == '0') {
+        _cur++;
+    } else if (digits() == 0) {
+        return _fail("invalid value");
+    }
+    if (_cur < _end && *_cur == '.') {
+        _cur++;
+        if (digits() == 0) {
+            return _fail("invalid number");
+        }
+    }
+    if (_cur < _end && (*_cur == 'e' || *_cur == 'E')) {
+        _cur++;
+        if (_cur < _end && (*_cur == '+' || *_cur == '-')) {
+            _cur++;
+        }
+        if (digits() == 0) {
+            return _fail("invalid number");
+        }
+    }
+    _tape.push_back({JSON_NUMBER, (uint32_t)_tape.size() + 1, 0, std::string_view(begin, _cur - begin)});
+    return true;
+}
+
+bool JsonDocument::_parseLiteral(std::string_view literal, JSON_TYPE type) {
+    if ((size_t)(_end - _cur) < literal.size() || memcmp(_cur, literal.data(), literal.size()) != 0) {
+        return _fail("invalid literal");
+    }
+    _tape.push_back({type, (uint32_t)_tape.size() + 1, 0, std::string_view(_cur, literal.size())});
+    _cur += literal.size();
+    return true;
+}
+
+void JsonDocument::_skipSpace() {
+    while (_cur < _end && (*_cur == ' ' || *_cur == '\n' || *_cur == '\r' || *_cur == '\t')) {
+        _cur++;
+    }
+}
+/**
+ * @description: 记录错误与出错位置，丢弃已构造的节点
+ * @param {char} *error
+ * @return {*}
+ */
+bool JsonDocument::_fail(const char *error) {
+    _error        = error;
+    _error_offset = _cur - _begin;
+    _tape.clear();
+    return false;
+}
+
+const JsonNode &JsonValue::_node() const {
+    return _doc->tape()[_index];
+}
+
+JSON_TYPE JsonValue::type() const {
+    return _node().type;
+}
+/**
+ * @description: 数组元素数或对象成员数，其余类型为 0
+ * @return {*}
+ */
+size_t JsonValue::size() const {
+    return valid() ? _node().count : 0;
+}
+/**
+ * @description: 返回第 index 个子节点的下标，对象返回成员值的下标
+ * @param {size_t} index
+ * @return {*}
+ */
+uint32_t JsonValue::_child(size_t index) const {
+    const JsonTape &tape = _doc->tape();
+    uint32_t child       = _index + 1;
+    bool object          = _node().type == JSON_OBJECT;
+    for (size_t i = 0; i < index; i++) {
+        child = tape[object ? child + 1 : child].next;
+    }
+    return object ? child + 1 : child;
+}
+/**
+ * @description: 按名称查找对象成员，重名时返回第一个
+ * @param {string_view} key
+ * @return {*}
+ */
+JsonValue JsonValue::get(std::string_view key) const {
+    if (!isObject()) {
+        return JsonValue();
+    }
+    const JsonTape &tape = _doc->tape();
+    uint32_t child       = _index + 1;
+    for (size_t i = 0; i < _node().count; i++) {
+        if (tape[child].text == key) {
+            return JsonValue(_doc, child + 1);
+        }
+        child = tape[child + 1].next;
+    }
+    return JsonValue();
+}
+/**
+ * @description: 返回数组第 index 个元素或对象第 index 个成员的值
+ * @param {size_t} index
+ * @return {*}
+ */
+JsonValue JsonValue::at(size_t index) const {
+    if (!(isArray() || isObject()) || index >= _node().count) {
+        return JsonValue();
+    }
+    return JsonValue(_doc, _child(index));
+}
+/**
+ * @description: 返回对象第 index 个成员的名称
+ * @param {size_t} index
+ * @return {*}
+ */
+std::string_view JsonValue::keyAt(size_t index) const {
+    if (!isObject() || index >= _node().count) {
+        return std::string_view();
+    }
+    return _doc->tape()[_child(index) - 1].text;
+}
+
+std::string_view JsonValue::asString(std::string_view def) const {
+    return isString() ? _node().text : def;
+}
+/**
+ * @description: 数字转为整数，带小数或指数、超出范围时返回默认值
+ * @param {int64_t} def
+ * @return {*}
+ */
+int64_t JsonValue::asInt(int64_t def) const {
+    if (!isNumber()) {
+        return def;
+    }
+    std::string_view text = _node().text;
+    int64_t value;
+    auto ret = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ret.ec == std::errc() && ret.ptr == text.data() + text.size() ? value : def;
+}
+
+double JsonValue::asDouble(double def) const {
+    if (!isNumber()) {
+        return def;
+    }
+    std::string_view text = _node().text;
+    double value;
+    auto ret = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ret.ec == std::errc() ? value : def;
+}
+
+bool JsonValue::asBool(bool def) const {
+    return isBool() ? type() == JSON_TRUE : def;
+}
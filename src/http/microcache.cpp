@@ -0,0 +1,352 @@
+/*
+ * @Description: 请求合并与短时缓存实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:36:05
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include "microcache.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+/* 链表节点、哈希表节点与 Result 控制块的大致开销 */
+static const size_t NODE_OVERHEAD = 2 * sizeof(void *) + sizeof(std::string_view) + 4 * sizeof(void *) + 32;
+
+/**
+ * @description:
+ * @param {size_t} max_bytes，全部条目的内存预算，平均分配到各分片
+ * @param {int} stale_ms，过期后仍可应答旧结果的时长，0 表示不使用旧结果
+ * @param {ThreadPool} *pool，执行后台刷新，需比缓存先停止
+ * @param {Router} *router，注册被包装处理函数的路由表
+ * @param {size_t} shard_num，向上取整为 2 的幂
+ * @return {*}
+ */
+MicroCache::MicroCache(size_t max_bytes, int stale_ms, ThreadPool *pool, const Router *router, size_t shard_num)
+    : _stale_ms(stale_ms)
+    , _pool(pool)
+    , _router(router)
+    , _count(0)
+    , _bytes(0) {
+    assert(max_bytes > 0 && stale_ms >= 0 && shard_num > 0 && pool && router);
+    size_t n = 1;
+    while (n < shard_num) {
+        n <<= 1;
+    }
+    _shards.reset(new Shard[n]);
+    _mask         = n - 1;
+    _shard_budget = max_bytes / n;
+}
+
+MicroCache::~MicroCache() {
+    _reap();
+    for (Revalidation *rev : _running) {
+        delete rev;
+    }
+}
+/**
+ * @description: 包装处理函数，结果缓存 ttl_ms
+ * @param {RouteHandler} handler
+ * @param {int} ttl_ms
+ * @return {*}
+ */
+RouteHandler MicroCache::wrap(RouteHandler handler, int ttl_ms) {
+    assert(ttl_ms > 0);
+    return [this, handler = std::move(handler), ttl_ms](const HttpRequest &request, HttpResponse &response) {
+        _handle(handler, ttl_ms, request, response);
+    };
+}
+/**
+ * @description: 命中时直接应答；同键已有计算在进行时挂起等待；否则作为 leader 执行处理函数。
+ *               带 Cookie 或 Authorization 的请求应答可能因用户而异，直接执行处理函数
+ * @param {RouteHandler} &handler
+ * @param {int} ttl_ms
+ * @param {HttpRequest} &request
+ * @param {HttpResponse} &response
+ * @return {*}
+ */
+void MicroCache::_handle(const RouteHandler &handler, int ttl_ms, const HttpRequest &request, HttpResponse &response) {
+    if (request.method() != "GET" || request.headers().has(HttpHeaders::COOKIE) ||
+        request.getHeader("Authorization").data()) {
+        handler(request, response);
+        return;
+    }
+    std::string_view host = request.headers().get(HttpHeaders::HOST);
+    std::string key;
+    key.reserve(host.size() + 1 + request.target().size());
+    key.append(host).append(1, ' ').append(request.target());
+    Shard &shard = _shard(key);
+    std::unique_lock<std::mutex> locker(shard.mtx);
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        EntryList::iterator entry = it->second;
+        Clock::time_point now     = Clock::now();
+        if (now < entry->stale_until) {
+            ResultPtr result = entry->result;
+            bool stale       = now >= entry->fresh_until;
+            FlightPtr flight;
+            if (stale && shard.flights.find(key) == shard.flights.end()) {
+                flight          = std::make_shared<Flight>();
+                flight->handler = &handler;
+                shard.flights.emplace(key, flight);
+            }
+            shard.lru.splice(shard.lru.begin(), shard.lru, entry);
+            locker.unlock();
+            Metrics::add(stale ? Metrics::MICRO_CACHE_STALE_HITS : Metrics::MICRO_CACHE_HITS);
+            _apply(result, response);
+            if (flight) {
+                /* 当前请求不等待刷新，请求在应答后即失效，任务持有一份副本 */
+                std::string raw = _copyRequest(request);
+                _pool->addTask([this, &handler, ttl_ms, key, flight, raw] {
+                    _revalidate(handler, ttl_ms, key, flight, raw);
+                });
+            }
+            return;
+        }
+        _erase(shard, entry);
+    }
+    auto running = shard.flights.find(key);
+    if (running != shard.flights.end()) {
+        FlightPtr flight = running->second;
+        locker.unlock();
+        Metrics::add(Metrics::MICRO_CACHE_COALESCED);
+        /* 请求线程交还连接后才挂到 flight 上，此后 leader 可在任意线程 resume；请求在应答发出前保持有效 */
+        HttpResponse *resp     = &response;
+        const HttpRequest *req = &request;
+        response.defer([&shard, flight, req, resp] {
+            std::unique_lock<std::mutex> locker(shard.mtx);
+            if (!flight->done) {
+                flight->waiters.push_back({req, resp, resp->deferToken()});
+                return;
+            }
+            locker.unlock();
+            if (flight->result) {
+                _apply(flight->result, *resp);
+                resp->resume();
+            } else {
+                _rerun(*flight->handler, *req, *resp);
+            }
+        });
+        return;
+    }
+    FlightPtr flight = std::make_shared<Flight>();
+    flight->handler  = &handler;
+    shard.flights.emplace(key, flight);
+    locker.unlock();
+    Metrics::add(Metrics::MICRO_CACHE_MISSES);
+
+    response.setBuffered(true);
+    response.setCompleteHandler(
+        [this, key, flight, ttl_ms](HttpResponse &resp) { _land(key, flight, ttl_ms, resp); });
+    handler(request, response);
+    if (!response.isDeferred()) {
+        response.complete();
+    }
+}
+/**
+ * @description: 在线程池任务中解析请求副本，用独立的应答对象重新执行处理函数刷新条目。
+ *               延后的处理函数(如反向代理)的任务在本线程执行，结果就绪后经 _land 保存
+ * @param {RouteHandler} &handler
+ * @param {int} ttl_ms
+ * @param {string} &key
+ * @param {FlightPtr} &flight
+ * @param {string_view} raw，_copyRequest 生成的请求报文
+ * @return {*}
+ */
+void MicroCache::_revalidate(const RouteHandler &handler, int ttl_ms, const std::string &key, const FlightPtr &flight,
+                             std::string_view raw) {
+    _reap();
+    Revalidation *rev      = new Revalidation();
+    HttpRequest &request   = rev->request;
+    HttpResponse &response = rev->response;
+    request.init(&rev->arena);
+    rev->raw.append(raw);
+    bool parsed = request.parse(rev->raw) == HttpRequest::GET_REQUEST;
+    response.init(&rev->arena, "/", request.path(), false, 200);
+    response.setBuffered(true);
+    response.setCompleteHandler(
+        [this, key, flight, ttl_ms](HttpResponse &resp) { _land(key, flight, ttl_ms, resp); });
+    /* 应答对象在自身的 resume 中不能释放，先移入 _finished，下次刷新时回收 */
+    response.setResumeHandler([this, rev] {
+        std::lock_guard<std::mutex> locker(_reap_mtx);
+        _running.erase(std::find(_running.begin(), _running.end(), rev));
+        _finished.push_back(rev);
+    });
+    {
+        std::lock_guard<std::mutex> locker(_reap_mtx);
+        _running.push_back(rev);
+    }
+    const RouteHandler *matched = nullptr;
+    if (!parsed || request.route(*_router, &matched) != 200) {
+        /* 不会发生：副本与原请求的请求行和首部相同。结果不可缓存，等待中的请求各自执行处理函数 */
+        LOG_WARN("Micro cache revalidate %s: request copy rejected", key.c_str());
+        response.setCode(500);
+        response.resume();
+        return;
+    }
+    LOG_DEBUG("Micro cache revalidate %s", key.c_str());
+    handler(request, response);
+    if (response.isDeferred()) {
+        response.takeDeferred()();
+    } else {
+        response.resume();
+    }
+}
+/**
+ * @description: leader 的结果就绪：可缓存时保存并交给等待中的请求，否则等待中的请求各自执行处理函数。
+ *               等待期间连接已关闭的请求认领失败，跳过
+ * @param {string} &key
+ * @param {FlightPtr} &flight
+ * @param {int} ttl_ms
+ * @param {HttpResponse} &response
+ * @return {*}
+ */
+void MicroCache::_land(const std::string &key, const FlightPtr &flight, int ttl_ms, HttpResponse &response) {
+    ResultPtr result;
+    if (response.hasContent() && response.code() == 200 && response.isCacheable()) {
+        std::shared_ptr<Result> landed(new Result());
+        landed->code    = response.code();
+        landed->content = response.content();
+        landed->type    = response.contentType();
+        landed->headers = response.headerLines();
+        result          = std::move(landed);
+    }
+
+    std::vector<Waiter> waiters;
+    Shard &shard = _shard(key);
+    {
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        flight->done   = true;
+        flight->result = result;
+        waiters.swap(flight->waiters);
+        auto it = shard.flights.find(key);
+        if (it != shard.flights.end() && it->second == flight) {
+            shard.flights.erase(it);
+        }
+        if (result) {
+            _store(shard, key, result, ttl_ms);
+        }
+    }
+    for (Waiter &waiter : waiters) {
+        if (!waiter.response->claim(waiter.token)) {
+            continue;
+        }
+        if (result) {
+            _apply(result, *waiter.response);
+            waiter.response->resume();
+        } else {
+            _rerun(*flight->handler, *waiter.request, *waiter.response);
+        }
+    }
+}
+/**
+ * @description: 保存结果，替换同键的旧条目，超出预算时从尾部淘汰。调用方持有分片锁
+ * @param {Shard} &shard
+ * @param {string} &key
+ * @param {ResultPtr} result
+ * @param {int} ttl_ms
+ * @return {*}
+ */
+void MicroCache::_store(Shard &shard, const std::string &key, ResultPtr result, int ttl_ms) {
+    size_t bytes = sizeof(Entry) + sizeof(Result) + 2 * key.capacity() + result->content.capacity() +
+                   result->type.capacity() + result->headers.capacity() + NODE_OVERHEAD;
+    if (bytes > _shard_budget) {
+        return;
+    }
+    auto it = shard.index.find(key);
+    if (it != shard.index.end()) {
+        _erase(shard, it->second);
+    }
+    Clock::time_point now = Clock::now();
+    Entry entry;
+    entry.key         = key;
+    entry.result      = std::move(result);
+    entry.fresh_until = now + std::chrono::milliseconds(ttl_ms);
+    entry.stale_until = entry.fresh_until + std::chrono::milliseconds(_stale_ms);
+    entry.bytes       = bytes;
+    shard.lru.push_front(std::move(entry));
+    shard.index.emplace(shard.lru.front().key, shard.lru.begin());
+    shard.bytes += bytes;
+    _count.fetch_add(1, std::memory_order_relaxed);
+    _bytes.fetch_add(bytes, std::memory_order_relaxed);
+    while (shard.bytes > _shard_budget) {
+        _erase(shard, std::prev(shard.lru.end()));
+    }
+}
+
+void MicroCache::_erase(Shard &shard, EntryList::iterator it) {
+    shard.bytes -= it->bytes;
+    _count.fetch_sub(1, std::memory_order_relaxed);
+    _bytes.fetch_sub(it->bytes, std::memory_order_relaxed);
+    shard.index.erase(std::string_view(it->key));
+    shard.lru.erase(it);
+}
+/**
+ * @description: 释放已完成的后台刷新
+ * @return {*}
+ */
+void MicroCache::_reap() {
+    std::vector<Revalidation *> finished;
+    {
+        std::lock_guard<std::mutex> locker(_reap_mtx);
+        finished.swap(_finished);
+    }
+    for (Revalidation *rev : finished) {
+        delete rev;
+    }
+}
+
+MicroCache::Shard &MicroCache::_shard(std::string_view key) {
+    return _shards[std::hash<std::string_view>()(key) & _mask];
+}
+/**
+ * @description: 复制请求行与首部，供后台刷新在请求应答后重新解析；GET 没有 body，不复制分帧相关的首部
+ * @param {HttpRequest} &request
+ * @return {*}
+ */
+std::string MicroCache::_copyRequest(const HttpRequest &request) {
+    const HttpHeaders &headers = request.headers();
+    std::string raw;
+    raw.append(request.method()).append(1, ' ').append(request.target()).append(" HTTP/1.1\r\n");
+    for (int i = 0; i < HttpHeaders::KNOWN_COUNT; i++) {
+        HttpHeaders::KNOWN_HEADER key = static_cast<HttpHeaders::KNOWN_HEADER>(i);
+        if (key == HttpHeaders::CONNECTION || key == HttpHeaders::CONTENT_LENGTH ||
+            key == HttpHeaders::TRANSFER_ENCODING || !headers.has(key)) {
+            continue;
+        }
+        raw.append(HttpHeaders::name(key)).append(": ").append(headers.get(key)).append("\r\n");
+    }
+    for (const HttpField &field : headers.others()) {
+        raw.append(field.first).append(": ").append(field.second).append("\r\n");
+    }
+    raw.append("\r\n");
+    return raw;
+}
+/**
+ * @description: 以共享结果应答，body 与结果共享所有权，写出期间不会被淘汰释放
+ * @param {ResultPtr} &result
+ * @param {HttpResponse} &response
+ * @return {*}
+ */
+void MicroCache::_apply(const ResultPtr &result, HttpResponse &response) {
+    response.setCode(result->code);
+    response.addHeaderLines(result->headers);
+    response.setContent(std::shared_ptr<const std::string>(result, &result->content), result->type);
+}
+/**
+ * @description: leader 的结果不可共享，等待中的请求自行执行处理函数，延后的处理函数在当前线程交出应答
+ * @param {RouteHandler} &handler
+ * @param {HttpRequest} &request
+ * @param {HttpResponse} &response
+ * @return {*}
+ */
+void MicroCache::_rerun(const RouteHandler &handler, const HttpRequest &request, HttpResponse &response) {
+    handler(request, response);
+    if (response.isDeferred()) {
+        response.runDeferred();
+    } else {
+        response.resume();
+    }
+}
@@ -0,0 +1,459 @@
+/*
+ * @Description: multipart/form-data 流式解析实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 15:41:07
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 15:41:07
+ */
+#include "multipart.h"
+
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+
+#include "httpheaders.h"
+#include "logger.h"
+#include "uploadfile.h"
+
+size_t MultipartCollector::spill_threshold = 64 << 10;
+const char *MultipartCollector::spill_dir  = "/tmp";
+
+static std::string_view trim(std::string_view str) {
+    while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+        str.remove_prefix(1);
+    }
+    while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+        str.remove_suffix(1);
+    }
+    return str;
+}
+/**
+ * @description: 取首部值中 "; key=value" 形式的参数，值可以带引号，key 大小写不敏感
+ * @param {string_view} value，如 form-data; name="file"; filename="a.png"
+ * @param {string_view} key
+ * @return {*}
+ */
+static std::string_view headerParam(std::string_view value, std::string_view key) {
+    while (!value.empty()) {
+        size_t semi = value.find(';');
+        if (semi == std::string_view::npos) {
+            break;
+        }
+        value     = value.substr(semi + 1);
+        size_t eq = value.find('=');
+        if (eq == std::string_view::npos) {
+            break;
+        }
+        std::string_view name = trim(value.substr(0, eq));
+        std::string_view rest = trim(value.substr(eq + 1));
+        std::string_view param;
+        if (!rest.empty() && rest.front() == '"') {
+            size_t quote = rest.find('"', 1);
+            if (quote == std::string_view::npos) {
+                break;
+            }
+            param = rest.substr(1, quote - 1);
+            value = rest.substr(quote + 1);
+        } else {
+            size_t end = rest.find(';');
+            param      = trim(rest.substr(0, end));
+            value      = end == std::string_view::npos ? std::string_view() : rest.substr(end);
+        }
+        if (HttpHeaders::equalsIgnoreCase(name, key)) {
+            return param;
+        }
+    }
+    return std::string_view();
+}
+/**
+ * @description: 收集器初始化，关闭上一请求遗留的临时文件
+ * @param {Arena} *arena
+ * @param {size_t} limit，内存中收集的总字节上限
+ * @return {*}
+ */
+void MultipartCollector::init(Arena *arena, size_t limit) {
+    clear();
+    _arena      = arena;
+    _parts      = MultipartPartList(ArenaAllocator<MultipartPart>(arena));
+    _data       = nullptr;
+    _capacity   = 0;
+    _used       = 0;
+    _limit      = limit;
+    _error_code = 0;
+}
+/**
+ * @description: 关闭溢出部分的临时文件，须在 arena 重置之前调用
+ * @return {*}
+ */
+void MultipartCollector::clear() {
+    for (auto &part : _parts) {
+        if (part.fd >= 0) {
+            close(part.fd);
+            part.fd = -1;
+        }
+    }
+    _parts.clear();
+}
+
+bool MultipartCollector::onPartBegin(const MultipartPart &part) {
+    _parts.push_back(part);
+    _data     = nullptr;
+    _capacity = 0;
+    return true;
+}
+/**
+ * @description: 追加部分数据；文件部分超过阈值或内存配额不足时溢出到临时文件，普通字段超出配额时拒绝
+ * @param {string_view} slice
+ * @return {*}
+ */
+bool MultipartCollector::onPartData(std::string_view slice) {
+    MultipartPart &part = _parts.back();
+    size_t size         = part.size + slice.size();
+    if (part.fd < 0 && !part.filename.empty() && (size > spill_threshold || _used + size > _limit)) {
+        if (!_spill(part)) {
+            return false;
+        }
+    }
+    if (part.fd >= 0) {
+        if (!_write(part.fd, slice)) {
+            return false;
+        }
+        part.size = size;
+        return true;
+    }
+    if (size > _capacity) {
+        assert(_arena);
+        size_t capacity = std::max({_capacity * 2, size, (size_t)256});
+        if (_used + capacity > _limit) {
+            capacity = size;
+        }
+        if (_used + capacity > _limit) {
+            _error_code = 413;
+            return false;
+        }
+        char *data = static_cast<char *>(_arena->allocate(capacity, 1));
+        if (part.size) {
+            memcpy(data, _data, part.size);
+        }
+        _data     = data;
+        _capacity = capacity;
+        _used += capacity;
+    }
+    memcpy(_data + part.size, slice.data(), slice.size());
+    part.size = size;
+    part.data = std::string_view(_data, size);
+    return true;
+}
+/**
+ * @description: 部分结束，溢出文件回到起始位置供处理函数读取
+ * @return {*}
+ */
+bool MultipartCollector::onPartEnd() {
+    MultipartPart &part = _parts.back();
+    if (part.fd >= 0) {
+        lseek(part.fd, 0, SEEK_SET);
+    }
+    _data     = nullptr;
+    _capacity = 0;
+    return true;
+}
+/**
+ * @description: 将文件部分转存到临时文件，已收集到内存中的内容先写入
+ * @param {MultipartPart} &part
+ * @return {*}
+ */
+bool MultipartCollector::_spill(MultipartPart &part) {
+    part.fd = UploadFile::createTemp(spill_dir);
+    if (part.fd < 0) {
+        LOG_ERROR("Multipart spill file in %s error: %d", spill_dir, errno);
+        _error_code = 500;
+        return false;
+    }
+    LOG_DEBUG("Multipart part %.*s spilled to disk", (int)part.name.size(), part.name.data());
+    if (!_write(part.fd, part.data)) {
+        return false;
+    }
+    part.data = std::string_view();
+    _data     = nullptr;
+    _capacity = 0;
+    return true;
+}
+
+bool MultipartCollector::_write(int fd, std::string_view slice) {
+    while (!slice.empty()) {
+        ssize_t n = write(fd, slice.data(), slice.size());
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            LOG_ERROR("Multipart write error: %d", errno);
+            _error_code = 500;
+            return false;
+        }
+        slice.remove_prefix(n);
+    }
+    return true;
+}
+/**
+ * @description: 解析器初始化，从 Content-Type 中取出 boundary 并构造 BMH 跳转表
+ * @param {Arena} *arena
+ * @param {string_view} content_type
+ * @param {MultipartListener} *listener
+ * @return {*} boundary 缺失或非法时返回 false
+ */
+bool MultipartParser::init(Arena *arena, std::string_view content_type, MultipartListener *listener) {
+    _arena        = arena;
+    _listener     = listener;
+    _state        = PREAMBLE;
+    _error_code   = 0;
+    _part         = MultipartPart{};
+    _part.fd      = -1;
+    _header_bytes = 0;
+    _delimiter    = std::string_view();
+    _carry        = nullptr;
+    _carry_len    = 0;
+    std::string_view bound = boundary(content_type);
+    if (!arena || !listener || bound.empty()) {
+        return false;
+    }
+    _delimiter = arena->concat("\r\n--", bound);
+    size_t len = _delimiter.size();
+    memset(_skip, (int)len, sizeof(_skip));
+    for (size_t i = 0; i + 1 < len; i++) {
+        _skip[static_cast<unsigned char>(_delimiter[i])] = len - 1 - i;
+    }
+    _carry = static_cast<char *>(arena->allocate(CARRY_SIZE, 1));
+    /* 首个分隔符前没有 CRLF，预置到未决数据中，使其与后续分隔符的形式一致 */
+    memcpy(_carry, "\r\n", 2);
+    _carry_len = 2;
+    return true;
+}
+/**
+ * @description: 从 Content-Type 中取出 boundary，不是 multipart/form-data 或 boundary 非法时返回空
+ * @param {string_view} content_type
+ * @return {*}
+ */
+std::string_view MultipartParser::boundary(std::string_view content_type) {
+    const std::string_view type = "multipart/form-data";
+    if (content_type.size() < type.size() || !HttpHeaders::equalsIgnoreCase(content_type.substr(0, type.size()), type)) {
+        return std::string_view();
+    }
+    std::string_view bound = headerParam(content_type, "boundary");
+    if (bound.empty() || bound.size() > MAX_BOUNDARY) {
+        return std::string_view();
+    }
+    return bound;
+}
+/**
+ * @description: Boyer-Moore-Horspool 搜索，失配时按窗口末字节跳过
+ * @param {string_view} haystack
+ * @param {string_view} needle
+ * @param {unsigned char} *skip，needle 的坏字符跳转表
+ * @return {*} 首次出现的位置，未找到返回 npos
+ */
+size_t MultipartParser::search(std::string_view haystack, std::string_view needle, const unsigned char *skip) {
+    const size_t m = needle.size();
+    if (m == 0 || haystack.size() < m) {
+        return std::string_view::npos;
+    }
+    const char last    = needle[m - 1];
+    const char *data   = haystack.data();
+    const size_t bound = haystack.size() - m;
+    for (size_t i = 0; i <= bound;) {
+        char ch = data[i + m - 1];
+        if (ch == last && memcmp(data + i, needle.data(), m - 1) == 0) {
+            return i;
+        }
+        i += skip[static_cast<unsigned char>(ch)];
+    }
+    return std::string_view::npos;
+}
+/**
+ * @description: 消费 body 切片。本次无法判定的末尾字节(可能是分隔符或首部行的前缀)保留在 _carry 中，
+ *               下一切片到达时补齐后继续，除此之外切片数据不拷贝，直接交付给接收者
+ * @param {string_view} slice
+ * @return {*}
+ */
+bool MultipartParser::onBodyData(std::string_view slice) {
+    while (!slice.empty() && _state != ERROR) {
+        if (_carry_len == 0) {
+            slice.remove_prefix(_process(slice));
+            if (_state == ERROR) {
+                break;
+            }
+            if (slice.size() > CARRY_SIZE) {
+                _fail(400);
+                break;
+            }
+            memcpy(_carry, slice.data(), slice.size());
+            _carry_len = slice.size();
+            break;
+        }
+        size_t fill = std::min(slice.size(), CARRY_SIZE - _carry_len);
+        memcpy(_carry + _carry_len, slice.data(), fill);
+        size_t window   = _carry_len + fill;
+        size_t consumed = _process(std::string_view(_carry, window));
+        if (_state == ERROR) {
+            break;
+        }
+        if (consumed >= _carry_len) {
+            /* 未决数据已判定，切片剩余部分直接解析 */
+            slice.remove_prefix(consumed - _carry_len);
+            _carry_len = 0;
+        } else if (fill == slice.size()) {
+            memmove(_carry, _carry + consumed, window - consumed);
+            _carry_len = window - consumed;
+            break;
+        } else {
+            /* 未决数据填满仍无法判定，首部行过长 */
+            _fail(400);
+        }
+    }
+    return _state != ERROR;
+}
+/**
+ * @description: body 结束时必须已读到结束分隔符
+ * @return {*}
+ */
+bool MultipartParser::onBodyEnd() {
+    if (_state != EPILOGUE) {
+        _fail(400);
+        return false;
+    }
+    return true;
+}
+
+int MultipartParser::errorCode() const {
+    return _error_code ? _error_code : 400;
+}
+/**
+ * @description: 在连续的数据视图上推进状态机
+ * @param {string_view} view
+ * @return {*} 已处理的字节数，其余字节需等待更多数据
+ */
+size_t MultipartParser::_process(std::string_view view) {
+    size_t pos = 0;
+    while (true) {
+        std::string_view rest = view.substr(pos);
+        switch (_state) {
+        case PREAMBLE:
+        case DATA: {
+            size_t found = search(rest, _delimiter, _skip);
+            if (found == std::string_view::npos) {
+                /* 末尾可能是分隔符的前缀，从最后一个 '\r' 起保留到下一切片 */
+                size_t keep = std::min(rest.size(), _delimiter.size() - 1);
+                size_t safe = rest.find('\r', rest.size() - keep);
+                if (safe == std::string_view::npos) {
+                    safe = rest.size();
+                }
+                if (_state == DATA && !_emit(rest.substr(0, safe))) {
+                    return _fail(_listener->errorCode());
+                }
+                return pos + safe;
+            }
+            if (_state == DATA && (!_emit(rest.substr(0, found)) || !_listener->onPartEnd())) {
+                return _fail(_listener->errorCode());
+            }
+            pos += found + _delimiter.size();
+            _state = DELIMITER;
+            break;
+        }
+        case DELIMITER: {
+            /* 分隔符之后为 "--"(结束) 或可选空白 + CRLF */
+            if (rest.size() < 2) {
+                return pos;
+            }
+            if (rest[0] == '-' && rest[1] == '-') {
+                pos += 2;
+                _state = EPILOGUE;
+                break;
+            }
+            size_t i = 0;
+            while (i < rest.size() && (rest[i] == ' ' || rest[i] == '\t')) {
+                i++;
+            }
+            if (rest.size() < i + 2) {
+                return pos;
+            }
+            if (rest[i] != '\r' || rest[i + 1] != '\n') {
+                return _fail(400);
+            }
+            pos += i + 2;
+            _part         = MultipartPart{};
+            _part.fd      = -1;
+            _header_bytes = 0;
+            _state        = HEADERS;
+            break;
+        }
+        case HEADERS: {
+            size_t eol = rest.find("\r\n");
+            if (eol == std::string_view::npos) {
+                return pos;
+            }
+            _header_bytes += eol + 2;
+            if (_header_bytes > CARRY_SIZE) {
+                return _fail(400);
+            }
+            pos += eol + 2;
+            if (eol > 0) {
+                if (!_parsePartHeader(rest.substr(0, eol))) {
+                    return _fail(400);
+                }
+                break;
+            }
+            if (_part.name.empty()) {
+                return _fail(400);
+            }
+            if (!_listener->onPartBegin(_part)) {
+                return _fail(_listener->errorCode());
+            }
+            _state = DATA;
+            break;
+        }
+        case EPILOGUE:
+            /* 结束分隔符之后的内容忽略 */
+            return view.size();
+        default:
+            return pos;
+        }
+    }
+}
+/**
+ * @description: 解析部分首部，只关心 Content-Disposition 与 Content-Type，其余忽略
+ * @param {string_view} line
+ * @return {*}
+ */
+bool MultipartParser::_parsePartHeader(std::string_view line) {
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        return false;
+    }
+    std::string_view name  = line.substr(0, colon);
+    std::string_view value = trim(line.substr(colon + 1));
+    auto save              = [this](std::string_view str) {
+        return str.empty() ? str : std::string_view(_arena->copy(str.data(), str.size()), str.size());
+    };
+    if (HttpHeaders::equalsIgnoreCase(name, "Content-Disposition")) {
+        _part.name     = save(headerParam(value, "name"));
+        _part.filename = save(headerParam(value, "filename"));
+    } else if (HttpHeaders::equalsIgnoreCase(name, "Content-Type")) {
+        _part.content_type = save(value);
+    }
+    return true;
+}
+
+bool MultipartParser::_emit(std::string_view data) {
+    return data.empty() || _listener->onPartData(data);
+}
+/**
+ * @description: 进入错误状态
+ * @param {int} code，应答的 HTTP 状态码
+ * @return {*}
+ */
+size_t MultipartParser::_fail(int code) {
+    _error_code = code;
+    _state      = ERROR;
+    LOG_WARN("Multipart error: %d", code);
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * @Description: 路由表实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:41:12
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include "router.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+Router::Router()
+    : _root(new Node{STATIC, "", "", {}, nullptr, nullptr, {}})
+    , _size(0) {}
+
+Router::~Router() = default;
+/**
+ * @description: 注册路由，模式按 '/' 分段，参数段 ":name" 与前缀段 "*name" 单独成节点，其余并入静态边
+ * @param {string_view} method，如 GET、POST
+ * @param {string_view} pattern
+ * @param {RouteHandler} handler
+ * @return {*} 模式非法或与已有路由冲突时返回 false
+ */
+bool Router::add(std::string_view method, std::string_view pattern, RouteHandler handler) {
+    if (pattern.empty() || pattern[0] != '/' || method.empty() || !handler) {
+        LOG_ERROR("Route %.*s %.*s invalid", (int)method.size(), method.data(), (int)pattern.size(), pattern.data());
+        return false;
+    }
+    Node *node            = _root.get();
+    std::string_view rest = pattern;
+    while (!rest.empty()) {
+        /* 静态部分延伸到下一个参数段之前 */
+        size_t special = 0;
+        while (special < rest.size() && !((rest[special] == ':' || rest[special] == '*') &&
+                                          (special == 0 || rest[special - 1] == '/'))) {
+            special++;
+        }
+        if (special > 0) {
+            node = _insertStatic(node, rest.substr(0, special));
+            rest.remove_prefix(special);
+            continue;
+        }
+        size_t end                   = rest.find('/');
+        std::string_view name        = rest.substr(1, end == std::string_view::npos ? end : end - 1);
+        std::unique_ptr<Node> &child = rest[0] == ':' ? node->param : node->wildcard;
+        if (name.empty() || (rest[0] == '*' && end != std::string_view::npos)) {
+            LOG_ERROR("Route %.*s invalid", (int)pattern.size(), pattern.data());
+            return false;
+        }
+        if (!child) {
+            child.reset(new Node{rest[0] == ':' ? PARAM : WILDCARD, std::string(name), "", {}, nullptr, nullptr, {}});
+        } else if (child->label != name) {
+            LOG_ERROR("Route %.*s conflicts with parameter %s", (int)pattern.size(), pattern.data(), child->label.c_str());
+            return false;
+        }
+        node = child.get();
+        rest.remove_prefix(name.size() + 1);
+    }
+    for (auto &entry : node->handlers) {
+        if (entry.first == method) {
+            LOG_ERROR("Route %.*s %.*s already registered", (int)method.size(), method.data(),
+                      (int)pattern.size(), pattern.data());
+            return false;
+        }
+    }
+    node->handlers.emplace_back(std::string(method), std::move(handler));
+    _size++;
+    return true;
+}
+/**
+ * @description: 在 node 下插入静态边，与已有边有公共前缀时分裂该边
+ * @param {Node} *node
+ * @param {string_view} label
+ * @return {*} label 末尾对应的节点
+ */
+Router::Node *Router::_insertStatic(Node *node, std::string_view label) {
+    while (!label.empty()) {
+        size_t index = node->indices.find(label[0]);
+        if (index == std::string::npos) {
+            node->indices.push_back(label[0]);
+            node->children.emplace_back(new Node{STATIC, std::string(label), "", {}, nullptr, nullptr, {}});
+            return node->children.back().get();
+        }
+        Node *child   = node->children[index].get();
+        size_t common = 0;
+        while (common < label.size() && common < child->label.size() && label[common] == child->label[common]) {
+            common++;
+        }
+        if (common < child->label.size()) {
+            /* 分裂：child 的前 common 个字符成为新的中间节点 */
+            std::unique_ptr<Node> split(new Node{STATIC, child->label.substr(0, common), "", {}, nullptr, nullptr, {}});
+            child->label.erase(0, common);
+            split->indices.push_back(child->label[0]);
+            split->children.push_back(std::move(node->children[index]));
+            node->children[index] = std::move(split);
+            child                 = node->children[index].get();
+        }
+        node = child;
+        label.remove_prefix(common);
+    }
+    return node;
+}
+/**
+ * @description: 匹配请求路径，参数值为指向 path 的 string_view
+ * @param {string_view} method
+ * @param {string_view} path
+ * @param {HttpFieldList} &params，匹配到的参数追加到末尾
+ * @param {RouteHandler} **handler，匹配成功时的处理函数
+ * @return {*} 200: 匹配成功；404: 没有匹配的路径；405: 有匹配的路径，但都没有注册该方法
+ */
+int Router::match(std::string_view method, std::string_view path, HttpFieldList &params,
+                  const RouteHandler **handler) const {
+    size_t base     = params.size();
+    bool path_found = false;
+    *handler        = _match(_root.get(), method, path, params, path_found);
+    if (*handler) {
+        return 200;
+    }
+    params.resize(base);
+    return path_found ? 405 : 404;
+}
+/**
+ * @description: 沿树逐字符下降，每个字符只比较一次；静态边走不通或其下的路由没有注册该方法时，
+ *               依次回退到同一节点的参数段与前缀段
+ * @param {Node} *node
+ * @param {string_view} method
+ * @param {string_view} path，node 之后尚未匹配的部分
+ * @param {HttpFieldList} &params
+ * @param {bool} &path_found，经过了路径匹配但方法未注册的节点时置为 true
+ * @return {*} 匹配到的处理函数，未匹配返回 nullptr
+ */
+const RouteHandler *Router::_match(const Node *node, std::string_view method, std::string_view path,
+                                   HttpFieldList &params, bool &path_found) const {
+    if (path.empty()) {
+        if (const RouteHandler *found = _handler(node, method, path_found)) {
+            return found;
+        }
+    } else {
+        size_t index = node->indices.find(path[0]);
+        if (index != std::string::npos) {
+            const Node *child = node->children[index].get();
+            if (path.compare(0, child->label.size(), child->label) == 0) {
+                if (const RouteHandler *found =
+                        _match(child, method, path.substr(child->label.size()), params, path_found)) {
+                    return found;
+                }
+            }
+        }
+        if (node->param && path[0] != '/') {
+            size_t end = std::min(path.find('/'), path.size());
+            params.emplace_back(node->param->label, path.substr(0, end));
+            if (const RouteHandler *found = _match(node->param.get(), method, path.substr(end), params, path_found)) {
+                return found;
+            }
+            params.pop_back();
+        }
+    }
+    if (node->wildcard) {
+        params.emplace_back(node->wildcard->label, path);
+        if (const RouteHandler *found = _handler(node->wildcard.get(), method, path_found)) {
+            return found;
+        }
+        params.pop_back();
+    }
+    return nullptr;
+}
+/**
+ * @description: 返回节点上注册给 method 的处理函数
+ * @param {Node} *node
+ * @param {string_view} method
+ * @param {bool} &path_found，节点有处理函数但没有该方法时置为 true
+ * @return {*}
+ */
+const RouteHandler *Router::_handler(const Node *node, std::string_view method, bool &path_found) {
+    for (auto &entry : node->handlers) {
+        if (entry.first == method) {
+            return &entry.second;
+        }
+    }
+    if (!node->handlers.empty()) {
+        path_found = true;
+    }
+    return nullptr;
+}
@@ -0,0 +1,175 @@
+/*
+ * @Description: 大文件上传落盘实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 15:22:40
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 15:41:07
+ */
+#include "uploadfile.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+size_t UploadFile::pipe_size = 1 << 20;
+
+UploadFile::UploadFile()
+    : _fd(-1)
+    , _pipe{-1, -1}
+    , _length(0)
+    , _remaining(0)
+    , _in_pipe(0)
+    , _capacity(0) {};
+
+UploadFile::~UploadFile() {
+    close();
+}
+/**
+ * @description: 创建匿名临时文件与中转 pipe，准备接收 length 字节的 body
+ * @param {char} *dir，临时文件所在目录，应与最终存放目录在同一文件系统
+ * @param {size_t} length
+ * @return {*}
+ */
+bool UploadFile::open(const char *dir, size_t length) {
+    assert(dir && !active());
+    _fd = createTemp(dir);
+    if (_fd < 0) {
+        LOG_ERROR("Upload temp file in %s error: %d", dir, errno);
+        return false;
+    }
+    if (pipe2(_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        LOG_ERROR("Upload pipe error: %d", errno);
+        close();
+        return false;
+    }
+    /* 扩大 pipe 容量以减少 splice 次数，超过系统上限时保留默认容量 */
+    int capacity = fcntl(_pipe[1], F_SETPIPE_SZ, (int)pipe_size);
+    if (capacity < 0) {
+        capacity = fcntl(_pipe[1], F_GETPIPE_SZ);
+    }
+    _capacity  = capacity > 0 ? capacity : 4096;
+    _length    = length;
+    _remaining = length;
+    _in_pipe   = 0;
+    return true;
+}
+/**
+ * @description: 解析首部时已读入缓冲区的 body 前缀直接写入文件，只取属于本请求的部分
+ * @param {Buffer} &buff
+ * @return {*}
+ */
+bool UploadFile::absorb(Buffer &buff) {
+    assert(active());
+    size_t len = std::min(_remaining, buff.readableBytes());
+    while (len > 0) {
+        ssize_t n = ::write(_fd, buff.beginRead(), len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            LOG_ERROR("Upload write error: %d", errno);
+            return false;
+        }
+        buff.hasRead(n);
+        _remaining -= n;
+        len -= n;
+    }
+    return true;
+}
+/**
+ * @description: socket -> pipe -> 文件，一次最多搬运一个 pipe 容量，且不会越过 body 末尾读取下一请求
+ * @param {int} sock_fd
+ * @param {int} *save_errno
+ * @return {*} 与 readFd 一致：读取的字节数，0 为对端关闭，-1 为出错
+ */
+ssize_t UploadFile::splice(int sock_fd, int *save_errno) {
+    assert(active());
+    if (_remaining == 0) {
+        return _drain() ? 0 : -1;
+    }
+    size_t want = std::min(_remaining, _capacity - _in_pipe);
+    ssize_t len = ::splice(sock_fd, nullptr, _pipe[1], nullptr, want, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (len < 0) {
+        *save_errno = errno;
+        return len;
+    }
+    _remaining -= len;
+    _in_pipe += len;
+    if (!_drain()) {
+        *save_errno = errno;
+        return -1;
+    }
+    return len;
+}
+/**
+ * @description: 将 pipe 中的数据全部写入文件
+ * @return {*}
+ */
+bool UploadFile::_drain() {
+    while (_in_pipe > 0) {
+        ssize_t n = ::splice(_pipe[0], nullptr, _fd, nullptr, _in_pipe, SPLICE_F_MOVE);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            LOG_ERROR("Upload splice to file error: %d", errno);
+            errno = n < 0 ? errno : EIO;
+            return false;
+        }
+        _in_pipe -= n;
+    }
+    return true;
+}
+/**
+ * @description: 关闭临时文件与 pipe，未链接到目录的临时文件随之删除
+ * @return {*}
+ */
+void UploadFile::close() {
+    for (int &fd : _pipe) {
+        if (fd >= 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _length = _remaining = _in_pipe = 0;
+}
+/**
+ * @description: 为 O_TMPFILE 创建的匿名文件建立目录项，使其在关闭后保留；
+ *               回退到 mkstemp 的文件已被 unlink，无法链接
+ * @param {int} fd
+ * @param {char} *path
+ * @return {*}
+ */
+bool UploadFile::linkTo(int fd, const char *path) {
+    char proc_path[32];
+    snprintf(proc_path, sizeof(proc_path), "/proc/self/fd/%d", fd);
+    if (linkat(AT_FDCWD, proc_path, AT_FDCWD, path, AT_SYMLINK_FOLLOW) < 0) {
+        LOG_ERROR("Upload link to %s error: %d", path, errno);
+        return false;
+    }
+    return true;
+}
+/**
+ * @description: 创建匿名临时文件，优先使用 O_TMPFILE，文件系统不支持时回退到 mkstemp + unlink
+ * @param {char} *dir
+ * @return {*} 文件描述符，失败返回 -1
+ */
+int UploadFile::createTemp(const char *dir) {
+    int fd = ::open(dir, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+    if (fd >= 0) {
+        return fd;
+    }
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/.upload.XXXXXX", dir);
+    fd = mkostemp(path, O_CLOEXEC);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    return fd;
+}
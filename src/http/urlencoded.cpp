@@ -0,0 +1,109 @@
+/*
+ * @Description: urlencoded 解析实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 16:20:45
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 16:20:45
+ */
+#include "urlencoded.h"
+
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @description: 单趟解析 "k1=v1&k2=v2"，'+' 解码为空格，"%XX" 解码为对应字节，非法的 '%' 按原字符保留。
+ *               解码结果不会长于原文，因此直接写回 data，键值对引用 data 中解码后的内容
+ * @param {char} *data
+ * @param {size_t} len
+ * @param {HttpFieldList} &fields，解析出的键值对追加到末尾，没有 '=' 的段值为空
+ * @return {*}
+ */
+void UrlEncoded::parse(char *data, size_t len, HttpFieldList &fields) {
+    const char *read = data;
+    const char *end  = data + len;
+    char *write      = data;
+    while (read < end) {
+        char *key     = write;
+        char *key_end = nullptr;
+        while (read < end) {
+            /* 不含特殊字符的连续片段整体搬移，无需解码时原地不动 */
+            size_t run = _plainRun(read, end - read);
+            if (write != read) {
+                memmove(write, read, run);
+            }
+            read += run;
+            write += run;
+            if (read == end) {
+                break;
+            }
+            char ch = *read++;
+            if (ch == '&') {
+                break;
+            } else if (ch == '=' && !key_end) {
+                key_end = write;
+            } else if (ch == '+') {
+                *write++ = ' ';
+            } else if (ch == '%' && end - read >= 2 && _hexValue(read[0]) >= 0 && _hexValue(read[1]) >= 0) {
+                *write++ = static_cast<char>(_hexValue(read[0]) << 4 | _hexValue(read[1]));
+                read += 2;
+            } else {
+                *write++ = ch;
+            }
+        }
+        if (!key_end) {
+            key_end = write;
+        }
+        if (key_end > key) {
+            fields.emplace_back(std::string_view(key, key_end - key), std::string_view(key_end, write - key_end));
+        }
+    }
+}
+/**
+ * @description: 返回开头连续的普通字节数，即第一个 '%'、'+'、'&'、'=' 之前的长度；
+ *               SSE2 下每次比较 16 字节，其余平台逐字节比较
+ * @param {char} *data
+ * @param {size_t} len
+ * @return {*}
+ */
+size_t UrlEncoded::_plainRun(const char *data, size_t len) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i percent = _mm_set1_epi8('%');
+    const __m128i plus    = _mm_set1_epi8('+');
+    const __m128i amp     = _mm_set1_epi8('&');
+    const __m128i equal   = _mm_set1_epi8('=');
+    for (; i + 16 <= len; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        __m128i hit   = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, percent), _mm_cmpeq_epi8(chunk, plus)),
+                                     _mm_or_si128(_mm_cmpeq_epi8(chunk, amp), _mm_cmpeq_epi8(chunk, equal)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < len; i++) {
+        char ch = data[i];
+        if (ch == '%' || ch == '+' || ch == '&' || ch == '=') {
+            break;
+        }
+    }
+    return i;
+}
+
+int UrlEncoded::_hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') {
+        return ch - '0';
+    }
+    if (ch >= 'a' && ch <= 'f') {
+        return ch - 'a' + 10;
+    }
+    if (ch >= 'A' && ch <= 'F') {
+        return ch - 'A' + 10;
+    }
+    return -1;
+}
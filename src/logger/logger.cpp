@@ -4,10 +4,12 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 16:14:26
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:52:41
+ * @LastEditTime: 2026-10-19 18:58:42
  */
 #include "logger.h"
 
+#include "metrics.h"
+
 using namespace std;
 
 Logger::Logger()
@@ -143,6 +145,9 @@ void Logger::write(int level, const char *format, ...) {
         if (_is_async && _deque && !_deque->full()) {
             _deque->push_back(_buff.resetToStr());
         } else {
+            if (_is_async) {
+                Metrics::add(Metrics::LOG_QUEUE_FULL);
+            }
             fputs(_buff.beginRead(), _fp);
         }
         _buff.reset();
@@ -169,6 +174,10 @@ void Logger::_appendLoggerLevelTitle(int level) {
     }
 }
 
+size_t Logger::queueSize() {
+    return _deque ? _deque->size() : 0;
+}
+
 void Logger::flush() {
     if (_is_async) {
         _deque->flush();
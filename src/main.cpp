@@ -4,15 +4,61 @@
  * @version: 1.0.1
  * @Date: 2025-05-18 17:00:26
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:02:41
+ * @LastEditTime: 2026-10-19 23:59:58
  */
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "master.h"
 #include "webserver.h"
 
-int main(int argc, char const *argv[])
+static int port = 12345, trig_mode = 3, thread_num = 6, log_level = 1;
+
+/* 单进程模式与多进程模式下的每个 worker 都执行同一配置；argv 非空时支持 SIGUSR2 平滑升级 */
+static int runServer(char **argv, bool multi_process)
 {
     WebServer server(
-        12345, 3, 60000, false,         /*  端口 ET模式 timeout_ms 优雅退出  */
-        6, true, 1, 1024);              /*  线程池数量 日志开关 日志等级 日志异步队列容量 */
+        port, trig_mode, 60000, false,  /*  端口 ET模式 timeout_ms 优雅退出  */
+        thread_num, true, log_level, 1024);  /*  线程池数量 日志开关 日志等级 日志异步队列容量 */
+    server.setCredentialStore("./data", 2, multi_process);  /*  用户凭据目录 口令线程池数量 多个 worker 共享日志 */
+    server.setSessionStore(16, 1800000, 64 << 20);  /*  会话分片数 空闲超时ms 内存预算 */
+    server.setGracefulShutdown(30000, argv);  /*  SIGTERM 后等待连接结束的上限ms，SIGUSR2 以相同参数重新执行并交接监听 socket */
+    // server.setRedis("127.0.0.1", 6379, 4, 2);  /*  RESP 后端地址 端口 连接数 口令线程池数量，地址为 nullptr 时使用进程内桩 */
+    // server.setTracing(0.01, 1 << 16);  /*  追踪抽样比例 每个线程保留的记录数，GET /trace 导出 */
+    // server.setCapture("./capture.bin", 0.1, 256 << 20);  /*  流量采集文件 抽样比例 文件大小上限 */
+    // server.setMicroCache(32 << 20, 5000);  /*  微缓存内存预算 过期后旧结果可用时长ms */
+    // server.addProxy("/api", {"127.0.0.1:8080", "127.0.0.1:8081"}, ReverseProxy::LEAST_OUTSTANDING, 32, 1000);  /*  转发前缀 上游列表 负载均衡 每个上游的长连接数 GET 缓存ms */
     server.start();
     return 0;
 }
+
+int main(int argc, char *argv[])
+{
+    /* 命令行可覆盖端口(-p)、ET模式(-m)、线程池数量(-t)与日志等级(-l)，便于压测脚本切换配置；
+       -w 启动多进程模式的 worker 数量，-a 将各 worker 绑定到不同 CPU */
+    int worker_num = 0;
+    bool pin_cpu   = false;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:m:t:l:w:a")) != -1) {
+        switch (opt) {
+        case 'p': port = atoi(optarg); break;
+        case 'm': trig_mode = atoi(optarg); break;
+        case 't': thread_num = atoi(optarg); break;
+        case 'l': log_level = atoi(optarg); break;
+        case 'w': worker_num = atoi(optarg); break;
+        case 'a': pin_cpu = true; break;
+        default:
+            fprintf(stderr, "usage: %s [-p port] [-m trig_mode] [-t threads] [-l log_level] [-w workers [-a]]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (worker_num <= 0) {
+        return runServer(argv, false);
+    }
+    /* master 只写少量日志，同步写出，fork 前刷新即可 */
+    Logger::getInstance()->init(log_level, "./log", ".log", 0);
+    Master master(port, false, worker_num, pin_cpu);  /*  端口 优雅退出 worker 数量 绑定 CPU */
+    return master.run([](int) { return runServer(nullptr, true); });
+}
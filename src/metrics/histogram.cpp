@@ -0,0 +1,62 @@
+/*
+ * @Description: 延迟直方图实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 19:21:07
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 20:31:52
+ */
+#include "histogram.h"
+
+Histogram::Histogram()
+    : _counts(BUCKETS, 0)
+    , _total(0)
+    , _sum(0)
+    , _max(0) {}
+/**
+ * @description: 桶内可能的最大值，分位数以此报告，不会低估
+ * @param {int} index
+ * @return {*}
+ */
+uint64_t Histogram::highest(int index) {
+    if (index < SUB_COUNT) {
+        return index;
+    }
+    int shift    = (index - SUB_COUNT) / HALF + 1;
+    uint64_t sub = (index - SUB_COUNT) % HALF + HALF;
+    return ((sub + 1) << shift) - 1;
+}
+/**
+ * @description: 合并另一个直方图，如各线程分别记录后汇总
+ * @param {Histogram} &other
+ * @return {*}
+ */
+void Histogram::merge(const Histogram &other) {
+    for (int i = 0; i < BUCKETS; i++) {
+        _counts[i] += other._counts[i];
+    }
+    _total += other._total;
+    _sum += other._sum;
+    addMax(other._max);
+}
+/**
+ * @description: 返回分位数对应的值，不超过记录到的最大值
+ * @param {double} quantile，0 ~ 1
+ * @return {*}
+ */
+uint64_t Histogram::percentile(double quantile) const {
+    if (_total == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(quantile * _total + 0.5);
+    rank          = rank < 1 ? 1 : rank > _total ? _total : rank;
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += _counts[i];
+        if (seen >= rank) {
+            uint64_t value = highest(i);
+            return value < _max ? value : _max;
+        }
+    }
+    return _max;
+}
@@ -0,0 +1,293 @@
+/*
+ * @Description: 运行指标实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:58:42
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 22:41:26
+ */
+#include "metrics.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+struct CounterInfo {
+    const char *name;
+    const char *help;
+};
+
+static const CounterInfo COUNTER_INFO[Metrics::COUNTER_COUNT] = {
+    {"webserver_connections_accepted_total", "Accepted client connections."},
+    {"webserver_connections_closed_total", "Closed client connections."},
+    {"webserver_connections_rejected_total", "Connections rejected because the server was full."},
+    {"webserver_received_bytes_total", "Bytes read from client sockets."},
+    {"webserver_sent_bytes_total", "Bytes written to client sockets."},
+    {"webserver_log_queue_full_total", "Log lines written synchronously because the async queue was full."},
+    /* 名称为空的计数由所属模块在启用时输出 */
+    {nullptr, nullptr},
+    {nullptr, nullptr},
+    {nullptr, nullptr},
+    {nullptr, nullptr},
+};
+
+static const char *STAGE_NAME[Metrics::STAGE_COUNT] = {
+    "first_byte", "queue", "parse", "response", "write", "keepalive_idle",
+};
+
+static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+static const CounterInfo GAUGE_INFO[Metrics::GAUGE_COUNT] = {
+    {"webserver_timer_heap_size", "Timers in the server timer heap."},
+    {"webserver_http_connections", "Open client connections."},
+};
+
+thread_local Metrics::Slot *Metrics::_slot;
+Metrics::Slot *Metrics::_shared;
+size_t Metrics::_shared_count;
+
+Metrics::Slot::Slot() {
+    for (auto &value : counters) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (auto &value : gauges) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (auto &value : status) {
+        value.store(0, std::memory_order_relaxed);
+    }
+    for (auto &stage : latency) {
+        for (auto &value : stage.buckets) {
+            value.store(0, std::memory_order_relaxed);
+        }
+        stage.sum.store(0, std::memory_order_relaxed);
+        stage.max.store(0, std::memory_order_relaxed);
+    }
+    owner.store(0, std::memory_order_relaxed);
+}
+
+/* 槽位登记表，只在线程首次计数与抓取时加锁 */
+std::mutex &Metrics::_registryMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+std::vector<std::unique_ptr<Metrics::Slot>> &Metrics::_registry() {
+    static std::vector<std::unique_ptr<Slot>> slots;
+    return slots;
+}
+
+Metrics::Slot *Metrics::_register() {
+    if (_shared) {
+        pid_t pid = getpid();
+        for (size_t i = 0; i < _shared_count; i++) {
+            pid_t expected = 0;
+            if (_shared[i].owner.compare_exchange_strong(expected, pid)) {
+                return &_shared[i];
+            }
+        }
+        /* 共享槽位用尽时退回本进程的槽位，其计数只在本进程抓取时可见 */
+    }
+    std::lock_guard<std::mutex> locker(_registryMutex());
+    _registry().emplace_back(new Slot());
+    return _registry().back().get();
+}
+
+template <class F>
+void Metrics::_forEach(F &&f) {
+    std::lock_guard<std::mutex> locker(_registryMutex());
+    for (auto &slot : _registry()) {
+        f(*slot);
+    }
+    for (size_t i = 0; i < _shared_count; i++) {
+        f(_shared[i]);
+    }
+}
+/**
+ * @description: 在共享内存中创建 max_slots 个槽位，须在 fork worker 之前、任何线程计数之前调用
+ * @param {size_t} max_slots
+ * @return {*}
+ */
+bool Metrics::share(size_t max_slots) {
+    /* 匿名共享映射按页清零，只有被线程占用的槽位才实际分配内存 */
+    void *addr = mmap(nullptr, max_slots * sizeof(Slot), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    _shared       = static_cast<Slot *>(addr);
+    _shared_count = max_slots;
+    return true;
+}
+/**
+ * @description: 释放已退出进程的槽位。计数保留，由之后占用槽位的线程继续累加；瞬时值清零
+ * @param {pid_t} pid
+ * @return {*}
+ */
+void Metrics::release(pid_t pid) {
+    for (size_t i = 0; i < _shared_count; i++) {
+        Slot &slot = _shared[i];
+        if (slot.owner.load() == pid) {
+            for (auto &value : slot.gauges) {
+                value.store(0, std::memory_order_relaxed);
+            }
+            slot.owner.store(0);
+        }
+    }
+}
+/**
+ * @description: fork 得到的子进程中调用，调用线程从父进程继承的槽位不再使用
+ * @return {*}
+ */
+void Metrics::afterFork() {
+    _slot = nullptr;
+}
+/**
+ * @description: 按状态码计数一个应答，超出范围的状态码计入 0
+ * @param {int} code
+ * @return {*}
+ */
+void Metrics::addStatus(int code) {
+    std::atomic<uint64_t> &value = _local()->status[code > 0 && code < MAX_STATUS ? code : 0];
+    value.store(value.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+/**
+ * @description: 汇总全部线程的计数
+ * @param {COUNTER} counter
+ * @return {*}
+ */
+uint64_t Metrics::total(COUNTER counter) {
+    uint64_t sum = 0;
+    _forEach([&](const Slot &slot) { sum += slot.counters[counter].load(std::memory_order_relaxed); });
+    return sum;
+}
+/**
+ * @description: 合并全部线程记录的某阶段耗时
+ * @param {STAGE} stage
+ * @param {Histogram} &histogram，合并到其中
+ * @return {*}
+ */
+void Metrics::latency(STAGE stage, Histogram &histogram) {
+    _forEach([&](const Slot &slot) {
+        const Latency &latency = slot.latency[stage];
+        for (int i = 0; i < Histogram::BUCKETS; i++) {
+            uint64_t count = latency.buckets[i].load(std::memory_order_relaxed);
+            if (count) {
+                histogram.add(i, count);
+            }
+        }
+        histogram.addSum(latency.sum.load(std::memory_order_relaxed));
+        histogram.addMax(latency.max.load(std::memory_order_relaxed));
+    });
+}
+/**
+ * @description: 以可读的表格输出各阶段耗时分位数，单位毫秒
+ * @param {string} &out
+ * @return {*}
+ */
+void Metrics::dumpLatency(std::string &out) {
+    char line[256];
+    snprintf(line, sizeof(line), "%-16s %10s %10s %10s %10s %10s %10s\n", "stage", "count", "p50", "p90", "p99",
+             "p99.9", "max");
+    out.append(line);
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        Histogram histogram;
+        latency(static_cast<STAGE>(stage), histogram);
+        snprintf(line, sizeof(line), "%-16s %10llu %10.3f %10.3f %10.3f %10.3f %10.3f\n", STAGE_NAME[stage],
+                 (unsigned long long)histogram.count(), histogram.percentile(0.5) / 1e6,
+                 histogram.percentile(0.9) / 1e6, histogram.percentile(0.99) / 1e6,
+                 histogram.percentile(0.999) / 1e6, histogram.max() / 1e6);
+        out.append(line);
+    }
+}
+/**
+ * @description: 以 Prometheus 文本格式输出全部计数器与瞬时值
+ * @param {string} &out
+ * @return {*}
+ */
+void Metrics::scrape(std::string &out) {
+    uint64_t counters[COUNTER_COUNT] = {0};
+    int64_t gauges[GAUGE_COUNT]      = {0};
+    std::vector<uint64_t> status(MAX_STATUS, 0);
+    _forEach([&](const Slot &slot) {
+        for (int i = 0; i < COUNTER_COUNT; i++) {
+            counters[i] += slot.counters[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < GAUGE_COUNT; i++) {
+            gauges[i] += slot.gauges[i].load(std::memory_order_relaxed);
+        }
+        for (int i = 0; i < MAX_STATUS; i++) {
+            status[i] += slot.status[i].load(std::memory_order_relaxed);
+        }
+    });
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        if (COUNTER_INFO[i].name) {
+            appendCounter(out, COUNTER_INFO[i].name, COUNTER_INFO[i].help, counters[i]);
+        }
+    }
+    out.append("# HELP webserver_http_responses_total HTTP responses by status code.\n"
+               "# TYPE webserver_http_responses_total counter\n");
+    char line[256];
+    for (int code = 0; code < MAX_STATUS; code++) {
+        if (status[code]) {
+            snprintf(line, sizeof(line), "webserver_http_responses_total{code=\"%d\"} %llu\n", code,
+                     (unsigned long long)status[code]);
+            out.append(line);
+        }
+    }
+    for (int i = 0; i < GAUGE_COUNT; i++) {
+        appendGauge(out, GAUGE_INFO[i].name, GAUGE_INFO[i].help, gauges[i]);
+    }
+
+    /* 各阶段耗时以 summary 输出，单位秒 */
+    out.append("# HELP webserver_stage_latency_seconds Latency of request lifecycle stages.\n"
+               "# TYPE webserver_stage_latency_seconds summary\n");
+    std::string max_lines;
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        Histogram histogram;
+        latency(static_cast<STAGE>(stage), histogram);
+        for (double quantile : QUANTILES) {
+            snprintf(line, sizeof(line), "webserver_stage_latency_seconds{stage=\"%s\",quantile=\"%g\"} %.9f\n",
+                     STAGE_NAME[stage], quantile, histogram.percentile(quantile) / 1e9);
+            out.append(line);
+        }
+        snprintf(line, sizeof(line),
+                 "webserver_stage_latency_seconds_sum{stage=\"%s\"} %.9f\n"
+                 "webserver_stage_latency_seconds_count{stage=\"%s\"} %llu\n",
+                 STAGE_NAME[stage], histogram.sum() / 1e9, STAGE_NAME[stage], (unsigned long long)histogram.count());
+        out.append(line);
+        snprintf(line, sizeof(line), "webserver_stage_latency_max_seconds{stage=\"%s\"} %.9f\n", STAGE_NAME[stage],
+                 histogram.max() / 1e9);
+        max_lines.append(line);
+    }
+    out.append("# HELP webserver_stage_latency_max_seconds Maximum latency of request lifecycle stages.\n"
+               "# TYPE webserver_stage_latency_max_seconds gauge\n");
+    out.append(max_lines);
+}
+/**
+ * @description: 输出一个由其他模块维护的累计值
+ * @param {string} &out
+ * @param {char} *name
+ * @param {char} *help
+ * @param {uint64_t} value
+ * @return {*}
+ */
+void Metrics::appendCounter(std::string &out, const char *name, const char *help, uint64_t value) {
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name,
+             (unsigned long long)value);
+    out.append(line);
+}
+/**
+ * @description: 输出一个抓取时采样的瞬时值
+ * @param {string} &out
+ * @param {char} *name
+ * @param {char} *help
+ * @param {double} value
+ * @return {*}
+ */
+void Metrics::appendGauge(std::string &out, const char *name, const char *help, double value) {
+    char line[256];
+    snprintf(line, sizeof(line), "# HELP %s %s\n# TYPE %s gauge\n%s %.17g\n", name, help, name, name, value);
+    out.append(line);
+}
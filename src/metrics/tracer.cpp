@@ -0,0 +1,168 @@
+/*
+ * @Description: 跨度追踪实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 21:24:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 21:24:37
+ */
+#include "tracer.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+std::atomic<bool> Tracer::_enabled(false);
+double Tracer::_sample_rate = 0;
+size_t Tracer::_capacity    = 0;
+std::atomic<uint32_t> Tracer::_seq(0);
+
+/**
+ * @description: 开启追踪，应在服务器启动前调用
+ * @param {double} sample_rate，追踪的连接比例，0 ~ 1
+ * @param {size_t} spans_per_thread，每个线程保留的最近记录数，向上取整为 2 的幂
+ * @return {*}
+ */
+void Tracer::enable(double sample_rate, size_t spans_per_thread) {
+    size_t capacity = 1;
+    while (capacity < spans_per_thread) {
+        capacity <<= 1;
+    }
+    _capacity    = capacity;
+    _sample_rate = sample_rate;
+    _enabled.store(sample_rate > 0, std::memory_order_relaxed);
+}
+/**
+ * @description: 新连接建立时决定是否追踪，按比例均匀抽样
+ * @return {*} 追踪时返回连接编号，否则返回 0
+ */
+uint32_t Tracer::sample() {
+    if (!enabled()) {
+        return 0;
+    }
+    uint32_t seq = ++_seq;
+    if (seq == 0 || floor(seq * _sample_rate) == floor((seq - 1) * _sample_rate)) {
+        return 0;
+    }
+    return seq;
+}
+/**
+ * @description: 记录一段耗时
+ * @param {char} *name，须为静态字符串
+ * @param {uint32_t} id，连接编号
+ * @param {uint64_t} start_ns
+ * @param {uint64_t} end_ns
+ * @param {char} *arg_name，附加参数名，须为静态字符串，为空时不输出
+ * @param {int64_t} arg
+ * @return {*}
+ */
+void Tracer::span(const char *name, uint32_t id, uint64_t start_ns, uint64_t end_ns, const char *arg_name,
+                  int64_t arg) {
+    _record(COMPLETE, name, id, start_ns, end_ns - start_ns, arg_name, arg);
+}
+/**
+ * @description: 记录一个时刻，如连接建立、任务投递
+ * @return {*}
+ */
+void Tracer::instant(const char *name, uint32_t id, const char *arg_name, int64_t arg) {
+    _record(INSTANT, name, id, Metrics::now(), 0, arg_name, arg);
+}
+
+void Tracer::_record(KIND kind, const char *name, uint32_t id, uint64_t start_ns, uint64_t dur_ns,
+                     const char *arg_name, int64_t arg) {
+    Ring *ring    = _local();
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    Span &span    = ring->spans[head & ring->mask];
+    span.name.store(name, std::memory_order_relaxed);
+    span.arg_name.store(arg_name, std::memory_order_relaxed);
+    span.start_ns.store(start_ns, std::memory_order_relaxed);
+    span.dur_ns.store(dur_ns, std::memory_order_relaxed);
+    span.arg.store(arg, std::memory_order_relaxed);
+    span.id.store(id, std::memory_order_relaxed);
+    span.kind.store(kind, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+/**
+ * @description: 设置本线程在时间线上显示的名称
+ * @param {char} *name
+ * @return {*}
+ */
+void Tracer::nameThread(const char *name) {
+    Ring *ring = _local();
+    std::lock_guard<std::mutex> locker(_registryMutex());
+    snprintf(ring->name, sizeof(ring->name), "%s", name);
+}
+
+std::mutex &Tracer::_registryMutex() {
+    static std::mutex mtx;
+    return mtx;
+}
+
+std::vector<std::unique_ptr<Tracer::Ring>> &Tracer::_registry() {
+    static std::vector<std::unique_ptr<Ring>> rings;
+    return rings;
+}
+
+Tracer::Ring *Tracer::_register() {
+    Ring *ring = new Ring();
+    ring->tid  = static_cast<int>(syscall(SYS_gettid));
+    snprintf(ring->name, sizeof(ring->name), "worker %d", ring->tid);
+    ring->spans.reset(new Span[_capacity ? _capacity : 1]);
+    ring->mask = (_capacity ? _capacity : 1) - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> locker(_registryMutex());
+    _registry().emplace_back(ring);
+    return ring;
+}
+/**
+ * @description: 以 Chrome trace-event 格式导出全部线程的记录，时间单位微秒
+ * @param {string} &out
+ * @return {*}
+ */
+void Tracer::exportJson(std::string &out) {
+    int pid = getpid();
+    char line[512];
+    out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    bool first = true;
+    std::lock_guard<std::mutex> locker(_registryMutex());
+    for (auto &ring : _registry()) {
+        snprintf(line, sizeof(line),
+                 "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                 first ? "" : ",", pid, ring->tid, ring->name);
+        out.append(line);
+        first = false;
+
+        uint64_t head  = ring->head.load(std::memory_order_acquire);
+        uint64_t begin = head > ring->mask + 1 ? head - ring->mask - 1 : 0;
+        for (uint64_t i = begin; i < head; i++) {
+            const Span &span     = ring->spans[i & ring->mask];
+            const char *name     = span.name.load(std::memory_order_relaxed);
+            const char *arg_name = span.arg_name.load(std::memory_order_relaxed);
+            uint64_t start_ns    = span.start_ns.load(std::memory_order_relaxed);
+            uint64_t dur_ns      = span.dur_ns.load(std::memory_order_relaxed);
+            int64_t arg          = span.arg.load(std::memory_order_relaxed);
+            uint32_t id          = span.id.load(std::memory_order_relaxed);
+            uint8_t kind         = span.kind.load(std::memory_order_relaxed);
+            /* 读取期间写入线程已绕回覆盖了这条记录 */
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (ring->head.load(std::memory_order_relaxed) > i + ring->mask + 1) {
+                continue;
+            }
+            int n = snprintf(line, sizeof(line), ",\n{\"name\":\"%s\",\"cat\":\"http\",\"ph\":\"%s\",\"ts\":%.3f,",
+                             name, kind == INSTANT ? "i\",\"s\":\"t" : "X", start_ns / 1e3);
+            if (kind == COMPLETE) {
+                n += snprintf(line + n, sizeof(line) - n, "\"dur\":%.3f,", dur_ns / 1e3);
+            }
+            n += snprintf(line + n, sizeof(line) - n, "\"pid\":%d,\"tid\":%d,\"args\":{\"conn\":%u", pid, ring->tid,
+                          id);
+            if (arg_name) {
+                n += snprintf(line + n, sizeof(line) - n, ",\"%s\":%lld", arg_name, (long long)arg);
+            }
+            snprintf(line + n, sizeof(line) - n, "}}");
+            out.append(line);
+        }
+    }
+    out.append("\n]}\n");
+}
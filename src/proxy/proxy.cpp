@@ -0,0 +1,1052 @@
+/*
+ * @Description: 反向代理实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 18:14:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include "proxy.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "metrics.h"
+
+static const size_t MAX_HEADER_SIZE = 16 * 1024; /* 上游应答头上限 */
+static const size_t PIPE_CHUNK      = 64 * 1024; /* 单次 splice 的字节数，与管道默认容量一致 */
+static const size_t MAX_BUFFERED    = 8 << 20;   /* 缓冲模式下应答 body 上限 */
+static const int TICK_MS            = 1000;
+
+static const uint32_t UPSTREAM_EVENT = EPOLLIN | EPOLLRDHUP;
+
+/* 逐跳首部，只对单个连接有效，不转发 */
+static const std::string_view HOP_BY_HOP[] = {
+    "Connection", "Keep-Alive", "Proxy-Connection", "TE", "Upgrade", "Transfer-Encoding", "Content-Length",
+};
+
+static bool hasToken(std::string_view value, std::string_view token) {
+    while (!value.empty()) {
+        size_t end            = value.find(',');
+        std::string_view item = value.substr(0, end);
+        value                 = end == std::string_view::npos ? std::string_view() : value.substr(end + 1);
+        while (!item.empty() && item.front() == ' ') {
+            item.remove_prefix(1);
+        }
+        while (!item.empty() && item.back() == ' ') {
+            item.remove_suffix(1);
+        }
+        if (HttpHeaders::equalsIgnoreCase(item, token)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* connection 为 Connection 首部的值，其中列出的首部同样只对当前连接有效(RFC 9110 §7.6.1) */
+static bool isHopByHop(std::string_view name, std::string_view connection) {
+    for (std::string_view hop : HOP_BY_HOP) {
+        if (HttpHeaders::equalsIgnoreCase(name, hop)) {
+            return true;
+        }
+    }
+    return !connection.empty() && hasToken(connection, name);
+}
+
+/* 收集首部块中全部 Connection 首部的值，以逗号连接 */
+static std::string connectionOptions(std::string_view lines) {
+    std::string options;
+    while (!lines.empty()) {
+        size_t next           = lines.find("\r\n");
+        std::string_view line = lines.substr(0, next);
+        lines                 = next == std::string_view::npos ? std::string_view() : lines.substr(next + 2);
+        if (line.size() > 11 && line[10] == ':' && HttpHeaders::equalsIgnoreCase(line.substr(0, 10), "Connection")) {
+            if (!options.empty()) {
+                options.append(",");
+            }
+            options.append(line.substr(11));
+        }
+    }
+    return options;
+}
+
+static void appendHeader(Buffer &buff, std::string_view name, std::string_view value) {
+    buff.append(name);
+    buff.append(": ");
+    buff.append(value);
+    buff.append("\r\n");
+}
+
+ReverseProxy::ReverseProxy()
+    : _epoller(nullptr)
+    , _client_event(0)
+    , _timeout_ms(0)
+    , _wake_fd(-1)
+    , _timer_fd(-1)
+    , _detached_seq(0) {}
+
+ReverseProxy::~ReverseProxy() {
+    close();
+}
+/**
+ * @description: 创建唤醒与超时检查所用的 fd 并注册到事件循环
+ * @param {Epoller} *epoller，服务器事件循环的 epoller，handleEvent 需在该事件循环线程中调用
+ * @param {uint32_t} client_event，客户端连接注册时使用的事件标志，等待客户端可写时沿用
+ * @param {int} timeout_ms，上游连续无进展的超时时间
+ * @return {*}
+ */
+bool ReverseProxy::init(Epoller *epoller, uint32_t client_event, int timeout_ms) {
+    assert(epoller && timeout_ms > 0 && _wake_fd < 0);
+    _epoller      = epoller;
+    _client_event = client_event;
+    _timeout_ms   = timeout_ms;
+    _wake_fd      = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _timer_fd     = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_wake_fd < 0 || _timer_fd < 0) {
+        LOG_ERROR("Proxy fd error: %d", errno);
+        close();
+        return false;
+    }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec  = TICK_MS / 1000;
+    spec.it_interval.tv_nsec = (TICK_MS % 1000) * 1000000L;
+    spec.it_value            = spec.it_interval;
+    timerfd_settime(_timer_fd, 0, &spec, nullptr);
+    _epoller->addFd(_wake_fd, EPOLLIN);
+    _epoller->addFd(_timer_fd, EPOLLIN);
+    /* splice 写往已关闭的客户端时内核发送 SIGPIPE，改为返回 EPIPE */
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+}
+
+void ReverseProxy::close() {
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        for (auto &item : _exchanges) {
+            delete item.second;
+        }
+        _exchanges.clear();
+        _pending.clear();
+    }
+    while (!_conns.empty()) {
+        Conn *conn     = _conns.begin()->second;
+        conn->exchange = nullptr;
+        _closeConn(conn);
+    }
+    _groups.clear();
+    for (int *fd : {&_wake_fd, &_timer_fd}) {
+        if (*fd >= 0) {
+            _epoller->delFd(*fd);
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+/**
+ * @description: 添加一组上游，同一组内按负载均衡策略选择
+ * @param {vector<string>} &upstreams，"ip:port" 列表
+ * @param {BALANCE} balance
+ * @param {size_t} max_conns，每个上游的连接数上限
+ * @return {*} 组编号，地址无效时返回 -1
+ */
+int ReverseProxy::addGroup(const std::vector<std::string> &upstreams, BALANCE balance, size_t max_conns) {
+    assert(max_conns > 0);
+    std::unique_ptr<Group> group(new Group());
+    group->balance   = balance;
+    group->max_conns = max_conns;
+    for (auto &address : upstreams) {
+        std::unique_ptr<Upstream> upstream(new Upstream());
+        if (!parseAddress(address, &upstream->addr)) {
+            LOG_ERROR("Upstream %s invalid", address.c_str());
+            return -1;
+        }
+        upstream->name  = address;
+        upstream->group = group.get();
+        group->upstreams.push_back(std::move(upstream));
+    }
+    if (group->upstreams.empty()) {
+        return -1;
+    }
+    _groups.push_back(std::move(group));
+    return _groups.size() - 1;
+}
+/**
+ * @description: 转发请求，在工作线程中由路由处理函数调用。请求在此序列化，之后不再访问 request
+ * @param {int} group
+ * @param {HttpRequest} &request
+ * @param {HttpResponse} &response
+ * @return {*}
+ */
+void ReverseProxy::forward(int group, const HttpRequest &request, HttpResponse &response) {
+    assert(group >= 0 && group < (int)_groups.size());
+    std::string_view method     = request.method();
+    bool idempotent             = method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" ||
+                      method == "OPTIONS";
+    Exchange *exchange          = new Exchange();
+    exchange->response          = &response;
+    exchange->client_fd         = response.socket();
+    exchange->head              = method == "HEAD";
+    exchange->idempotent        = idempotent;
+    exchange->client_keep_alive = response.isKeepAlive();
+    exchange->group             = _groups[group].get();
+    exchange->buffered          = response.isBuffered();
+
+    Buffer &buff = exchange->request;
+    buff.append(method);
+    buff.append(" ");
+    buff.append(request.target());
+    buff.append(" HTTP/1.1\r\n");
+    const HttpHeaders &headers  = request.headers();
+    std::string_view connection = headers.get(HttpHeaders::CONNECTION);
+    for (int key = 0; key < HttpHeaders::KNOWN_COUNT; key++) {
+        std::string_view name = HttpHeaders::name(static_cast<HttpHeaders::KNOWN_HEADER>(key));
+        if (headers.has(static_cast<HttpHeaders::KNOWN_HEADER>(key)) && !isHopByHop(name, connection)) {
+            appendHeader(buff, name, headers.get(static_cast<HttpHeaders::KNOWN_HEADER>(key)));
+        }
+    }
+    if (!headers.has(HttpHeaders::HOST)) {
+        appendHeader(buff, "Host", exchange->group->upstreams[0]->name);
+    }
+    std::string_view forwarded_for;
+    for (auto &field : request.headers().others()) {
+        if (HttpHeaders::equalsIgnoreCase(field.first, "X-Forwarded-For")) {
+            forwarded_for = field.second;
+        } else if (!isHopByHop(field.first, connection)) {
+            appendHeader(buff, field.first, field.second);
+        }
+    }
+    struct sockaddr_in peer;
+    socklen_t len = sizeof(peer);
+    char ip[INET_ADDRSTRLEN];
+    if (getpeername(exchange->client_fd, (struct sockaddr *)&peer, &len) == 0 &&
+        inet_ntop(AF_INET, &peer.sin_addr, ip, sizeof(ip))) {
+        buff.append("X-Forwarded-For: ");
+        if (!forwarded_for.empty()) {
+            buff.append(forwarded_for);
+            buff.append(", ");
+        }
+        buff.append(ip, strlen(ip));
+        buff.append("\r\n");
+    }
+    std::string_view body = request.body();
+    if (!body.empty() || method == "POST" || method == "PUT" || method == "PATCH") {
+        appendHeader(buff, "Content-Length", std::to_string(body.size()));
+    }
+    buff.append("Connection: keep-alive\r\n\r\n");
+    if (!body.empty()) {
+        buff.append(body);
+    }
+
+    /* 请求线程交还连接后再提交，此后连接由事件循环中的转发过程持有，直到 resume */
+    response.defer([this, exchange] {
+        {
+            std::lock_guard<std::mutex> locker(_mtx);
+            exchange->key = exchange->client_fd >= 0 ? exchange->client_fd : --_detached_seq;
+            _pending.push_back(exchange);
+            _exchanges[exchange->key] = exchange;
+        }
+        uint64_t one = 1;
+        if (write(_wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            LOG_ERROR("Proxy wake error: %d", errno);
+        }
+    });
+}
+/**
+ * @description: 处理代理相关的事件，由事件循环对每个就绪的 fd 调用
+ * @param {int} fd
+ * @param {uint32_t} events
+ * @return {*} fd 不属于代理时返回 false
+ */
+bool ReverseProxy::handleEvent(int fd, uint32_t events) {
+    if (fd == _wake_fd) {
+        uint64_t count;
+        while (read(_wake_fd, &count, sizeof(count)) > 0) {
+        }
+        std::vector<Exchange *> pending;
+        {
+            std::lock_guard<std::mutex> locker(_mtx);
+            pending.swap(_pending);
+        }
+        for (Exchange *exchange : pending) {
+            _start(exchange);
+        }
+        return true;
+    }
+    if (fd == _timer_fd) {
+        uint64_t expirations;
+        while (read(_timer_fd, &expirations, sizeof(expirations)) > 0) {
+        }
+        _onTimer();
+        return true;
+    }
+    auto conn = _conns.find(fd);
+    if (conn != _conns.end()) {
+        _onConnEvent(conn->second, events);
+        return true;
+    }
+    Exchange *exchange = nullptr;
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        auto it = _exchanges.find(fd);
+        if (it != _exchanges.end() && it->second->client_blocked) {
+            exchange = it->second;
+        }
+    }
+    if (!exchange) {
+        return false;
+    }
+    /* 客户端 socket 可写，继续转发 */
+    exchange->client_blocked = false;
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        _fail(exchange, 0, "client closed");
+    } else {
+        _pump(exchange);
+    }
+    return true;
+}
+/**
+ * @description: 事件循环关闭客户端连接(如超时)时调用，丢弃进行中的请求，不再 resume。
+ *               只能在事件循环线程中、应答已撤销(HttpResponse::cancel)之后调用，与转发过程互不交错；
+ *               工作线程关闭连接时应答已 resume，不存在进行中的请求
+ * @param {int} client_fd
+ * @return {*}
+ */
+void ReverseProxy::abort(int client_fd) {
+    Exchange *exchange = nullptr;
+    bool pending       = false;
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        auto it = _exchanges.find(client_fd);
+        if (it == _exchanges.end()) {
+            return;
+        }
+        exchange = it->second;
+        auto waiting = std::find(_pending.begin(), _pending.end(), exchange);
+        if (waiting != _pending.end()) {
+            _pending.erase(waiting);
+            _exchanges.erase(it);
+            pending = true;
+        }
+    }
+    if (pending) {
+        /* 完成回调可能再次提交请求，须在锁外执行 */
+        HttpResponse *resp = exchange->response;
+        delete exchange;
+        resp->abandon(502);
+        return;
+    }
+    LOG_WARN("Proxy request of client[%d] aborted", client_fd);
+    _drop(exchange);
+}
+/**
+ * @description: 解析 "ip:port" 形式的 IPv4 地址
+ * @param {string_view} address
+ * @param {sockaddr_in} *addr
+ * @return {*}
+ */
+bool ReverseProxy::parseAddress(std::string_view address, struct sockaddr_in *addr) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string_view::npos || colon + 1 == address.size()) {
+        return false;
+    }
+    std::string host(address.substr(0, colon));
+    std::string port(address.substr(colon + 1));
+    char *end;
+    long value = strtol(port.c_str(), &end, 10);
+    if (*end != '\0' || value <= 0 || value > 65535) {
+        return false;
+    }
+    memset(addr, 0, sizeof(*addr));
+    addr->sin_family = AF_INET;
+    addr->sin_port   = htons(value);
+    return inet_pton(AF_INET, host.c_str(), &addr->sin_addr) == 1;
+}
+/**
+ * @description: 为新请求选择上游并分配连接，没有空闲连接且连接数已满时排队
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_start(Exchange *exchange) {
+    Group *group    = exchange->group;
+    size_t n        = group->upstreams.size();
+    size_t start    = group->next++;
+    Upstream *upstream = group->upstreams[start % n].get();
+    if (group->balance == LEAST_OUTSTANDING) {
+        /* 从轮转位置开始比较，负载相同时仍然轮流分配 */
+        for (size_t i = 1; i < n; i++) {
+            Upstream *candidate = group->upstreams[(start + i) % n].get();
+            if (candidate->outstanding < upstream->outstanding) {
+                upstream = candidate;
+            }
+        }
+    }
+    exchange->upstream = upstream;
+    upstream->outstanding++;
+    upstream->waiting.push_back(exchange);
+    _dispatchWaiting(upstream);
+}
+/**
+ * @description: 为排队的请求分配空闲连接，或在连接数未满时新建连接
+ * @param {Upstream} *upstream
+ * @return {*}
+ */
+void ReverseProxy::_dispatchWaiting(Upstream *upstream) {
+    size_t max_conns = upstream->group->max_conns;
+    while (!upstream->waiting.empty()) {
+        Conn *conn = nullptr;
+        if (!upstream->idle.empty()) {
+            conn = upstream->idle.back();
+            upstream->idle.pop_back();
+            conn->reused = true;
+        } else if (upstream->conns < max_conns) {
+            conn = _connect(upstream);
+            if (!conn) {
+                Exchange *exchange = upstream->waiting.front();
+                upstream->waiting.pop_front();
+                _fail(exchange, 502, "connect failed");
+                continue;
+            }
+        } else {
+            return;
+        }
+        Exchange *exchange = upstream->waiting.front();
+        upstream->waiting.pop_front();
+        _assign(exchange, conn);
+    }
+}
+
+void ReverseProxy::_assign(Exchange *exchange, Conn *conn) {
+    conn->exchange       = exchange;
+    exchange->conn       = conn;
+    exchange->state      = SENDING;
+    exchange->sent       = 0;
+    exchange->idle_ticks = 0;
+    if (!conn->connecting) {
+        _send(exchange);
+    }
+}
+/**
+ * @description: 发起非阻塞连接，连接完成后在 EPOLLOUT 中发送请求
+ * @param {Upstream} *upstream
+ * @return {*}
+ */
+ReverseProxy::Conn *ReverseProxy::_connect(Upstream *upstream) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Upstream socket error: %d", errno);
+        return nullptr;
+    }
+    int opt_val = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt_val, sizeof(opt_val));
+    int ret = connect(fd, (struct sockaddr *)&upstream->addr, sizeof(upstream->addr));
+    if (ret < 0 && errno != EINPROGRESS) {
+        LOG_WARN("Upstream %s connect error: %d", upstream->name.c_str(), errno);
+        ::close(fd);
+        return nullptr;
+    }
+    Conn *conn       = new Conn();
+    conn->fd         = fd;
+    conn->upstream   = upstream;
+    conn->connecting = ret < 0;
+    conn->events     = UPSTREAM_EVENT | (conn->connecting ? EPOLLOUT : 0);
+    if (pipe2(conn->pipe_fd, O_NONBLOCK | O_CLOEXEC) < 0) {
+        /* 没有管道时 body 经用户态缓冲转发 */
+        conn->pipe_fd[0] = conn->pipe_fd[1] = -1;
+    }
+    _conns[fd] = conn;
+    upstream->conns++;
+    _epoller->addFd(fd, conn->events);
+    LOG_DEBUG("Upstream %s connection[%d] opened", upstream->name.c_str(), fd);
+    return conn;
+}
+
+void ReverseProxy::_closeConn(Conn *conn) {
+    if (conn->exchange) {
+        conn->exchange->conn = nullptr;
+    }
+    Upstream *upstream = conn->upstream;
+    auto idle          = std::find(upstream->idle.begin(), upstream->idle.end(), conn);
+    if (idle != upstream->idle.end()) {
+        upstream->idle.erase(idle);
+    }
+    _conns.erase(conn->fd);
+    _epoller->delFd(conn->fd);
+    ::close(conn->fd);
+    for (int fd : conn->pipe_fd) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+    upstream->conns--;
+    delete conn;
+}
+/**
+ * @description: 请求完成，连接放回空闲列表，继续关注 EPOLLIN 以发现上游关闭
+ * @param {Conn} *conn
+ * @return {*}
+ */
+void ReverseProxy::_release(Conn *conn) {
+    if (conn->exchange) {
+        conn->exchange->conn = nullptr;
+        conn->exchange       = nullptr;
+    }
+    conn->reused = false;
+    _watch(conn, UPSTREAM_EVENT);
+    conn->upstream->idle.push_back(conn);
+}
+
+void ReverseProxy::_watch(Conn *conn, uint32_t events) {
+    if (conn->events != events) {
+        conn->events = events;
+        _epoller->modFd(conn->fd, events);
+    }
+}
+
+void ReverseProxy::_onConnEvent(Conn *conn, uint32_t events) {
+    Exchange *exchange = conn->exchange;
+    if (!exchange) {
+        /* 空闲连接上出现数据或关闭，均不可再复用 */
+        LOG_DEBUG("Upstream %s idle connection[%d] closed", conn->upstream->name.c_str(), conn->fd);
+        _closeConn(conn);
+        return;
+    }
+    if (exchange->client_blocked) {
+        return;
+    }
+    if (conn->connecting) {
+        int error     = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(conn->fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
+            _fail(exchange, 502, strerror(error ? error : errno));
+            return;
+        }
+        if (!(events & EPOLLOUT)) {
+            return;
+        }
+        conn->connecting = false;
+    }
+    if (exchange->state == SENDING) {
+        _send(exchange);
+    } else {
+        _pump(exchange);
+    }
+}
+/**
+ * @description: 发送序列化的请求，内核缓冲区满时等待 EPOLLOUT
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_send(Exchange *exchange) {
+    Conn *conn       = exchange->conn;
+    const char *data = exchange->request.beginRead();
+    size_t len       = exchange->request.readableBytes();
+    while (exchange->sent < len) {
+        ssize_t n = send(conn->fd, data + exchange->sent, len - exchange->sent, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                _watch(conn, UPSTREAM_EVENT | EPOLLOUT);
+                return;
+            }
+            _fail(exchange, 502, strerror(errno));
+            return;
+        }
+        exchange->sent += n;
+    }
+    exchange->state = RECV_HEADER;
+    _watch(conn, UPSTREAM_EVENT);
+}
+/**
+ * @description: 在上游与客户端之间搬运应答：先把已有数据写给客户端，写不动时暂停；
+ *               再从上游读取，直到 body 结束或上游暂无数据
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_pump(Exchange *exchange) {
+    Conn *conn    = exchange->conn;
+    bool progress = false;
+    while (true) {
+        int flushed = exchange->buffered ? 1 : _flushClient(exchange);
+        if (flushed <= 0) {
+            break;
+        }
+        if (exchange->state == RECV_BODY &&
+            (exchange->framing == BODY_NONE || (exchange->framing == BODY_LENGTH && exchange->remaining == 0) ||
+             (exchange->framing == BODY_CHUNKED && exchange->chunk == CHUNK_DONE) ||
+             (exchange->framing == BODY_CLOSE && exchange->eof))) {
+            if (_activity_handler && exchange->client_fd >= 0) {
+                _activity_handler(exchange->client_fd);
+            }
+            _finish(exchange);
+            return;
+        }
+        ssize_t n = 0;
+        int error = 0;
+        if (exchange->state == RECV_BODY && !exchange->buffered && conn->pipe_fd[1] >= 0 && conn->in.readableBytes() == 0 &&
+            (exchange->framing == BODY_LENGTH || exchange->framing == BODY_CLOSE)) {
+            /* body 不经用户态：上游 socket -> 管道 -> 客户端 socket */
+            size_t want = exchange->framing == BODY_LENGTH ? std::min(exchange->remaining, PIPE_CHUNK) : PIPE_CHUNK;
+            n           = splice(conn->fd, nullptr, conn->pipe_fd[1], nullptr, want, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0) {
+                exchange->piped += n;
+                if (exchange->framing == BODY_LENGTH) {
+                    exchange->remaining -= n;
+                }
+            }
+            error = errno;
+        } else {
+            n = conn->in.readFd(conn->fd, &error);
+        }
+        if (n == 0) {
+            if (exchange->state == RECV_BODY && exchange->framing == BODY_CLOSE) {
+                exchange->eof                 = true;
+                exchange->upstream_keep_alive = false;
+                continue;
+            }
+            _fail(exchange, 502, "upstream closed");
+            return;
+        } else if (n < 0) {
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                _watch(conn, UPSTREAM_EVENT);
+                break;
+            }
+            _fail(exchange, 502, strerror(error));
+            return;
+        }
+        progress             = true;
+        exchange->idle_ticks = 0;
+        if (exchange->state == RECV_HEADER) {
+            int ret = _parseHeader(exchange);
+            if (ret < 0) {
+                _fail(exchange, 502, "invalid upstream response");
+                return;
+            } else if (ret == 0) {
+                continue;
+            }
+        }
+        /* 用户态缓冲中的 body 按界定方式移入客户端输出缓冲，缓冲模式下 chunked 解码后收集 */
+        size_t readable = conn->in.readableBytes();
+        size_t used     = 0;
+        bool decoded    = false;
+        if (exchange->framing == BODY_LENGTH) {
+            used = std::min(readable, exchange->remaining);
+            exchange->remaining -= used;
+        } else if (exchange->framing == BODY_CHUNKED) {
+            decoded = exchange->buffered;
+            used    = _scanChunked(exchange, conn->in.beginRead(), readable, decoded ? &exchange->out : nullptr);
+            if (exchange->chunk == CHUNK_ERROR) {
+                _fail(exchange, 502, "invalid chunked body");
+                return;
+            }
+        } else if (exchange->framing == BODY_CLOSE) {
+            used = readable;
+        }
+        if (used > 0) {
+            if (!decoded) {
+                exchange->out.append(conn->in.beginRead(), used);
+            }
+            conn->in.hasRead(used);
+        }
+        if (exchange->buffered && exchange->out.readableBytes() > MAX_BUFFERED) {
+            _fail(exchange, 502, "response too large to buffer");
+            return;
+        }
+    }
+    if (progress && _activity_handler && exchange->client_fd >= 0) {
+        _activity_handler(exchange->client_fd);
+    }
+}
+/**
+ * @description: 解析上游应答头，改写逐跳首部后放入客户端输出缓冲，并确定 body 的界定方式
+ * @param {Exchange} *exchange
+ * @return {*} 1 完成；0 需要更多数据；-1 应答无效
+ */
+int ReverseProxy::_parseHeader(Exchange *exchange) {
+    Conn *conn = exchange->conn;
+    while (true) {
+        std::string_view data(conn->in.beginRead(), conn->in.readableBytes());
+        size_t end = data.find("\r\n\r\n");
+        if (end == std::string_view::npos) {
+            return data.size() > MAX_HEADER_SIZE ? -1 : 0;
+        }
+        size_t line_end = data.find("\r\n");
+        std::string_view status = data.substr(0, line_end);
+        if (status.size() < 12 || status.substr(0, 7) != "HTTP/1." || status[8] != ' ') {
+            return -1;
+        }
+        int code = 0;
+        for (size_t i = 9; i < 12; i++) {
+            if (status[i] < '0' || status[i] > '9') {
+                return -1;
+            }
+            code = code * 10 + (status[i] - '0');
+        }
+        if (code == 101) {
+            return -1;
+        } else if (code >= 100 && code < 200) {
+            /* 中间应答(如 100 Continue)不转发 */
+            conn->in.hasRead(end + 4);
+            continue;
+        }
+
+        Buffer &out         = exchange->out;
+        bool chunked        = false;
+        bool has_length     = false;
+        bool close          = status[7] == '0';
+        size_t length       = 0;
+        exchange->code      = code;
+        if (!exchange->buffered) {
+            out.append(status);
+            out.append("\r\n");
+        }
+        std::string_view lines = data.substr(line_end + 2, end - line_end);
+        std::string connection = connectionOptions(lines);
+        while (!lines.empty()) {
+            size_t next           = lines.find("\r\n");
+            std::string_view line = lines.substr(0, next);
+            lines.remove_prefix(next + 2);
+            size_t colon = line.find(':');
+            if (colon == std::string_view::npos || colon == 0) {
+                return -1;
+            }
+            std::string_view name  = line.substr(0, colon);
+            std::string_view value = line.substr(colon + 1);
+            while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+                value.remove_prefix(1);
+            }
+            while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+                value.remove_suffix(1);
+            }
+            /* body 原样透传，界定 body 的两个首部保留，其余逐跳首部去除 */
+            bool forward = true;
+            if (HttpHeaders::equalsIgnoreCase(name, "Transfer-Encoding")) {
+                chunked = hasToken(value, "chunked");
+                if (!chunked) {
+                    return -1;
+                }
+            } else if (HttpHeaders::equalsIgnoreCase(name, "Content-Length")) {
+                has_length = !value.empty();
+                length     = 0;
+                for (char ch : value) {
+                    if (ch < '0' || ch > '9' || length > (SIZE_MAX - 9) / 10) {
+                        return -1;
+                    }
+                    length = length * 10 + (ch - '0');
+                }
+            } else if (HttpHeaders::equalsIgnoreCase(name, "Connection")) {
+                if (hasToken(value, "close")) {
+                    close = true;
+                } else if (hasToken(value, "keep-alive")) {
+                    close = false;
+                }
+                forward = false;
+            } else {
+                forward = !isHopByHop(name, connection);
+            }
+            if (!exchange->buffered) {
+                if (forward) {
+                    out.append(line);
+                    out.append("\r\n");
+                }
+            } else if (HttpHeaders::equalsIgnoreCase(name, "Content-Type")) {
+                exchange->content_type = value;
+            } else if (forward && !isHopByHop(name, connection)) {
+                /* body 已解码，界定 body 的首部由应答重新生成；带有会话或禁止缓存的应答不可共享 */
+                if (HttpHeaders::equalsIgnoreCase(name, "Set-Cookie") ||
+                    (HttpHeaders::equalsIgnoreCase(name, "Cache-Control") &&
+                     (hasToken(value, "no-store") || hasToken(value, "no-cache") || hasToken(value, "private")))) {
+                    exchange->cacheable = false;
+                }
+                exchange->headers.append(line.data(), line.size());
+                exchange->headers.append("\r\n");
+            }
+        }
+
+        if (exchange->head || code == 204 || code == 304) {
+            exchange->framing = BODY_NONE;
+        } else if (chunked) {
+            exchange->framing = BODY_CHUNKED;
+            exchange->chunk   = CHUNK_SIZE;
+        } else if (has_length) {
+            exchange->framing   = length > 0 ? BODY_LENGTH : BODY_NONE;
+            exchange->remaining = length;
+        } else {
+            exchange->framing = BODY_CLOSE;
+        }
+        exchange->upstream_keep_alive = !close;
+        bool keep_alive               = exchange->client_keep_alive && exchange->framing != BODY_CLOSE;
+        if (!exchange->buffered) {
+            out.append(keep_alive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n");
+        }
+        conn->in.hasRead(end + 4);
+        exchange->state = RECV_BODY;
+        return 1;
+    }
+}
+/**
+ * @description: 跟踪 chunked 编码的边界，数据原样透传，只判断 body 在何处结束
+ * @param {Exchange} *exchange
+ * @param {char} *data
+ * @param {size_t} len
+ * @param {Buffer} *decoded，非空时收集块数据，即解码后的 body
+ * @return {*} 属于 body 的字节数
+ */
+size_t ReverseProxy::_scanChunked(Exchange *exchange, const char *data, size_t len, Buffer *decoded) {
+    size_t i = 0;
+    while (i < len && exchange->chunk != CHUNK_DONE && exchange->chunk != CHUNK_ERROR) {
+        char ch = data[i];
+        switch (exchange->chunk) {
+        case CHUNK_SIZE:
+            if (isxdigit((unsigned char)ch) && exchange->remaining <= (SIZE_MAX >> 4)) {
+                int digit           = ch <= '9' ? ch - '0' : (ch | 0x20) - 'a' + 10;
+                exchange->remaining = exchange->remaining * 16 + digit;
+            } else if (ch == ';' || ch == ' ' || ch == '\t') {
+                exchange->chunk = CHUNK_EXT;
+            } else if (ch == '\r') {
+                exchange->chunk = CHUNK_SIZE_LF;
+            } else {
+                exchange->chunk = CHUNK_ERROR;
+            }
+            i++;
+            break;
+        case CHUNK_EXT:
+            if (ch == '\r') {
+                exchange->chunk = CHUNK_SIZE_LF;
+            }
+            i++;
+            break;
+        case CHUNK_SIZE_LF:
+            exchange->chunk = ch != '\n' ? CHUNK_ERROR : exchange->remaining == 0 ? CHUNK_TRAILER : CHUNK_DATA;
+            i++;
+            break;
+        case CHUNK_DATA: {
+            size_t n = std::min(exchange->remaining, len - i);
+            if (decoded) {
+                decoded->append(data + i, n);
+            }
+            i += n;
+            exchange->remaining -= n;
+            if (exchange->remaining == 0) {
+                exchange->chunk = CHUNK_DATA_CR;
+            }
+            break;
+        }
+        case CHUNK_DATA_CR:
+            exchange->chunk = ch == '\r' ? CHUNK_DATA_LF : CHUNK_ERROR;
+            i++;
+            break;
+        case CHUNK_DATA_LF:
+            exchange->chunk = ch == '\n' ? CHUNK_SIZE : CHUNK_ERROR;
+            i++;
+            break;
+        case CHUNK_TRAILER:
+            exchange->chunk = ch == '\r' ? CHUNK_TRAILER_LF : CHUNK_TRAILER_LINE;
+            i++;
+            break;
+        case CHUNK_TRAILER_LINE:
+            if (ch == '\n') {
+                exchange->chunk = CHUNK_TRAILER;
+            }
+            i++;
+            break;
+        case CHUNK_TRAILER_LF:
+            exchange->chunk = ch == '\n' ? CHUNK_DONE : CHUNK_ERROR;
+            i++;
+            break;
+        default:
+            break;
+        }
+    }
+    return i;
+}
+/**
+ * @description: 把输出缓冲与管道中的数据写给客户端。写不动时暂停读取上游，改为等待客户端 EPOLLOUT
+ * @param {Exchange} *exchange
+ * @return {*} 1 已全部写出；0 等待客户端可写；-1 客户端出错，请求已结束
+ */
+int ReverseProxy::_flushClient(Exchange *exchange) {
+    Conn *conn = exchange->conn;
+    int fd     = exchange->client_fd;
+    while (exchange->out.readableBytes() > 0 || exchange->piped > 0) {
+        ssize_t n;
+        if (exchange->out.readableBytes() > 0) {
+            n = send(fd, exchange->out.beginRead(), exchange->out.readableBytes(), MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                exchange->out.hasRead(n);
+                Metrics::add(Metrics::BYTES_OUT, n);
+            }
+        } else {
+            n = splice(conn->pipe_fd[0], nullptr, fd, nullptr, exchange->piped, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+            if (n > 0) {
+                exchange->piped -= n;
+                Metrics::add(Metrics::BYTES_OUT, n);
+            }
+        }
+        if (n > 0) {
+            continue;
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            /* 上游改为 ONESHOT 且不关注任何事件：暂停期间的 EPOLLHUP/EPOLLERR 至多报告一次 */
+            exchange->client_blocked = true;
+            _watch(conn, EPOLLONESHOT);
+            _epoller->modFd(fd, _client_event | EPOLLOUT);
+            return 0;
+        }
+        _fail(exchange, 0, n < 0 ? strerror(errno) : "client closed");
+        return -1;
+    }
+    return 1;
+}
+/**
+ * @description: 复用的空闲连接可能已被上游关闭，尚未收到任何应答的幂等请求换新连接重试一次
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+bool ReverseProxy::_retry(Exchange *exchange) {
+    Conn *conn = exchange->conn;
+    if (!conn || !conn->reused || exchange->retried || !exchange->idempotent || exchange->state > RECV_HEADER ||
+        conn->in.readableBytes() > 0) {
+        return false;
+    }
+    LOG_DEBUG("Upstream %s connection[%d] stale, retry", conn->upstream->name.c_str(), conn->fd);
+    exchange->retried = true;
+    exchange->state   = WAIT_CONN;
+    conn->exchange    = nullptr;
+    exchange->conn    = nullptr;
+    _closeConn(conn);
+    exchange->upstream->waiting.push_front(exchange);
+    _dispatchWaiting(exchange->upstream);
+    return true;
+}
+/**
+ * @description: 应答转发完毕，上游连接可复用时放回空闲列表
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_finish(Exchange *exchange) {
+    Conn *conn = exchange->conn;
+    if (exchange->upstream_keep_alive && exchange->framing != BODY_CLOSE && conn->in.readableBytes() == 0) {
+        _release(conn);
+    } else {
+        _closeConn(conn);
+    }
+    HttpResponse *resp = exchange->response;
+    if (exchange->buffered) {
+        std::string_view type = exchange->content_type;
+        resp->setCode(exchange->code);
+        resp->setContent(std::string_view(exchange->out.beginRead(), exchange->out.readableBytes()),
+                         type.empty() ? "application/octet-stream" : type);
+        resp->addHeaderLines(exchange->headers);
+        resp->setCacheable(exchange->cacheable);
+    } else {
+        resp->setCode(exchange->code);
+        resp->setSent(exchange->client_keep_alive && exchange->framing != BODY_CLOSE);
+    }
+    _complete(exchange);
+}
+/**
+ * @description: 请求失败。尚未向客户端写出应答头时以 code 应答，否则只能关闭客户端连接
+ * @param {Exchange} *exchange
+ * @param {int} code，0 表示客户端出错
+ * @param {char} *reason
+ * @return {*}
+ */
+void ReverseProxy::_fail(Exchange *exchange, int code, const char *reason) {
+    LOG_WARN("Proxy client[%d] to %s failed: %s", exchange->client_fd,
+             exchange->upstream ? exchange->upstream->name.c_str() : "-", reason);
+    if (code && _retry(exchange)) {
+        return;
+    }
+    if (exchange->conn) {
+        _closeConn(exchange->conn);
+    }
+    if (code && (exchange->buffered || exchange->state != RECV_BODY)) {
+        exchange->response->setCode(code);
+    } else {
+        exchange->response->setSent(false);
+    }
+    _complete(exchange);
+}
+/**
+ * @description: 结束请求并交还客户端连接
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_complete(Exchange *exchange) {
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        _exchanges.erase(exchange->key);
+    }
+    Upstream *upstream = exchange->upstream;
+    if (upstream && exchange->state == WAIT_CONN) {
+        /* 排队中超时的请求 */
+        auto waiting = std::find(upstream->waiting.begin(), upstream->waiting.end(), exchange);
+        if (waiting != upstream->waiting.end()) {
+            upstream->waiting.erase(waiting);
+        }
+    }
+    HttpResponse *resp = exchange->response;
+    delete exchange;
+    resp->resume();
+    if (upstream) {
+        upstream->outstanding--;
+        _dispatchWaiting(upstream);
+    }
+}
+/**
+ * @description: 丢弃请求，客户端连接已由服务器关闭，不再 resume，只通知完成回调
+ * @param {Exchange} *exchange
+ * @return {*}
+ */
+void ReverseProxy::_drop(Exchange *exchange) {
+    Upstream *upstream = exchange->upstream;
+    if (upstream) {
+        auto waiting = std::find(upstream->waiting.begin(), upstream->waiting.end(), exchange);
+        if (waiting != upstream->waiting.end()) {
+            upstream->waiting.erase(waiting);
+        }
+        upstream->outstanding--;
+    }
+    if (exchange->conn) {
+        _closeConn(exchange->conn);
+    }
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        _exchanges.erase(exchange->key);
+    }
+    HttpResponse *resp = exchange->response;
+    delete exchange;
+    resp->abandon(502);
+    if (upstream) {
+        _dispatchWaiting(upstream);
+    }
+}
+/**
+ * @description: 超时检查：连续 timeout_ms 没有进展的请求以 504 结束，等待客户端可写的请求由客户端连接的计时器负责
+ * @return {*}
+ */
+void ReverseProxy::_onTimer() {
+    std::vector<Exchange *> expired;
+    {
+        std::lock_guard<std::mutex> locker(_mtx);
+        for (auto &item : _exchanges) {
+            Exchange *exchange = item.second;
+            if (exchange->upstream && !exchange->client_blocked && ++exchange->idle_ticks * TICK_MS >= _timeout_ms) {
+                expired.push_back(exchange);
+            }
+        }
+    }
+    for (Exchange *exchange : expired) {
+        _fail(exchange, 504, "upstream timeout");
+    }
+}
@@ -0,0 +1,363 @@
+/*
+ * @Description: RESP 连接池实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#include "redispool.h"
+
+#include <cstring>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+static const uint32_t CONN_EVENT = EPOLLIN | EPOLLRDHUP;
+
+RedisPool::RedisPool()
+    : _epoller(nullptr)
+    , _addr({0})
+    , _wake_fd(-1)
+    , _timer_fd(-1)
+    , _next(0) {}
+
+RedisPool::~RedisPool() {
+    close();
+}
+/**
+ * @description: 创建 conn_num 个连接并注册到事件循环，连接失败时由健康检查重试
+ * @param {Epoller} *epoller，事件循环所用的 epoller，handleEvent 需在该事件循环线程中调用
+ * @param {char} *host，IPv4 地址
+ * @param {int} port
+ * @param {size_t} conn_num
+ * @param {int} health_ms，健康检查周期
+ * @return {*}
+ */
+bool RedisPool::init(Epoller *epoller, const char *host, int port, size_t conn_num, int health_ms) {
+    assert(epoller && conn_num > 0 && health_ms > 0 && _conns.empty());
+    _addr.sin_family = AF_INET;
+    _addr.sin_port   = htons(port);
+    if (inet_pton(AF_INET, host, &_addr.sin_addr) != 1) {
+        LOG_ERROR("Redis host %s invalid", host);
+        return false;
+    }
+    _epoller  = epoller;
+    _wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_wake_fd < 0 || _timer_fd < 0) {
+        LOG_ERROR("Redis pool fd error: %d", errno);
+        close();
+        return false;
+    }
+    struct itimerspec spec;
+    spec.it_interval.tv_sec  = health_ms / 1000;
+    spec.it_interval.tv_nsec = (health_ms % 1000) * 1000000L;
+    spec.it_value            = spec.it_interval;
+    timerfd_settime(_timer_fd, 0, &spec, nullptr);
+    _epoller->addFd(_wake_fd, EPOLLIN);
+    _epoller->addFd(_timer_fd, EPOLLIN);
+
+    for (size_t i = 0; i < conn_num; i++) {
+        _conns.emplace_back(new Conn());
+        _connect(*_conns.back());
+    }
+    LOG_INFO("Redis pool: %s:%d, %zu connections", host, port, conn_num);
+    return true;
+}
+
+void RedisPool::close() {
+    for (auto &conn : _conns) {
+        _reset(*conn, "pool closed");
+    }
+    _conns.clear();
+    for (int *fd : {&_wake_fd, &_timer_fd}) {
+        if (*fd >= 0) {
+            _epoller->delFd(*fd);
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+/**
+ * @description: 发送命令，可在任意线程调用。参数在返回前已编码进发送缓冲区，调用方无需保持其有效；
+ *               没有可用连接时立即以错误应答回调
+ * @param {initializer_list<string_view>} args
+ * @param {RedisCallback} callback
+ * @return {*}
+ */
+void RedisPool::command(std::initializer_list<std::string_view> args, RedisCallback callback) {
+    assert(callback);
+    size_t n     = _conns.size();
+    size_t start = _next++;
+    for (size_t i = 0; i < n; i++) {
+        Conn &conn = *_conns[(start + i) % n];
+        bool wake;
+        {
+            std::lock_guard<std::mutex> locker(conn.mtx);
+            if (conn.state != CONNECTED) {
+                continue;
+            }
+            Resp::encode(conn.out, args);
+            conn.callbacks.push_back(std::move(callback));
+            wake          = !conn.flushing;
+            conn.flushing = true;
+        }
+        if (wake) {
+            _wake();
+        }
+        return;
+    }
+    RespReply reply;
+    reply.type = RESP_ERROR;
+    reply.str  = "ERR no redis connection";
+    callback(reply);
+}
+/**
+ * @description: 处理连接池的事件，由事件循环对每个就绪的 fd 调用
+ * @param {int} fd
+ * @param {uint32_t} events
+ * @return {*} fd 不属于连接池时返回 false
+ */
+bool RedisPool::handleEvent(int fd, uint32_t events) {
+    if (fd < 0) {
+        return false;
+    }
+    if (fd == _wake_fd) {
+        uint64_t count;
+        while (read(_wake_fd, &count, sizeof(count)) > 0) {
+        }
+        for (auto &conn : _conns) {
+            _flush(*conn);
+        }
+        return true;
+    }
+    if (fd == _timer_fd) {
+        uint64_t expirations;
+        while (read(_timer_fd, &expirations, sizeof(expirations)) > 0) {
+        }
+        _onTimer();
+        return true;
+    }
+    for (auto &conn : _conns) {
+        if (conn->fd != fd) {
+            continue;
+        }
+        if (events & EPOLLOUT) {
+            _onWritable(*conn);
+        }
+        if (conn->fd == fd && (events & EPOLLIN)) {
+            _onReadable(*conn);
+        }
+        if (conn->fd == fd && (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+            _reset(*conn, "connection closed");
+        }
+        return true;
+    }
+    return false;
+}
+
+size_t RedisPool::connected() const {
+    size_t count = 0;
+    for (auto &conn : _conns) {
+        std::lock_guard<std::mutex> locker(conn->mtx);
+        count += conn->state == CONNECTED;
+    }
+    return count;
+}
+/**
+ * @description: 发起非阻塞连接，完成后在 EPOLLOUT 中确认
+ * @param {Conn} &conn
+ * @return {*}
+ */
+void RedisPool::_connect(Conn &conn) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Redis socket error: %d", errno);
+        return;
+    }
+    int opt_val = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt_val, sizeof(opt_val));
+    if (connect(fd, (struct sockaddr *)&_addr, sizeof(_addr)) < 0 && errno != EINPROGRESS) {
+        LOG_WARN("Redis connect error: %d", errno);
+        ::close(fd);
+        return;
+    }
+    std::lock_guard<std::mutex> locker(conn.mtx);
+    conn.fd         = fd;
+    conn.state      = CONNECTING;
+    conn.idle_ticks = 0;
+    _epoller->addFd(fd, CONN_EVENT | EPOLLOUT);
+}
+/**
+ * @description: 断开连接，未应答的命令以错误应答回调，等待下一次健康检查重连
+ * @param {Conn} &conn
+ * @param {char} *reason
+ * @return {*}
+ */
+void RedisPool::_reset(Conn &conn, const char *reason) {
+    std::deque<RedisCallback> callbacks;
+    {
+        std::lock_guard<std::mutex> locker(conn.mtx);
+        if (conn.fd < 0) {
+            return;
+        }
+        LOG_WARN("Redis connection[%d] reset: %s, %zu pending", conn.fd, reason, conn.callbacks.size());
+        _epoller->delFd(conn.fd);
+        ::close(conn.fd);
+        conn.fd       = -1;
+        conn.state    = DISCONNECTED;
+        conn.flushing = false;
+        conn.writable = true;
+        conn.out.reset();
+        conn.in.reset();
+        callbacks.swap(conn.callbacks);
+    }
+    RespReply reply;
+    reply.type = RESP_ERROR;
+    reply.str  = reason;
+    for (auto &callback : callbacks) {
+        if (callback) {
+            callback(reply);
+        }
+    }
+}
+/**
+ * @description: 发送缓冲区中累积的命令，内核缓冲区满时关注 EPOLLOUT 继续发送
+ * @param {Conn} &conn
+ * @return {*}
+ */
+void RedisPool::_flush(Conn &conn) {
+    std::unique_lock<std::mutex> locker(conn.mtx);
+    conn.flushing = false;
+    if (conn.state != CONNECTED) {
+        return;
+    }
+    int write_errno = 0;
+    while (conn.out.readableBytes() > 0) {
+        if (conn.out.writeFd(conn.fd, &write_errno) < 0) {
+            if (write_errno == EAGAIN || write_errno == EWOULDBLOCK) {
+                break;
+            }
+            locker.unlock();
+            _reset(conn, strerror(write_errno));
+            return;
+        }
+    }
+    bool writable = conn.out.readableBytes() == 0;
+    if (writable != conn.writable) {
+        conn.writable = writable;
+        _epoller->modFd(conn.fd, CONN_EVENT | (writable ? 0 : EPOLLOUT));
+    }
+}
+/**
+ * @description: 读取并按序分派应答，回调执行期间不持有锁，回调中可以再次发送命令
+ * @param {Conn} &conn
+ * @return {*}
+ */
+void RedisPool::_onReadable(Conn &conn) {
+    int read_errno = 0;
+    ssize_t len    = conn.in.readFd(conn.fd, &read_errno);
+    if (len == 0 || (len < 0 && read_errno != EAGAIN && read_errno != EWOULDBLOCK)) {
+        _reset(conn, len == 0 ? "closed by peer" : strerror(read_errno));
+        return;
+    }
+    RespReply reply;
+    while (conn.in.readableBytes() > 0) {
+        ssize_t used = Resp::parse(conn.in.beginRead(), conn.in.readableBytes(), &reply);
+        if (used == 0) {
+            break;
+        }
+        RedisCallback callback;
+        bool unexpected = false;
+        {
+            std::lock_guard<std::mutex> locker(conn.mtx);
+            if (used < 0 || conn.callbacks.empty()) {
+                unexpected = true;
+            } else {
+                callback = std::move(conn.callbacks.front());
+                conn.callbacks.pop_front();
+                conn.idle_ticks = 0;
+            }
+        }
+        if (unexpected) {
+            _reset(conn, used < 0 ? "protocol error" : "unexpected reply");
+            return;
+        }
+        if (callback) {
+            callback(reply);
+        }
+        conn.in.hasRead(used);
+    }
+}
+/**
+ * @description: 非阻塞连接完成，或发送缓冲区可继续写入
+ * @param {Conn} &conn
+ * @return {*}
+ */
+void RedisPool::_onWritable(Conn &conn) {
+    bool connecting;
+    {
+        std::lock_guard<std::mutex> locker(conn.mtx);
+        connecting = conn.state == CONNECTING;
+    }
+    if (connecting) {
+        int error     = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
+            _reset(conn, strerror(error ? error : errno));
+            return;
+        }
+        std::lock_guard<std::mutex> locker(conn.mtx);
+        conn.state    = CONNECTED;
+        conn.writable = true;
+        _epoller->modFd(conn.fd, CONN_EVENT);
+        LOG_INFO("Redis connection[%d] established", conn.fd);
+        return;
+    }
+    _flush(conn);
+}
+/**
+ * @description: 健康检查：重连断开的连接；空闲连接发送 PING；连接超时或两个周期没有应答的连接断开
+ * @return {*}
+ */
+void RedisPool::_onTimer() {
+    for (auto &ptr : _conns) {
+        Conn &conn         = *ptr;
+        const char *reason = nullptr;
+        bool flush         = false;
+        {
+            std::lock_guard<std::mutex> locker(conn.mtx);
+            if (conn.state == CONNECTING) {
+                reason = ++conn.idle_ticks >= 2 ? "connect timeout" : nullptr;
+            } else if (conn.state == CONNECTED && !conn.callbacks.empty()) {
+                reason = ++conn.idle_ticks >= 2 ? "health check timeout" : nullptr;
+            } else if (conn.state == CONNECTED) {
+                Resp::encode(conn.out, {"PING"});
+                conn.callbacks.emplace_back();
+                flush = true;
+            }
+        }
+        if (reason) {
+            _reset(conn, reason);
+        } else if (flush) {
+            _flush(conn);
+        }
+        if (conn.fd < 0) {
+            _connect(conn);
+        }
+    }
+}
+
+void RedisPool::_wake() {
+    uint64_t one = 1;
+    if (write(_wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("Redis pool wake error: %d", errno);
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * @Description: RESP 编码与解析实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#include "resp.h"
+
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @description: 将命令编码为 bulk string 数组追加到缓冲区，如 {"GET", "key"} -> "*2\r\n$3\r\nGET\r\n$3\r\nkey\r\n"
+ * @param {Buffer} &buff
+ * @param {initializer_list<string_view>} args
+ * @return {*}
+ */
+void Resp::encode(Buffer &buff, std::initializer_list<std::string_view> args) {
+    encode(buff, args.begin(), args.size());
+}
+
+void Resp::encode(Buffer &buff, const std::string_view *args, size_t count) {
+    _header(buff, '*', count);
+    for (size_t i = 0; i < count; i++) {
+        bulk(buff, args[i]);
+    }
+}
+
+void Resp::status(Buffer &buff, std::string_view str) {
+    buff.append("+");
+    buff.append(str);
+    buff.append("\r\n");
+}
+
+void Resp::error(Buffer &buff, std::string_view str) {
+    buff.append("-");
+    buff.append(str);
+    buff.append("\r\n");
+}
+
+void Resp::integer(Buffer &buff, long long value) {
+    _header(buff, ':', value);
+}
+
+void Resp::bulk(Buffer &buff, std::string_view str) {
+    _header(buff, '$', str.size());
+    buff.append(str);
+    buff.append("\r\n");
+}
+
+void Resp::nil(Buffer &buff) {
+    buff.append("$-1\r\n");
+}
+/**
+ * @description: 解析一个完整的应答
+ * @param {char} *data
+ * @param {size_t} len
+ * @param {RespReply} *reply
+ * @return {*} 消耗的字节数；数据不完整时返回 0，协议错误返回 -1
+ */
+ssize_t Resp::parse(const char *data, size_t len, RespReply *reply) {
+    return _parse(data, len, reply, 0);
+}
+
+ssize_t Resp::_parse(const char *data, size_t len, RespReply *reply, size_t depth) {
+    const char *line_end = static_cast<const char *>(memmem(data, len, "\r\n", 2));
+    if (!line_end) {
+        return len > 64 * 1024 ? -1 : 0;
+    }
+    if (line_end == data) {
+        return -1;
+    }
+    std::string_view line(data + 1, line_end - data - 1);
+    size_t used = line_end - data + 2;
+    reply->elements.clear();
+    if (data[0] == '+' || data[0] == '-') {
+        reply->type = data[0] == '+' ? RESP_STATUS : RESP_ERROR;
+        reply->str  = line;
+        return used;
+    }
+    /* 其余类型首行均为整数 */
+    long long value = 0;
+    bool negative   = !line.empty() && line[0] == '-';
+    size_t i        = negative ? 1 : 0;
+    if (i == line.size()) {
+        return -1;
+    }
+    for (; i < line.size(); i++) {
+        if (line[i] < '0' || line[i] > '9' || value > 922337203685477579LL) {
+            return -1;
+        }
+        value = value * 10 + (line[i] - '0');
+    }
+    value = negative ? -value : value;
+    switch (data[0]) {
+    case ':':
+        reply->type    = RESP_INTEGER;
+        reply->integer = value;
+        return used;
+    case '$':
+        if (value < 0) {
+            reply->type = RESP_NIL;
+            return used;
+        }
+        if (value > MAX_BULK) {
+            return -1;
+        }
+        if (len - used < (size_t)value + 2) {
+            return 0;
+        }
+        if (data[used + value] != '\r' || data[used + value + 1] != '\n') {
+            return -1;
+        }
+        reply->type = RESP_STRING;
+        reply->str  = std::string_view(data + used, value);
+        return used + value + 2;
+    case '*':
+        if (value < 0) {
+            reply->type = RESP_NIL;
+            return used;
+        }
+        if (depth >= MAX_DEPTH || value > MAX_ELEMENTS) {
+            return -1;
+        }
+        if ((size_t)value * 3 > len - used) {
+            /* 每个元素至少占 3 字节，剩余数据不足时不可能完整 */
+            return 0;
+        }
+        reply->type = RESP_ARRAY;
+        reply->elements.resize(value);
+        for (auto &element : reply->elements) {
+            ssize_t ret = _parse(data + used, len - used, &element, depth + 1);
+            if (ret <= 0) {
+                return ret;
+            }
+            used += ret;
+        }
+        return used;
+    default:
+        return -1;
+    }
+}
+
+void Resp::_header(Buffer &buff, char type, long long value) {
+    char line[32];
+    int len = snprintf(line, sizeof(line), "%c%lld\r\n", type, value);
+    buff.append(line, len);
+}
@@ -0,0 +1,284 @@
+/*
+ * @Description: 进程内 RESP 服务端桩实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 17:31:48
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 17:31:48
+ */
+#include "respstub.h"
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <errno.h>
+#include <netinet/in.h>
+#include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+/**
+ * @description: 大小写不敏感地比较命令名
+ * @param {string_view} name
+ * @param {char} *expected，大写命令名
+ * @return {*}
+ */
+static bool isCommand(std::string_view name, const char *expected) {
+    return name.size() == strlen(expected) && strncasecmp(name.data(), expected, name.size()) == 0;
+}
+
+static bool toInteger(std::string_view str, long long *value) {
+    std::string copy(str);
+    char *end;
+    errno  = 0;
+    *value = strtoll(copy.c_str(), &end, 10);
+    return !copy.empty() && *end == '\0' && errno == 0;
+}
+
+RespStub::RespStub()
+    : _listen_fd(-1)
+    , _stop_fd(-1)
+    , _port(0) {}
+
+RespStub::~RespStub() {
+    stop();
+}
+/**
+ * @description: 监听 127.0.0.1:port 并启动服务线程
+ * @param {int} port，为 0 时由内核分配，通过 port() 获取
+ * @return {*}
+ */
+bool RespStub::start(int port) {
+    assert(_listen_fd < 0);
+    _listen_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    _stop_fd   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_listen_fd < 0 || _stop_fd < 0) {
+        LOG_ERROR("Resp stub socket error: %d", errno);
+        stop();
+        return false;
+    }
+    int opt_val = 1;
+    setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, &opt_val, sizeof(opt_val));
+    struct sockaddr_in addr = {0};
+    addr.sin_family         = AF_INET;
+    addr.sin_addr.s_addr    = htonl(INADDR_LOOPBACK);
+    addr.sin_port           = htons(port);
+    socklen_t len           = sizeof(addr);
+    if (bind(_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(_listen_fd, 64) < 0 ||
+        getsockname(_listen_fd, (struct sockaddr *)&addr, &len) < 0) {
+        LOG_ERROR("Resp stub listen on %d error: %d", port, errno);
+        stop();
+        return false;
+    }
+    _port    = ntohs(addr.sin_port);
+    _epoller.reset(new Epoller(64));
+    _epoller->addFd(_listen_fd, EPOLLIN);
+    _epoller->addFd(_stop_fd, EPOLLIN);
+    _thread = std::thread(&RespStub::_loop, this);
+    LOG_INFO("Resp stub listening on 127.0.0.1:%d", _port);
+    return true;
+}
+
+void RespStub::stop() {
+    if (_thread.joinable()) {
+        uint64_t one = 1;
+        if (write(_stop_fd, &one, sizeof(one)) < 0) {
+            LOG_ERROR("Resp stub stop error: %d", errno);
+        }
+        _thread.join();
+    }
+    for (auto &client : _clients) {
+        close(client.first);
+    }
+    _clients.clear();
+    for (int *fd : {&_listen_fd, &_stop_fd}) {
+        if (*fd >= 0) {
+            close(*fd);
+            *fd = -1;
+        }
+    }
+    _epoller.reset();
+}
+
+void RespStub::_loop() {
+    while (true) {
+        int event_cnt = _epoller->wait(-1);
+        for (int i = 0; i < event_cnt; i++) {
+            int fd = _epoller->getEventFd(i);
+            if (fd == _stop_fd) {
+                return;
+            } else if (fd == _listen_fd) {
+                int client_fd;
+                while ((client_fd = accept4(_listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    _clients[client_fd];
+                    _epoller->addFd(client_fd, EPOLLIN | EPOLLRDHUP);
+                }
+            } else if (!_onReadable(fd, _clients[fd]) || (_epoller->getEvents(i) & (EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+                _epoller->delFd(fd);
+                close(fd);
+                _clients.erase(fd);
+            }
+        }
+    }
+}
+/**
+ * @description: 读取请求，执行其中所有完整的命令，应答合并后一次写回
+ * @param {int} fd
+ * @param {Client} &client
+ * @return {*} 连接需要关闭时返回 false
+ */
+bool RespStub::_onReadable(int fd, Client &client) {
+    int read_errno = 0;
+    ssize_t len    = client.in.readFd(fd, &read_errno);
+    if (len == 0 || (len < 0 && read_errno != EAGAIN)) {
+        return false;
+    }
+    RespReply request;
+    while (client.in.readableBytes() > 0) {
+        ssize_t used = Resp::parse(client.in.beginRead(), client.in.readableBytes(), &request);
+        if (used < 0) {
+            Resp::error(client.out, "ERR Protocol error");
+            client.out.writeFd(fd, &read_errno);
+            return false;
+        } else if (used == 0) {
+            break;
+        }
+        _execute(request, client.out);
+        client.in.hasRead(used);
+    }
+    /* 本地回环连接，应答量小，阻塞写出 */
+    while (client.out.readableBytes() > 0) {
+        int write_errno = 0;
+        if (client.out.writeFd(fd, &write_errno) < 0 && write_errno != EAGAIN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RespStub::_execute(const RespReply &request, Buffer &out) {
+    if (request.type != RESP_ARRAY || request.elements.empty()) {
+        Resp::error(out, "ERR Protocol error: expected array of bulk strings");
+        return;
+    }
+    for (auto &arg : request.elements) {
+        if (arg.type != RESP_STRING) {
+            Resp::error(out, "ERR Protocol error: expected bulk string");
+            return;
+        }
+    }
+    const std::vector<RespReply> &args = request.elements;
+    std::string_view cmd               = args[0].str;
+    size_t argc                        = args.size();
+    if (isCommand(cmd, "PING")) {
+        if (argc > 1) {
+            Resp::bulk(out, args[1].str);
+        } else {
+            Resp::status(out, "PONG");
+        }
+    } else if (isCommand(cmd, "ECHO") && argc == 2) {
+        Resp::bulk(out, args[1].str);
+    } else if (isCommand(cmd, "GET") && argc == 2) {
+        if (Entry *entry = _lookup(std::string(args[1].str))) {
+            Resp::bulk(out, entry->value);
+        } else {
+            Resp::nil(out);
+        }
+    } else if (isCommand(cmd, "SET") && argc >= 3) {
+        std::string key(args[1].str);
+        Clock::time_point expires;
+        bool nx = false, xx = false;
+        for (size_t i = 3; i < argc; i++) {
+            long long value;
+            if (isCommand(args[i].str, "NX")) {
+                nx = true;
+            } else if (isCommand(args[i].str, "XX")) {
+                xx = true;
+            } else if ((isCommand(args[i].str, "EX") || isCommand(args[i].str, "PX")) && i + 1 < argc &&
+                       toInteger(args[i + 1].str, &value) && value > 0) {
+                bool seconds = isCommand(args[i].str, "EX");
+                expires      = Clock::now() + std::chrono::milliseconds(seconds ? value * 1000 : value);
+                i++;
+            } else {
+                Resp::error(out, "ERR syntax error");
+                return;
+            }
+        }
+        bool exists = _lookup(key) != nullptr;
+        if ((nx && exists) || (xx && !exists)) {
+            Resp::nil(out);
+            return;
+        }
+        _data[key] = Entry{std::string(args[2].str), expires};
+        Resp::status(out, "OK");
+    } else if ((isCommand(cmd, "DEL") || isCommand(cmd, "EXISTS")) && argc >= 2) {
+        long long count = 0;
+        for (size_t i = 1; i < argc; i++) {
+            std::string key(args[i].str);
+            if (_lookup(key)) {
+                count++;
+                if (isCommand(cmd, "DEL")) {
+                    _data.erase(key);
+                }
+            }
+        }
+        Resp::integer(out, count);
+    } else if (isCommand(cmd, "EXPIRE") && argc == 3) {
+        long long seconds;
+        Entry *entry = _lookup(std::string(args[1].str));
+        if (!toInteger(args[2].str, &seconds)) {
+            Resp::error(out, "ERR value is not an integer or out of range");
+        } else if (!entry) {
+            Resp::integer(out, 0);
+        } else {
+            entry->expires = Clock::now() + std::chrono::seconds(seconds);
+            Resp::integer(out, 1);
+        }
+    } else if (isCommand(cmd, "TTL") && argc == 2) {
+        Entry *entry = _lookup(std::string(args[1].str));
+        if (!entry) {
+            Resp::integer(out, -2);
+        } else if (entry->expires == Clock::time_point()) {
+            Resp::integer(out, -1);
+        } else {
+            Resp::integer(out, std::chrono::duration_cast<std::chrono::seconds>(entry->expires - Clock::now()).count());
+        }
+    } else if (isCommand(cmd, "INCR") && argc == 2) {
+        std::string key(args[1].str);
+        Entry *entry    = _lookup(key);
+        long long value = 0;
+        if (entry && !toInteger(entry->value, &value)) {
+            Resp::error(out, "ERR value is not an integer or out of range");
+            return;
+        }
+        if (!entry) {
+            entry = &_data[key];
+        }
+        entry->value = std::to_string(++value);
+        Resp::integer(out, value);
+    } else if (isCommand(cmd, "FLUSHALL")) {
+        _data.clear();
+        Resp::status(out, "OK");
+    } else {
+        Resp::error(out, "ERR unknown command or wrong number of arguments");
+    }
+}
+/**
+ * @description: 查找未过期的键，访问时惰性删除已过期的键
+ * @param {string} &key
+ * @return {*}
+ */
+RespStub::Entry *RespStub::_lookup(const std::string &key) {
+    auto it = _data.find(key);
+    if (it == _data.end()) {
+        return nullptr;
+    }
+    if (it->second.expires != Clock::time_point() && it->second.expires <= Clock::now()) {
+        _data.erase(it);
+        return nullptr;
+    }
+    return &it->second;
+}
@@ -0,0 +1,226 @@
+/*
+ * @Description: 多进程模式的 master 实现
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 22:58:37
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 22:58:37
+ */
+#include "master.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "metrics.h"
+#include "webserver.h"
+
+Master::Master(int port, bool opt_linger, int worker_num, bool pin_cpu)
+    : _port(port)
+    , _open_linger(opt_linger)
+    , _pin_cpu(pin_cpu)
+    , _listen_fd(-1)
+    , _stopping(false)
+    , _pid(getpid())
+    , _workers(worker_num > 0 ? worker_num : 1, Worker{0, 0, 0}) {
+    sigemptyset(&_signals);
+    sigemptyset(&_old_mask);
+    if (_pin_cpu) {
+        /* 只在启动时允许的 CPU 中分配，尊重 taskset/cgroup 的限制 */
+        cpu_set_t set;
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    _cpus.push_back(cpu);
+                }
+            }
+        }
+    }
+}
+
+Master::~Master() {
+    if (_listen_fd >= 0) {
+        close(_listen_fd);
+    }
+}
+/**
+ * @description: 打开监听 socket 并启动全部 worker，直到收到 SIGTERM/SIGINT 且全部 worker 退出后返回
+ * @param {WorkerMain} &worker_main
+ * @return {*} 进程退出码
+ */
+int Master::run(const WorkerMain &worker_main) {
+    _worker_main = worker_main;
+    _listen_fd   = WebServer::createListenSocket(_port, _open_linger);
+    if (_listen_fd < 0) {
+        return 1;
+    }
+    /* 须在 fork 之前创建，worker 继承同一映射 */
+    if (!Metrics::share(_workers.size() * SLOTS_PER_WORKER)) {
+        LOG_WARN("Shared metrics unavailable, each worker reports its own counters");
+    }
+
+    sigaddset(&_signals, SIGCHLD);
+    sigaddset(&_signals, SIGTERM);
+    sigaddset(&_signals, SIGINT);
+    sigaddset(&_signals, SIGUSR1);
+    sigaddset(&_signals, SIGUSR2);
+    sigprocmask(SIG_BLOCK, &_signals, &_old_mask);
+
+    LOG_INFO("Master pid %d, port %d, %zu workers", _pid, _port, _workers.size());
+    for (size_t i = 0; i < _workers.size(); i++) {
+        _spawn(i);
+    }
+    while (!_stopping || _running() > 0) {
+        /* SIGCHLD 可能合并，每轮都回收；定时醒来以执行延迟的重启 */
+        _reap();
+        _respawn();
+        if (_stopping && _running() == 0) {
+            break;
+        }
+        struct timespec timeout = {POLL_MS / 1000, (POLL_MS % 1000) * 1000000L};
+        int signo               = sigtimedwait(&_signals, nullptr, &timeout);
+        if (signo > 0) {
+            _dealSignal(signo);
+        }
+    }
+    sigprocmask(SIG_SETMASK, &_old_mask, nullptr);
+    LOG_INFO("All workers exited");
+    return 0;
+}
+/**
+ * @description: fork 第 index 个 worker
+ * @param {int} index
+ * @return {*}
+ */
+bool Master::_spawn(int index) {
+    Worker &worker = _workers[index];
+    /* 缓冲中的日志在 fork 后会被父子进程各写一次 */
+    Logger::getInstance()->flush();
+    pid_t pid = fork();
+    if (pid < 0) {
+        LOG_ERROR("Fork worker %d error: %s", index, strerror(errno));
+        worker.respawn_ms = _nowMs() + RESPAWN_DELAY_MS;
+        return false;
+    }
+    if (pid == 0) {
+        sigprocmask(SIG_SETMASK, &_old_mask, nullptr);
+        /* master 意外退出时 worker 随之优雅退出，不留下无人看护的进程 */
+        prctl(PR_SET_PDEATHSIG, SIGTERM);
+        if (getppid() != _pid) {
+            _exit(0);
+        }
+        if (!_cpus.empty()) {
+            /* 之后创建的线程池线程继承同一绑定 */
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(_cpus[index % _cpus.size()], &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+        Metrics::afterFork();
+        WebServer::inherited_listen_fd = _listen_fd;
+        exit(_worker_main(index));
+    }
+    worker.pid      = pid;
+    worker.start_ms = _nowMs();
+    if (_cpus.empty()) {
+        LOG_INFO("Worker %d started, pid %d", index, pid);
+    } else {
+        LOG_INFO("Worker %d started, pid %d, cpu %d", index, pid, _cpus[index % _cpus.size()]);
+    }
+    return true;
+}
+/**
+ * @description: 回收已退出的 worker，释放其指标槽位并安排重启
+ * @return {*}
+ */
+void Master::_reap() {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        Metrics::release(pid);
+        for (size_t i = 0; i < _workers.size(); i++) {
+            Worker &worker = _workers[i];
+            if (worker.pid != pid) {
+                continue;
+            }
+            if (WIFSIGNALED(status)) {
+                LOG_ERROR("Worker %zu (pid %d) killed by signal %d", i, pid, WTERMSIG(status));
+            } else if (WEXITSTATUS(status) != 0 || !_stopping) {
+                LOG_WARN("Worker %zu (pid %d) exited with code %d", i, pid, WEXITSTATUS(status));
+            } else {
+                LOG_INFO("Worker %zu (pid %d) exited", i, pid);
+            }
+            uint64_t now      = _nowMs();
+            worker.pid        = 0;
+            worker.respawn_ms = now - worker.start_ms < (uint64_t)RESPAWN_DELAY_MS ? now + RESPAWN_DELAY_MS : now;
+            break;
+        }
+    }
+}
+/**
+ * @description: 重新 fork 已到重启时刻的 worker
+ * @return {*}
+ */
+void Master::_respawn() {
+    if (_stopping) {
+        return;
+    }
+    uint64_t now = _nowMs();
+    for (size_t i = 0; i < _workers.size(); i++) {
+        if (_workers[i].pid == 0 && _workers[i].respawn_ms <= now) {
+            _spawn(i);
+        }
+    }
+}
+/**
+ * @description: 处理同步取得的信号
+ * @param {int} signo
+ * @return {*}
+ */
+void Master::_dealSignal(int signo) {
+    if (signo == SIGTERM || signo == SIGINT) {
+        /* 再次收到时照常转发，worker 随即强制关闭剩余连接 */
+        LOG_INFO("Master received signal %d, stopping %d workers", signo, _running());
+        _stopping = true;
+        _signalWorkers(SIGTERM);
+    } else if (signo == SIGUSR1) {
+        std::string table;
+        Metrics::dumpLatency(table);
+        /* 日志按行写出 */
+        size_t begin = 0, end;
+        while ((end = table.find('\n', begin)) != std::string::npos) {
+            LOG_INFO("%.*s", (int)(end - begin), table.data() + begin);
+            begin = end + 1;
+        }
+    } else if (signo == SIGUSR2) {
+        LOG_WARN("Upgrade by SIGUSR2 is not supported in multi-process mode");
+    }
+}
+
+void Master::_signalWorkers(int signo) {
+    for (const Worker &worker : _workers) {
+        if (worker.pid > 0) {
+            kill(worker.pid, signo);
+        }
+    }
+}
+
+int Master::_running() const {
+    int count = 0;
+    for (const Worker &worker : _workers) {
+        count += worker.pid > 0;
+    }
+    return count;
+}
+
+uint64_t Master::_nowMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000ull + ts.tv_nsec / 1000000;
+}
@@ -4,12 +4,70 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 17:10:56
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 16:00:00
+ * @LastEditTime: 2026-10-19 23:59:58
  */
 #include "webserver.h"
 
 using namespace std;
 
+int WebServer::inherited_listen_fd = -1;
+
+/* 信号处理函数只能访问全局状态，只写入管道，其余工作交给事件循环 */
+static int signal_write_fd = -1;
+
+static void onSignal(int signo) {
+    int saved_errno = errno;
+    char byte       = static_cast<char>(signo);
+    ssize_t ret     = write(signal_write_fd, &byte, 1);
+    (void)ret;
+    errno = saved_errno;
+}
+
+/* 经 Unix socket 以 SCM_RIGHTS 传递 fd，附带一个字节的数据 */
+static bool sendFd(int sock, int fd) {
+    char byte        = 0;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control = {};
+    struct msghdr msg    = {};
+    msg.msg_iov          = &iov;
+    msg.msg_iovlen       = 1;
+    msg.msg_control      = control.buf;
+    msg.msg_controllen   = sizeof(control.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level     = SOL_SOCKET;
+    cmsg->cmsg_type      = SCM_RIGHTS;
+    cmsg->cmsg_len       = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+    return sendmsg(sock, &msg, MSG_NOSIGNAL) == 1;
+}
+
+static int recvFd(int sock) {
+    char byte        = 0;
+    struct iovec iov = {&byte, 1};
+    union {
+        struct cmsghdr hdr;
+        char buf[CMSG_SPACE(sizeof(int))];
+    } control = {};
+    struct msghdr msg  = {};
+    msg.msg_iov        = &iov;
+    msg.msg_iovlen     = 1;
+    msg.msg_control    = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+    if (recvmsg(sock, &msg, MSG_CMSG_CLOEXEC) != 1) {
+        return -1;
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+        return -1;
+    }
+    int fd;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    return fd;
+}
+
 WebServer::WebServer(
         int port, int trig_mode, int timeout_ms, bool opt_linger,
         int thread_num, bool open_log, int log_level, int log_que_size)
@@ -17,17 +75,38 @@ WebServer::WebServer(
     , _open_linger(opt_linger)
     , _timeout_ms(timeout_ms)
     , _is_close(false)
+    , _listen_fd(-1)
+    , _signal_fds{-1, -1}
+    , _draining(false)
+    , _closing_idle(false)
+    , _drain_timeout_ms(DRAIN_TIMEOUT_MS)
+    , _argv(nullptr)
+    , _upgrade_fd(-1)
+    , _upgrade_pid(-1)
+    , _handoff_fd(-1)
     , _timer(new HeapTimer())
-    , _threadpool(new ThreadPool(thread_num))
-    , _epoller(new Epoller()) {
+    , _threadpool(new ThreadPool(thread_num, true))
+    , _epoller(new Epoller())
+    , _router(new Router()) {
     _src_dir = getcwd(nullptr, 256);
     assert(_src_dir);
     strncat(_src_dir, "/resources/", 16);
     HttpConn::user_count = 0;
+    HttpConn::draining   = false;
     HttpConn::src_dir    = _src_dir;
+    HttpConn::router     = _router.get();
+
+    HttpConn::resume_handler = [this](HttpConn *client) {
+        uint32_t trace_id = client->traceId();
+        _epoller->modFd(client->getFd(), _conn_event | EPOLLOUT);
+        if (trace_id) {
+            Tracer::instant("rearm write", trace_id);
+        }
+    };
+    _initRoutes();
 
     _initEventMode(trig_mode);
-    if (!_initSocket()) {
+    if (!_initSocket() || !_initSignal()) {
         _is_close = true;
     }
 
@@ -49,10 +128,442 @@ WebServer::WebServer(
 }
 
 WebServer::~WebServer() {
-    close(_listen_fd);
+    /* 先等待工作线程执行完已入队的任务，此后不再有线程访问连接、epoll 与代理 */
+    _threadpool.reset();
+    _hash_pool.reset();
+    if (_listen_fd >= 0) {
+        close(_listen_fd);
+    }
+    if (_upgrade_fd >= 0) {
+        close(_upgrade_fd);
+    }
+    if (_handoff_fd >= 0) {
+        close(_handoff_fd);
+    }
+    if (_signal_fds[0] >= 0) {
+        signal(SIGUSR1, SIG_DFL);
+        signal(SIGUSR2, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        signal(SIGINT, SIG_DFL);
+        signal_write_fd = -1;
+        close(_signal_fds[0]);
+        close(_signal_fds[1]);
+    }
     _is_close = true;
     free(_src_dir);
 }
+/**
+ * @description: 配置请求大小限制
+ * @param {size_t} max_header_size，请求行与首部总长度上限
+ * @param {size_t} max_body_size，body 总长度上限
+ * @param {size_t} max_buffered_body，收集到内存中的 body 上限
+ * @return {*}
+ */
+void WebServer::setRequestLimits(size_t max_header_size, size_t max_body_size, size_t max_buffered_body) {
+    HttpRequest::max_header_size   = max_header_size;
+    BodyReader::max_body_size      = max_body_size;
+    HttpRequest::max_buffered_body = max_buffered_body;
+    LOG_INFO("Request limits: header %zu, body %zu, buffered %zu", max_header_size, max_body_size, max_buffered_body);
+}
+/**
+ * @description: 开启落盘上传，Content-Length 不小于 threshold 的 POST/PUT 请求 body 经 splice 写入 dir 下的临时文件，
+ *               完成后交给 handler；传输期间的超时沿用连接计时器
+ * @param {char} *dir，临时文件目录，需在服务器生命周期内有效
+ * @param {size_t} threshold
+ * @param {size_t} max_size，上传 body 上限，超过时应答 413
+ * @param {UploadHandler} handler
+ * @return {*}
+ */
+void WebServer::setUploadHandler(const char *dir, size_t threshold, size_t max_size, UploadHandler handler) {
+    assert(dir && threshold > 0 && handler);
+    HttpConn::upload_dir          = dir;
+    HttpConn::upload_handler      = std::move(handler);
+    HttpRequest::upload_threshold = threshold;
+    HttpRequest::max_upload_size  = max_size;
+    LOG_INFO("Upload: dir %s, threshold %zu, max %zu", dir, threshold, max_size);
+}
+/**
+ * @description: 注册路由，需在 start() 之前调用；未注册的路径按 resources 下的静态文件处理
+ * @param {string_view} method
+ * @param {string_view} pattern，如 "/api/users/:id"，以 '*' 开头的段匹配剩余全部路径
+ * @param {RouteHandler} handler，在工作线程中执行
+ * @param {int} cache_ttl_ms，大于 0 时 GET 请求经微缓存合并并缓存结果，需先 setMicroCache
+ * @return {*} 模式非法或重复注册时返回 false
+ */
+bool WebServer::addRoute(std::string_view method, std::string_view pattern, RouteHandler handler, int cache_ttl_ms) {
+    if (cache_ttl_ms > 0 && method == "GET") {
+        if (_cache) {
+            handler = _cache->wrap(std::move(handler), cache_ttl_ms);
+        } else {
+            LOG_WARN("Micro cache disabled, route %.*s not cached", (int)pattern.size(), pattern.data());
+        }
+    }
+    return _router->add(method, pattern, std::move(handler));
+}
+/**
+ * @description: 开启微缓存，之后以 cache_ttl_ms 注册的路由合并并发的相同 GET 请求，结果短时缓存
+ * @param {size_t} max_bytes，缓存内存预算
+ * @param {int} stale_ms，条目过期后仍以旧结果应答并在后台刷新的时长
+ * @return {*}
+ */
+void WebServer::setMicroCache(size_t max_bytes, int stale_ms) {
+    _cache.reset(new MicroCache(max_bytes, stale_ms, _threadpool.get(), _router.get()));
+    LOG_INFO("Micro cache: %zu bytes, stale %d ms", max_bytes, stale_ms);
+}
+/**
+ * @description: 开启流量采集，按连接抽样记录请求字节与时间，供 replay 回放
+ * @param {char} *path，采集文件，已存在时覆盖
+ * @param {double} sample_rate，采集的连接比例，0 ~ 1
+ * @param {size_t} max_bytes，文件大小上限，达到后停止采集
+ * @return {*}
+ */
+bool WebServer::setCapture(const char *path, double sample_rate, size_t max_bytes) {
+    std::unique_ptr<TrafficCapture> capture(new TrafficCapture(sample_rate, max_bytes));
+    if (!capture->open(path)) {
+        return false;
+    }
+    _capture          = std::move(capture);
+    HttpConn::capture = _capture.get();
+    LOG_INFO("Capture: %s, sample rate %.3f, max %zu bytes", path, sample_rate, max_bytes);
+    return true;
+}
+/**
+ * @description: 开启追踪，按连接抽样记录各处理阶段，GET /trace 导出 Chrome trace-event JSON
+ * @param {double} sample_rate，追踪的连接比例，0 ~ 1
+ * @param {size_t} spans_per_thread，每个线程保留的最近记录数
+ * @return {*}
+ */
+void WebServer::setTracing(double sample_rate, size_t spans_per_thread) {
+    Tracer::enable(sample_rate, spans_per_thread);
+    addRoute("GET", "/trace", [](const HttpRequest &, HttpResponse &response) {
+        std::string out;
+        Tracer::exportJson(out);
+        response.setContent(out, "application/json");
+    });
+    LOG_INFO("Tracing: sample rate %.3f, %zu spans per thread", sample_rate, spans_per_thread);
+}
+/**
+ * @description: 配置优雅退出。SIGTERM/SIGINT 后停止接受连接，关闭空闲的长连接，进行中的请求写完应答后关闭，
+ *               超过 drain_timeout_ms 仍未结束的连接强制关闭；再次收到 SIGTERM 时立即强制关闭。
+ *               argv 不为空时，SIGUSR2 以 argv 启动新进程并经 Unix socket 交接监听 socket，新进程开始服务后本进程优雅退出
+ * @param {int} drain_timeout_ms
+ * @param {char} **argv，main 的参数，argv[0] 为新进程的可执行文件路径，需在服务器生命周期内有效
+ * @return {*}
+ */
+void WebServer::setGracefulShutdown(int drain_timeout_ms, char **argv) {
+    assert(drain_timeout_ms > 0);
+    _drain_timeout_ms = drain_timeout_ms;
+    _argv             = argv;
+    LOG_INFO("Graceful shutdown: drain timeout %d ms, upgrade %s", drain_timeout_ms, argv ? "on" : "off");
+}
+/**
+ * @description: 注册内置路由：省略 .html 后缀的页面别名，登录与注册表单
+ * @return {*}
+ */
+void WebServer::_initRoutes() {
+    static const std::pair<std::string_view, std::string_view> PAGES[] = {
+        {"/", "/index.html"},
+        {"/index", "/index.html"},
+        {"/register", "/register.html"},
+        {"/login", "/login.html"},
+        {"/video", "/video.html"},
+        {"/picture", "/picture.html"},
+    };
+    for (auto &page : PAGES) {
+        std::string_view file = page.second;
+        addRoute("GET", page.first, [file](const HttpRequest &, HttpResponse &response) {
+            response.setPath(file);
+        });
+    }
+
+    static const std::pair<std::string_view, bool> FORMS[] = {
+        {"/register", false},
+        {"/register.html", false},
+        {"/login", true},
+        {"/login.html", true},
+    };
+    for (auto &form : FORMS) {
+        bool is_login = form.second;
+        addRoute("POST", form.first, [this, is_login](const HttpRequest &request, HttpResponse &response) {
+            _userVerify(request, response, is_login);
+        });
+    }
+
+    /* 启用会话后，欢迎页需要有效的会话 cookie，否则返回登录页 */
+    for (std::string_view path : {"/welcome", "/welcome.html"}) {
+        addRoute("GET", path, [this](const HttpRequest &request, HttpResponse &response) {
+            bool ok = !_sessions || _sessions->lookup(request.getCookie(SESSION_COOKIE), nullptr);
+            response.setPath(ok ? "/welcome.html" : "/login.html");
+        });
+    }
+    addRoute("GET", "/logout", [this](const HttpRequest &request, HttpResponse &response) {
+        if (_sessions) {
+            _sessions->remove(request.getCookie(SESSION_COOKIE));
+            response.addHeader("Set-Cookie", std::string(SESSION_COOKIE) + "=; Path=/; Max-Age=0");
+        }
+        response.setPath("/login.html");
+    });
+    addRoute("GET", "/metrics", [this](const HttpRequest &, HttpResponse &response) {
+        std::string out;
+        _scrapeMetrics(out);
+        response.setContent(out, "text/plain; version=0.0.4");
+    });
+}
+/**
+ * @description: 汇总各线程的计数，并采样连接数、队列深度等瞬时值，输出 Prometheus 文本格式
+ * @param {string} &out
+ * @return {*}
+ */
+void WebServer::_scrapeMetrics(std::string &out) const {
+    Metrics::scrape(out);
+    Metrics::appendGauge(out, "webserver_threadpool_queue_depth", "Tasks waiting for a worker thread.",
+                         _threadpool->queueSize());
+    Metrics::appendGauge(out, "webserver_log_queue_depth", "Log lines waiting for the writer thread.",
+                         Logger::getInstance()->queueSize());
+    if (_hash_pool) {
+        Metrics::appendGauge(out, "webserver_hash_pool_queue_depth", "Password hashes waiting for a hash thread.",
+                             _hash_pool->queueSize());
+    }
+    if (_sessions) {
+        Metrics::appendGauge(out, "webserver_sessions", "Live login sessions.", _sessions->size());
+    }
+    if (_cache) {
+        Metrics::appendGauge(out, "webserver_micro_cache_entries", "Entries in the micro cache.", _cache->size());
+        Metrics::appendGauge(out, "webserver_micro_cache_bytes", "Approximate micro cache memory.", _cache->bytes());
+        Metrics::appendCounter(out, "webserver_micro_cache_hits_total", "Micro cache fresh hits.", _cache->hits());
+        Metrics::appendCounter(out, "webserver_micro_cache_stale_hits_total", "Micro cache stale hits.",
+                               _cache->staleHits());
+        Metrics::appendCounter(out, "webserver_micro_cache_misses_total", "Micro cache misses.", _cache->misses());
+        Metrics::appendCounter(out, "webserver_micro_cache_coalesced_total",
+                               "Requests that waited on an identical in-flight request.", _cache->coalesced());
+    }
+}
+/**
+ * @description: 打开用户凭据存储，并创建专用于口令派生的线程池，登录高峰不占用处理静态资源的工作线程
+ * @param {char} *dir，日志与索引所在目录，不存在时创建
+ * @param {int} hash_threads
+ * @param {bool} shared，多进程模式下各 worker 同时打开同一目录，见 CredentialStore
+ * @return {*}
+ */
+bool WebServer::setCredentialStore(const char *dir, int hash_threads, bool shared) {
+    assert(hash_threads > 0);
+    _credentials.reset(new CredentialStore());
+    if (!_credentials->open(dir, shared)) {
+        _credentials.reset();
+        return false;
+    }
+    if (!_hash_pool) {
+        _hash_pool.reset(new ThreadPool(hash_threads));
+    }
+    LOG_INFO("Credential store: %s, %zu users, %d hash threads", dir, _credentials->size(), hash_threads);
+    return true;
+}
+/**
+ * @description: 将路径前缀 prefix 下的全部请求转发到一组上游，如 addProxy("/api", {"127.0.0.1:8080"})。
+ *               转发的请求 body 原样保留，不做表单解析，大小受 max_buffered_body 限制
+ * @param {string_view} prefix，以 '/' 开头，匹配 prefix 本身及其下的全部路径
+ * @param {vector<string>} &upstreams，"ip:port" 列表
+ * @param {BALANCE} balance
+ * @param {size_t} max_conns，每个上游的长连接数上限
+ * @param {int} cache_ttl_ms，大于 0 时 GET 应答经微缓存合并与缓存，见 addRoute
+ * @return {*}
+ */
+bool WebServer::addProxy(std::string_view prefix, const std::vector<std::string> &upstreams,
+                         ReverseProxy::BALANCE balance, size_t max_conns, int cache_ttl_ms) {
+    while (prefix.size() > 1 && prefix.back() == '/') {
+        prefix.remove_suffix(1);
+    }
+    if (prefix.empty() || prefix[0] != '/') {
+        return false;
+    }
+    if (!_proxy) {
+        _proxy.reset(new ReverseProxy());
+        if (!_proxy->init(_epoller.get(), _conn_event)) {
+            _proxy.reset();
+            return false;
+        }
+        _proxy->setActivityHandler([this](int fd) { _extentTime(&_users[fd]); });
+        HttpRequest::raw_body_filter = [this](std::string_view path) { return _isProxied(path); };
+    }
+    int group = _proxy->addGroup(upstreams, balance, max_conns);
+    if (group < 0) {
+        return false;
+    }
+    static const char *METHODS[] = {"GET", "HEAD", "POST", "PUT", "DELETE", "PATCH", "OPTIONS"};
+    std::string wildcard = std::string(prefix == "/" ? "" : prefix) + "/*path";
+    for (const char *method : METHODS) {
+        auto handler = [this, group](const HttpRequest &request, HttpResponse &response) {
+            _proxy->forward(group, request, response);
+        };
+        if ((prefix != "/" && !addRoute(method, prefix, handler, cache_ttl_ms)) ||
+            !addRoute(method, wildcard, handler, cache_ttl_ms)) {
+            return false;
+        }
+    }
+    _proxy_prefixes.emplace_back(prefix);
+    LOG_INFO("Proxy %.*s -> %zu upstreams, %s", (int)prefix.size(), prefix.data(), upstreams.size(),
+             balance == ReverseProxy::ROUND_ROBIN ? "round robin" : "least outstanding");
+    return true;
+}
+/**
+ * @description: 路径是否属于某个转发前缀
+ * @param {string_view} path
+ * @return {*}
+ */
+bool WebServer::_isProxied(std::string_view path) const {
+    for (auto &prefix : _proxy_prefixes) {
+        if (prefix == "/" || (path.substr(0, prefix.size()) == prefix &&
+                              (path.size() == prefix.size() || path[prefix.size()] == '/'))) {
+            return true;
+        }
+    }
+    return false;
+}
+/**
+ * @description: 启用内存会话，登录或注册成功后下发会话 cookie。过期清理由服务器计时器周期触发
+ * @param {size_t} shard_num，分片数，取工作线程数的数倍可使查询几乎不竞争
+ * @param {int} ttl_ms，会话空闲超时
+ * @param {size_t} max_bytes，会话内存预算，超出时淘汰最久未访问的会话
+ * @return {*}
+ */
+void WebServer::setSessionStore(size_t shard_num, int ttl_ms, size_t max_bytes) {
+    _sessions.reset(new SessionStore(shard_num, ttl_ms, max_bytes));
+    _timer->add(SESSION_TIMER, std::min(ttl_ms, SESSION_SWEEP_MS), [this] { _sweepSessions(); });
+    LOG_INFO("Session store: %zu shards, ttl %d ms, budget %zu bytes", shard_num, ttl_ms, max_bytes);
+}
+/**
+ * @description: 清理过期会话并重新登记下一次清理
+ * @return {*}
+ */
+void WebServer::_sweepSessions() {
+    size_t removed = _sessions->expire();
+    if (removed > 0) {
+        LOG_DEBUG("Sessions expired: %zu, alive: %zu, %zu bytes", removed, _sessions->size(), _sessions->bytes());
+    }
+    _timer->add(SESSION_TIMER, std::min(_sessions->ttl(), SESSION_SWEEP_MS), [this] { _sweepSessions(); });
+}
+/**
+ * @description: 登录或注册完成，先认领应答，成功时创建会话并设置 cookie，随后发出应答。可在任意线程调用
+ * @param {HttpResponse} *resp
+ * @param {uint32_t} token，defer 之后取得，连接已关闭时认领失败，结果丢弃
+ * @param {string} &name
+ * @param {bool} ok
+ * @return {*}
+ */
+void WebServer::_finishLogin(HttpResponse *resp, uint32_t token, const std::string &name, bool ok) {
+    if (!resp->claim(token)) {
+        LOG_DEBUG("Login %s: connection closed", name.c_str());
+        return;
+    }
+    if (ok && _sessions) {
+        std::string id = _sessions->create(name);
+        if (!id.empty()) {
+            resp->addHeader("Set-Cookie", std::string(SESSION_COOKIE) + "=" + id + "; Path=/; HttpOnly; SameSite=Lax");
+        }
+    }
+    resp->setPath(ok ? "/welcome.html" : "/error.html");
+    resp->resume();
+}
+/**
+ * @description: 用户凭据改由 RESP 后端(redis 或兼容的缓存)提供，键为 "user:用户名"，优先于本地凭据存储。
+ *               连接注册在服务器事件循环中，并发的登录查询在同一连接上流水线发送
+ * @param {char} *host，IPv4 地址；为 nullptr 时启动进程内的 RESP 桩并连接到它
+ * @param {int} port
+ * @param {size_t} conn_num
+ * @param {int} hash_threads，口令线程池数量，已由 setCredentialStore 创建时忽略
+ * @return {*}
+ */
+bool WebServer::setRedis(const char *host, int port, size_t conn_num, int hash_threads) {
+    assert(conn_num > 0 && hash_threads > 0);
+    if (!host) {
+        _redis_stub.reset(new RespStub());
+        if (!_redis_stub->start(port)) {
+            _redis_stub.reset();
+            return false;
+        }
+        host = "127.0.0.1";
+        port = _redis_stub->port();
+    }
+    _redis.reset(new RedisPool());
+    if (!_redis->init(_epoller.get(), host, port, conn_num)) {
+        _redis.reset();
+        return false;
+    }
+    if (!_hash_pool) {
+        _hash_pool.reset(new ThreadPool(hash_threads));
+    }
+    return true;
+}
+/**
+ * @description: 登录或注册。口令派生耗时数毫秒，请求延后到口令线程池中完成，结果就绪后再发出应答
+ * @param {HttpRequest} &request
+ * @param {HttpResponse} &response
+ * @param {bool} is_login
+ * @return {*}
+ */
+void WebServer::_userVerify(const HttpRequest &request, HttpResponse &response, bool is_login) {
+    /* name、pwd 指向请求缓冲区，只在本调用期间有效 */
+    std::string_view name = request.getPost("username");
+    std::string_view pwd  = request.getPost("password");
+    HttpResponse *resp    = &response;
+    if (_redis) {
+        if (name.empty() || pwd.empty()) {
+            response.setPath("/error.html");
+            return;
+        }
+        response.defer([this, name = std::string(name), pwd = std::string(pwd), is_login, resp] {
+            _redisVerify(name, pwd, is_login, resp, resp->deferToken());
+        });
+        return;
+    }
+    if (!_credentials) {
+        LOG_WARN("Credential store not configured");
+        response.setPath("/error.html");
+        return;
+    }
+    /* 连接可能在校验期间关闭并被复用，任务持有副本 */
+    response.defer([this, name = std::string(name), pwd = std::string(pwd), is_login, resp] {
+        uint32_t token = resp->deferToken();
+        _hash_pool->addTask([this, name, pwd, is_login, resp, token] {
+            CredentialStore::RESULT ret = is_login ? _credentials->verify(name, pwd) : _credentials->add(name, pwd);
+            LOG_DEBUG("%s %s: %d", is_login ? "Login" : "Register", name.c_str(), ret);
+            _finishLogin(resp, token, name, ret == CredentialStore::OK);
+        });
+    });
+}
+/**
+ * @description: 经 RESP 后端登录或注册。登录先 GET 凭据再在口令线程池中校验；注册先派生口令再 SET NX，
+ *               应答回调在事件循环线程中执行，只做转交
+ * @param {string} &name
+ * @param {string} &pwd
+ * @param {bool} is_login
+ * @param {HttpResponse} *resp
+ * @param {uint32_t} token，见 _finishLogin
+ * @return {*}
+ */
+void WebServer::_redisVerify(const std::string &name, const std::string &pwd, bool is_login, HttpResponse *resp,
+                             uint32_t token) {
+    std::string key = "user:" + name;
+    if (is_login) {
+        _redis->command({"GET", key}, [this, name, pwd, resp, token](const RespReply &reply) {
+            std::string encoded(reply.type == RESP_STRING ? reply.str : std::string_view());
+            _hash_pool->addTask([this, name, pwd, resp, token, encoded = std::move(encoded)] {
+                _finishLogin(resp, token, name, CredentialStore::checkPassword(encoded, pwd));
+            });
+        });
+        return;
+    }
+    _hash_pool->addTask([this, name, pwd, resp, token, key = std::move(key)] {
+        std::string encoded = CredentialStore::encodePassword(pwd);
+        if (encoded.empty()) {
+            _finishLogin(resp, token, name, false);
+            return;
+        }
+        _redis->command({"SET", key, encoded, "NX"}, [this, name, resp, token](const RespReply &reply) {
+            _finishLogin(resp, token, name, reply.type == RESP_STATUS);
+        });
+    });
+}
 /**
  * @description: 初始化事件触发模式
  * @param {int} trig_mode
@@ -89,12 +600,32 @@ void WebServer::start() {
     int time_ms = -1; /* epoll wait timeout == -1 无事件将阻塞 */
     if (!_is_close) {
         LOG_INFO("========== Server start ==========");
+        if (Tracer::enabled()) {
+            Tracer::nameThread("event loop");
+        }
+        if (_handoff_fd >= 0) {
+            /* 由旧进程启动：通知其已开始服务，旧进程随即优雅退出 */
+            char ready  = 1;
+            ssize_t ret = write(_handoff_fd, &ready, 1);
+            (void)ret;
+            close(_handoff_fd);
+            _handoff_fd = -1;
+        }
     }
     while (!_is_close) {
+        if (_draining && HttpConn::user_count == 0) {
+            LOG_INFO("All connections drained");
+            break;
+        }
         /* 消费任务并获取下一计时器间隔时间 */
-        if (_timeout_ms > 0) {
+        if (_timeout_ms > 0 || _sessions || _draining) {
             time_ms = _timer->getNextTick();
         }
+        /* 连接在工作线程中关闭，不会唤醒事件循环，优雅退出期间定期检查 */
+        if (_draining && (time_ms < 0 || time_ms > DRAIN_POLL_MS)) {
+            time_ms = DRAIN_POLL_MS;
+        }
+        Metrics::set(Metrics::TIMER_HEAP, _timer->size());
         int event_cnt = _epoller->wait(time_ms);
         for (int i = 0; i < event_cnt; i++) {
             /* 处理事件 */
@@ -104,17 +635,33 @@ void WebServer::start() {
             if (fd == _listen_fd) {
                 _dealListen();
             }
-            /* 情况2：连接关闭 */
-            else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+            /* 信号：SIGUSR1 输出各阶段耗时，SIGTERM/SIGINT 优雅退出，SIGUSR2 交接给新进程 */
+            else if (fd == _signal_fds[0]) {
+                _dealSignal();
+            }
+            /* 新进程开始服务，或启动失败 */
+            else if (fd == _upgrade_fd) {
+                _dealUpgrade();
+            }
+            /* 情况2：RESP 连接池的连接、唤醒与健康检查事件 */
+            else if (_redis && _redis->handleEvent(fd, events)) {
+            }
+            /* 情况3：反向代理的上游连接，以及转发中等待可写的客户端连接 */
+            else if (_proxy && _proxy->handleEvent(fd, events)) {
+            }
+            /* 情况4：连接关闭；优雅退出时读端由本端关闭，交给读任务先应答已到达的请求 */
+            else if (events & (EPOLLHUP | EPOLLERR) || (events & EPOLLRDHUP && !_draining)) {
                 assert(_users.count(fd) > 0);
+                /* 收到事件说明持有者已重新注册，连接交还事件循环 */
+                _users[fd].setDispatched(false);
                 _closeConn(&_users[fd]);
             }
-            /* 情况3：读事件 */
+            /* 情况5：读事件 */
             else if (events & EPOLLIN) {
                 assert(_users.count(fd) > 0);
                 _dealRead(&_users[fd]);
             }
-            /* 情况4：写事件 */
+            /* 情况6：写事件 */
             else if (events & EPOLLOUT) {
                 assert(_users.count(fd) > 0);
                 _dealWrite(&_users[fd]);
@@ -125,6 +672,9 @@ void WebServer::start() {
             }
         }
     }
+    if (_draining) {
+        LOG_INFO("========== Server stop ==========");
+    }
 }
 /**
  * @description: 连接异常，发送错误消息并关闭连接
@@ -140,7 +690,7 @@ void WebServer::_sendError(int fd, const char *info) {
     close(fd);
 }
 /**
- * @description: 关闭客户端连接
+ * @description: 关闭客户端连接，由当前持有连接的线程调用
  * @param {HttpConn*} client
  * @return {*}
  */
@@ -150,6 +700,31 @@ void WebServer::_closeConn(HttpConn *client) {
     _epoller->delFd(client->getFd());
     client->disconn();
 }
+/**
+ * @description: 事件循环主动关闭连接(超时、强制退出)。连接可能已派发给工作线程或应答延后中：
+ *               可撤销的延后应答撤销后直接关闭；否则只关闭 socket，由持有者读写失败时关闭，或重新注册事件后经 EPOLLHUP 关闭
+ * @param {HttpConn*} client
+ * @return {*}
+ */
+void WebServer::_requestClose(HttpConn *client) {
+    assert(client);
+    /* 工作线程关闭连接时不移除计时器，此后 fd 可能已被代理的上游连接复用 */
+    if (client->isClosed()) {
+        return;
+    }
+    if (client->isDispatched()) {
+        if (client->cancelDeferred() != HttpResponse::CANCELLED) {
+            LOG_DEBUG("Client[%d] busy, shutdown", client->getFd());
+            shutdown(client->getFd(), SHUT_RDWR);
+            return;
+        }
+        /* 撤销后转发过程不再 resume，丢弃进行中的请求 */
+        if (_proxy) {
+            _proxy->abort(client->getFd());
+        }
+    }
+    _closeConn(client);
+}
 /**
  * @description: 将就绪的文件描述符，添加到监听队列中
  * @param {int} fd
@@ -160,7 +735,8 @@ void WebServer::_addClient(int fd, sockaddr_in addr) {
     assert(fd > 0);
     _users[fd].init(fd, addr);
     if (_timeout_ms > 0) {
-        _timer->add(fd, _timeout_ms, std::bind(&WebServer::_closeConn, this, &_users[fd]));
+        HttpConn *client = &_users[fd];
+        _timer->add(fd, _timeout_ms, [this, client] { _requestClose(client); });
     }
     _epoller->addFd(fd, EPOLLIN | _conn_event);
     _setFdNonblock(fd);
@@ -179,6 +755,7 @@ void WebServer::_dealListen() {
             return;
         } else if (HttpConn::user_count >= MAX_FD) {
             _sendError(fd, "Server busy!");
+            Metrics::add(Metrics::CONN_REJECTED);
             LOG_WARN("Clients is full!");
             return;
         }
@@ -193,7 +770,15 @@ void WebServer::_dealListen() {
 void WebServer::_dealRead(HttpConn *client) {
     assert(client);
     _extentTime(client);
-    _threadpool->addTask(std::bind(&WebServer::_onRead, this, client));
+    client->setDispatched(true);
+    if (client->traceId()) {
+        uint64_t queued = Metrics::now();
+        Tracer::instant("enqueue read", client->traceId());
+        _threadpool->addTask([this, client, queued] { _onTracedRead(client, queued); });
+        return;
+    }
+    /* lambda 仅捕获两个指针，可放入 std::function 的内联存储，避免每次投递任务的堆分配 */
+    _threadpool->addTask([this, client] { _onRead(client); });
 }
 /**
  * @description: 写事件处理函数，新增写任务到任务队列
@@ -203,7 +788,14 @@ void WebServer::_dealRead(HttpConn *client) {
 void WebServer::_dealWrite(HttpConn *client) {
     assert(client);
     _extentTime(client);
-    _threadpool->addTask(std::bind(&WebServer::_onWrite, this, client));
+    client->setDispatched(true);
+    if (client->traceId()) {
+        uint64_t queued = Metrics::now();
+        Tracer::instant("enqueue write", client->traceId());
+        _threadpool->addTask([this, client, queued] { _onTracedWrite(client, queued); });
+        return;
+    }
+    _threadpool->addTask([this, client] { _onWrite(client); });
 }
 /**
  * @description: 延长活跃客户端的计时器阻塞时间
@@ -227,21 +819,64 @@ void WebServer::_onRead(HttpConn *client) {
     int read_errno = 0;
     ret            = client->read(&read_errno);
     if (ret <= 0 && read_errno != EAGAIN) {
-        _closeConn(client);
-        return;
+        /* 优雅退出时关闭了空闲连接的读端，关闭前已到达的请求仍然应答，应答带 Connection: close */
+        if (!HttpConn::draining || ret < 0 || client->readableBytes() == 0) {
+            _closeConn(client);
+            return;
+        }
     }
     _onProcess(client);
 }
+/**
+ * @description: 被追踪连接的读任务，额外记录排队与处理耗时；任务结束后连接可能已交还事件循环，只使用预先取得的编号
+ * @param {HttpConn*} client
+ * @param {uint64_t} queued_ns，投递任务的时刻
+ * @return {*}
+ */
+void WebServer::_onTracedRead(HttpConn *client, uint64_t queued_ns) {
+    uint32_t id    = client->traceId();
+    uint64_t start = Metrics::now();
+    Tracer::span("queue", id, queued_ns, start);
+    _onRead(client);
+    Tracer::span("onRead", id, start, Metrics::now());
+}
+/**
+ * @description: 被追踪连接的写任务
+ * @param {HttpConn*} client
+ * @param {uint64_t} queued_ns，投递任务的时刻
+ * @return {*}
+ */
+void WebServer::_onTracedWrite(HttpConn *client, uint64_t queued_ns) {
+    uint32_t id    = client->traceId();
+    uint64_t start = Metrics::now();
+    Tracer::span("queue", id, queued_ns, start);
+    _onWrite(client);
+    Tracer::span("onWrite", id, start, Metrics::now());
+}
 /**
  * @description: todo
  * @param {HttpConn*} client
  * @return {*}
  */
 void WebServer::_onProcess(HttpConn *client) {
+    /* 重新注册事件后连接归事件循环所有，追踪编号须事先取得 */
+    uint32_t trace_id = client->traceId();
     if (client->process()) {
         _epoller->modFd(client->getFd(), _conn_event | EPOLLOUT);
+        if (trace_id) {
+            Tracer::instant("rearm write", trace_id);
+        }
+    } else if (client->isDeferred()) {
+        /* 应答由延后的任务完成后注册写事件，此后本线程不再访问 client */
+        client->runDeferred();
+    } else if (_closing_idle && client->isIdle()) {
+        /* 优雅退出中，应答已写完的长连接不再等待下一请求 */
+        _closeConn(client);
     } else {
         _epoller->modFd(client->getFd(), _conn_event | EPOLLIN);
+        if (trace_id) {
+            Tracer::instant("rearm read", trace_id);
+        }
     }
 }
 /**
@@ -263,7 +898,11 @@ void WebServer::_onWrite(HttpConn *client) {
     } else if (ret < 0) {
         if (write_errno == EAGAIN) {
             /* 继续传输 */
+            uint32_t trace_id = client->traceId();
             _epoller->modFd(client->getFd(), _conn_event | EPOLLOUT);
+            if (trace_id) {
+                Tracer::instant("rearm write", trace_id);
+            }
             return;
         }
     }
@@ -274,70 +913,311 @@ void WebServer::_onWrite(HttpConn *client) {
  * @return {*}
  */
 bool WebServer::_initSocket() {
+    const char *handoff = getenv(HANDOFF_ENV);
+    if (handoff) {
+        return _inheritListenFd(atoi(handoff));
+    }
+    if (inherited_listen_fd >= 0) {
+        /* 多进程模式：各 worker 共享 master 打开的监听 socket，每个连接只唤醒其中一个进程 */
+        return _useListenFd(inherited_listen_fd, true);
+    }
+    int fd = createListenSocket(_port, _open_linger);
+    return fd >= 0 && _useListenFd(fd, false);
+}
+/**
+ * @description: 创建、绑定并监听端口
+ * @param {int} port
+ * @param {bool} opt_linger，关闭连接时等待剩余数据发送完毕
+ * @return {*} 失败时返回 -1
+ */
+int WebServer::createListenSocket(int port, bool opt_linger) {
     int ret;
     struct sockaddr_in addr;
-    if (_port > 65535 || _port < 1024) {
-        LOG_ERROR("Port:%d error!", _port);
-        return false;
+    if (port > 65535 || port < 1024) {
+        LOG_ERROR("Port:%d error!", port);
+        return -1;
     }
     addr.sin_family      = AF_INET;
     addr.sin_addr.s_addr = htonl(INADDR_ANY);
-    addr.sin_port        = htons(_port);
+    addr.sin_port        = htons(port);
 
-    struct linger opt_linger = {0};
-    if (_open_linger) {
+    struct linger linger = {0};
+    if (opt_linger) {
         /* 优雅关闭: 直到所剩数据发送完毕或超时 */
-        opt_linger.l_onoff  = 1;
-        opt_linger.l_linger = 1;
+        linger.l_onoff  = 1;
+        linger.l_linger = 1;
     }
-    /* 创建socket */
-    _listen_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (_listen_fd < 0) {
-        LOG_ERROR("Create socket error!", _port);
-        return false;
+    /* 创建socket，升级时经 SCM_RIGHTS 显式交接，不随 exec 继承 */
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        LOG_ERROR("Create socket error!", port);
+        return -1;
     }
     /* socket 配置 */
-    ret = setsockopt(_listen_fd, SOL_SOCKET, SO_LINGER, &opt_linger, sizeof(opt_linger));
+    ret = setsockopt(fd, SOL_SOCKET, SO_LINGER, &linger, sizeof(linger));
     if (ret < 0) {
-        close(_listen_fd);
-        LOG_ERROR("Init linger error!", _port);
-        return false;
+        close(fd);
+        LOG_ERROR("Init linger error!", port);
+        return -1;
     }
 
     int opt_val = 1;
     /* 端口复用 */
     /* 只有最后一个套接字会正常接收数据。 */
-    ret = setsockopt(_listen_fd, SOL_SOCKET, SO_REUSEADDR, (const void *)&opt_val, sizeof(int));
+    ret = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, (const void *)&opt_val, sizeof(int));
     if (ret == -1) {
         LOG_ERROR("set socket setsockopt error !");
-        close(_listen_fd);
-        return false;
+        close(fd);
+        return -1;
     }
     /* 端口绑定 */
-    ret = bind(_listen_fd, (struct sockaddr *)&addr, sizeof(addr));
+    ret = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
     if (ret < 0) {
-        LOG_ERROR("Bind Port:%d error!", _port);
-        close(_listen_fd);
-        return false;
+        LOG_ERROR("Bind Port:%d error!", port);
+        close(fd);
+        return -1;
     }
-    /* 被动监听，并配置accept队列 */
-    ret = listen(_listen_fd, 6);
+    /* 被动监听，并配置accept队列；优雅退出时长连接集中重连，队列过短会丢弃 SYN，客户端等待重传数秒 */
+    ret = listen(fd, SOMAXCONN);
     if (ret < 0) {
-        LOG_ERROR("Listen port:%d error!", _port);
-        close(_listen_fd);
-        return false;
+        LOG_ERROR("Listen port:%d error!", port);
+        close(fd);
+        return -1;
     }
-    /* 新增连接，监听读事件 */
-    ret = _epoller->addFd(_listen_fd, _listen_event | EPOLLIN);
-    if (ret == 0) {
+    _setFdNonblock(fd);
+    return fd;
+}
+/**
+ * @description: 将已在监听的 socket 加入事件循环
+ * @param {int} fd
+ * @param {bool} exclusive，与其他进程共享时以 EPOLLEXCLUSIVE 注册，其不能与 EPOLLRDHUP 同用
+ * @return {*}
+ */
+bool WebServer::_useListenFd(int fd, bool exclusive) {
+    uint32_t events = exclusive ? (_listen_event & ~EPOLLRDHUP) | EPOLLEXCLUSIVE : _listen_event;
+    if (_epoller->addFd(fd, events | EPOLLIN) == 0) {
         LOG_ERROR("Add listen error!");
-        close(_listen_fd);
+        close(fd);
         return false;
     }
+    _listen_fd = fd;
     _setFdNonblock(_listen_fd);
     LOG_INFO("Server port:%d", _port);
     return true;
 }
+/**
+ * @description: 由旧进程启动时，从交接用的 socket 取得监听 socket，不再重新绑定端口
+ * @param {int} handoff_fd
+ * @return {*}
+ */
+bool WebServer::_inheritListenFd(int handoff_fd) {
+    unsetenv(HANDOFF_ENV);
+    fcntl(handoff_fd, F_SETFD, FD_CLOEXEC);
+    _handoff_fd = handoff_fd;
+    int fd      = recvFd(handoff_fd);
+    if (fd < 0) {
+        LOG_ERROR("Receive listen socket error!");
+        return false;
+    }
+    LOG_INFO("Listen socket inherited");
+    return _useListenFd(fd, false);
+}
+/**
+ * @description: 初始化信号管道，信号经管道转为事件循环中的读事件处理
+ * @return {*}
+ */
+bool WebServer::_initSignal() {
+    if (pipe2(_signal_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        LOG_ERROR("Create signal pipe error!");
+        return false;
+    }
+    if (_epoller->addFd(_signal_fds[0], EPOLLIN) == 0) {
+        LOG_ERROR("Add signal pipe error!");
+        close(_signal_fds[0]);
+        close(_signal_fds[1]);
+        _signal_fds[0] = _signal_fds[1] = -1;
+        return false;
+    }
+    signal_write_fd = _signal_fds[1];
+
+    struct sigaction act = {};
+    act.sa_handler       = onSignal;
+    act.sa_flags         = SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    sigaction(SIGUSR1, &act, nullptr);
+    sigaction(SIGUSR2, &act, nullptr);
+    /* 正常返回 main 才会执行析构与 atexit，PGO 插桩版本依赖它写出 profile */
+    sigaction(SIGTERM, &act, nullptr);
+    sigaction(SIGINT, &act, nullptr);
+    /* 已被 shutdown 或对端关闭的连接写出时返回 EPIPE */
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+}
+/**
+ * @description: 处理管道中积累的信号
+ * @return {*}
+ */
+void WebServer::_dealSignal() {
+    char signals[64];
+    ssize_t len;
+    while ((len = read(_signal_fds[0], signals, sizeof(signals))) > 0) {
+        for (ssize_t i = 0; i < len; i++) {
+            if (signals[i] == SIGUSR1) {
+                std::string table;
+                Metrics::dumpLatency(table);
+                /* 日志按行写出 */
+                size_t begin = 0, end;
+                while ((end = table.find('\n', begin)) != std::string::npos) {
+                    LOG_INFO("%.*s", (int)(end - begin), table.data() + begin);
+                    begin = end + 1;
+                }
+            } else if (signals[i] == SIGTERM || signals[i] == SIGINT) {
+                _beginDrain();
+            } else if (signals[i] == SIGUSR2) {
+                _upgrade();
+            }
+        }
+    }
+}
+/**
+ * @description: 开始优雅退出：关闭监听 socket，此后的应答均带 Connection: close，写完即关闭连接；
+ *               空闲的长连接稍后关闭，截止时间到达时强制关闭全部连接。已在优雅退出中时立即强制关闭
+ * @return {*}
+ */
+void WebServer::_beginDrain() {
+    if (_draining) {
+        LOG_WARN("Drain interrupted, closing %d connections", (int)HttpConn::user_count);
+        _forceClose();
+        return;
+    }
+    _draining          = true;
+    HttpConn::draining = true;
+    if (_listen_fd >= 0) {
+        _epoller->delFd(_listen_fd);
+        close(_listen_fd);
+        _listen_fd = -1;
+    }
+    /* 空闲连接的客户端可能正在发送下一请求，留出一段时间使其收到带 Connection: close 的应答，避免请求被丢弃 */
+    _timer->add(DRAIN_IDLE_TIMER, std::min(DRAIN_IDLE_MS, _drain_timeout_ms), [this] { _closeIdle(); });
+    _timer->add(DRAIN_TIMER, _drain_timeout_ms, [this] {
+        LOG_WARN("Drain timeout, closing %d connections", (int)HttpConn::user_count);
+        _forceClose();
+    });
+    LOG_INFO("Draining %d connections, timeout %d ms", (int)HttpConn::user_count, _drain_timeout_ms);
+}
+/**
+ * @description: 关闭空闲的长连接。连接可能刚被派发给工作线程，不在事件循环中直接关闭，
+ *               而是关闭读端，以 EPOLLRDHUP 经读任务关闭；此后变为空闲的连接由工作线程关闭
+ * @return {*}
+ */
+void WebServer::_closeIdle() {
+    /* 先置位再检查各连接是否空闲，与工作线程先置空闲再检查 _closing_idle 的顺序配合，两者至少有一方看到对方的写入 */
+    _closing_idle = true;
+    int idle      = 0;
+    for (auto &user : _users) {
+        HttpConn &client = user.second;
+        if (!client.isClosed() && client.isIdle()) {
+            shutdown(client.getFd(), SHUT_RD);
+            idle++;
+        }
+    }
+    LOG_INFO("Closing %d idle connections, %d remain", idle, (int)HttpConn::user_count);
+}
+/**
+ * @description: 关闭全部连接并退出主循环。工作线程或完成方持有的连接只关闭 socket，由持有者关闭，
+ *               析构时先等待工作线程结束，剩余的连接随 _users 关闭
+ * @return {*}
+ */
+void WebServer::_forceClose() {
+    for (auto &user : _users) {
+        _requestClose(&user.second);
+    }
+    _is_close = true;
+}
+/**
+ * @description: 以 _argv 启动新进程，经 socketpair 以 SCM_RIGHTS 交接监听 socket；
+ *               新进程开始服务后回写一个字节，本进程随即优雅退出；新进程启动失败时本进程继续服务
+ * @return {*}
+ */
+void WebServer::_upgrade() {
+    if (!_argv) {
+        LOG_WARN("Upgrade is not enabled");
+        return;
+    }
+    if (_draining || _upgrade_fd >= 0 || _listen_fd < 0) {
+        LOG_WARN("Upgrade ignored, already upgrading or draining");
+        return;
+    }
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) < 0) {
+        LOG_ERROR("Create upgrade socket error!");
+        return;
+    }
+    /* fork 后的子进程只能调用异步信号安全的函数，环境变量事先准备好 */
+    std::string handoff = std::string(HANDOFF_ENV) + "=" + std::to_string(HANDOFF_FD);
+    std::vector<char *> envp;
+    for (char **env = environ; *env; env++) {
+        if (strncmp(*env, handoff.data(), strlen(HANDOFF_ENV) + 1) != 0) {
+            envp.push_back(*env);
+        }
+    }
+    envp.push_back(&handoff[0]);
+    envp.push_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        /* 只保留标准输入输出与交接用的 socket，客户端连接等其余 fd 不带入新进程 */
+        if (fds[1] == HANDOFF_FD) {
+            fcntl(HANDOFF_FD, F_SETFD, 0);
+        } else {
+            dup2(fds[1], HANDOFF_FD);
+        }
+        if (close_range(HANDOFF_FD + 1, ~0U, 0) < 0) {
+            for (int fd = HANDOFF_FD + 1; fd < MAX_FD; fd++) {
+                close(fd);
+            }
+        }
+        execve(_argv[0], _argv, envp.data());
+        _exit(127);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        LOG_ERROR("Fork upgrade process error!");
+        close(fds[0]);
+        return;
+    }
+    if (!sendFd(fds[0], _listen_fd) || _epoller->addFd(fds[0], EPOLLIN) == 0) {
+        LOG_ERROR("Hand off listen socket to process %d error!", pid);
+        close(fds[0]);
+        kill(pid, SIGKILL);
+        waitpid(pid, nullptr, 0);
+        return;
+    }
+    _upgrade_fd  = fds[0];
+    _upgrade_pid = pid;
+    LOG_INFO("Upgrade: started process %d (%s)", pid, _argv[0]);
+}
+/**
+ * @description: 新进程回写表示已开始服务，读到 EOF 表示其在开始服务前退出
+ * @return {*}
+ */
+void WebServer::_dealUpgrade() {
+    char ready  = 0;
+    ssize_t len = read(_upgrade_fd, &ready, 1);
+    _epoller->delFd(_upgrade_fd);
+    close(_upgrade_fd);
+    _upgrade_fd = -1;
+    if (len == 1) {
+        LOG_INFO("Upgrade: process %d is serving", _upgrade_pid);
+        _beginDrain();
+    } else {
+        int status = 0;
+        waitpid(_upgrade_pid, &status, 0);
+        LOG_ERROR("Upgrade: process %d exited before serving, %s %d", _upgrade_pid,
+                  WIFEXITED(status) ? "exit code" : "signal", WIFEXITED(status) ? WEXITSTATUS(status) : WTERMSIG(status));
+    }
+    _upgrade_pid = -1;
+}
 /**
  * @description: 设置文件为非阻塞模式，避免accept、read阻塞主线程
  * @param {int} fd
@@ -4,32 +4,50 @@
  * @version: 1.0.1
  * @Date: 2025-05-20 17:55:47
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:53:37
+ * @LastEditTime: 2026-10-19 22:12:45
  */
 #include "threadpool.h"
 
-ThreadPool::ThreadPool(size_t thread_count)
+ThreadPool::ThreadPool(size_t thread_count, bool timed)
     : _pool(std::make_shared<Pool>()) {
     assert(thread_count > 0);
+    _pool->timed = timed;
     for (size_t i = 0; i < thread_count; i++) {
-        std::thread([=] {
-            std::unique_lock<std::mutex> locker(_pool->mtx);
+        /* 只持有共享的 Pool，ThreadPool 被移动后工作线程不受影响 */
+        _threads.emplace_back([pool = _pool] {
+            std::unique_lock<std::mutex> locker(pool->mtx);
             while (true) {
-                if (!_pool->tasks.empty()) {
-                    auto task = std::move(_pool->tasks.front());
-                    _pool->tasks.pop();
+                if (!pool->tasks.empty()) {
+                    auto task = std::move(pool->tasks.front());
+                    pool->tasks.pop();
+                    PROBE2(task_dequeue, task.enqueued_ns, pool->tasks.size());
                     locker.unlock();
-                    task();
+                    if (task.enqueued_ns) {
+                        Metrics::since(Metrics::STAGE_QUEUE, task.enqueued_ns);
+                    }
+                    task.fn();
                     locker.lock();
-                } else if (_pool->is_closed)
+                } else if (pool->is_closed)
                     break;
                 else
-                    _pool->cond.wait(locker);
+                    pool->cond.wait(locker);
             }
-        }).detach();
+        });
     }
 }
 
+/**
+ * @description: 排队等待执行的任务数
+ * @return {*}
+ */
+size_t ThreadPool::queueSize() const {
+    if (!_pool) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> locker(_pool->mtx);
+    return _pool->tasks.size();
+}
+
 ThreadPool::~ThreadPool() {
     if (_pool) {
         {
@@ -38,4 +56,7 @@ ThreadPool::~ThreadPool() {
         }
         _pool->cond.notify_all();
     }
+    for (auto &thread : _threads) {
+        thread.join();
+    }
 }
\ No newline at end of file
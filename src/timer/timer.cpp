@@ -4,7 +4,7 @@
  * @version: 1.0.1
  * @Date: 2025-05-21 14:26:42
  * @LastEditors: Roo
- * @LastEditTime: 2025-05-22 15:53:54
+ * @LastEditTime: 2026-10-19 17:52:16
  */
 #include "timer.h"
 
@@ -106,8 +106,8 @@ void HeapTimer::doWork(int id) {
     }
     size_t i       = _ref_map[id];
     TimerNode node = _heap[i];
-    node.cb();
     _del(i);
+    node.cb();
 }
 /**
  * @description: 删除制定节点，并重新调整堆
@@ -155,12 +155,14 @@ void HeapTimer::tick() {
         return;
     }
     while (!_heap.empty()) {
-        TimerNode node = _heap.front();
-        if (std::chrono::duration_cast<MS>(node.expires - Clock::now()).count() > 0) {
+        /* 先判断是否到期再拷贝节点，避免每轮事件循环都拷贝回调 */
+        if (std::chrono::duration_cast<MS>(_heap.front().expires - Clock::now()).count() > 0) {
             break;
         }
-        node.cb();
+        /* 先出堆再执行回调，回调中可以重新添加同一 id 实现周期任务 */
+        TimerNode node = _heap.front();
         pop();
+        node.cb();
     }
 }
 /**
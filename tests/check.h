@@ -0,0 +1,58 @@
+/*
+ * @Description: 单元测试的断言，失败时输出位置与表达式并计数，main 以 checkResult() 的返回值退出
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <string_view>
+
+/* 每个测试可执行文件一份计数，断言失败后继续执行，一次输出全部失败 */
+static int check_failures = 0;
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            check_failures++;                                                        \
+        }                                                                            \
+    } while (0)
+
+#define CHECK_EQ(actual, expected)                                                                          \
+    do {                                                                                                    \
+        long long actual_   = (long long)(actual);                                                          \
+        long long expected_ = (long long)(expected);                                                        \
+        if (actual_ != expected_) {                                                                         \
+            fprintf(stderr, "%s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, actual_,     \
+                    expected_);                                                                             \
+            check_failures++;                                                                               \
+        }                                                                                                   \
+    } while (0)
+
+/* 比较放在函数中，actual 与 expected 为临时 std::string 时在整个调用期间有效 */
+static void checkStr(const char *file, int line, const char *expr, std::string_view actual,
+                     std::string_view expected) {
+    if (actual != expected) {
+        fprintf(stderr, "%s:%d: %s is \"%.*s\", expected \"%.*s\"\n", file, line, expr, (int)actual.size(),
+                actual.data(), (int)expected.size(), expected.data());
+        check_failures++;
+    }
+}
+
+#define CHECK_STR(actual, expected) checkStr(__FILE__, __LINE__, #actual, (actual), (expected))
+
+static int checkResult(const char *suite) {
+    if (check_failures) {
+        fprintf(stderr, "%s: %d checks failed\n", suite, check_failures);
+        return 1;
+    }
+    fprintf(stderr, "%s: all checks passed\n", suite);
+    return 0;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,158 @@
+/*
+ * @Description: BodyReader 的 Content-Length 与 chunked 分帧，输入在每个位置切分后分多次到达
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <stdint.h>
+#include <string>
+
+#include "bodyreader.h"
+#include "check.h"
+#include "httprequest.h"
+
+struct ReadResult {
+    BodyReader::READ_STATE state;
+    int code;
+    std::string body;
+    std::string rest; /* body 之后尚未消费的字节，属于下一个请求 */
+};
+
+/* 每次向缓冲区追加 step 个字节后调用 feed，直到完成或出错 */
+static ReadResult readBody(std::string_view input, size_t step, bool chunked, size_t length = 0) {
+    Arena arena;
+    Buffer buff;
+    BodyReader reader;
+    BodyCollector collector;
+    collector.init(&arena, 0, SIZE_MAX);
+    if (chunked) {
+        reader.initChunked();
+    } else {
+        reader.initLength(length);
+    }
+    BodyReader::READ_STATE state = reader.state();
+    size_t appended              = 0;
+    while (state != BodyReader::DONE && state != BodyReader::ERROR && appended < input.size()) {
+        std::string_view piece = input.substr(appended, step);
+        buff.append(piece);
+        appended += piece.size();
+        state = reader.feed(buff, &collector);
+    }
+    ReadResult result;
+    result.state = state;
+    result.code  = reader.errorCode();
+    result.body.assign(collector.data() ? collector.data() : "", collector.size());
+    result.rest.assign(buff.beginRead(), buff.readableBytes());
+    result.rest.append(input.substr(appended));
+    return result;
+}
+
+/* 同一输入按 1 ~ 全长的每种步长切分，结果都应相同 */
+static void checkBody(std::string_view input, bool chunked, std::string_view body, std::string_view rest,
+                      size_t length = 0) {
+    for (size_t step = 1; step <= input.size(); step++) {
+        ReadResult result = readBody(input, step, chunked, length);
+        CHECK_EQ(result.state, BodyReader::DONE);
+        CHECK_STR(result.body, body);
+        CHECK_STR(result.rest, rest);
+    }
+}
+
+static void checkError(std::string_view input, int code) {
+    for (size_t step = 1; step <= input.size(); step++) {
+        ReadResult result = readBody(input, step, true);
+        CHECK_EQ(result.state, BodyReader::ERROR);
+        CHECK_EQ(result.code, code);
+    }
+}
+
+static void testLength() {
+    checkBody("hello worldGET /", false, "hello world", "GET /", 11);
+    ReadResult result = readBody("", 1, false, 0);
+    CHECK_EQ(result.state, BodyReader::DONE);
+}
+
+static void testChunked() {
+    checkBody("5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n", true, "hello world", "");
+    /* 大写十六进制、扩展参数、trailer 字段，结束后的字节留给下一个请求 */
+    checkBody("A;name=value\r\n0123456789\r\n0\r\nX-Checksum: 1\r\nX-Other: 2\r\n\r\nGET / HTTP/1.1\r\n", true,
+              "0123456789", "GET / HTTP/1.1\r\n");
+    checkBody("0\r\n\r\n", true, "", "");
+}
+
+static void testMalformed() {
+    checkError("\r\n", 400);                     /* 缺少长度 */
+    checkError("x\r\nhello\r\n", 400);           /* 非十六进制 */
+    checkError("5x\r\nhello\r\n0\r\n\r\n", 400); /* 长度后跟非法字符 */
+    checkError("5\r\nhelloXX0\r\n\r\n", 400);    /* 数据后缺少 CRLF */
+    checkError("5\r\nhello\n0\r\n\r\n", 400);
+}
+
+static void testLimits() {
+    size_t max_body = BodyReader::max_body_size;
+    size_t max_line = BodyReader::max_chunk_line;
+    BodyReader::max_body_size  = 16;
+    BodyReader::max_chunk_line = 32;
+
+    checkError("11\r\n", 413);                                          /* 单个块超过上限 */
+    checkError("a\r\n0123456789\r\na\r\n", 413);                        /* 累计超过上限 */
+    checkError("ffffffffffffffffffffffff\r\n", 413);                    /* 长度溢出 */
+    checkError("1;" + std::string(40, 'e') + "\r\n", 400);              /* chunk-size 行过长 */
+    checkError("0\r\nX-A: " + std::string(40, 'a') + "\r\n\r\n", 400); /* trailer 过长 */
+    checkBody("10\r\n0123456789abcdef\r\n0\r\n\r\n", true, "0123456789abcdef", "");
+
+    ReadResult result = readBody("x", 1, false, 17);
+    CHECK_EQ(result.state, BodyReader::ERROR);
+    CHECK_EQ(result.code, 413);
+
+    BodyReader::max_body_size  = max_body;
+    BodyReader::max_chunk_line = max_line;
+}
+
+/* 经 HttpRequest 解析整个请求，返回结果与状态码 */
+static int parseRequest(std::string_view input, size_t step, std::string *value) {
+    Arena arena;
+    Buffer buff;
+    HttpRequest request;
+    request.init(&arena);
+    HttpRequest::HTTP_CODE ret = HttpRequest::NO_REQUEST;
+    for (size_t pos = 0; pos < input.size() && ret == HttpRequest::NO_REQUEST; pos += step) {
+        buff.append(input.substr(pos, step));
+        ret = request.parse(buff);
+    }
+    if (ret != HttpRequest::GET_REQUEST) {
+        return ret == HttpRequest::BAD_REQUEST ? request.errorCode() : 0;
+    }
+    if (value) {
+        *value = std::string(request.getPost("a"));
+    }
+    return 200;
+}
+
+static void testRequest() {
+    std::string input = "POST /form HTTP/1.1\r\nHost: a\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                        "Transfer-Encoding: chunked\r\n\r\n3\r\na=1\r\n4\r\n&b=2\r\n0\r\n\r\n";
+    for (size_t step = 1; step <= input.size(); step++) {
+        std::string value;
+        CHECK_EQ(parseRequest(input, step, &value), 200);
+        CHECK_STR(value, "1");
+    }
+    /* body 边界有歧义或无法确定的请求 */
+    CHECK_EQ(parseRequest("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\nContent-Length: 3\r\n\r\n", 64, nullptr),
+             400);
+    CHECK_EQ(parseRequest("POST / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n", 64, nullptr), 400);
+    CHECK_EQ(parseRequest("POST / HTTP/1.1\r\nTransfer-Encoding: chunked, gzip\r\n\r\n", 64, nullptr), 400);
+    CHECK_EQ(parseRequest("POST / HTTP/1.1\r\nContent-Length:\r\n\r\n", 64, nullptr), 400);
+    CHECK_EQ(parseRequest("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n", 64, nullptr), 400);
+}
+
+int main() {
+    testLength();
+    testChunked();
+    testMalformed();
+    testLimits();
+    testRequest();
+    return checkResult("bodyreader");
+}
@@ -0,0 +1,176 @@
+/*
+ * @Description: JSON 原地解析的转义、UTF-16 代理对、嵌套深度与数字语法，以及经 HttpRequest 分段到达的 JSON body
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <stdio.h>
+#include <string>
+
+#include "check.h"
+#include "httprequest.h"
+#include "json.h"
+
+/* 解析时字符串原地反转义，text 拷贝到可写缓冲区，文档使用期间保持有效 */
+struct Parsed {
+    Arena arena;
+    std::string text;
+    JsonDocument doc;
+    bool ok;
+
+    explicit Parsed(std::string_view json)
+        : text(json) {
+        doc.init(&arena);
+        ok = doc.parse(text.data(), text.size());
+    }
+};
+
+static void checkString(std::string_view json, std::string_view value) {
+    Parsed parsed(json);
+    CHECK(parsed.ok);
+    CHECK(parsed.doc.root().isString());
+    CHECK_STR(parsed.doc.root().asString(), value);
+}
+
+static void checkInvalid(std::string_view json) {
+    Parsed parsed(json);
+    CHECK(!parsed.ok);
+    CHECK(parsed.doc.error() != nullptr);
+}
+
+static void testEscapes() {
+    checkString("\"\"", "");
+    checkString("\"\\\" \\\\ \\/ \\b \\f \\n \\r \\t\"", "\" \\ / \b \f \n \r \t");
+    checkString("\"\\u0041\"", "A");
+    checkString("\"\\u00e9\"", "\xC3\xA9");
+    checkString("\"\\u20AC\"", "\xE2\x82\xAC");
+    checkString("\"\\ud83d\\ude00\"", "\xF0\x9F\x98\x80");
+    checkString("\"a\\u0000b\"", std::string_view("a\0b", 3));
+    checkString("\"\xE4\xB8\xAD\"", "\xE4\xB8\xAD"); /* 非 ASCII 字节原样保留 */
+
+    checkInvalid("\"\\ud83d\"");        /* 孤立的高代理 */
+    checkInvalid("\"\\ud83dx\"");
+    checkInvalid("\"\\ud83d\\u0041\""); /* 高代理后不是低代理 */
+    checkInvalid("\"\\ude00\"");        /* 孤立的低代理 */
+    checkInvalid("\"\\u12g4\"");
+    checkInvalid("\"\\u12\"");
+    checkInvalid("\"\\x41\"");
+    checkInvalid("\"a\nb\"");           /* 未转义的控制字符 */
+    checkInvalid("\"abc");
+    checkInvalid("\"abc\\");
+}
+
+/* 转义与引号落在 SSE2 每 16 字节一组扫描的各个位置 */
+static void testScanBoundary() {
+    for (size_t len = 0; len <= 40; len++) {
+        for (size_t pos = 0; pos <= len; pos++) {
+            std::string plain(len, 'a');
+            std::string json = "\"" + plain.substr(0, pos) + "\\n" + plain.substr(pos) + "\"";
+            std::string value = plain.substr(0, pos) + "\n" + plain.substr(pos);
+            checkString(json, value);
+
+            json = "\"" + plain.substr(0, pos) + "\x01" + plain.substr(pos) + "\"";
+            checkInvalid(json);
+        }
+        checkString("\"" + std::string(len, 'a') + "\"", std::string(len, 'a'));
+        checkInvalid("\"" + std::string(len, 'a'));
+    }
+}
+
+static void testDepth() {
+    size_t depth = JsonDocument::max_depth;
+    CHECK(Parsed(std::string(depth, '[') + std::string(depth, ']')).ok);
+    CHECK(!Parsed(std::string(depth + 1, '[') + std::string(depth + 1, ']')).ok);
+
+    JsonDocument::max_depth = 3;
+    CHECK(Parsed("{\"a\":[{\"b\":1}]}").ok);
+    Parsed deep("{\"a\":[{\"b\":[]}]}");
+    CHECK(!deep.ok);
+    CHECK_STR(deep.doc.error(), "nesting too deep");
+    JsonDocument::max_depth = depth;
+}
+
+static void testSyntax() {
+    const char *valid[] = {"0", "-0", "1.5e+3", "-12.25E-2", "true", "false", "null", " [ ] ", "{}", "[1,[2,{}]]"};
+    for (const char *json : valid) {
+        CHECK(Parsed(json).ok);
+    }
+    const char *invalid[] = {"",    "01",      "1.",         "-",     ".5",      "1e",    "+1",   "[1,]",
+                             "[,1]", "{\"a\":1,}", "{\"a\" 1}", "{1:2}", "[1 2]", "tru", "nul", "[1]x", "1 2"};
+    for (const char *json : invalid) {
+        checkInvalid(json);
+    }
+    Parsed trailing("{} }");
+    CHECK_STR(trailing.doc.error(), "trailing characters");
+    CHECK_EQ(trailing.doc.errorOffset(), 3);
+}
+
+static void testAccessors() {
+    Parsed parsed("{\"id\":42,\"name\":\"a\\tb\",\"tags\":[\"x\",{\"k\":-7}],\"ok\":true,\"pi\":3.5,\"none\":null}");
+    CHECK(parsed.ok);
+    JsonValue root = parsed.doc.root();
+    CHECK_EQ(root.size(), 6);
+    CHECK_STR(root.keyAt(2), "tags");
+    CHECK_EQ(root.get("id").asInt(), 42);
+    CHECK_STR(root.get("name").asString(), "a\tb");
+    CHECK_EQ(root.get("tags").size(), 2);
+    CHECK_STR(root.get("tags").at(0).asString(), "x");
+    CHECK_EQ(root.get("tags").at(1).get("k").asInt(), -7);
+    CHECK(root.get("ok").asBool());
+    CHECK(root.get("pi").asDouble() == 3.5);
+    CHECK(root.get("none").isNull());
+    /* 不存在的成员与类型不符时返回默认值 */
+    CHECK(!root.get("missing").valid());
+    CHECK(!root.get("tags").at(2).valid());
+    CHECK_EQ(root.get("name").asInt(5), 5);
+    CHECK_EQ(root.get("pi").asInt(5), 5);
+    CHECK_STR(root.get("id").asString("d"), "d");
+}
+
+/* chunked 的 JSON body 经 HttpRequest 在每个位置切成两段到达 */
+static void testRequest() {
+    std::string body  = "{\"user\":\"\\u00e9t\\u00e9\",\"n\":[1,2,3]}";
+    std::string input = "POST /api HTTP/1.1\r\nHost: a\r\nContent-Type: application/json; charset=utf-8\r\n"
+                        "Transfer-Encoding: chunked\r\n\r\n";
+    input += "5\r\n" + body.substr(0, 5) + "\r\n";
+    char size[16];
+    snprintf(size, sizeof(size), "%zx\r\n", body.size() - 5);
+    input += size + body.substr(5) + "\r\n0\r\n\r\n";
+
+    for (size_t split = 0; split <= input.size(); split++) {
+        Arena arena;
+        Buffer buff;
+        HttpRequest request;
+        request.init(&arena);
+        buff.append(std::string_view(input).substr(0, split));
+        HttpRequest::HTTP_CODE ret = request.parse(buff);
+        if (ret == HttpRequest::NO_REQUEST) {
+            buff.append(std::string_view(input).substr(split));
+            ret = request.parse(buff);
+        }
+        CHECK_EQ(ret, HttpRequest::GET_REQUEST);
+        CHECK_STR(request.json().get("user").asString(), "\xC3\xA9t\xC3\xA9");
+        CHECK_EQ(request.json().get("n").at(2).asInt(), 3);
+        CHECK_STR(request.getPost("user"), "\xC3\xA9t\xC3\xA9");
+    }
+
+    Arena arena;
+    Buffer buff;
+    HttpRequest request;
+    request.init(&arena);
+    buff.append("POST /api HTTP/1.1\r\nContent-Type: application/json\r\nContent-Length: 10\r\n\r\n{\"a\":\"\\q\"}");
+    CHECK_EQ(request.parse(buff), HttpRequest::BAD_REQUEST);
+    CHECK_EQ(request.errorCode(), 400);
+}
+
+int main() {
+    testEscapes();
+    testScanBoundary();
+    testDepth();
+    testSyntax();
+    testAccessors();
+    testRequest();
+    return checkResult("json");
+}
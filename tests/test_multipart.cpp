@@ -0,0 +1,166 @@
+/*
+ * @Description: multipart/form-data 流式解析，分隔符与部分首部在任意位置被切分到两次读取之间
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <stdint.h>
+#include <string>
+#include <unistd.h>
+
+#include "check.h"
+#include "multipart.h"
+
+static const char CONTENT_TYPE[] = "multipart/form-data; boundary=----Bound7MA4";
+
+struct ParseResult {
+    bool ok;
+    int code;
+    std::string parts; /* 每个部分为 "name|filename|content_type|data;"，溢出到文件的数据读回后拼接 */
+    size_t spilled;
+};
+
+static std::string readAll(int fd) {
+    std::string data;
+    char buf[256];
+    ssize_t n;
+    off_t offset = 0;
+    while ((n = pread(fd, buf, sizeof(buf), offset)) > 0) {
+        data.append(buf, n);
+        offset += n;
+    }
+    return data;
+}
+
+/* splits 为切分位置，body 依次按这些位置分段送入，最后一段到结尾 */
+static ParseResult parse(std::string_view content_type, std::string_view body, const std::vector<size_t> &splits,
+                         size_t limit = SIZE_MAX) {
+    Arena arena;
+    MultipartCollector collector;
+    MultipartParser parser;
+    collector.init(&arena, limit);
+    ParseResult result = {false, 0, "", 0};
+    if (!parser.init(&arena, content_type, &collector)) {
+        return result;
+    }
+    result.ok   = true;
+    size_t from = 0;
+    for (size_t i = 0; i <= splits.size() && result.ok; i++) {
+        size_t to = i < splits.size() ? splits[i] : body.size();
+        result.ok = parser.onBodyData(body.substr(from, to - from));
+        from      = to;
+    }
+    result.ok   = result.ok && parser.onBodyEnd();
+    result.code = result.ok ? 0 : parser.errorCode();
+    for (const MultipartPart &part : collector.parts()) {
+        result.parts.append(part.name).append("|").append(part.filename).append("|").append(part.content_type);
+        result.parts.append("|").append(part.fd >= 0 ? readAll(part.fd) : std::string(part.data)).append(";");
+        result.spilled += part.fd >= 0;
+    }
+    collector.clear();
+    return result;
+}
+
+/* 在每个位置切成两段，以及逐字节送入，结果都应与一次送入相同 */
+static void checkParts(std::string_view body, std::string_view parts) {
+    for (size_t split = 0; split <= body.size(); split++) {
+        ParseResult result = parse(CONTENT_TYPE, body, {split});
+        CHECK(result.ok);
+        CHECK_STR(result.parts, parts);
+    }
+    std::vector<size_t> bytes;
+    for (size_t i = 1; i < body.size(); i++) {
+        bytes.push_back(i);
+    }
+    ParseResult result = parse(CONTENT_TYPE, body, bytes);
+    CHECK(result.ok);
+    CHECK_STR(result.parts, parts);
+}
+
+static void checkError(std::string_view body, int code) {
+    for (size_t split = 0; split <= body.size(); split++) {
+        ParseResult result = parse(CONTENT_TYPE, body, {split});
+        CHECK(!result.ok);
+        CHECK_EQ(result.code, code);
+    }
+}
+
+static const char FORM[] = "preamble\r\n"
+                           "------Bound7MA4\r\n"
+                           "Content-Disposition: form-data; name=\"user\"\r\n"
+                           "\r\n"
+                           "alice\r\n"
+                           "------Bound7MA4  \r\n"
+                           "Content-Disposition: form-data; name=\"file\"; filename=\"a.txt\"\r\n"
+                           "Content-Type: text/plain\r\n"
+                           "\r\n"
+                           "line\r\n--not\r\n------Bound7M\r\n----Bound7MA4x\r\n"
+                           "------Bound7MA4\r\n"
+                           "Content-Disposition: form-data; name=\"empty\"\r\n"
+                           "\r\n"
+                           "\r\n"
+                           "------Bound7MA4--\r\n"
+                           "epilogue";
+
+static const char FORM_PARTS[] = "user|||alice;"
+                                 "file|a.txt|text/plain|line\r\n--not\r\n------Bound7M\r\n----Bound7MA4x;"
+                                 "empty|||;";
+
+static void testParts() {
+    checkParts(FORM, FORM_PARTS);
+    /* 没有前导内容，结束分隔符后没有 CRLF */
+    checkParts("------Bound7MA4\r\nContent-Disposition: form-data; name=a\r\n\r\n1\r\n------Bound7MA4--", "a|||1;");
+}
+
+static void testSpill() {
+    size_t threshold                    = MultipartCollector::spill_threshold;
+    MultipartCollector::spill_threshold = 8;
+    for (size_t split = 0; split <= sizeof(FORM) - 1; split += 7) {
+        ParseResult result = parse(CONTENT_TYPE, FORM, {split});
+        CHECK(result.ok);
+        CHECK_EQ(result.spilled, 1);
+        CHECK_STR(result.parts, FORM_PARTS);
+    }
+    MultipartCollector::spill_threshold = threshold;
+
+    /* 普通字段超出内存配额 */
+    ParseResult result = parse(CONTENT_TYPE, FORM, {}, 4);
+    CHECK(!result.ok);
+    CHECK_EQ(result.code, 413);
+}
+
+static void testMalformed() {
+    /* 没有结束分隔符 */
+    checkError("------Bound7MA4\r\nContent-Disposition: form-data; name=a\r\n\r\n1\r\n", 400);
+    /* 分隔符后既不是 "--" 也不是 CRLF */
+    checkError("------Bound7MA4x\r\nContent-Disposition: form-data; name=a\r\n\r\n1\r\n------Bound7MA4--", 400);
+    /* 部分没有 name */
+    checkError("------Bound7MA4\r\nContent-Type: text/plain\r\n\r\n1\r\n------Bound7MA4--", 400);
+    /* 首部行没有冒号 */
+    checkError("------Bound7MA4\r\nbroken\r\n\r\n1\r\n------Bound7MA4--", 400);
+    /* 部分首部超过上限 */
+    std::string header = "------Bound7MA4\r\nX-Long: " + std::string(MultipartParser::CARRY_SIZE, 'x') + "\r\n";
+    ParseResult result = parse(CONTENT_TYPE, header, {header.size() / 2});
+    CHECK(!result.ok);
+    CHECK_EQ(result.code, 400);
+}
+
+static void testBoundary() {
+    CHECK_STR(MultipartParser::boundary("multipart/form-data; boundary=abc"), "abc");
+    CHECK_STR(MultipartParser::boundary("Multipart/Form-Data; charset=utf-8; BOUNDARY=\"a b;c\""), "a b;c");
+    CHECK_STR(MultipartParser::boundary("multipart/form-data"), "");
+    CHECK_STR(MultipartParser::boundary("multipart/mixed; boundary=abc"), "");
+    std::string too_long = "multipart/form-data; boundary=" + std::string(MultipartParser::MAX_BOUNDARY + 1, 'a');
+    CHECK_STR(MultipartParser::boundary(too_long), "");
+    CHECK(!parse("text/plain", FORM, {}).ok);
+}
+
+int main() {
+    testParts();
+    testSpill();
+    testMalformed();
+    testBoundary();
+    return checkResult("multipart");
+}
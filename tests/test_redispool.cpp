@@ -0,0 +1,157 @@
+/*
+ * @Description: RESP 连接池对接进程内的 RespStub：多线程并发提交时应答与回调的对应、错误应答与断线重连
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "epoller.h"
+#include "redispool.h"
+#include "respstub.h"
+
+/* 测试线程充当事件循环，分派连接池的事件直到 done() 成立或超时 */
+static bool runUntil(Epoller &epoller, RedisPool &pool, const std::function<bool()> &done, int timeout_ms = 3000) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        int event_cnt = epoller.wait(10);
+        for (int i = 0; i < event_cnt; i++) {
+            pool.handleEvent(epoller.getEventFd(i), epoller.getEvents(i));
+        }
+    }
+    return true;
+}
+
+/* 应答转为 "类型:内容"，便于比较 */
+static std::string describe(const RespReply &reply) {
+    switch (reply.type) {
+    case RESP_NIL:
+        return "nil";
+    case RESP_STATUS:
+        return "+" + std::string(reply.str);
+    case RESP_ERROR:
+        return "-" + std::string(reply.str);
+    case RESP_INTEGER:
+        return ":" + std::to_string(reply.integer);
+    case RESP_STRING:
+        return "$" + std::string(reply.str);
+    case RESP_ARRAY:
+        return "*" + std::to_string(reply.elements.size());
+    }
+    return "?";
+}
+
+static void testCommands(Epoller &epoller, RedisPool &pool) {
+    std::vector<std::string> replies;
+    auto collect = [&replies](const RespReply &reply) { replies.push_back(describe(reply)); };
+    /* 同一批命令可能分到不同连接，逐条等待应答以确定顺序 */
+    auto run = [&](std::initializer_list<std::string_view> args) {
+        size_t expected = replies.size() + 1;
+        pool.command(args, collect);
+        CHECK(runUntil(epoller, pool, [&] { return replies.size() == expected; }));
+        return replies.empty() ? std::string() : replies.back();
+    };
+    CHECK_STR(run({"PING"}), "+PONG");
+    CHECK_STR(run({"SET", "key", std::string_view("v\r\n\0x", 5)}), "+OK");
+    CHECK_STR(run({"GET", "key"}), "$" + std::string("v\r\n\0x", 5));
+    CHECK_STR(run({"GET", "missing"}), "nil");
+    CHECK_STR(run({"SET", "key", "other", "NX"}), "nil");
+    CHECK_STR(run({"EXISTS", "key", "missing"}), ":1");
+    CHECK_STR(run({"INCR", "key"}), "-ERR value is not an integer or out of range");
+    CHECK_STR(run({"NOSUCH"}).substr(0, 4), "-ERR");
+    CHECK_STR(run({"DEL", "key"}), ":1");
+    CHECK_STR(run({"ECHO", ""}), "$");
+}
+
+/* 多个线程并发提交，回调与命令一一对应：ECHO 的应答与各自的参数相同，INCR 的值各出现一次 */
+static void testPipeline(Epoller &epoller, RedisPool &pool) {
+    const int threads = 4;
+    const int per     = 250;
+    std::vector<long long> values; /* 回调都在事件循环线程中执行，无需加锁 */
+    std::atomic<int> echoes(0);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&pool, &values, &echoes, &errors, t] {
+            for (int i = 0; i < per; i++) {
+                std::string payload = std::to_string(t) + ":" + std::to_string(i);
+                pool.command({"ECHO", payload}, [payload, &echoes, &errors](const RespReply &reply) {
+                    if (reply.type == RESP_STRING && reply.str == payload) {
+                        echoes++;
+                    } else {
+                        errors++;
+                    }
+                });
+                pool.command({"INCR", "counter"}, [&values, &errors](const RespReply &reply) {
+                    if (reply.type == RESP_INTEGER) {
+                        values.push_back(reply.integer);
+                    } else {
+                        errors++;
+                    }
+                });
+            }
+        });
+    }
+    const int total = threads * per;
+    CHECK(runUntil(epoller, pool, [&] { return echoes + errors + (int)values.size() == 2 * total; }));
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    CHECK_EQ(errors, 0);
+    CHECK_EQ(echoes, total);
+    CHECK_EQ(values.size(), total);
+    std::vector<bool> seen(total + 1, false);
+    for (long long value : values) {
+        CHECK(value >= 1 && value <= total && !seen[value]);
+        if (value >= 1 && value <= total) {
+            seen[value] = true;
+        }
+    }
+}
+
+/* 服务端断开时未应答的命令以错误回调，健康检查在服务端恢复后重连 */
+static void testReconnect(Epoller &epoller, RedisPool &pool, RespStub &stub, size_t conn_num) {
+    int port = stub.port();
+    stub.stop();
+    CHECK(runUntil(epoller, pool, [&] { return pool.connected() == 0; }));
+
+    std::string reply;
+    pool.command({"PING"}, [&reply](const RespReply &r) { reply = describe(r); });
+    CHECK_STR(reply, "-ERR no redis connection"); /* 没有可用连接时立即回调 */
+
+    CHECK(stub.start(port));
+    CHECK(runUntil(epoller, pool, [&] { return pool.connected() == conn_num; }));
+    reply.clear();
+    pool.command({"PING"}, [&reply](const RespReply &r) { reply = describe(r); });
+    CHECK(runUntil(epoller, pool, [&] { return !reply.empty(); }));
+    CHECK_STR(reply, "+PONG");
+}
+
+int main() {
+    const size_t conn_num = 3;
+    RespStub stub;
+    CHECK(stub.start());
+    Epoller epoller;
+    RedisPool pool;
+    CHECK(pool.init(&epoller, "127.0.0.1", stub.port(), conn_num, 50));
+    CHECK(runUntil(epoller, pool, [&] { return pool.connected() == conn_num; }));
+
+    testCommands(epoller, pool);
+    testPipeline(epoller, pool);
+    testReconnect(epoller, pool, stub, conn_num);
+
+    pool.close();
+    stub.stop();
+    return checkResult("redispool");
+}
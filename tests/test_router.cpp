@@ -0,0 +1,141 @@
+/*
+ * @Description: 路由匹配的 静态 > 参数 > 前缀 优先级、方法不匹配时的回溯、404 与 405 的区分以及注册冲突
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <string>
+
+#include "check.h"
+#include "httprequest.h"
+#include "httpresponse.h"
+#include "router.h"
+
+static std::string called; /* 被调用的处理函数写入自己的名字 */
+
+static RouteHandler named(const char *name) {
+    return [name](const HttpRequest &, HttpResponse &) { called = name; };
+}
+
+struct MatchResult {
+    int code;
+    std::string name;
+    std::string params; /* "key=value;" */
+};
+
+static MatchResult match(const Router &router, std::string_view method, std::string_view path) {
+    Arena arena;
+    HttpFieldList params{ArenaAllocator<HttpField>(&arena)};
+    params.emplace_back("existing", "1"); /* 已有的参数不受匹配失败的影响 */
+    const RouteHandler *handler = nullptr;
+    MatchResult result          = {router.match(method, path, params, &handler), "", ""};
+    called.clear();
+    if (handler) {
+        HttpRequest request;
+        HttpResponse response;
+        (*handler)(request, response);
+        result.name = called;
+    }
+    CHECK(params.size() >= 1);
+    for (size_t i = 1; i < params.size(); i++) {
+        result.params.append(params[i].first).append("=").append(params[i].second).append(";");
+    }
+    return result;
+}
+
+static void checkMatch(const Router &router, std::string_view method, std::string_view path, std::string_view name,
+                       std::string_view params = "") {
+    MatchResult result = match(router, method, path);
+    CHECK_EQ(result.code, 200);
+    CHECK_STR(result.name, name);
+    CHECK_STR(result.params, params);
+}
+
+static void checkCode(const Router &router, std::string_view method, std::string_view path, int code) {
+    MatchResult result = match(router, method, path);
+    CHECK_EQ(result.code, code);
+    CHECK_STR(result.params, "");
+}
+
+static void testPriority() {
+    Router router;
+    CHECK(router.add("GET", "/users", named("list")));
+    CHECK(router.add("GET", "/users/new", named("new")));
+    CHECK(router.add("GET", "/users/:id", named("user")));
+    CHECK(router.add("GET", "/users/:id/posts/:post", named("post")));
+    CHECK(router.add("GET", "/users/*rest", named("users_rest")));
+    CHECK(router.add("GET", "/static/*path", named("static")));
+    CHECK(router.add("GET", "/use", named("use"))); /* 与 /users 共享前缀，分裂静态边 */
+    CHECK_EQ(router.size(), 7);
+
+    checkMatch(router, "GET", "/users", "list");
+    checkMatch(router, "GET", "/use", "use");
+    checkMatch(router, "GET", "/users/new", "new");
+    checkMatch(router, "GET", "/users/newer", "user", "id=newer;");
+    checkMatch(router, "GET", "/users/ne", "user", "id=ne;");
+    checkMatch(router, "GET", "/users/42", "user", "id=42;");
+    checkMatch(router, "GET", "/users/42/posts/7", "post", "id=42;post=7;");
+    /* 参数分支走不通时回退到前缀，参数不残留 */
+    checkMatch(router, "GET", "/users/42/likes", "users_rest", "rest=42/likes;");
+    checkMatch(router, "GET", "/users//x", "users_rest", "rest=/x;");
+    checkMatch(router, "GET", "/static/css/a.css", "static", "path=css/a.css;");
+    checkMatch(router, "GET", "/static/", "static", "path=;");
+    checkMatch(router, "GET", "/users/", "users_rest", "rest=;"); /* 参数不匹配空段，前缀可以为空 */
+
+    checkCode(router, "GET", "/", 404);
+    checkCode(router, "GET", "/user", 404);
+    checkCode(router, "GET", "/static", 404);
+}
+
+static void testMethod() {
+    Router router;
+    CHECK(router.add("POST", "/users/new", named("create")));
+    CHECK(router.add("GET", "/users/:id", named("user")));
+    CHECK(router.add("DELETE", "/users/:id", named("delete")));
+    CHECK(router.add("GET", "/files/*path", named("files")));
+    CHECK(router.add("PUT", "/files/readme", named("put")));
+
+    /* 静态分支没有注册 GET，回溯到参数分支 */
+    checkMatch(router, "GET", "/users/new", "user", "id=new;");
+    checkMatch(router, "POST", "/users/new", "create");
+    checkMatch(router, "DELETE", "/users/new", "delete", "id=new;");
+    checkMatch(router, "GET", "/files/readme", "files", "path=readme;");
+    checkMatch(router, "PUT", "/files/readme", "put");
+
+    /* 路径存在但所有分支都没有该方法时为 405，路径不存在为 404 */
+    checkCode(router, "PATCH", "/users/new", 405);
+    checkCode(router, "POST", "/users/5", 405);
+    checkCode(router, "PUT", "/files/other", 405);
+    checkCode(router, "POST", "/nope", 404);
+    checkCode(router, "GET", "/users/5/x", 404);
+    checkCode(router, "get", "/users/5", 405); /* 方法区分大小写 */
+}
+
+static void testAdd() {
+    Router router;
+    CHECK(router.add("GET", "/a/:id", named("a")));
+    CHECK(!router.add("GET", "/a/:id", named("dup")));   /* 重复注册 */
+    CHECK(router.add("POST", "/a/:id", named("post")));  /* 同一路径的其他方法 */
+    CHECK(!router.add("GET", "/a/:name/x", named("x"))); /* 同一位置的参数名不同 */
+    CHECK(!router.add("GET", "/b/*rest/x", named("x"))); /* 前缀段不在末尾 */
+    CHECK(!router.add("GET", "/c/:", named("x")));
+    CHECK(!router.add("GET", "/c/*", named("x")));
+    CHECK(!router.add("GET", "c", named("x")));
+    CHECK(!router.add("", "/c", named("x")));
+    CHECK(!router.add("GET", "/c", RouteHandler()));
+    CHECK_EQ(router.size(), 2);
+    /* ':' 不在段首时是静态字符 */
+    CHECK(router.add("GET", "/time/12:30", named("time")));
+    checkMatch(router, "GET", "/time/12:30", "time");
+    checkCode(router, "GET", "/time/12:31", 404);
+    checkMatch(router, "GET", "/a/x", "a", "id=x;");
+}
+
+int main() {
+    testPriority();
+    testMethod();
+    testAdd();
+    return checkResult("router");
+}
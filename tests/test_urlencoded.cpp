@@ -0,0 +1,111 @@
+/*
+ * @Description: urlencoded 原地解码的 '%'、'+' 边界情况，以及经 HttpRequest 分段到达的查询串与表单 body
+ * @Author: Roo
+ * @version: 1.0.1
+ * @Date: 2026-10-19 23:59:59
+ * @LastEditors: Roo
+ * @LastEditTime: 2026-10-19 23:59:59
+ */
+#include <string>
+
+#include "check.h"
+#include "httprequest.h"
+#include "urlencoded.h"
+
+/* 键值对拼接为 "key=value;"，便于整体比较 */
+static std::string parse(std::string_view input) {
+    Arena arena;
+    std::string data(input);
+    HttpFieldList fields{ArenaAllocator<HttpField>(&arena)};
+    UrlEncoded::parse(data.data(), data.size(), fields);
+    std::string result;
+    for (const HttpField &field : fields) {
+        result.append(field.first).append("=").append(field.second).append(";");
+    }
+    return result;
+}
+
+static void testDecode() {
+    CHECK_STR(parse(""), "");
+    CHECK_STR(parse("a=1&b=2"), "a=1;b=2;");
+    CHECK_STR(parse("q=hello+world&x=%41%62%2b"), "q=hello world;x=Ab+;");
+    CHECK_STR(parse("%E4%B8%AD=%e6%96%87"), "\xE4\xB8\xAD=\xE6\x96\x87;");
+    CHECK_STR(parse("k%3Dv=a%26b"), "k=v=a&b;"); /* 编码后的分隔符不再分隔 */
+    CHECK_STR(parse("a=b=c"), "a=b=c;");           /* 只有第一个 '=' 分隔键值 */
+    CHECK_STR(parse("%00=x"), std::string("\0=x;", 4));
+}
+
+static void testInvalidPercent() {
+    /* 非法或被截断的 '%' 按原字符保留，后续字符正常解码 */
+    CHECK_STR(parse("a=%zz"), "a=%zz;");
+    CHECK_STR(parse("a=%4"), "a=%4;");
+    CHECK_STR(parse("a=%"), "a=%;");
+    CHECK_STR(parse("a=%%41"), "a=%A;");
+    CHECK_STR(parse("a=%4g+%41"), "a=%4g A;");
+    CHECK_STR(parse("a=%&b=%2"), "a=%;b=%2;");
+    CHECK_STR(parse("a=100%+b"), "a=100% b;");
+}
+
+static void testEmpty() {
+    CHECK_STR(parse("a"), "a=;");
+    CHECK_STR(parse("a=&b"), "a=;b=;");
+    CHECK_STR(parse("=v&&&=&x=1&"), "x=1;"); /* 空键的段被丢弃 */
+    CHECK_STR(parse("+=+"), " = ;");
+    CHECK_STR(parse("a=1&a=2&a"), "a=1;a=2;a=;"); /* 重复键全部保留，查找时取第一个 */
+}
+
+/* 特殊字符落在 SSE2 每 16 字节一组扫描的各个位置 */
+static void testScanBoundary() {
+    for (size_t len = 1; len <= 40; len++) {
+        std::string plain(len, 'x'); /* 不是十六进制数字，'%' 后的字符不构成转义 */
+        CHECK_STR(parse(plain), plain + "=;");
+        for (size_t pos = 0; pos < len; pos++) {
+            std::string head = plain.substr(0, pos);
+            std::string tail = plain.substr(pos + 1);
+            CHECK_STR(parse("k=" + head + "%41" + tail), "k=" + head + "A" + tail + ";");
+            CHECK_STR(parse("k=" + head + "+" + tail), "k=" + head + " " + tail + ";");
+            CHECK_STR(parse("k=" + head + "%" + tail), "k=" + head + "%" + tail + ";");
+            CHECK_STR(parse("a" + head + "=" + tail), "a" + head + "=" + tail + ";");
+            CHECK_STR(parse("k=" + head + "&" + tail), tail.empty() ? "k=" + head + ";"
+                                                                    : "k=" + head + ";" + tail + "=;");
+        }
+    }
+}
+
+/* 整个请求在每个位置切成两段到达，查询串与表单 body 都应正确解码，且请求行不被修改 */
+static void testRequest() {
+    std::string body  = "name=J%C3%B6rg+M&empty=&bad";
+    std::string input = "POST /search?q=a%2Bb+c&lang=%zz&q=second HTTP/1.1\r\nHost: a\r\n"
+                        "Content-Type: application/x-www-form-urlencoded\r\nContent-Length: " +
+                        std::to_string(body.size()) + "\r\n\r\n" + body;
+    for (size_t split = 0; split <= input.size(); split++) {
+        Arena arena;
+        Buffer buff;
+        HttpRequest request;
+        request.init(&arena);
+        buff.append(std::string_view(input).substr(0, split));
+        HttpRequest::HTTP_CODE ret = request.parse(buff);
+        if (ret == HttpRequest::NO_REQUEST) {
+            buff.append(std::string_view(input).substr(split));
+            ret = request.parse(buff);
+        }
+        CHECK_EQ(ret, HttpRequest::GET_REQUEST);
+        CHECK_STR(request.path(), "/search");
+        CHECK_STR(request.target(), "/search?q=a%2Bb+c&lang=%zz&q=second");
+        CHECK_STR(request.getQuery("q"), "a+b c");
+        CHECK_STR(request.getQuery("lang"), "%zz");
+        CHECK_STR(request.getPost("name"), "J\xC3\xB6rg M");
+        CHECK_STR(request.getPost("empty"), "");
+        CHECK_STR(request.getPost("bad"), "");
+        CHECK_STR(request.getPost("missing"), "");
+    }
+}
+
+int main() {
+    testDecode();
+    testInvalidPercent();
+    testEmpty();
+    testScanBoundary();
+    testRequest();
+    return checkResult("urlencoded");
+}